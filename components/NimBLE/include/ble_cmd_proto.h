@@ -0,0 +1,135 @@
+// components/ble_server/include/ble_cmd_proto.h
+// Protocolo binário de comandos. C puro (sem dependências do ESP-IDF),
+// compila também no Linux.
+//
+// Requisição (characteristic Command):
+//   [0] opcode  [1] seq  [2..3] len (LE)  [4..] payload (len bytes)
+// Resposta (notificação na characteristic Status):
+//   [0] opcode | 0x80  [1] seq  [2] status  [3] len  [4..] payload
+#ifndef BLE_CMD_PROTO_H
+#define BLE_CMD_PROTO_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define BLE_CMD_HDR_LEN 4
+#define BLE_CMD_RESP_HDR_LEN 4
+#define BLE_CMD_RESP_FLAG 0x80
+#define BLE_CMD_RESP_MAX_PAYLOAD 32
+#define BLE_CMD_RESP_MAX_LEN (BLE_CMD_RESP_HDR_LEN + BLE_CMD_RESP_MAX_PAYLOAD)
+#define BLE_CMD_MAX_DEFS 255
+
+    // Código de status da resposta
+    typedef enum
+    {
+        BLE_CMD_STATUS_OK = 0x00,
+        BLE_CMD_STATUS_BAD_FRAME = 0x01,      // Cabeçalho inválido ou tamanho inconsistente
+        BLE_CMD_STATUS_UNKNOWN_OPCODE = 0x02, // Opcode não registrado
+        BLE_CMD_STATUS_BAD_LENGTH = 0x03,     // Payload fora de [min_len, max_len]
+        BLE_CMD_STATUS_FAILED = 0x04,         // Handler falhou
+        BLE_CMD_STATUS_BUSY = 0x05,           // Handler não pode executar agora
+    } ble_cmd_status_t;
+
+    // Requisição decodificada (payload aponta para o buffer original)
+    typedef struct
+    {
+        uint8_t opcode;
+        uint8_t seq;
+        uint16_t len;
+        const uint8_t *payload;
+    } ble_cmd_frame_t;
+
+    // Payload da resposta, preenchido pelo handler
+    typedef struct
+    {
+        uint8_t len;
+        uint8_t payload[BLE_CMD_RESP_MAX_PAYLOAD];
+    } ble_cmd_resp_t;
+
+    typedef ble_cmd_status_t (*ble_cmd_handler_t)(const ble_cmd_frame_t *req, ble_cmd_resp_t *resp, void *arg);
+
+    // Definição de um opcode (normalmente num array const da aplicação)
+    typedef struct
+    {
+        uint8_t opcode;
+        uint16_t min_len;
+        uint16_t max_len;
+        ble_cmd_handler_t handler;
+    } ble_cmd_def_t;
+
+    // Tabela de despacho: índice direto por opcode (O(1))
+    typedef struct
+    {
+        const ble_cmd_def_t *defs;
+        void *arg;
+        uint8_t index[256]; // 0 = não registrado, senão posição em defs + 1
+    } ble_cmd_table_t;
+
+    /**
+     * @brief Monta a tabela de despacho a partir das definições da aplicação
+     *
+     * @param table Tabela a preencher
+     * @param defs Definições (devem permanecer válidas)
+     * @param count Número de definições (máx BLE_CMD_MAX_DEFS)
+     * @param arg Argumento repassado aos handlers
+     * @return 0 se sucesso, -1 se opcode duplicado, reservado (bit 0x80) ou excesso
+     */
+    int ble_cmd_table_init(ble_cmd_table_t *table, const ble_cmd_def_t *defs, size_t count, void *arg);
+
+    /**
+     * @brief Decodifica uma requisição
+     *
+     * @return BLE_CMD_STATUS_OK ou BLE_CMD_STATUS_BAD_FRAME
+     */
+    ble_cmd_status_t ble_cmd_frame_parse(const uint8_t *buf, size_t len, ble_cmd_frame_t *frame);
+
+    /**
+     * @brief Indica se o buffer é texto ASCII imprimível (comandos legados)
+     *
+     * Frames binários sempre têm bytes não imprimíveis (o byte alto do len
+     * é 0 para payloads < 256 bytes), então o texto não se confunde com eles.
+     *
+     * @return true se len > 0 e todos os bytes estão em 0x20..0x7E
+     */
+    bool ble_cmd_is_text(const uint8_t *buf, size_t len);
+
+    /**
+     * @brief Codifica a resposta BLE_CMD_STATUS_BAD_FRAME para uma requisição malformada
+     *
+     * Opcode e seq vêm dos bytes recebidos, quando existem (0 senão), para o
+     * cliente associar o erro ao comando enviado.
+     *
+     * @return Bytes escritos em out (0 se cap insuficiente)
+     */
+    size_t ble_cmd_resp_bad_frame(const uint8_t *buf, size_t len, uint8_t *out, size_t cap);
+
+    /**
+     * @brief Resolve o opcode, valida o tamanho e executa o handler
+     *
+     * @param table Tabela de despacho
+     * @param frame Requisição já decodificada
+     * @param out Buffer da resposta codificada
+     * @param cap Capacidade de out (BLE_CMD_RESP_MAX_LEN cobre qualquer resposta)
+     * @return Bytes escritos em out (0 se cap insuficiente)
+     */
+    size_t ble_cmd_dispatch(const ble_cmd_table_t *table, const ble_cmd_frame_t *frame, uint8_t *out, size_t cap);
+
+    /**
+     * @brief Codifica um frame de resposta
+     *
+     * @return Bytes escritos em out (0 se cap insuficiente)
+     */
+    size_t ble_cmd_resp_encode(uint8_t opcode, uint8_t seq, uint8_t status,
+                               const uint8_t *payload, uint8_t len, uint8_t *out, size_t cap);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,83 @@
+// components/ble_server/include/ble_mbuf_view.h
+#ifndef BLE_MBUF_VIEW_H
+#define BLE_MBUF_VIEW_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "os/os_mbuf.h"
+
+// Visão somente leitura sobre uma cadeia os_mbuf recebida num write.
+// Válida apenas durante o callback: o mbuf é liberado pelo host em seguida.
+typedef struct
+{
+    const struct os_mbuf *om; // Primeiro segmento da cadeia
+    uint16_t len;             // Total de bytes na cadeia
+} ble_mbuf_view_t;
+
+// Segmento contíguo da cadeia (usado para iterar sem copiar)
+typedef struct
+{
+    const uint8_t *data;
+    uint16_t len;
+    const struct os_mbuf *om; // Segmento atual (cursor interno)
+} ble_mbuf_seg_t;
+
+/**
+ * @brief Inicializa uma visão sobre a cadeia
+ *
+ * @param view Visão a preencher
+ * @param om Cadeia de mbufs (ctxt->om)
+ */
+void ble_mbuf_view_init(ble_mbuf_view_t *view, const struct os_mbuf *om);
+
+/**
+ * @brief Posiciona o iterador no primeiro segmento não vazio
+ *
+ * @return true se existe segmento
+ */
+bool ble_mbuf_view_seg_first(const ble_mbuf_view_t *view, ble_mbuf_seg_t *seg);
+
+/**
+ * @brief Avança o iterador para o próximo segmento não vazio
+ *
+ * @return true se existe segmento
+ */
+bool ble_mbuf_view_seg_next(ble_mbuf_seg_t *seg);
+
+/**
+ * @brief Lê um byte na posição indicada
+ *
+ * @return Valor do byte (0-255) ou -1 se fora da visão
+ */
+int ble_mbuf_view_byte(const ble_mbuf_view_t *view, uint16_t off);
+
+/**
+ * @brief Retorna ponteiro direto se [off, off+len) estiver num único segmento
+ *
+ * @return Ponteiro para os dados ou NULL se o intervalo cruza segmentos
+ */
+const uint8_t *ble_mbuf_view_contig(const ble_mbuf_view_t *view, uint16_t off, uint16_t len);
+
+/**
+ * @brief Copia um trecho pequeno da visão (ex.: campo de cabeçalho)
+ *
+ * @return true se o intervalo está dentro da visão
+ */
+bool ble_mbuf_view_read(const ble_mbuf_view_t *view, uint16_t off, void *dst, uint16_t len);
+
+/**
+ * @brief Compara um trecho da visão com um buffer, sem copiar
+ *
+ * @return true se o trecho existe e é idêntico
+ */
+bool ble_mbuf_view_equals(const ble_mbuf_view_t *view, uint16_t off, const void *data, uint16_t len);
+
+/**
+ * @brief Lê inteiros little-endian
+ *
+ * @return true se o intervalo está dentro da visão
+ */
+bool ble_mbuf_view_get_u16le(const ble_mbuf_view_t *view, uint16_t off, uint16_t *out);
+bool ble_mbuf_view_get_u32le(const ble_mbuf_view_t *view, uint16_t off, uint32_t *out);
+
+#endif
@@ -3,44 +3,616 @@
 #define BLE_SERVER_H
 
 #include "esp_err.h"
+#include "ble_mbuf_view.h"
+#include "host/ble_uuid.h"
+#include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
+// Destino especial de ble_server_notify_enqueue(): todos os clientes inscritos
+#define BLE_SERVER_NOTIFY_ALL 0xFFFF
+
+// Flags do cabeçalho de segmento da characteristic Long Write:
+// [0] flags  [1..4] offset (LE)  [5..] dados
+#define BLE_SERVER_LONGWR_FIRST 0x01 // Início de um novo objeto (offset 0)
+#define BLE_SERVER_LONGWR_LAST 0x02  // Último segmento: entrega o objeto
+#define BLE_SERVER_LONGWR_ABORT 0x04 // Descarta o objeto em andamento
+
+// Código de evento do broadcast gerado a cada mudança de state do status
+// (value = novo state). Códigos a partir de 0x80 ficam para a aplicação.
+#define BLE_SERVER_EVT_STATE_CHANGE 0x01
+
+// Characteristic Diag (CONFIG_BLE_SERVER_DIAG). Histogramas com buckets de
+// latência fixos: [0] < 250 us, [i] < 250 << i us, o último sem limite.
+// Leitura (little-endian):
+//   [versão=1][nº de characteristics][nº de buckets][selecionada]
+//   3 x histograma (u16 por bucket): despacho (chegada do write na Command
+//     até o on_write), execução do on_write, chegada até a primeira
+//     notificação para a conexão (resultado)
+//   characteristic selecionada: [reads u32][writes u32][erros u32]
+//     [bytes rx u32][bytes tx u32] + histograma do handler
+// Write de 1 byte seleciona a characteristic (posição na tabela GATT:
+// internas primeiro) ou zera tudo com BLE_SERVER_DIAG_RESET.
+#define BLE_SERVER_DIAG_BUCKETS 12
+#define BLE_SERVER_DIAG_RESET 0xFF
+
 // Callbacks para aplicação
 typedef void (*ble_on_write_cb_t)(uint8_t *data, uint16_t len);
+// Variante sem cópia: recebe a cadeia de mbufs original (executada na task do host)
+typedef void (*ble_on_write_view_cb_t)(const ble_mbuf_view_t *view);
 typedef void (*ble_on_connect_cb_t)(uint16_t conn_handle);
-typedef void (*ble_on_disconnect_cb_t)(void);
+typedef void (*ble_on_disconnect_cb_t)(uint16_t conn_handle);
+// Objeto remontado da characteristic Long Write (executado na task do host;
+// o buffer volta ao pool quando o callback retorna)
+typedef void (*ble_on_long_write_cb_t)(uint16_t conn_handle, const uint8_t *data, uint32_t len);
+// Resultado de uma notificação enfileirada (executado na task do host)
+typedef void (*ble_server_sent_cb_t)(uint16_t conn_handle, esp_err_t status, void *arg);
+
+// Canal bulk L2CAP CoC (streaming)
+// Recebe cada SDU sem cópia; retornar != 0 fecha o canal
+typedef int (*ble_bulk_sink_cb_t)(uint16_t conn_handle, const ble_mbuf_view_t *sdu, void *arg);
+// Preenche até max_len bytes; retorna bytes escritos, 0 no fim, < 0 para abortar
+typedef int (*ble_bulk_source_cb_t)(uint16_t conn_handle, uint8_t *buf, uint16_t max_len, void *arg);
+// Fim de um envio iniciado por ble_server_bulk_send()
+typedef void (*ble_bulk_done_cb_t)(uint16_t conn_handle, esp_err_t status, void *arg);
+
+typedef struct
+{
+    ble_bulk_sink_cb_t on_rx;
+    ble_bulk_done_cb_t on_tx_done; // Recebe o arg passado a ble_server_bulk_send()
+    void *arg;                     // Repassado ao on_rx
+} ble_server_bulk_cbs_t;
+
+// Characteristics registradas pela aplicação (executados na task do host)
+// Leitura: acrescenta o valor em om; retorna 0 ou código de erro ATT
+typedef int (*ble_chr_read_cb_t)(uint16_t conn_handle, struct os_mbuf *om, void *arg);
+// Escrita: recebe o valor sem cópia; retorna 0 ou código de erro ATT
+typedef int (*ble_chr_write_cb_t)(uint16_t conn_handle, const ble_mbuf_view_t *view, void *arg);
+
+typedef struct
+{
+    const ble_uuid_t *uuid;      // Precisa continuar válido (estático)
+    uint16_t flags;              // BLE_GATT_CHR_F_*
+    ble_chr_read_cb_t on_read;   // Obrigatório com BLE_GATT_CHR_F_READ
+    ble_chr_write_cb_t on_write; // Obrigatório com BLE_GATT_CHR_F_WRITE(_NO_RSP)
+    void *arg;                   // Repassado aos handlers
+    uint16_t *val_handle;        // Recebe o handle do valor (opcional)
+    bool require_auth;           // Writes precisam de tag HMAC (ver ble_server_auth_set_key)
+} ble_server_chr_def_t;
+
+// Política de parâmetros de conexão
+typedef enum
+{
+    BLE_SERVER_CONN_POLICY_NONE = 0,       // Mantém os parâmetros escolhidos pelo central
+    BLE_SERVER_CONN_POLICY_FAST_THEN_IDLE, // Intervalo curto + 2M/DLE, relaxa quando ocioso
+} ble_server_conn_policy_t;
+
+// Perfis do agendador de advertising (do mais rápido ao mais lento)
+typedef enum
+{
+    BLE_SERVER_ADV_DIRECTED = 0, // Alto duty cycle para o último par com bond (1,28 s)
+    BLE_SERVER_ADV_FAST,         // Boot, desconexão ou ble_server_adv_request_fast()
+    BLE_SERVER_ADV_MEDIUM,
+    BLE_SERVER_ADV_SLOW,     // Mantido até a próxima conexão
+    BLE_SERVER_ADV_PROFILE_COUNT,
+} ble_server_adv_profile_t;
 
 typedef struct
 {
     const char *device_name;
     ble_on_write_cb_t on_write;
+    ble_on_write_view_cb_t on_write_view; // Se definido, tem prioridade sobre on_write (sem async_commands)
+    ble_on_long_write_cb_t on_long_write;
     ble_on_connect_cb_t on_connect;
     ble_on_disconnect_cb_t on_disconnect;
+    bool async_commands; // Executa on_write numa tarefa dedicada (fora do host NimBLE); não vale para on_write_view
+    bool auth_commands;  // Command, Data/Hora e Long Write só aceitam writes autenticados (sessão da characteristic Auth)
+    uint16_t coalesce_window_ms; // Janela de agregação de ble_server_notify_record (0 = desativada)
+    ble_server_conn_policy_t conn_policy;
+    const ble_server_bulk_cbs_t *bulk; // Canal L2CAP CoC (NULL = desativado)
 } ble_server_config_t;
 
+// Registro servido pela characteristic Status (20 bytes, little-endian)
+typedef struct
+{
+    uint32_t state;        // Estado da fechadura (0 = travado, 1 = destravado)
+    uint32_t changed_ms;   // Última mudança de state (ms desde o boot, preenchido pelo servidor)
+    uint32_t change_count; // Mudanças de state desde o boot (preenchido pelo servidor)
+    uint32_t op_count;     // Contador de operações da aplicação
+    uint32_t error_flags;  // Bits de erro definidos pela aplicação
+} ble_server_status_t;
+
+// Estado de uma conexão ativa
+typedef struct
+{
+    uint16_t conn_handle;
+    uint16_t mtu;         // MTU ATT negociado
+    bool subscribed;      // Notificações da characteristic Status habilitadas
+    bool encrypted;
+    bool authenticated;
+    bool bonded;
+    uint8_t key_size;
+    uint32_t connected_ms; // Tempo desde a conexão
+    uint32_t rx_writes;
+    uint32_t rx_bytes;
+    uint32_t tx_notifies;
+    uint32_t tx_errors;
+} ble_server_conn_info_t;
+
+// Estatísticas do agregador de notificações
+typedef struct
+{
+    uint32_t records;         // Registros recebidos
+    uint32_t records_dropped; // Registros perdidos (nenhum cliente/erro de envio)
+    uint32_t packets;         // Notificações enviadas
+    uint32_t packets_saved;   // Notificações economizadas (registros - pacotes)
+    uint32_t flush_window;    // Envios por fim de janela
+    uint32_t flush_full;      // Envios por pacote cheio (MTU)
+    uint32_t flush_manual;    // Envios por ble_server_notify_flush()
+} ble_server_coalesce_stats_t;
+
+// Estatísticas da fila de transmissão de notificações
+typedef struct
+{
+    uint32_t enqueued;      // Notificações aceitas
+    uint32_t sent;          // Notificações entregues ao controlador
+    uint32_t dropped_full;  // Recusadas por fila cheia
+    uint32_t dropped_error; // Descartadas por erro ou desconexão
+    uint32_t retries;       // Drenagens interrompidas por falta de mbufs
+    uint32_t pending;       // Pendentes agora (todas as conexões)
+    uint32_t depth_max;     // Maior ocupação de uma fila
+    uint32_t delay_us_avg;  // Tempo médio na fila (us)
+    uint32_t delay_us_max;  // Maior tempo na fila (us)
+} ble_server_txq_stats_t;
+
+// Estatísticas da política de conexão
+typedef struct
+{
+    uint32_t fast_requests;    // Pedidos de intervalo curto
+    uint32_t idle_requests;    // Pedidos de intervalo longo
+    uint32_t first_cmd_count;  // Conexões que enviaram ao menos um comando
+    uint32_t first_cmd_ms_avg; // Tempo médio conexão -> primeiro comando (ms)
+    uint32_t first_cmd_ms_max; // Maior tempo conexão -> primeiro comando (ms)
+    uint32_t approach_count;   // Primeiros comandos em conexões de janela direcionada/rápida
+    uint32_t approach_ms_avg;  // Tempo médio gatilho do advertising -> primeiro comando (ms)
+    uint32_t approach_ms_max;  // Maior tempo gatilho do advertising -> primeiro comando (ms)
+} ble_server_policy_stats_t;
+
+// Estatísticas do agendador de advertising
+typedef struct
+{
+    bool advertising;                                  // Advertising ativo agora
+    ble_server_adv_profile_t profile;                  // Perfil atual (ou último)
+    uint32_t profile_ms[BLE_SERVER_ADV_PROFILE_COUNT]; // Tempo anunciando em cada perfil
+    uint32_t fast_requests;                            // Chamadas a ble_server_adv_request_fast()
+    uint32_t events_est;                               // Eventos de advertising estimados
+    uint32_t radio_ms_est;                             // Tempo de rádio estimado
+    uint32_t duty_ppm;                                 // Duty cycle estimado desde o init (ppm)
+    uint32_t window_connects;                          // Conexões em janelas direcionada/rápida
+    uint32_t window_connect_ms_avg;                    // Tempo médio gatilho -> conexão (ms)
+    uint32_t window_connect_ms_max;                    // Maior tempo gatilho -> conexão (ms)
+    uint32_t directed_connects;                        // Reconexões pelo advertising direcionado
+} ble_server_adv_stats_t;
+
+// Estatísticas das sessões de comandos autenticados
+typedef struct
+{
+    uint32_t sessions;            // Nonces emitidos (leituras da characteristic Auth)
+    uint32_t verified;            // Comandos aceitos
+    uint32_t rejected_format;     // Mais curtos que cabeçalho + tag
+    uint32_t rejected_no_session; // Sem nonce lido na conexão
+    uint32_t rejected_key;        // key_id sem chave configurada
+    uint32_t rejected_replay;     // Contador repetido ou menor
+    uint32_t rejected_tag;        // Tag não confere
+    uint32_t verify_us_avg;       // Tempo médio de verificação (us)
+    uint32_t verify_us_max;       // Maior tempo de verificação (us)
+} ble_server_auth_stats_t;
+
+// Estatísticas de resets do host/controlador NimBLE
+typedef struct
+{
+    uint32_t resets;          // Resets desde o boot
+    int last_reason;          // Motivo do último reset (BLE_HS_E*, BLE_HS_HCI_ERR)
+    uint32_t syncs;           // Sincronizações com o controlador (boot incluído)
+    uint32_t sync_retries;    // Sincronizações adiadas por erro
+    uint32_t boot_adv_ms;     // ble_server_init() até o primeiro advertising
+    uint32_t recover_ms_last; // Reset até anunciar de novo (último)
+    uint32_t recover_ms_max;  // Reset até anunciar de novo (pior caso)
+} ble_server_reset_stats_t;
+
+// Tipos de registro do trace (CONFIG_BLE_SERVER_TRACE)
+typedef enum
+{
+    BLE_SERVER_TRACE_GAP = 1,     // sub = BLE_GAP_EVENT_*, value = status/reason/MTU
+    BLE_SERVER_TRACE_READ,        // sub = índice da characteristic, value = duração | rc
+    BLE_SERVER_TRACE_WRITE,       // sub = índice da characteristic, value = duração | rc
+    BLE_SERVER_TRACE_NOTIFY,      // sub = 0 fila, 1 direta; value = espera | rc
+    BLE_SERVER_TRACE_APP_CB,      // sub = BLE_SERVER_TRACE_CB_*, value = duração
+    BLE_SERVER_TRACE_RESET,       // Reset do host; value = motivo
+} ble_server_trace_type_t;
+
+// Callbacks da aplicação medidos (sub de BLE_SERVER_TRACE_APP_CB)
+typedef enum
+{
+    BLE_SERVER_TRACE_CB_WRITE = 0, // on_write (host ou tarefa de comandos)
+    BLE_SERVER_TRACE_CB_WRITE_VIEW,
+    BLE_SERVER_TRACE_CB_LONG_WRITE,
+    BLE_SERVER_TRACE_CB_CONNECT,
+    BLE_SERVER_TRACE_CB_DISCONNECT,
+    BLE_SERVER_TRACE_CB_SENT,
+} ble_server_trace_cb_t;
+
+// Registro do trace (12 bytes, little-endian). Durações em us nos 24 bits
+// baixos de value (saturadas em 0xFFFFFF) e código de retorno no byte alto.
+typedef struct __attribute__((packed))
+{
+    uint32_t time_us; // esp_timer (32 bits baixos)
+    uint8_t type;     // ble_server_trace_type_t
+    uint8_t sub;
+    uint16_t conn_handle; // 0xFFFF se não se aplica
+    uint32_t value;
+} ble_server_trace_rec_t;
+
+// Estatísticas do canal bulk L2CAP
+typedef struct
+{
+    uint32_t channels_opened;
+    uint32_t rx_bytes;
+    uint32_t tx_bytes;
+    uint32_t tx_transfers; // Envios concluídos
+    uint32_t tx_aborted;   // Envios abortados (erro/desconexão)
+    uint32_t tx_stalls;    // Esperas por créditos do par
+    uint32_t rx_kbps_last; // Taxa sustentada de recepção (kbit/s)
+    uint32_t tx_kbps_last; // Taxa sustentada do último envio (kbit/s)
+} ble_server_bulk_stats_t;
+
+// Estatísticas da remontagem de writes longos
+typedef struct
+{
+    uint32_t objects;        // Objetos entregues
+    uint32_t bytes;          // Bytes entregues
+    uint32_t segments;       // Segmentos aceitos
+    uint32_t aborted;        // Objetos descartados (erro, ABORT, desconexão)
+    uint32_t pool_exhausted; // Objetos recusados por falta de buffer
+} ble_server_longwr_stats_t;
+
+// Estatísticas do pipeline assíncrono de comandos
+typedef struct
+{
+    uint32_t enqueued;    // Comandos aceitos na fila
+    uint32_t executed;    // Comandos executados pela tarefa
+    uint32_t dropped;     // Comandos descartados (fila cheia)
+    uint32_t depth;       // Ocupação atual da fila
+    uint32_t depth_max;   // Pico de ocupação da fila
+    uint32_t wait_us_avg; // Tempo médio na fila (us)
+    uint32_t wait_us_max; // Maior tempo na fila (us)
+    uint32_t exec_us_avg; // Tempo médio de execução do on_write (us)
+    uint32_t exec_us_max; // Maior tempo de execução do on_write (us)
+} ble_server_cmd_stats_t;
+
 /**
  * @brief Inicializa servidor BLE
  *
  * @param config Configuração de callbacks
- * @return ESP_OK se sucesso
+ * @return ESP_OK se sucesso, ESP_ERR_INVALID_ARG se a configuração é
+ *         inválida (sem device_name, ou on_write_view com async_commands)
  */
 esp_err_t ble_server_init(const ble_server_config_t *config);
 
 /**
- * @brief Envia notificação para cliente conectado
+ * @brief Declara uma characteristic no serviço Lock Control
+ *
+ * Deve ser chamada antes de ble_server_init(): a tabela GATT é montada uma
+ * única vez a partir das declarações. A declaração é copiada.
+ *
+ * @param def Declaração da characteristic
+ * @return ESP_OK se registrada, ESP_ERR_INVALID_ARG se faltam handlers,
+ *         ESP_ERR_NO_MEM se CONFIG_BLE_SERVER_MAX_APP_CHRS foi atingido,
+ *         ESP_ERR_INVALID_STATE se o servidor já foi inicializado
+ */
+esp_err_t ble_server_register_chr(const ble_server_chr_def_t *def);
+
+/**
+ * @brief Configura a chave de um key_id para comandos autenticados
+ *
+ * O HMAC-SHA256 da chave é pré-processado aqui, uma vez; verificar um
+ * comando não refaz o key schedule. Pode ser chamada de qualquer tarefa,
+ * inclusive com o servidor rodando (ex.: provisionar um novo celular).
+ *
+ * Comando autenticado, escrito nas characteristics com require_auth:
+ *   [0] key_id  [1..4] contador (LE)  [5..n-9] comando  [n-8..n-1] tag
+ * tag = HMAC-SHA256(chave, nonce || bytes[0..n-9]), primeiros 8 bytes. O
+ * nonce (16 bytes) vem da leitura da characteristic Auth, que abre uma
+ * sessão nova; o contador precisa crescer a cada comando da sessão.
+ *
+ * @param key_id Slot (0 a CONFIG_BLE_SERVER_AUTH_KEY_SLOTS - 1)
+ * @param key Segredo compartilhado
+ * @param len Tamanho do segredo (1 a 64 bytes)
+ * @return ESP_OK se configurada, ESP_ERR_INVALID_ARG se slot ou tamanho inválido
+ */
+esp_err_t ble_server_auth_set_key(uint8_t key_id, const uint8_t *key, size_t len);
+
+/**
+ * @brief Remove a chave de um key_id (comandos com ela passam a ser recusados)
+ *
+ * @param key_id Slot
+ * @return ESP_OK se sucesso, ESP_ERR_INVALID_ARG se slot inválido
+ */
+esp_err_t ble_server_auth_clear_key(uint8_t key_id);
+
+/**
+ * @brief Lê as estatísticas dos comandos autenticados
+ *
+ * @param stats Estrutura preenchida com os contadores atuais
+ * @return ESP_OK se sucesso
+ */
+esp_err_t ble_server_get_auth_stats(ble_server_auth_stats_t *stats);
+
+/**
+ * @brief Envia notificação para todos os clientes inscritos
+ *
+ * Até CONFIG_BLE_SERVER_TXQ_SLOT_SIZE bytes a notificação passa pela fila de
+ * transmissão (ver ble_server_notify_enqueue); acima disso é enviada direto.
  *
  * @param data Dados a enviar (máx 512 bytes)
  * @param len Tamanho dos dados
- * @return ESP_OK se enviado com sucesso
+ * @return ESP_OK se aceito para ao menos um cliente,
+ *         ESP_ERR_INVALID_STATE se nenhum cliente inscrito
  */
 esp_err_t ble_server_notify(uint8_t *data, uint16_t len);
 
+/**
+ * @brief Enfileira uma notificação sem bloquear
+ *
+ * A notificação é copiada para a fila da conexão e enviada pela task do host
+ * assim que houver mbufs disponíveis. Falta de buffers não descarta o evento.
+ * Só conexões com o CCCD da Status habilitado recebem; o que estava na fila
+ * de quem o desabilita é descartado (sent_cb com ESP_ERR_INVALID_STATE).
+ *
+ * @param conn_handle Conexão de destino ou BLE_SERVER_NOTIFY_ALL
+ * @param data Dados a enviar (máx CONFIG_BLE_SERVER_TXQ_SLOT_SIZE)
+ * @param len Tamanho dos dados
+ * @param sent_cb Chamado ao enviar ou descartar (opcional)
+ * @param arg Argumento repassado ao sent_cb
+ * @return ESP_OK se enfileirado, ESP_ERR_NO_MEM se a fila está cheia,
+ *         ESP_ERR_NOT_FOUND se a conexão não existe,
+ *         ESP_ERR_INVALID_STATE se o destino não habilitou notificações
+ */
+esp_err_t ble_server_notify_enqueue(uint16_t conn_handle, const uint8_t *data, uint16_t len,
+                                    ble_server_sent_cb_t sent_cb, void *arg);
+
+/**
+ * @brief Lê as estatísticas da fila de transmissão
+ *
+ * @param stats Estrutura preenchida com os contadores atuais
+ * @return ESP_OK se sucesso
+ */
+esp_err_t ble_server_get_txq_stats(ble_server_txq_stats_t *stats);
+
+/**
+ * @brief Enfileira um registro pequeno de status/evento para notificação agregada
+ *
+ * Registros que chegam dentro de coalesce_window_ms são enviados juntos numa
+ * notificação no formato [len][dados][len][dados]..., dimensionada pelo menor
+ * MTU negociado. Com a agregação desativada cada registro é enviado sozinho,
+ * no mesmo formato.
+ *
+ * @param data Dados do registro
+ * @param len Tamanho do registro
+ * @return ESP_OK se aceito, ESP_ERR_INVALID_SIZE se não cabe no MTU,
+ *         ESP_ERR_INVALID_STATE se nenhum cliente inscrito
+ */
+esp_err_t ble_server_notify_record(const uint8_t *data, uint8_t len);
+
+/**
+ * @brief Envia imediatamente os registros pendentes
+ *
+ * @return ESP_OK
+ */
+esp_err_t ble_server_notify_flush(void);
+
+/**
+ * @brief Lê as estatísticas do agregador de notificações
+ *
+ * @param stats Estrutura preenchida com os contadores atuais
+ * @return ESP_OK se sucesso, ESP_ERR_INVALID_STATE se a agregação está desativada
+ */
+esp_err_t ble_server_get_coalesce_stats(ble_server_coalesce_stats_t *stats);
+
 /**
  * @brief Atualiza valor da característica de leitura
  *
+ * Equivale a ble_server_set_status() alterando apenas o campo state.
+ *
  * @param value Novo valor
  * @return ESP_OK se atualizado
  */
 esp_err_t ble_server_update_read_value(uint32_t value);
 
+/**
+ * @brief Publica o registro de status
+ *
+ * Pode ser chamada de qualquer tarefa. Leituras em andamento na task do
+ * host nunca bloqueiam nem veem um registro parcial. changed_ms e
+ * change_count são mantidos pelo servidor e ignorados na entrada.
+ *
+ * @param status Novo registro
+ * @return ESP_OK se publicado
+ */
+esp_err_t ble_server_set_status(const ble_server_status_t *status);
+
+/**
+ * @brief Lê o último registro de status publicado
+ *
+ * @param status Estrutura preenchida
+ * @return ESP_OK se sucesso
+ */
+esp_err_t ble_server_get_status(ble_server_status_t *status);
+
+/**
+ * @brief Lê as estatísticas do pipeline assíncrono de comandos
+ *
+ * Úteis para dimensionar CONFIG_BLE_SERVER_CMD_QUEUE_LEN.
+ *
+ * @param stats Estrutura preenchida com os contadores atuais
+ * @return ESP_OK se sucesso, ESP_ERR_INVALID_STATE se async_commands desativado
+ */
+esp_err_t ble_server_get_cmd_stats(ble_server_cmd_stats_t *stats);
+
+/**
+ * @brief Conexão que enviou o comando em execução
+ *
+ * Válida dentro de on_write/on_write_view, na task do host ou na tarefa de
+ * comandos. Passada a ble_server_notify_enqueue(), a resposta vai só para
+ * quem enviou o comando.
+ *
+ * @return Handle da conexão, ou BLE_SERVER_NOTIFY_ALL fora de um comando
+ */
+uint16_t ble_server_cmd_conn_handle(void);
+
+/**
+ * @brief Lê as estatísticas da política de conexão
+ *
+ * @param stats Estrutura preenchida com os contadores atuais
+ * @return ESP_OK se sucesso
+ */
+esp_err_t ble_server_get_policy_stats(ble_server_policy_stats_t *stats);
+
+/**
+ * @brief Lê as estatísticas de resets do host
+ *
+ * Após um reset o NimBLE ressincroniza com o controlador sozinho; o servidor
+ * reenvia payloads, reconfigura os sets de advertising e volta a anunciar.
+ * As tabelas GATT e os bonds continuam valendo. Conexões caem e as
+ * notificações pendentes são reportadas como falha ao sent_cb.
+ *
+ * @param stats Estrutura preenchida com os contadores atuais
+ * @return ESP_OK se sucesso
+ */
+esp_err_t ble_server_get_reset_stats(ble_server_reset_stats_t *stats);
+
+/**
+ * @brief Copia os registros do trace, do mais antigo ao mais recente
+ *
+ * Com CONFIG_BLE_SERVER_TRACE, eventos GAP, acessos GATT, resultados de
+ * notificações e a duração dos callbacks da aplicação ficam num anel em RAM
+ * (CONFIG_BLE_SERVER_TRACE_RECORDS registros). A gravação pausa durante a
+ * cópia; o que chega nesse intervalo conta como perdido.
+ *
+ * @param recs Vetor de saída
+ * @param max Capacidade do vetor
+ * @param lost Recebe registros sobrescritos ou perdidos desde o boot (opcional)
+ * @return Quantidade copiada (0 se o trace está desativado)
+ */
+int ble_server_trace_read(ble_server_trace_rec_t *recs, int max, uint32_t *lost);
+
+/**
+ * @brief Despeja o trace na serial em hexadecimal
+ *
+ * Formato por linha: "BLE_TRACE begin v1 recs=N lost=L now_us=T", depois
+ * "BLE_TRACE <registros>" com até 4 registros em hex cada e "BLE_TRACE end".
+ *
+ * @return ESP_OK se sucesso, ESP_ERR_NOT_SUPPORTED se o trace está desativado
+ */
+esp_err_t ble_server_trace_dump(void);
+
+/**
+ * @brief Descarta os registros do trace
+ */
+void ble_server_trace_clear(void);
+
+/**
+ * @brief Abre uma janela de advertising rápido
+ *
+ * Para um gatilho de despertar (botão, sensor de aproximação): reinicia o
+ * advertising no perfil rápido, que volta a descer pelos perfis ao expirar.
+ *
+ * @return ESP_OK se agendado, ESP_ERR_INVALID_STATE antes de ble_server_init()
+ */
+esp_err_t ble_server_adv_request_fast(void);
+
+/**
+ * @brief Atualiza o nível de bateria anunciado no manufacturer data
+ *
+ * O advertising carrega [company id 0xFFFF][state][change_count LE][bateria],
+ * permitindo ler o estado da fechadura por scan, sem conectar. state e
+ * change_count acompanham ble_server_set_status().
+ *
+ * @param level Bateria em % (0xFF = desconhecido)
+ * @return ESP_OK se sucesso, ESP_ERR_INVALID_STATE antes de ble_server_init()
+ */
+esp_err_t ble_server_adv_set_battery(uint8_t level);
+
+/**
+ * @brief Acrescenta um evento ao log transmitido por advertising periódico
+ *
+ * Com CONFIG_BLE_SERVER_EVENT_BROADCAST um set BLE 5 não conectável carrega
+ * os últimos CONFIG_BLE_SERVER_EVENT_BROADCAST_DEPTH eventos; observadores
+ * sincronizados acompanham sem conectar. Mudanças de state do status são
+ * registradas automaticamente (BLE_SERVER_EVT_STATE_CHANGE).
+ *
+ * @param code Código do evento
+ * @param value Valor associado
+ * @return ESP_OK se registrado, ESP_ERR_NOT_SUPPORTED se o broadcast está desativado
+ */
+esp_err_t ble_server_broadcast_event(uint8_t code, uint8_t value);
+
+/**
+ * @brief Lê as estatísticas do agendador de advertising
+ *
+ * O duty cycle é estimado a partir do intervalo de cada perfil e do tempo de
+ * rádio típico de um evento legado em 3 canais.
+ *
+ * @param stats Estrutura preenchida com os contadores atuais
+ * @return ESP_OK se sucesso
+ */
+esp_err_t ble_server_get_adv_stats(ble_server_adv_stats_t *stats);
+
+/**
+ * @brief Inicia um envio em streaming pelo canal bulk
+ *
+ * A fonte é chamada na task do host sempre que houver créditos, escrevendo
+ * direto no SDU. Apenas um envio por vez.
+ *
+ * @param source Fonte de dados
+ * @param arg Argumento repassado à fonte e ao on_tx_done
+ * @return ESP_OK se iniciado, ESP_ERR_INVALID_STATE se não há canal aberto
+ *         ou já existe envio em andamento
+ */
+esp_err_t ble_server_bulk_send(ble_bulk_source_cb_t source, void *arg);
+
+/**
+ * @brief Lê as estatísticas do canal bulk
+ *
+ * @param stats Estrutura preenchida com os contadores atuais
+ * @return ESP_OK se sucesso
+ */
+esp_err_t ble_server_get_bulk_stats(ble_server_bulk_stats_t *stats);
+
+/**
+ * @brief Lê as estatísticas da remontagem de writes longos
+ *
+ * @param stats Estrutura preenchida com os contadores atuais
+ * @return ESP_OK se sucesso
+ */
+esp_err_t ble_server_get_longwr_stats(ble_server_longwr_stats_t *stats);
+
+/**
+ * @brief Lê o estado de uma conexão
+ *
+ * @param conn_handle Handle da conexão
+ * @param info Estrutura preenchida
+ * @return ESP_OK se sucesso, ESP_ERR_NOT_FOUND se a conexão não existe
+ */
+esp_err_t ble_server_get_conn_info(uint16_t conn_handle, ble_server_conn_info_t *info);
+
+/**
+ * @brief Lista as conexões ativas
+ *
+ * @param infos Vetor de saída
+ * @param max Capacidade do vetor
+ * @return Quantidade de conexões copiadas
+ */
+int ble_server_get_conns(ble_server_conn_info_t *infos, int max);
+
 #endif
\ No newline at end of file
@@ -0,0 +1,187 @@
+// components/ble_server/src/ble_auth.c
+#include "ble_auth.h"
+#include <string.h>
+
+#define SHA256_BLOCK_LEN 64
+#define SHA256_LEN 32
+
+static void wipe(void *buf, size_t len)
+{
+    volatile uint8_t *p = buf;
+    while (len--)
+    {
+        *p++ = 0;
+    }
+}
+
+static uint32_t get_u32le(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+int ble_auth_key_init(ble_auth_key_t *key, const uint8_t *secret, size_t len)
+{
+    uint8_t pad[SHA256_BLOCK_LEN];
+    int rc;
+
+    if (key == NULL || secret == NULL || len == 0 || len > BLE_AUTH_KEY_MAX_LEN)
+    {
+        return -1;
+    }
+
+    key->valid = false;
+    mbedtls_sha256_init(&key->inner);
+    mbedtls_sha256_init(&key->outer);
+
+    // Chave já cabe num bloco: o HMAC usa direto, completada com zeros
+    memset(pad, 0x36, sizeof(pad));
+    for (size_t i = 0; i < len; i++)
+        pad[i] ^= secret[i];
+    rc = mbedtls_sha256_starts(&key->inner, 0);
+    if (rc == 0)
+        rc = mbedtls_sha256_update(&key->inner, pad, sizeof(pad));
+
+    memset(pad, 0x5c, sizeof(pad));
+    for (size_t i = 0; i < len; i++)
+        pad[i] ^= secret[i];
+    if (rc == 0)
+        rc = mbedtls_sha256_starts(&key->outer, 0);
+    if (rc == 0)
+        rc = mbedtls_sha256_update(&key->outer, pad, sizeof(pad));
+
+    wipe(pad, sizeof(pad));
+    if (rc != 0)
+    {
+        ble_auth_key_free(key);
+        return -1;
+    }
+
+    key->valid = true;
+    return 0;
+}
+
+void ble_auth_key_free(ble_auth_key_t *key)
+{
+    if (key == NULL)
+    {
+        return;
+    }
+
+    mbedtls_sha256_free(&key->inner);
+    mbedtls_sha256_free(&key->outer);
+    wipe(key, sizeof(*key));
+}
+
+void ble_auth_session_start(ble_auth_session_t *session, const uint8_t nonce[BLE_AUTH_NONCE_LEN])
+{
+    memcpy(session->nonce, nonce, BLE_AUTH_NONCE_LEN);
+    session->last_counter = 0;
+    session->active = true;
+}
+
+void ble_auth_mac_start(ble_auth_mac_t *mac, const ble_auth_key_t *key, const ble_auth_session_t *session)
+{
+    mac->key = key;
+    mbedtls_sha256_init(&mac->sha);
+    mbedtls_sha256_clone(&mac->sha, &key->inner);
+    mbedtls_sha256_update(&mac->sha, session->nonce, BLE_AUTH_NONCE_LEN);
+}
+
+void ble_auth_mac_update(ble_auth_mac_t *mac, const uint8_t *data, size_t len)
+{
+    mbedtls_sha256_update(&mac->sha, data, len);
+}
+
+void ble_auth_mac_finish(ble_auth_mac_t *mac, uint8_t tag[BLE_AUTH_TAG_LEN])
+{
+    uint8_t digest[SHA256_LEN];
+
+    mbedtls_sha256_finish(&mac->sha, digest);
+    mbedtls_sha256_free(&mac->sha);
+
+    // Hash externo parte do estado opad pré-processado
+    mbedtls_sha256_init(&mac->sha);
+    mbedtls_sha256_clone(&mac->sha, &mac->key->outer);
+    mbedtls_sha256_update(&mac->sha, digest, sizeof(digest));
+    mbedtls_sha256_finish(&mac->sha, digest);
+    mbedtls_sha256_free(&mac->sha);
+
+    memcpy(tag, digest, BLE_AUTH_TAG_LEN);
+    wipe(digest, sizeof(digest));
+}
+
+bool ble_auth_tag_equal(const uint8_t *a, const uint8_t *b)
+{
+    uint8_t diff = 0;
+
+    for (int i = 0; i < BLE_AUTH_TAG_LEN; i++)
+    {
+        diff |= a[i] ^ b[i];
+    }
+    return diff == 0;
+}
+
+ble_auth_status_t ble_auth_verify(ble_auth_session_t *session, const ble_auth_key_t *key,
+                                  const uint8_t *msg, size_t len)
+{
+    ble_auth_mac_t mac;
+    uint8_t tag[BLE_AUTH_TAG_LEN];
+
+    if (len < BLE_AUTH_OVERHEAD)
+    {
+        return BLE_AUTH_ERR_FORMAT;
+    }
+    if (!session->active)
+    {
+        return BLE_AUTH_ERR_NO_SESSION;
+    }
+    if (key == NULL || !key->valid)
+    {
+        return BLE_AUTH_ERR_KEY;
+    }
+
+    // Contador antigo é recusado antes de gastar o HMAC
+    uint32_t counter = get_u32le(&msg[1]);
+    if (counter <= session->last_counter)
+    {
+        return BLE_AUTH_ERR_REPLAY;
+    }
+
+    ble_auth_mac_start(&mac, key, session);
+    ble_auth_mac_update(&mac, msg, len - BLE_AUTH_TAG_LEN);
+    ble_auth_mac_finish(&mac, tag);
+
+    if (!ble_auth_tag_equal(tag, &msg[len - BLE_AUTH_TAG_LEN]))
+    {
+        return BLE_AUTH_ERR_TAG;
+    }
+
+    session->last_counter = counter;
+    return BLE_AUTH_OK;
+}
+
+size_t ble_auth_sign(const ble_auth_key_t *key, const ble_auth_session_t *session, uint8_t key_id,
+                     uint32_t counter, const uint8_t *cmd, size_t len, uint8_t *out, size_t cap)
+{
+    ble_auth_mac_t mac;
+
+    if (cap < len + BLE_AUTH_OVERHEAD)
+    {
+        return 0;
+    }
+
+    out[0] = key_id;
+    out[1] = (uint8_t)counter;
+    out[2] = (uint8_t)(counter >> 8);
+    out[3] = (uint8_t)(counter >> 16);
+    out[4] = (uint8_t)(counter >> 24);
+    if (len > 0)
+    {
+        memcpy(&out[BLE_AUTH_HDR_LEN], cmd, len);
+    }
+
+    ble_auth_mac_start(&mac, key, session);
+    ble_auth_mac_update(&mac, out, BLE_AUTH_HDR_LEN + len);
+    ble_auth_mac_finish(&mac, &out[BLE_AUTH_HDR_LEN + len]);
+    return len + BLE_AUTH_OVERHEAD;
+}
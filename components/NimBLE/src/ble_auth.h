@@ -0,0 +1,114 @@
+// components/ble_server/src/ble_auth.h
+// Núcleo de verificação dos comandos autenticados. C portável (só depende do
+// SHA-256 do mbedTLS), compila também no Linux.
+//
+// Comando autenticado:
+//   [0] key_id  [1..4] contador (LE)  [5..n-9] comando  [n-8..n-1] tag
+// tag = HMAC-SHA256(chave[key_id], nonce || bytes[0..n-9]) truncado em 8 bytes.
+// O nonce é sorteado pelo servidor a cada sessão; o contador precisa crescer
+// dentro da sessão.
+#ifndef BLE_AUTH_H
+#define BLE_AUTH_H
+
+#include "mbedtls/sha256.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define BLE_AUTH_NONCE_LEN 16
+#define BLE_AUTH_HDR_LEN 5
+#define BLE_AUTH_TAG_LEN 8
+#define BLE_AUTH_OVERHEAD (BLE_AUTH_HDR_LEN + BLE_AUTH_TAG_LEN)
+#define BLE_AUTH_KEY_MAX_LEN 64 // Um bloco SHA-256
+
+typedef enum
+{
+    BLE_AUTH_OK = 0,
+    BLE_AUTH_ERR_FORMAT,     // Mais curto que cabeçalho + tag
+    BLE_AUTH_ERR_NO_SESSION, // Nonce ainda não lido
+    BLE_AUTH_ERR_KEY,        // key_id sem chave
+    BLE_AUTH_ERR_REPLAY,     // Contador não cresceu
+    BLE_AUTH_ERR_TAG,        // Tag não confere
+} ble_auth_status_t;
+
+// Chave com o HMAC pré-processado: estados SHA-256 após os blocos ipad/opad.
+// Cada verificação parte de cópias desses estados, sem refazer o key schedule.
+typedef struct
+{
+    bool valid;
+    mbedtls_sha256_context inner;
+    mbedtls_sha256_context outer;
+} ble_auth_key_t;
+
+// Sessão de uma conexão
+typedef struct
+{
+    bool active;
+    uint8_t nonce[BLE_AUTH_NONCE_LEN];
+    uint32_t last_counter;
+} ble_auth_session_t;
+
+// HMAC em andamento (permite alimentar a mensagem em segmentos)
+typedef struct
+{
+    mbedtls_sha256_context sha;
+    const ble_auth_key_t *key;
+} ble_auth_mac_t;
+
+/**
+ * @brief Pré-processa uma chave (até BLE_AUTH_KEY_MAX_LEN bytes)
+ *
+ * @return 0 se sucesso, -1 se tamanho inválido ou erro do mbedTLS
+ */
+int ble_auth_key_init(ble_auth_key_t *key, const uint8_t *secret, size_t len);
+
+/**
+ * @brief Apaga a chave (estados do HMAC incluídos)
+ */
+void ble_auth_key_free(ble_auth_key_t *key);
+
+/**
+ * @brief Inicia uma sessão com o nonce sorteado pelo chamador
+ */
+void ble_auth_session_start(ble_auth_session_t *session, const uint8_t nonce[BLE_AUTH_NONCE_LEN]);
+
+/**
+ * @brief Inicia o HMAC de um comando, já com o nonce da sessão
+ */
+void ble_auth_mac_start(ble_auth_mac_t *mac, const ble_auth_key_t *key, const ble_auth_session_t *session);
+
+void ble_auth_mac_update(ble_auth_mac_t *mac, const uint8_t *data, size_t len);
+
+/**
+ * @brief Finaliza o HMAC e retorna a tag truncada
+ */
+void ble_auth_mac_finish(ble_auth_mac_t *mac, uint8_t tag[BLE_AUTH_TAG_LEN]);
+
+/**
+ * @brief Compara tags em tempo constante
+ */
+bool ble_auth_tag_equal(const uint8_t *a, const uint8_t *b);
+
+/**
+ * @brief Verifica um comando contíguo e avança o contador da sessão
+ *
+ * @param session Sessão da conexão
+ * @param key Chave do key_id em msg[0] (NULL ou inválida se não existe)
+ * @param msg Comando autenticado completo
+ * @param len Tamanho de msg
+ * @return BLE_AUTH_OK se autêntico; o comando está em
+ *         msg[BLE_AUTH_HDR_LEN .. len - BLE_AUTH_TAG_LEN)
+ */
+ble_auth_status_t ble_auth_verify(ble_auth_session_t *session, const ble_auth_key_t *key,
+                                  const uint8_t *msg, size_t len);
+
+/**
+ * @brief Gera o comando autenticado (lado do cliente, ferramentas e testes)
+ *
+ * @param out Recebe len + BLE_AUTH_OVERHEAD bytes
+ * @return Bytes escritos em out (0 se cap insuficiente)
+ */
+size_t ble_auth_sign(const ble_auth_key_t *key, const ble_auth_session_t *session, uint8_t key_id,
+                     uint32_t counter, const uint8_t *cmd, size_t len, uint8_t *out, size_t cap);
+
+#endif
@@ -0,0 +1,132 @@
+// components/ble_server/src/ble_cmd_proto.c
+#include "ble_cmd_proto.h"
+#include <string.h>
+
+int ble_cmd_table_init(ble_cmd_table_t *table, const ble_cmd_def_t *defs, size_t count, void *arg)
+{
+    if (table == NULL || (defs == NULL && count > 0) || count > BLE_CMD_MAX_DEFS)
+    {
+        return -1;
+    }
+
+    memset(table->index, 0, sizeof(table->index));
+    table->defs = defs;
+    table->arg = arg;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        uint8_t op = defs[i].opcode;
+
+        // Bit 0x80 identifica respostas; opcodes duplicados são erro de configuração
+        if ((op & BLE_CMD_RESP_FLAG) || table->index[op] != 0 || defs[i].handler == NULL)
+        {
+            memset(table->index, 0, sizeof(table->index));
+            return -1;
+        }
+        table->index[op] = (uint8_t)(i + 1);
+    }
+
+    return 0;
+}
+
+ble_cmd_status_t ble_cmd_frame_parse(const uint8_t *buf, size_t len, ble_cmd_frame_t *frame)
+{
+    if (buf == NULL || len < BLE_CMD_HDR_LEN)
+    {
+        return BLE_CMD_STATUS_BAD_FRAME;
+    }
+
+    uint16_t payload_len = (uint16_t)(buf[2] | (buf[3] << 8));
+
+    // Tamanho declarado precisa bater exatamente com o recebido
+    if ((size_t)payload_len + BLE_CMD_HDR_LEN != len || (buf[0] & BLE_CMD_RESP_FLAG))
+    {
+        return BLE_CMD_STATUS_BAD_FRAME;
+    }
+
+    frame->opcode = buf[0];
+    frame->seq = buf[1];
+    frame->len = payload_len;
+    frame->payload = buf + BLE_CMD_HDR_LEN;
+    return BLE_CMD_STATUS_OK;
+}
+
+bool ble_cmd_is_text(const uint8_t *buf, size_t len)
+{
+    if (buf == NULL || len == 0)
+    {
+        return false;
+    }
+
+    for (size_t i = 0; i < len; i++)
+    {
+        if (buf[i] < 0x20 || buf[i] > 0x7E)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+size_t ble_cmd_resp_bad_frame(const uint8_t *buf, size_t len, uint8_t *out, size_t cap)
+{
+    uint8_t opcode = (buf != NULL && len > 0) ? (buf[0] & ~BLE_CMD_RESP_FLAG) : 0;
+    uint8_t seq = (buf != NULL && len > 1) ? buf[1] : 0;
+
+    return ble_cmd_resp_encode(opcode, seq, BLE_CMD_STATUS_BAD_FRAME, NULL, 0, out, cap);
+}
+
+size_t ble_cmd_resp_encode(uint8_t opcode, uint8_t seq, uint8_t status,
+                           const uint8_t *payload, uint8_t len, uint8_t *out, size_t cap)
+{
+    if (out == NULL || cap < (size_t)BLE_CMD_RESP_HDR_LEN + len)
+    {
+        return 0;
+    }
+
+    out[0] = opcode | BLE_CMD_RESP_FLAG;
+    out[1] = seq;
+    out[2] = status;
+    out[3] = len;
+    if (len > 0)
+    {
+        memcpy(out + BLE_CMD_RESP_HDR_LEN, payload, len);
+    }
+
+    return BLE_CMD_RESP_HDR_LEN + len;
+}
+
+size_t ble_cmd_dispatch(const ble_cmd_table_t *table, const ble_cmd_frame_t *frame, uint8_t *out, size_t cap)
+{
+    ble_cmd_resp_t resp;
+    ble_cmd_status_t status;
+    uint8_t slot = table->index[frame->opcode];
+
+    resp.len = 0;
+
+    if (slot == 0)
+    {
+        status = BLE_CMD_STATUS_UNKNOWN_OPCODE;
+    }
+    else
+    {
+        const ble_cmd_def_t *def = &table->defs[slot - 1];
+
+        if (frame->len < def->min_len || frame->len > def->max_len)
+        {
+            status = BLE_CMD_STATUS_BAD_LENGTH;
+        }
+        else
+        {
+            status = def->handler(frame, &resp, table->arg);
+            if (resp.len > BLE_CMD_RESP_MAX_PAYLOAD)
+            {
+                resp.len = 0;
+                status = BLE_CMD_STATUS_FAILED;
+            }
+        }
+    }
+
+    return ble_cmd_resp_encode(frame->opcode, frame->seq, (uint8_t)status,
+                               resp.payload, resp.len, out, cap);
+}
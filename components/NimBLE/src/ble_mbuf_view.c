@@ -0,0 +1,179 @@
+// components/ble_server/src/ble_mbuf_view.c
+// Helpers para interpretar a cadeia os_mbuf de um write diretamente,
+// sem achatar em buffer na stack da task do host.
+#include "ble_mbuf_view.h"
+#include <string.h>
+
+// Localiza o segmento que contém o byte 'off'; devolve offset local
+static const struct os_mbuf *view_seek(const ble_mbuf_view_t *view, uint16_t off, uint16_t *local_off)
+{
+    const struct os_mbuf *om = view->om;
+
+    while (om != NULL && off >= om->om_len)
+    {
+        off -= om->om_len;
+        om = SLIST_NEXT(om, om_next);
+    }
+
+    *local_off = off;
+    return om;
+}
+
+void ble_mbuf_view_init(ble_mbuf_view_t *view, const struct os_mbuf *om)
+{
+    view->om = om;
+    view->len = om ? OS_MBUF_PKTLEN(om) : 0;
+}
+
+bool ble_mbuf_view_seg_first(const ble_mbuf_view_t *view, ble_mbuf_seg_t *seg)
+{
+    seg->om = view->om;
+    while (seg->om != NULL && seg->om->om_len == 0)
+    {
+        seg->om = SLIST_NEXT(seg->om, om_next);
+    }
+    if (seg->om == NULL)
+    {
+        return false;
+    }
+
+    seg->data = seg->om->om_data;
+    seg->len = seg->om->om_len;
+    return true;
+}
+
+bool ble_mbuf_view_seg_next(ble_mbuf_seg_t *seg)
+{
+    if (seg->om == NULL)
+    {
+        return false;
+    }
+
+    do
+    {
+        seg->om = SLIST_NEXT(seg->om, om_next);
+    } while (seg->om != NULL && seg->om->om_len == 0);
+
+    if (seg->om == NULL)
+    {
+        return false;
+    }
+
+    seg->data = seg->om->om_data;
+    seg->len = seg->om->om_len;
+    return true;
+}
+
+int ble_mbuf_view_byte(const ble_mbuf_view_t *view, uint16_t off)
+{
+    uint16_t local;
+
+    if (off >= view->len)
+    {
+        return -1;
+    }
+
+    const struct os_mbuf *om = view_seek(view, off, &local);
+    return om ? om->om_data[local] : -1;
+}
+
+const uint8_t *ble_mbuf_view_contig(const ble_mbuf_view_t *view, uint16_t off, uint16_t len)
+{
+    uint16_t local;
+
+    if ((uint32_t)off + len > view->len)
+    {
+        return NULL;
+    }
+
+    const struct os_mbuf *om = view_seek(view, off, &local);
+    if (om == NULL || (uint32_t)local + len > om->om_len)
+    {
+        return NULL;
+    }
+
+    return om->om_data + local;
+}
+
+bool ble_mbuf_view_read(const ble_mbuf_view_t *view, uint16_t off, void *dst, uint16_t len)
+{
+    uint8_t *out = dst;
+    uint16_t local;
+
+    if ((uint32_t)off + len > view->len)
+    {
+        return false;
+    }
+
+    const struct os_mbuf *om = view_seek(view, off, &local);
+    while (len > 0 && om != NULL)
+    {
+        uint16_t chunk = om->om_len - local;
+        if (chunk > len)
+            chunk = len;
+
+        memcpy(out, om->om_data + local, chunk);
+        out += chunk;
+        len -= chunk;
+        local = 0;
+        om = SLIST_NEXT(om, om_next);
+    }
+
+    return len == 0;
+}
+
+bool ble_mbuf_view_equals(const ble_mbuf_view_t *view, uint16_t off, const void *data, uint16_t len)
+{
+    const uint8_t *ref = data;
+    uint16_t local;
+
+    if ((uint32_t)off + len > view->len)
+    {
+        return false;
+    }
+
+    const struct os_mbuf *om = view_seek(view, off, &local);
+    while (len > 0 && om != NULL)
+    {
+        uint16_t chunk = om->om_len - local;
+        if (chunk > len)
+            chunk = len;
+
+        if (memcmp(om->om_data + local, ref, chunk) != 0)
+        {
+            return false;
+        }
+        ref += chunk;
+        len -= chunk;
+        local = 0;
+        om = SLIST_NEXT(om, om_next);
+    }
+
+    return len == 0;
+}
+
+bool ble_mbuf_view_get_u16le(const ble_mbuf_view_t *view, uint16_t off, uint16_t *out)
+{
+    uint8_t b[2];
+
+    if (!ble_mbuf_view_read(view, off, b, sizeof(b)))
+    {
+        return false;
+    }
+
+    *out = (uint16_t)(b[0] | (b[1] << 8));
+    return true;
+}
+
+bool ble_mbuf_view_get_u32le(const ble_mbuf_view_t *view, uint16_t off, uint32_t *out)
+{
+    uint8_t b[4];
+
+    if (!ble_mbuf_view_read(view, off, b, sizeof(b)))
+    {
+        return false;
+    }
+
+    *out = (uint32_t)b[0] | ((uint32_t)b[1] << 8) | ((uint32_t)b[2] << 16) | ((uint32_t)b[3] << 24);
+    return true;
+}
@@ -1,6 +1,8 @@
 // components/ble_server/src/ble_server.c
 #include "ble_server.h"
+#include "ble_server_priv.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 #include "nvs_flash.h"
 
 // NimBLE
@@ -13,269 +15,219 @@
 
 static const char *TAG = "BLE_SERVER";
 
-static void ble_app_advertise(void);
+// Armazenamento de bonds do NimBLE (store/config, sem header público)
+void ble_store_config_init(void);
 
-// ===== UUIDs (128-bit customizados) =====
-// Gerados com: uuidgen (Linux) ou online em uuidgenerator.net
+// Nova tentativa de sync após erro (dobra até o máximo)
+#define SYNC_RETRY_MS 50
+#define SYNC_RETRY_MAX_MS 1000
 
-// Service UUID: Lock Control Service
-//"12345678-5678-1234-7856-12349abcdef0"
-static const ble_uuid128_t gatt_svr_svc_uuid =
-    BLE_UUID128_INIT(
-        0x23, 0xd1, 0xbc, 0xea, 0x5f, 0x78, 0x23, 0x15,
-        0xde, 0xef, 0x12, 0x12, 0x23, 0x15, 0x00, 0x00);
-
-// Characteristic UUID: Command (Write)
-static const ble_uuid128_t gatt_svr_chr_cmd_uuid =
-    BLE_UUID128_INIT(
-        0x23, 0xd1, 0xbc, 0xea, 0x5f, 0x78, 0x23, 0x15,
-        0xde, 0xef, 0x12, 0x12, 0x25, 0x15, 0x00, 0x00);
-
-// Characteristic UUID: Status (Read + Notify)
-static const ble_uuid128_t gatt_svr_chr_status_uuid =
-    BLE_UUID128_INIT(
-        0x23, 0xd1, 0xbc, 0xea, 0x5f, 0x78, 0x23, 0x15,
-        0xde, 0xef, 0x12, 0x12, 0x24, 0x15, 0x00, 0x00);
+// ===== Estado do Servidor =====
+ble_server_config_t server_config;
 
-static const ble_uuid128_t gatt_svr_chr_datetime_uuid =
-    BLE_UUID128_INIT(
-        0x23, 0xd1, 0xbc, 0xea, 0x5f, 0x78, 0x23, 0x15,
-        0xde, 0xef, 0x12, 0x12, 0x26, 0x15, 0x00, 0x00);
+// Recuperação após reset do host (task do host)
+static struct ble_npl_callout sync_retry;
+static uint32_t sync_retry_ms;
+static int64_t init_at;
+static int64_t reset_at; // 0 = nenhum reset aguardando advertising
+static ble_server_reset_stats_t reset_stats;
 
-// ===== Estado do Servidor =====
-static uint16_t conn_handle = BLE_HS_CONN_HANDLE_NONE;
-static uint16_t status_val_handle;  // Handle da characteristic Status
-static uint32_t current_status = 0; // Valor atual do status
-static ble_server_config_t server_config;
-
-// ===== Callback: Acesso a Characteristic (Read/Write) =====
-static int gatt_svr_chr_access(uint16_t conn_handle, uint16_t attr_handle,
-                               struct ble_gatt_access_ctxt *ctxt, void *arg)
+// ===== Callback: Eventos GAP (Conexão/Desconexão) =====
+int ble_server_gap_event(struct ble_gap_event *event, void *arg)
 {
-    const ble_uuid_t *uuid = ctxt->chr->uuid;
-    int rc = 0;
+    ble_server_trace_gap(event);
 
-    // Characteristic: Command (Write)
-    if (ble_uuid_cmp(uuid, &gatt_svr_chr_cmd_uuid.u) == 0)
+    switch (event->type)
     {
-        switch (ctxt->op)
-        {
-        case BLE_GATT_ACCESS_OP_WRITE_CHR:
-            ESP_LOGI(TAG, "Write recebido: %d bytes", ctxt->om->om_len);
-
-            // Copia dados recebidos
-            uint8_t data[512];
-            uint16_t len = ctxt->om->om_len;
-            if (len > sizeof(data))
-                len = sizeof(data);
+    case BLE_GAP_EVENT_CONNECT:
+        ESP_LOGI(TAG, "Cliente conectado: handle=%d, status=%d",
+                 event->connect.conn_handle, event->connect.status);
 
-            ble_hs_mbuf_to_flat(ctxt->om, data, len, NULL);
+        if (event->connect.status == 0)
+        {
+            ble_server_conn_add(event->connect.conn_handle);
+            ble_server_txq_conn_open(event->connect.conn_handle);
+            ble_server_policy_on_connect(event->connect.conn_handle);
+            ble_server_conn_refresh_security(event->connect.conn_handle);
 
-            // Chama callback da aplicação
-            if (server_config.on_write)
+            if (server_config.on_connect)
             {
-                server_config.on_write(data, len);
+                int64_t cb_at = ble_server_probe_now();
+                server_config.on_connect(event->connect.conn_handle);
+                ble_server_trace_end(BLE_SERVER_TRACE_APP_CB, BLE_SERVER_TRACE_CB_CONNECT,
+                                     event->connect.conn_handle, cb_at, 0);
             }
+        }
 
-            return 0;
+        // Advertising para ao conectar: retoma enquanto houver slots livres
+        ble_server_adv_on_connect(event->connect.status);
+        return 0;
 
-        default:
-            ESP_LOGW(TAG, "Operação não suportada: %d", ctxt->op);
-            return BLE_ATT_ERR_UNLIKELY;
+    case BLE_GAP_EVENT_DISCONNECT:
+        ESP_LOGI(TAG, "Cliente desconectado: handle=%d, reason=%d",
+                 event->disconnect.conn.conn_handle, event->disconnect.reason);
+
+        ble_server_conn_remove(event->disconnect.conn.conn_handle);
+        ble_server_txq_conn_close(event->disconnect.conn.conn_handle);
+        ble_server_policy_on_disconnect(event->disconnect.conn.conn_handle);
+        ble_server_longwr_conn_close(event->disconnect.conn.conn_handle);
+        ble_server_auth_conn_close(event->disconnect.conn.conn_handle);
+        ble_server_diag_conn_close(event->disconnect.conn.conn_handle);
+
+        // Relatório do pipeline para dimensionar a fila
+        ble_server_cmd_stats_t cmd_stats;
+        if (ble_server_get_cmd_stats(&cmd_stats) == ESP_OK)
+        {
+            ESP_LOGI(TAG, "Comandos: exec=%lu, descartados=%lu, fila máx=%lu, "
+                          "espera méd/máx=%lu/%lu us, exec méd/máx=%lu/%lu us",
+                     cmd_stats.executed, cmd_stats.dropped, cmd_stats.depth_max,
+                     cmd_stats.wait_us_avg, cmd_stats.wait_us_max,
+                     cmd_stats.exec_us_avg, cmd_stats.exec_us_max);
         }
-    }
 
-    // Characteristic: Status (Read + Notify)
-    if (ble_uuid_cmp(uuid, &gatt_svr_chr_status_uuid.u) == 0)
-    {
-        switch (ctxt->op)
+        if (server_config.on_disconnect)
         {
-        case BLE_GATT_ACCESS_OP_READ_CHR:
-            ESP_LOGI(TAG, "Read solicitado: status = %lu", current_status);
-
-            rc = os_mbuf_append(ctxt->om, &current_status, sizeof(current_status));
-            return rc == 0 ? 0 : BLE_ATT_ERR_INSUFFICIENT_RES;
-
-        default:
-            ESP_LOGW(TAG, "Operação não suportada: %d", ctxt->op);
-            return BLE_ATT_ERR_UNLIKELY;
+            int64_t cb_at = ble_server_probe_now();
+            server_config.on_disconnect(event->disconnect.conn.conn_handle);
+            ble_server_trace_end(BLE_SERVER_TRACE_APP_CB, BLE_SERVER_TRACE_CB_DISCONNECT,
+                                 event->disconnect.conn.conn_handle, cb_at, 0);
         }
-    }
-    if (ble_uuid_cmp(uuid, &gatt_svr_chr_datetime_uuid.u) == 0)
-    {
-        if (ctxt->op == BLE_GATT_ACCESS_OP_WRITE_CHR)
-        {
-            uint8_t data[7];
-            uint16_t len = ctxt->om->om_len;
 
-            if (len == 7)
-            {
-                ble_hs_mbuf_to_flat(ctxt->om, data, len, NULL);
-                ESP_LOGI(TAG, "Data/Hora: %02d/%02d/20%02d %02d:%02d:%02d",
-                         data[2], data[1], data[0], data[3], data[4], data[5]);
+        // Retoma advertising para reconexão (direcionado se o par tem bond)
+        ble_server_adv_on_disconnect(&event->disconnect.conn);
+        return 0;
 
-                // Aqui você pode chamar uma função para atualizar o relógio (RTC)
-                return 0;
-            }
-            else
-            {
-                return BLE_ATT_ERR_INVALID_ATTR_VALUE_LEN;
-            }
+    case BLE_GAP_EVENT_ADV_COMPLETE:
+        ESP_LOGI(TAG, "Advertising encerrado: reason=%d", event->adv_complete.reason);
+#if CONFIG_BT_NIMBLE_EXT_ADV
+        // Set de broadcast roda sem duração: só o conectável é agendado
+        if (event->adv_complete.instance != BLE_SERVER_ADV_INSTANCE_CONN)
+        {
+            return 0;
         }
-    }
-
-    return BLE_ATT_ERR_UNLIKELY;
-}
+#endif
+        ble_server_adv_on_complete(event->adv_complete.reason);
+        return 0;
 
-// ===== Definição dos Serviços GATT =====
-static const struct ble_gatt_svc_def gatt_svr_svcs[] = {
-    {
-        // Serviço: Lock Control
-        .type = BLE_GATT_SVC_TYPE_PRIMARY,
-        .uuid = &gatt_svr_svc_uuid.u,
-        .characteristics = (struct ble_gatt_chr_def[]){
-            {
-                // Characteristic: Command (Write)
-                .uuid = &gatt_svr_chr_cmd_uuid.u,
-                .access_cb = gatt_svr_chr_access,
-                .flags = BLE_GATT_CHR_F_WRITE | BLE_GATT_CHR_F_WRITE_NO_RSP,
-            },
-            {
-                // Characteristic: Status (Read + Notify)
-                .uuid = &gatt_svr_chr_status_uuid.u,
-                .access_cb = gatt_svr_chr_access,
-                .val_handle = &status_val_handle,
-                .flags = BLE_GATT_CHR_F_READ | BLE_GATT_CHR_F_NOTIFY,
-            },
-            {
-                // Characteristic: Data e Hora (Write)
-                .uuid = &gatt_svr_chr_datetime_uuid.u,
-                .access_cb = gatt_svr_chr_access,
-                .flags = BLE_GATT_CHR_F_WRITE,
-            },
-            {
-                0, // Fim da lista de características
-            }},
-    },
-    {
-        0, // Fim da lista de serviços
-    },
-};
+    case BLE_GAP_EVENT_MTU:
+        ESP_LOGI(TAG, "MTU atualizado: conn=%d, mtu=%d",
+                 event->mtu.conn_handle, event->mtu.value);
+        ble_server_conn_set_mtu(event->mtu.conn_handle, event->mtu.value);
+        ble_server_coalesce_on_mtu_change();
+        return 0;
 
-// ===== Callback: Eventos GAP (Conexão/Desconexão) =====
-static int ble_gap_event(struct ble_gap_event *event, void *arg)
-{
-    switch (event->type)
+    case BLE_GAP_EVENT_CONN_UPDATE:
     {
-    case BLE_GAP_EVENT_CONNECT:
-        ESP_LOGI(TAG, "Cliente conectado: handle=%d, status=%d",
-                 event->connect.conn_handle, event->connect.status);
-
-        if (event->connect.status == 0)
+        struct ble_gap_conn_desc desc;
+        if (event->conn_update.status == 0 &&
+            ble_gap_conn_find(event->conn_update.conn_handle, &desc) == 0)
         {
-            conn_handle = event->connect.conn_handle;
-
-            if (server_config.on_connect)
-            {
-                server_config.on_connect(conn_handle);
-            }
-        }
-        else
-        {
-            // Falha na conexão, retoma advertising
-            ble_gap_adv_start(BLE_OWN_ADDR_PUBLIC, NULL, BLE_HS_FOREVER,
-                              NULL, ble_gap_event, NULL);
+            ESP_LOGI(TAG, "Parâmetros de conexão: conn=%d, itvl=%d, latency=%d, timeout=%d",
+                     event->conn_update.conn_handle, desc.conn_itvl,
+                     desc.conn_latency, desc.supervision_timeout);
         }
         return 0;
+    }
 
-    case BLE_GAP_EVENT_DISCONNECT:
-        ESP_LOGI(TAG, "Cliente desconectado: reason=%d",
-                 event->disconnect.reason);
+    case BLE_GAP_EVENT_PHY_UPDATE_COMPLETE:
+        ESP_LOGI(TAG, "PHY atualizado: conn=%d, status=%d, tx=%d, rx=%d",
+                 event->phy_updated.conn_handle, event->phy_updated.status,
+                 event->phy_updated.tx_phy, event->phy_updated.rx_phy);
+        return 0;
 
-        conn_handle = BLE_HS_CONN_HANDLE_NONE;
+    case BLE_GAP_EVENT_NOTIFY_TX:
+        // Buffers podem ter sido liberados: continua drenando a fila
+        ble_server_txq_kick();
+        return 0;
 
-        if (server_config.on_disconnect)
+    case BLE_GAP_EVENT_ENC_CHANGE:
+        ESP_LOGI(TAG, "Criptografia alterada: conn=%d, status=%d",
+                 event->enc_change.conn_handle, event->enc_change.status);
+        if (event->enc_change.status == 0)
         {
-            server_config.on_disconnect();
-        }
+            ble_server_conn_refresh_security(event->enc_change.conn_handle);
 
-        // Retoma advertising
-        ble_app_advertise();
+            // Novo bond pode ter sido gravado: accept list precisa incluí-lo
+            ble_server_adv_on_bonds_changed();
+        }
         return 0;
 
-    case BLE_GAP_EVENT_MTU:
-        ESP_LOGI(TAG, "MTU atualizado: %d", event->mtu.value);
-        return 0;
+    case BLE_GAP_EVENT_REPEAT_PAIRING:
+    {
+        // Par perdeu o bond (celular apagou): descarta o antigo e pareia de novo
+        struct ble_gap_conn_desc desc;
+        if (ble_gap_conn_find(event->repeat_pairing.conn_handle, &desc) == 0)
+        {
+            ESP_LOGI(TAG, "Pareamento repetido: conn=%d, apagando bond antigo",
+                     event->repeat_pairing.conn_handle);
+            ble_store_util_delete_peer(&desc.peer_id_addr);
+            ble_server_adv_on_bonds_changed();
+        }
+        return BLE_GAP_REPEAT_PAIRING_RETRY;
+    }
 
     case BLE_GAP_EVENT_SUBSCRIBE:
         ESP_LOGI(TAG, "Notificações %s: conn=%d, attr=%d",
                  event->subscribe.cur_notify ? "habilitadas" : "desabilitadas",
                  event->subscribe.conn_handle,
                  event->subscribe.attr_handle);
+
+        if (event->subscribe.attr_handle == status_val_handle)
+        {
+            ble_server_conn_set_subscribed(event->subscribe.conn_handle,
+                                           event->subscribe.cur_notify);
+
+            // Novo inscrito pode ter MTU menor que o da janela em andamento
+            ble_server_coalesce_on_mtu_change();
+        }
         return 0;
     }
 
     return 0;
 }
 
-// ===== Inicialização do Advertising =====
-static void ble_app_advertise(void)
+// ===== Callback: Reset do host/controlador =====
+static void ble_app_on_reset(int reason)
 {
-    struct ble_gap_adv_params adv_params = {0};
-    struct ble_hs_adv_fields fields = {0};
-    struct ble_hs_adv_fields rsp_fields = {0};
-    int rc;
+    ESP_LOGW(TAG, "Reset do host BLE: reason=%d", reason);
 
-    // === PACOTE 1: ADVERTISING (Obrigatório, pequeno) ===
-    // Aqui colocamos o UUID para o app achar a fechadura rápido
-    fields.flags = BLE_HS_ADV_F_DISC_GEN | BLE_HS_ADV_F_BREDR_UNSUP;
+    reset_stats.resets++;
+    reset_stats.last_reason = reason;
+    reset_at = esp_timer_get_time();
+    ble_server_trace(BLE_SERVER_TRACE_RESET, 0, 0xFFFF, (uint32_t)reason);
 
-    fields.uuids128 = &gatt_svr_svc_uuid;
-    fields.num_uuids128 = 1;
-    fields.uuids128_is_complete = 0; // Lista completa de UUIDs de 128 bits
-
-    rc = ble_gap_adv_set_fields(&fields);
-    if (rc != 0)
-    {
-        ESP_LOGE(TAG, "Erro ao configurar dados de advertising: %d", rc);
-        return;
-    }
+    // Conexões já foram encerradas pelo host (eventos de desconexão)
+    ble_npl_callout_stop(&sync_retry);
+    ble_server_adv_on_reset();
+    ble_server_bcast_on_reset();
+}
 
-    // === PACOTE 2: SCAN RESPONSE (Opcional, solicitado pelo celular) ===
-    // Aqui colocamos o Nome, que pode ser longo
-    rsp_fields.name = (uint8_t *)server_config.device_name;
-    rsp_fields.name_len = strlen(server_config.device_name);
-    rsp_fields.name_is_complete = 1;
+// Advertising voltou: fecha as medições de boot/recuperação
+static void sync_measure_adv(void)
+{
+    ble_server_adv_stats_t adv_stats;
 
-    rc = ble_gap_adv_rsp_set_fields(&rsp_fields);
-    if (rc != 0)
+    if (ble_server_get_adv_stats(&adv_stats) != ESP_OK || !adv_stats.advertising)
     {
-        ESP_LOGE(TAG, "Erro ao configurar dados de scan response: %d", rc);
         return;
     }
 
-    // === INICIAR O ADVERTISING ===
-    adv_params.conn_mode = BLE_GAP_CONN_MODE_UND;
-    adv_params.disc_mode = BLE_GAP_DISC_MODE_GEN;
-
-    // MELHORIA DE VELOCIDADE:
-    // O valor é em unidades de 0.625ms.
-    // Mínimo: 32 * 0.625 = 20ms
-    // Máximo: 48 * 0.625 = 30ms
-    // Isso faz a ESP32 anunciar MUITO rápido.
-    adv_params.itvl_min = 32;
-    adv_params.itvl_max = 48;
-
-    rc = ble_gap_adv_start(BLE_OWN_ADDR_PUBLIC, NULL, BLE_HS_FOREVER,
-                           &adv_params, ble_gap_event, NULL);
-
-    if (rc != 0)
+    int64_t now = esp_timer_get_time();
+    if (reset_stats.syncs == 1)
     {
-        ESP_LOGE(TAG, "Erro ao iniciar advertising: %d", rc);
-        return;
+        reset_stats.boot_adv_ms = (uint32_t)((now - init_at) / 1000);
+        ESP_LOGI(TAG, "Anunciando %lu ms após ble_server_init()", reset_stats.boot_adv_ms);
     }
+    if (reset_at != 0)
+    {
+        uint32_t ms = (uint32_t)((now - reset_at) / 1000);
 
-    ESP_LOGI(TAG, "Advertising iniciado com sucesso: '%s'", server_config.device_name);
+        reset_stats.recover_ms_last = ms;
+        if (ms > reset_stats.recover_ms_max)
+            reset_stats.recover_ms_max = ms;
+        reset_at = 0;
+        ESP_LOGI(TAG, "Recuperado do reset: anunciando %lu ms depois", ms);
+    }
 }
 
 // ===== Callback: Stack BLE sincronizado =====
@@ -290,9 +242,17 @@ static void ble_app_on_sync(void)
     rc = ble_hs_id_infer_auto(0, &own_addr_type);
     if (rc != 0)
     {
-        ESP_LOGE(TAG, "Erro ao inferir tipo de endereço: %d", rc);
+        // Tenta de novo em vez de ficar sem advertising até reiniciar
+        sync_retry_ms = sync_retry_ms ? sync_retry_ms * 2 : SYNC_RETRY_MS;
+        if (sync_retry_ms > SYNC_RETRY_MAX_MS)
+            sync_retry_ms = SYNC_RETRY_MAX_MS;
+        reset_stats.sync_retries++;
+        ESP_LOGE(TAG, "Erro ao inferir tipo de endereço: %d, nova tentativa em %lu ms", rc, sync_retry_ms);
+        ble_npl_callout_reset(&sync_retry, ble_npl_time_ms_to_ticks32(sync_retry_ms));
         return;
     }
+    sync_retry_ms = 0;
+    reset_stats.syncs++;
 
     // (Opcional) Usar o tipo inferido se quiser garantir o match
     // Mas geralmente para addr público, o código abaixo já funciona:
@@ -305,7 +265,19 @@ static void ble_app_on_sync(void)
                  addr[5], addr[4], addr[3], addr[2], addr[1], addr[0]);
     }
 
-    ble_app_advertise();
+    // Rajada rápida após o boot (ou reset): payloads e sets são reenviados
+    ble_server_adv_on_sync();
+    ble_server_adv_start(BLE_SERVER_ADV_FAST);
+    ble_server_bcast_on_sync();
+    sync_measure_adv();
+}
+
+static void sync_retry_cb(struct ble_npl_event *ev)
+{
+    if (ble_hs_synced())
+    {
+        ble_app_on_sync();
+    }
 }
 
 // ===== Task do NimBLE =====
@@ -325,8 +297,30 @@ esp_err_t ble_server_init(const ble_server_config_t *config)
         return ESP_ERR_INVALID_ARG;
     }
 
+    // on_write_view roda na task do host, sobre o mbuf: não há o que enfileirar
+    if (config->on_write_view && config->async_commands)
+    {
+        ESP_LOGE(TAG, "on_write_view não combina com async_commands");
+        return ESP_ERR_INVALID_ARG;
+    }
+
     // Copia configuração
     server_config = *config;
+    init_at = esp_timer_get_time();
+    ble_server_conn_reset();
+
+    // Pipeline de comandos precisa existir antes do primeiro write
+    esp_err_t err = ble_server_cmd_init();
+    if (err != ESP_OK)
+    {
+        return err;
+    }
+
+    err = ble_server_coalesce_init();
+    if (err != ESP_OK)
+    {
+        return err;
+    }
 
     // Inicializa NVS (necessário para BLE)
     esp_err_t ret = nvs_flash_init();
@@ -339,15 +333,30 @@ esp_err_t ble_server_init(const ble_server_config_t *config)
 
     // Inicializa NimBLE
     ESP_ERROR_CHECK(nimble_port_init());
+    ble_server_txq_init();
+    ble_server_policy_init();
+    ble_server_adv_init();
+    ble_server_bcast_init();
+    ble_npl_callout_init(&sync_retry, nimble_port_get_dflt_eventq(), sync_retry_cb, NULL);
 
     // Configura callbacks
     ble_hs_cfg.sync_cb = ble_app_on_sync;
-    ble_hs_cfg.reset_cb = NULL; // Poderia adicionar handler de reset
+    ble_hs_cfg.reset_cb = ble_app_on_reset;
+
+    // Bonds persistidos em NVS (CONFIG_BT_NIMBLE_NVS_PERSIST): celulares
+    // conhecidos reconectam sem novo pareamento após reiniciar
+    ble_hs_cfg.store_status_cb = ble_store_util_status_rr;
+    ble_hs_cfg.sm_bonding = 1;
+    ble_hs_cfg.sm_sc = 1;
+    ble_hs_cfg.sm_our_key_dist = BLE_SM_PAIR_KEY_DIST_ENC | BLE_SM_PAIR_KEY_DIST_ID;
+    ble_hs_cfg.sm_their_key_dist = BLE_SM_PAIR_KEY_DIST_ENC | BLE_SM_PAIR_KEY_DIST_ID;
+    ble_store_config_init();
 
     // Configura nome do dispositivo
     ble_svc_gap_device_name_set(server_config.device_name);
 
-    // Registra serviços GATT
+    // Registra serviços GATT (internos + registrados pela aplicação)
+    const struct ble_gatt_svc_def *gatt_svr_svcs = ble_server_gatt_build();
     int rc = ble_gatts_count_cfg(gatt_svr_svcs);
     if (rc != 0)
     {
@@ -362,6 +371,13 @@ esp_err_t ble_server_init(const ble_server_config_t *config)
         return ESP_FAIL;
     }
 
+    // Canal bulk L2CAP (opcional)
+    err = ble_server_bulk_init();
+    if (err != ESP_OK)
+    {
+        return err;
+    }
+
     // Inicia serviço GAP padrão
     ble_svc_gap_init();
 
@@ -375,43 +391,68 @@ esp_err_t ble_server_init(const ble_server_config_t *config)
     return ESP_OK;
 }
 
-esp_err_t ble_server_notify(uint8_t *data, uint16_t len)
+esp_err_t ble_server_get_reset_stats(ble_server_reset_stats_t *out)
 {
-    if (conn_handle == BLE_HS_CONN_HANDLE_NONE)
+    if (out == NULL)
     {
-        ESP_LOGW(TAG, "Nenhum cliente conectado");
-        return ESP_ERR_INVALID_STATE;
+        return ESP_ERR_INVALID_ARG;
     }
 
+    *out = reset_stats;
+    return ESP_OK;
+}
+
+esp_err_t ble_server_notify(uint8_t *data, uint16_t len)
+{
+    uint16_t handles[BLE_SERVER_MAX_CONNS];
+    int sent = 0;
+
     if (len > 512)
     {
         ESP_LOGE(TAG, "Dados muito grandes: %d bytes (máx 512)", len);
         return ESP_ERR_INVALID_SIZE;
     }
 
-    // Cria mbuf com os dados
-    struct os_mbuf *om = ble_hs_mbuf_from_flat(data, len);
-    if (om == NULL)
+    // Caminho normal: fila por conexão com controle de fluxo
+    if (len <= CONFIG_BLE_SERVER_TXQ_SLOT_SIZE)
     {
-        ESP_LOGE(TAG, "Erro ao alocar mbuf");
-        return ESP_ERR_NO_MEM;
+        return ble_server_notify_enqueue(BLE_SERVER_NOTIFY_ALL, data, len, NULL, NULL);
     }
 
-    // Envia notificação
-    int rc = ble_gattc_notify_custom(conn_handle, status_val_handle, om);
-    if (rc != 0)
+    // Apenas clientes que habilitaram notificações (CCCD)
+    int count = ble_server_conn_subscribers(handles, BLE_SERVER_MAX_CONNS);
+    if (count == 0)
     {
-        ESP_LOGE(TAG, "Erro ao enviar notificação: %d", rc);
-        return ESP_FAIL;
+        ESP_LOGW(TAG, "Nenhum cliente inscrito");
+        return ESP_ERR_INVALID_STATE;
     }
 
-    ESP_LOGD(TAG, "Notificação enviada: %d bytes", len);
-    return ESP_OK;
-}
+    for (int i = 0; i < count; i++)
+    {
+        // Cada envio consome o mbuf, então um por cliente
+        struct os_mbuf *om = ble_hs_mbuf_from_flat(data, len);
+        if (om == NULL)
+        {
+            ESP_LOGE(TAG, "Erro ao alocar mbuf");
+            ble_server_conn_on_tx(handles[i], false);
+            continue;
+        }
 
-esp_err_t ble_server_update_read_value(uint32_t value)
-{
-    current_status = value;
-    ESP_LOGD(TAG, "Valor de leitura atualizado: %lu", value);
-    return ESP_OK;
-}
\ No newline at end of file
+        int64_t tx_at = ble_server_probe_now();
+        int rc = ble_gattc_notify_custom(handles[i], status_val_handle, om);
+        ble_server_trace_end(BLE_SERVER_TRACE_NOTIFY, 1, handles[i], tx_at, rc);
+        if (rc != 0)
+        {
+            ESP_LOGE(TAG, "Erro ao enviar notificação: conn=%d, rc=%d", handles[i], rc);
+            ble_server_conn_on_tx(handles[i], false);
+            continue;
+        }
+
+        ble_server_conn_on_tx(handles[i], true);
+        ble_server_diag_on_notify(handles[i]);
+        sent++;
+    }
+
+    ESP_LOGD(TAG, "Notificação enviada: %d bytes para %d/%d clientes", len, sent, count);
+    return sent > 0 ? ESP_OK : ESP_FAIL;
+}
@@ -0,0 +1,783 @@
+// components/ble_server/src/ble_server_adv.c
+// Agendador de advertising por perfis. Rajada rápida após o boot, após uma
+// desconexão ou a pedido da aplicação; depois desce para intervalos mais
+// longos quando a duração do perfil expira (BLE_GAP_EVENT_ADV_COMPLETE).
+// Uma conexão no meio do perfil não renova a duração: o advertising volta
+// com o tempo que faltava, ou já no perfil seguinte.
+// Os payloads são codificados uma vez; o estado da fechadura vai no
+// manufacturer data para leitura passiva por scan, sem conexão.
+// Após desconectar um par com bond, tenta primeiro advertising direcionado
+// de alto duty cycle para ele. Com CONFIG_BLE_SERVER_ADV_ACCEPT_LIST os
+// perfis médio e lento aceitam apenas pares com bond (accept list).
+// Anunciamos com endereço público e sem lista de resolução: um par cujo bond
+// traz IRK (celulares usam endereço privado resolvível) não responde ao
+// direcionado nem casa com o endereço de identidade na accept list, então
+// fica fora dos dois.
+// Contabiliza o tempo em cada perfil e estima o duty cycle do rádio para
+// comparar latência de conexão contra consumo.
+#include "ble_server_priv.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "nimble/nimble_port.h"
+#include "host/ble_store.h"
+#include <string.h>
+
+static const char *TAG = "BLE_ADV";
+
+// Manufacturer data: [company id LE][state][change count LE][bateria]
+// 0xFFFF = company id reservado para testes/uso interno
+#define ADV_MFG_COMPANY_ID 0xFFFF
+#define ADV_MFG_DATA_LEN 6
+#define ADV_MFG_OFF_STATE 2
+#define ADV_MFG_OFF_COUNT 3
+#define ADV_MFG_OFF_BATTERY 5
+#define ADV_BATTERY_UNKNOWN 0xFF
+
+// Estimativa de rádio por evento: 3 canais x (PDU de 31 bytes em 1M = 376 us
+// + ~200 us de escuta por SCAN_REQ/CONNECT_IND)
+#define ADV_EVENT_RADIO_US (3 * (376 + 200))
+// advDelay aleatório de 0-10 ms somado a cada evento (média 5 ms)
+#define ADV_DELAY_AVG_US 5000
+
+typedef struct
+{
+    uint16_t itvl;        // Unidades de 0,625 ms
+    uint32_t duration_ms; // 0 = até conectar
+    const char *name;
+} adv_profile_def_t;
+
+// Direcionado de alto duty cycle: eventos a cada <= 3,75 ms, limitado a 1,28 s
+// pelo controlador
+#define ADV_DIRECTED_ITVL 6
+#define ADV_DIRECTED_DURATION_MS 1280
+
+// Menor sobra de duração retomada após uma conexão (granularidade do set
+// estendido); abaixo disso o agendador já desce de perfil
+#define ADV_RESUME_MIN_MS 10
+
+static const adv_profile_def_t profiles[BLE_SERVER_ADV_PROFILE_COUNT] = {
+    [BLE_SERVER_ADV_DIRECTED] = {ADV_DIRECTED_ITVL, ADV_DIRECTED_DURATION_MS, "direcionado"},
+    [BLE_SERVER_ADV_FAST] = {CONFIG_BLE_SERVER_ADV_FAST_ITVL, CONFIG_BLE_SERVER_ADV_FAST_DURATION_MS, "rápido"},
+    [BLE_SERVER_ADV_MEDIUM] = {CONFIG_BLE_SERVER_ADV_MEDIUM_ITVL, CONFIG_BLE_SERVER_ADV_MEDIUM_DURATION_MS, "médio"},
+    [BLE_SERVER_ADV_SLOW] = {CONFIG_BLE_SERVER_ADV_SLOW_ITVL, 0, "lento"},
+};
+
+static struct
+{
+    bool active;
+    ble_server_adv_profile_t profile;
+    int64_t started_at;
+    int64_t ends_at;   // Fim da duração do perfil (0 = até conectar)
+    int64_t window_at; // Gatilho da janela atual (boot, desconexão, pedido)
+} adv_state;
+
+// Último par com bond desconectado (alvo do advertising direcionado)
+static ble_addr_t direct_peer;
+static bool direct_peer_valid;
+
+// Accept list com os pares com bond (recarregada com o advertising parado).
+// 0 = sem filtro, inclusive quando algum bond tem IRK
+static bool accept_list_dirty = true;
+#if CONFIG_BLE_SERVER_ADV_ACCEPT_LIST
+static int bonded_count;
+#endif
+
+static uint32_t window_connects;
+static uint64_t window_connect_ms_total;
+static uint32_t window_connect_ms_max;
+static uint32_t directed_connects;
+
+static uint64_t profile_us[BLE_SERVER_ADV_PROFILE_COUNT];
+static uint64_t radio_us;
+static uint32_t events_est;
+static uint32_t fast_requests;
+static int64_t init_at;
+static portMUX_TYPE adv_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static struct ble_npl_event fast_ev;
+
+// Payloads codificados uma vez em ble_server_adv_init(); depois apenas os
+// bytes do manufacturer data são alterados no lugar
+static uint8_t adv_buf[BLE_HS_ADV_MAX_SZ];
+static uint8_t adv_len;
+static uint8_t *adv_mfg; // Início do manufacturer data dentro de adv_buf
+static uint8_t rsp_buf[BLE_HS_ADV_MAX_SZ];
+static uint8_t rsp_len;
+static bool adv_dirty;   // adv_buf mudou desde o último envio ao controlador
+static bool rsp_dirty;
+static struct ble_npl_event data_ev;
+
+// Acrescenta um campo AD [len][type][dados]; retorna o início dos dados
+static uint8_t *adv_put_field(uint8_t *buf, uint8_t *len, uint8_t type, const void *data, uint8_t data_len)
+{
+    uint8_t *dst = &buf[*len + 2];
+
+    buf[*len] = data_len + 1;
+    buf[*len + 1] = type;
+    if (data)
+    {
+        memcpy(dst, data, data_len);
+    }
+    *len += data_len + 2;
+    return dst;
+}
+
+static void adv_build_payloads(void)
+{
+    uint8_t flags = BLE_HS_ADV_F_DISC_GEN | BLE_HS_ADV_F_BREDR_UNSUP;
+    ble_server_status_t status;
+    ble_server_get_status(&status);
+
+    uint8_t mfg[ADV_MFG_DATA_LEN] = {
+        ADV_MFG_COMPANY_ID & 0xFF, ADV_MFG_COMPANY_ID >> 8,
+        (uint8_t)status.state, status.change_count & 0xFF, (status.change_count >> 8) & 0xFF,
+        ADV_BATTERY_UNKNOWN};
+
+    // === PACOTE 1: ADVERTISING (Obrigatório, pequeno) ===
+    // UUID para o app achar a fechadura rápido + estado para leitura passiva
+    adv_len = 0;
+    adv_put_field(adv_buf, &adv_len, BLE_HS_ADV_TYPE_FLAGS, &flags, 1);
+    adv_put_field(adv_buf, &adv_len, BLE_HS_ADV_TYPE_INCOMP_UUIDS128, gatt_svr_svc_uuid.value, 16);
+    adv_mfg = adv_put_field(adv_buf, &adv_len, BLE_HS_ADV_TYPE_MFG_DATA, mfg, sizeof(mfg));
+
+    // === PACOTE 2: SCAN RESPONSE (Opcional, solicitado pelo celular) ===
+    // Nome, abreviado se não couber
+    size_t name_len = strlen(server_config.device_name);
+    uint8_t name_type = BLE_HS_ADV_TYPE_COMP_NAME;
+    if (name_len > BLE_HS_ADV_MAX_SZ - 2)
+    {
+        name_len = BLE_HS_ADV_MAX_SZ - 2;
+        name_type = BLE_HS_ADV_TYPE_INCOMP_NAME;
+    }
+    rsp_len = 0;
+    adv_put_field(rsp_buf, &rsp_len, name_type, server_config.device_name, name_len);
+
+    adv_dirty = true;
+    rsp_dirty = true;
+}
+
+// ===== Acesso ao controlador =====
+// Com CONFIG_BT_NIMBLE_EXT_ADV as funções ble_gap_adv_* não existem: o set
+// conectável passa a ser a instância 0, ainda com PDUs legados para que
+// qualquer celular o encontre. A instância 1 fica com o broadcast de eventos
+// (ble_server_bcast.c).
+#if CONFIG_BT_NIMBLE_EXT_ADV
+
+static bool adv_hw_active(void)
+{
+    return ble_gap_ext_adv_active(BLE_SERVER_ADV_INSTANCE_CONN);
+}
+
+static int adv_hw_stop(void)
+{
+    return ble_gap_ext_adv_stop(BLE_SERVER_ADV_INSTANCE_CONN);
+}
+
+static int adv_hw_set_data(const uint8_t *data, uint8_t len, bool rsp)
+{
+    struct os_mbuf *om = os_msys_get_pkthdr(len, 0);
+    if (om == NULL)
+    {
+        return BLE_HS_ENOMEM;
+    }
+    if (os_mbuf_append(om, data, len) != 0)
+    {
+        os_mbuf_free_chain(om);
+        return BLE_HS_ENOMEM;
+    }
+
+    // O mbuf é consumido mesmo em caso de erro
+    return rsp ? ble_gap_ext_adv_rsp_set_data(BLE_SERVER_ADV_INSTANCE_CONN, om)
+               : ble_gap_ext_adv_set_data(BLE_SERVER_ADV_INSTANCE_CONN, om);
+}
+
+#else
+
+static bool adv_hw_active(void)
+{
+    return ble_gap_adv_active();
+}
+
+static int adv_hw_stop(void)
+{
+    return ble_gap_adv_stop();
+}
+
+static int adv_hw_set_data(const uint8_t *data, uint8_t len, bool rsp)
+{
+    return rsp ? ble_gap_adv_rsp_set_data(data, len) : ble_gap_adv_set_data(data, len);
+}
+
+#endif
+
+// Envia ao controlador os payloads alterados (task do host)
+static bool adv_push_data(void)
+{
+    uint8_t buf[BLE_HS_ADV_MAX_SZ];
+    uint8_t len = 0;
+    bool push_adv;
+    int rc;
+
+    portENTER_CRITICAL(&adv_lock);
+    push_adv = adv_dirty;
+    if (push_adv)
+    {
+        memcpy(buf, adv_buf, adv_len);
+        len = adv_len;
+        adv_dirty = false;
+    }
+    portEXIT_CRITICAL(&adv_lock);
+
+    if (push_adv)
+    {
+        rc = adv_hw_set_data(buf, len, false);
+        if (rc != 0)
+        {
+            ESP_LOGE(TAG, "Erro ao configurar dados de advertising: %d", rc);
+            portENTER_CRITICAL(&adv_lock);
+            adv_dirty = true;
+            portEXIT_CRITICAL(&adv_lock);
+            return false;
+        }
+    }
+
+    if (rsp_dirty)
+    {
+        rc = adv_hw_set_data(rsp_buf, rsp_len, true);
+        if (rc != 0)
+        {
+            ESP_LOGE(TAG, "Erro ao configurar dados de scan response: %d", rc);
+            return false;
+        }
+        rsp_dirty = false;
+    }
+
+    return true;
+}
+
+// Estado mudou: atualiza o payload já em uso sem reiniciar o advertising.
+// O direcionado não tem payload; o próximo perfil envia o atualizado
+static void adv_data_ev_cb(struct ble_npl_event *ev)
+{
+    if (adv_hw_active() && adv_state.profile != BLE_SERVER_ADV_DIRECTED)
+    {
+        adv_push_data();
+    }
+}
+
+// Altera bytes do manufacturer data e agenda o envio
+static void adv_patch_mfg(uint8_t off, const uint8_t *data, uint8_t len)
+{
+    bool changed;
+
+    portENTER_CRITICAL(&adv_lock);
+    changed = memcmp(&adv_mfg[off], data, len) != 0;
+    if (changed)
+    {
+        memcpy(&adv_mfg[off], data, len);
+        adv_dirty = true;
+    }
+    portEXIT_CRITICAL(&adv_lock);
+
+    if (changed)
+    {
+        ble_npl_eventq_put(nimble_port_get_dflt_eventq(), &data_ev);
+    }
+}
+
+// Eventos estimados em 'elapsed_us' de advertising no perfil
+static uint32_t adv_events_in(ble_server_adv_profile_t profile, int64_t elapsed_us)
+{
+    // Direcionado de alto duty cycle não usa advDelay
+    int64_t delay_us = profile == BLE_SERVER_ADV_DIRECTED ? 0 : ADV_DELAY_AVG_US;
+
+    return (uint32_t)(elapsed_us / ((int64_t)profiles[profile].itvl * 625 + delay_us));
+}
+
+#if CONFIG_BLE_SERVER_ADV_DIRECTED_RECONNECT || CONFIG_BLE_SERVER_ADV_ACCEPT_LIST
+// Par com IRK no bond usa endereço privado resolvível
+static bool adv_peer_has_irk(const ble_addr_t *addr)
+{
+    struct ble_store_key_sec key;
+    struct ble_store_value_sec value;
+
+    memset(&key, 0, sizeof(key));
+    key.peer_addr = *addr;
+    return ble_store_read_peer_sec(&key, &value) == 0 && value.irk_present;
+}
+#endif
+
+static void adv_refresh_accept_list(void)
+{
+#if CONFIG_BLE_SERVER_ADV_ACCEPT_LIST
+    ble_addr_t peers[CONFIG_BT_NIMBLE_MAX_BONDS];
+    int num = 0;
+
+    if (!accept_list_dirty)
+    {
+        return;
+    }
+
+    int rc = ble_store_util_bonded_peers(peers, &num, CONFIG_BT_NIMBLE_MAX_BONDS);
+    if (rc != 0)
+    {
+        ESP_LOGW(TAG, "Erro ao ler bonds: %d", rc);
+        bonded_count = 0;
+        return;
+    }
+
+    // Sem resolução de endereço o filtro trancaria fora dos perfis médio e
+    // lento quem anuncia com RPA: com qualquer bond com IRK, fica sem filtro
+    for (int i = 0; i < num; i++)
+    {
+        if (adv_peer_has_irk(&peers[i]))
+        {
+            bonded_count = 0;
+            accept_list_dirty = false;
+            ESP_LOGI(TAG, "Accept list desativada: bond com IRK (endereço privado)");
+            return;
+        }
+    }
+
+    if (num > 0)
+    {
+        rc = ble_gap_wl_set(peers, num);
+    }
+    if (rc != 0)
+    {
+        ESP_LOGW(TAG, "Erro ao carregar accept list: %d", rc);
+        bonded_count = 0;
+        return;
+    }
+
+    bonded_count = num;
+    accept_list_dirty = false;
+    ESP_LOGI(TAG, "Accept list: %d pares com bond", num);
+#endif
+}
+
+// Perfis médio e lento só aceitam pares com bond; a janela rápida continua
+// aberta para novos pareamentos
+static uint8_t adv_filter_policy(ble_server_adv_profile_t profile)
+{
+#if CONFIG_BLE_SERVER_ADV_ACCEPT_LIST
+    if (profile >= BLE_SERVER_ADV_MEDIUM && bonded_count > 0)
+    {
+        return BLE_HCI_ADV_FILT_BOTH;
+    }
+#endif
+    return BLE_HCI_ADV_FILT_NONE;
+}
+
+static void adv_account_start(ble_server_adv_profile_t profile, uint32_t duration_ms)
+{
+    int64_t now = esp_timer_get_time();
+
+    portENTER_CRITICAL(&adv_lock);
+    adv_state.active = true;
+    adv_state.profile = profile;
+    adv_state.started_at = now;
+    adv_state.ends_at = duration_ms ? now + (int64_t)duration_ms * 1000 : 0;
+    portEXIT_CRITICAL(&adv_lock);
+}
+
+static void adv_account_stop(void)
+{
+    int64_t now = esp_timer_get_time();
+
+    portENTER_CRITICAL(&adv_lock);
+    if (adv_state.active)
+    {
+        int64_t elapsed = now - adv_state.started_at;
+        uint32_t events = adv_events_in(adv_state.profile, elapsed);
+
+        profile_us[adv_state.profile] += elapsed;
+        events_est += events;
+        radio_us += (uint64_t)events * ADV_EVENT_RADIO_US;
+        adv_state.active = false;
+    }
+    portEXIT_CRITICAL(&adv_lock);
+}
+
+#if CONFIG_BT_NIMBLE_EXT_ADV
+
+// ble_gap_ext_adv_start() recebe a duração em unidades de 10 ms (uint16_t)
+#define ADV_EXT_DURATION_MAX_MS (UINT16_MAX * 10)
+_Static_assert(CONFIG_BLE_SERVER_ADV_FAST_DURATION_MS <= ADV_EXT_DURATION_MAX_MS &&
+                   CONFIG_BLE_SERVER_ADV_MEDIUM_DURATION_MS <= ADV_EXT_DURATION_MAX_MS,
+               "duração de perfil acima de 655350 ms não cabe no set estendido");
+
+static int adv_hw_start(ble_server_adv_profile_t profile, uint32_t duration_ms)
+{
+    const adv_profile_def_t *def = &profiles[profile];
+    struct ble_gap_ext_adv_params params = {0};
+    int rc;
+
+    // Conectável com PDUs legados: ADV_IND ou ADV_DIRECT_IND
+    params.connectable = 1;
+    params.legacy_pdu = 1;
+    if (profile == BLE_SERVER_ADV_DIRECTED)
+    {
+        params.directed = 1;
+        params.high_duty_directed = 1;
+        params.peer = direct_peer;
+    }
+    else
+    {
+        params.scannable = 1;
+    }
+    params.filter_policy = adv_filter_policy(profile);
+    params.own_addr_type = BLE_OWN_ADDR_PUBLIC;
+    params.primary_phy = BLE_HCI_LE_PHY_1M;
+    params.secondary_phy = BLE_HCI_LE_PHY_1M;
+    params.channel_map = 0x07; // Canais 37, 38 e 39
+    params.tx_power = 127; // Sem preferência
+    params.itvl_min = def->itvl;
+    params.itvl_max = def->itvl + def->itvl / 2;
+
+    rc = ble_gap_ext_adv_configure(BLE_SERVER_ADV_INSTANCE_CONN, &params, NULL,
+                                   ble_server_gap_event, NULL);
+    if (rc != 0)
+    {
+        return rc;
+    }
+
+    // Reconfigurar o set pode descartar os dados no controlador. ADV_DIRECT_IND
+    // não leva dados (o NimBLE recusa com EINVAL): ficam para o próximo perfil
+    ble_server_adv_on_sync();
+    if (profile != BLE_SERVER_ADV_DIRECTED && !adv_push_data())
+    {
+        return BLE_HS_EUNKNOWN;
+    }
+
+    // Duração em unidades de 10 ms (0 = até conectar)
+    return ble_gap_ext_adv_start(BLE_SERVER_ADV_INSTANCE_CONN, duration_ms / 10, 0);
+}
+
+#else
+
+static int adv_hw_start(ble_server_adv_profile_t profile, uint32_t duration_ms)
+{
+    const adv_profile_def_t *def = &profiles[profile];
+    struct ble_gap_adv_params adv_params = {0};
+    const ble_addr_t *peer = NULL;
+
+    if (!adv_push_data())
+    {
+        return BLE_HS_EUNKNOWN;
+    }
+
+    if (profile == BLE_SERVER_ADV_DIRECTED)
+    {
+        adv_params.conn_mode = BLE_GAP_CONN_MODE_DIR;
+        adv_params.disc_mode = BLE_GAP_DISC_MODE_NON;
+        adv_params.high_duty_cycle = 1;
+        peer = &direct_peer;
+    }
+    else
+    {
+        adv_params.conn_mode = BLE_GAP_CONN_MODE_UND;
+        adv_params.disc_mode = BLE_GAP_DISC_MODE_GEN;
+    }
+    adv_params.filter_policy = adv_filter_policy(profile);
+    adv_params.itvl_min = def->itvl;
+    adv_params.itvl_max = def->itvl + def->itvl / 2;
+
+    return ble_gap_adv_start(BLE_OWN_ADDR_PUBLIC, peer,
+                             duration_ms ? (int32_t)duration_ms : BLE_HS_FOREVER,
+                             &adv_params, ble_server_gap_event, NULL);
+}
+
+#endif
+
+// Intervalo em unidades de 0,625 ms, máximo 50% acima do mínimo (perfil
+// rápido padrão: 32-48 = 20-30 ms). Ao expirar a duração o NimBLE gera
+// ADV_COMPLETE e o agendador desce de perfil. duration_ms 0 = duração
+// inteira do perfil.
+static bool adv_start(ble_server_adv_profile_t profile, uint32_t duration_ms)
+{
+    if (profile == BLE_SERVER_ADV_DIRECTED && !direct_peer_valid)
+    {
+        profile = BLE_SERVER_ADV_FAST;
+        duration_ms = 0;
+    }
+    if (duration_ms == 0)
+    {
+        duration_ms = profiles[profile].duration_ms;
+    }
+
+    // Advertising parado: momento seguro para alterar a accept list
+    adv_refresh_accept_list();
+
+    int rc = adv_hw_start(profile, duration_ms);
+    if (rc != 0 && profile == BLE_SERVER_ADV_DIRECTED)
+    {
+        // Sem o direcionado o par ainda encontra a rajada rápida
+        ESP_LOGW(TAG, "Erro ao iniciar advertising direcionado: %d, usando o rápido", rc);
+        profile = BLE_SERVER_ADV_FAST;
+        duration_ms = profiles[profile].duration_ms;
+        rc = adv_hw_start(profile, duration_ms);
+    }
+    if (rc != 0)
+    {
+        ESP_LOGE(TAG, "Erro ao iniciar advertising: %d", rc);
+        return false;
+    }
+
+    const adv_profile_def_t *def = &profiles[profile];
+
+    adv_account_start(profile, duration_ms);
+    ESP_LOGI(TAG, "Advertising %s: '%s', itvl=%d, duração=%lu ms",
+             def->name, server_config.device_name, def->itvl, duration_ms);
+    return true;
+}
+
+// Inicia o perfil se ainda há slots de conexão livres
+static void adv_start_if_free(ble_server_adv_profile_t profile, uint32_t duration_ms)
+{
+    // Durante um reset do host: o sync reinicia o advertising
+    if (!ble_hs_synced())
+    {
+        return;
+    }
+    if (ble_server_conn_count() >= BLE_SERVER_MAX_CONNS)
+    {
+        ESP_LOGI(TAG, "Todos os %d slots de conexão ocupados", BLE_SERVER_MAX_CONNS);
+        return;
+    }
+
+    adv_start(profile, duration_ms);
+}
+
+static void adv_fast_ev_cb(struct ble_npl_event *ev)
+{
+    ble_server_adv_start(BLE_SERVER_ADV_FAST);
+}
+
+// ===== Interface interna =====
+
+void ble_server_adv_init(void)
+{
+    memset(&adv_state, 0, sizeof(adv_state));
+    init_at = esp_timer_get_time();
+    ble_npl_event_init(&fast_ev, adv_fast_ev_cb, NULL);
+    ble_npl_event_init(&data_ev, adv_data_ev_cb, NULL);
+    adv_build_payloads();
+}
+
+void ble_server_adv_on_sync(void)
+{
+    // Controlador pode ter sido reiniciado: reenvia os payloads
+    portENTER_CRITICAL(&adv_lock);
+    adv_dirty = true;
+    portEXIT_CRITICAL(&adv_lock);
+    rsp_dirty = true;
+}
+
+void ble_server_adv_on_reset(void)
+{
+    // Controlador parou de anunciar sem ADV_COMPLETE garantido
+    adv_account_stop();
+}
+
+void ble_server_adv_set_state(uint8_t state, uint16_t change_count)
+{
+    uint8_t data[3] = {state, change_count & 0xFF, change_count >> 8};
+
+    if (adv_mfg == NULL)
+    {
+        return;
+    }
+    adv_patch_mfg(ADV_MFG_OFF_STATE, data, sizeof(data));
+}
+
+void ble_server_adv_start(ble_server_adv_profile_t profile)
+{
+    // Reinicia no perfil pedido mesmo se já anunciando num perfil mais lento
+    if (adv_hw_active())
+    {
+        adv_hw_stop();
+        adv_account_stop();
+    }
+
+    adv_state.window_at = esp_timer_get_time();
+    adv_start_if_free(profile, 0);
+}
+
+void ble_server_adv_on_disconnect(const struct ble_gap_conn_desc *desc)
+{
+#if CONFIG_BLE_SERVER_ADV_DIRECTED_RECONNECT
+    // Par com bond e endereço de identidade fixo: direcionado de alto duty
+    // cycle antes da rajada rápida. Com IRK o par não responde a
+    // ADV_DIRECT_IND para o endereço de identidade
+    if (desc->sec_state.bonded && !adv_peer_has_irk(&desc->peer_id_addr))
+    {
+        direct_peer = desc->peer_id_addr;
+        direct_peer_valid = true;
+        ble_server_adv_start(BLE_SERVER_ADV_DIRECTED);
+        return;
+    }
+#endif
+
+    ble_server_adv_start(BLE_SERVER_ADV_FAST);
+}
+
+void ble_server_adv_on_bonds_changed(void)
+{
+    accept_list_dirty = true;
+}
+
+bool ble_server_adv_window(int64_t *window_at)
+{
+    // Só janelas abertas por gatilho medem a aproximação; no perfil médio ou
+    // lento o início do advertising não diz quando o celular chegou
+    if (!adv_state.active || adv_state.profile > BLE_SERVER_ADV_FAST)
+    {
+        return false;
+    }
+
+    *window_at = adv_state.window_at;
+    return true;
+}
+
+void ble_server_adv_on_connect(int status)
+{
+    int64_t window_at;
+
+    if (status == 0 && ble_server_adv_window(&window_at))
+    {
+        uint32_t ms = (uint32_t)((esp_timer_get_time() - window_at) / 1000);
+
+        portENTER_CRITICAL(&adv_lock);
+        window_connects++;
+        window_connect_ms_total += ms;
+        if (ms > window_connect_ms_max)
+            window_connect_ms_max = ms;
+        if (adv_state.profile == BLE_SERVER_ADV_DIRECTED)
+            directed_connects++;
+        portEXIT_CRITICAL(&adv_lock);
+
+        ESP_LOGI(TAG, "Conectado %lu ms após o início da janela (%s)", ms, profiles[adv_state.profile].name);
+    }
+
+    // Advertising conectável para ao conectar. O direcionado só vale para o
+    // par que acabou de voltar: segue a rajada rápida inteira. Os demais
+    // perfis retomam com o que faltava da duração; sem sobra, o seguinte
+    ble_server_adv_profile_t profile = adv_state.profile;
+    uint32_t remaining_ms = 0;
+
+    if (profile == BLE_SERVER_ADV_DIRECTED)
+    {
+        profile = BLE_SERVER_ADV_FAST;
+    }
+    else if (adv_state.ends_at != 0)
+    {
+        int64_t left_us = adv_state.ends_at - esp_timer_get_time();
+
+        if (left_us >= ADV_RESUME_MIN_MS * 1000)
+        {
+            remaining_ms = (uint32_t)(left_us / 1000);
+        }
+        else if (profile + 1 < BLE_SERVER_ADV_PROFILE_COUNT)
+        {
+            profile++;
+        }
+    }
+    adv_account_stop();
+
+    if (!adv_hw_active())
+    {
+        adv_start_if_free(profile, remaining_ms);
+    }
+}
+
+void ble_server_adv_on_complete(int reason)
+{
+    ble_server_adv_profile_t profile = adv_state.profile;
+
+    // Fim por conexão (sets estendidos) já foi tratado em on_connect
+    if (reason == 0)
+    {
+        return;
+    }
+
+    adv_account_stop();
+
+    // Duração do perfil expirou: desce para o próximo
+    if (reason == BLE_HS_ETIMEOUT && profile + 1 < BLE_SERVER_ADV_PROFILE_COUNT)
+    {
+        adv_start_if_free(profile + 1, 0);
+    }
+}
+
+// ===== API Pública =====
+
+esp_err_t ble_server_adv_request_fast(void)
+{
+    if (init_at == 0)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    portENTER_CRITICAL(&adv_lock);
+    fast_requests++;
+    portEXIT_CRITICAL(&adv_lock);
+
+    // Troca de perfil acontece na task do host
+    ble_npl_eventq_put(nimble_port_get_dflt_eventq(), &fast_ev);
+    return ESP_OK;
+}
+
+esp_err_t ble_server_adv_set_battery(uint8_t level)
+{
+    if (adv_mfg == NULL)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    adv_patch_mfg(ADV_MFG_OFF_BATTERY, &level, 1);
+    return ESP_OK;
+}
+
+esp_err_t ble_server_get_adv_stats(ble_server_adv_stats_t *out)
+{
+    if (out == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    int64_t now = esp_timer_get_time();
+    uint64_t radio;
+
+    portENTER_CRITICAL(&adv_lock);
+    out->advertising = adv_state.active;
+    out->profile = adv_state.profile;
+    out->fast_requests = fast_requests;
+    out->events_est = events_est;
+    out->window_connects = window_connects;
+    out->window_connect_ms_avg = window_connects ? (uint32_t)(window_connect_ms_total / window_connects) : 0;
+    out->window_connect_ms_max = window_connect_ms_max;
+    out->directed_connects = directed_connects;
+    radio = radio_us;
+    for (int i = 0; i < BLE_SERVER_ADV_PROFILE_COUNT; i++)
+    {
+        out->profile_ms[i] = (uint32_t)(profile_us[i] / 1000);
+    }
+
+    // Perfil em andamento entra na conta até agora
+    if (adv_state.active)
+    {
+        int64_t elapsed = now - adv_state.started_at;
+        uint32_t events = adv_events_in(adv_state.profile, elapsed);
+
+        out->profile_ms[adv_state.profile] += (uint32_t)(elapsed / 1000);
+        out->events_est += events;
+        radio += (uint64_t)events * ADV_EVENT_RADIO_US;
+    }
+    portEXIT_CRITICAL(&adv_lock);
+
+    out->radio_ms_est = (uint32_t)(radio / 1000);
+    out->duty_ppm = now > init_at ? (uint32_t)(radio * 1000000 / (uint64_t)(now - init_at)) : 0;
+    return ESP_OK;
+}
@@ -0,0 +1,241 @@
+// components/ble_server/src/ble_server_auth.c
+// Sessões de comandos autenticados. Ler a characteristic Auth sorteia um
+// nonce novo para a conexão (desafio); cada write nas characteristics com
+// require_auth precisa trazer key_id, contador crescente e a tag HMAC
+// (formato em ble_auth.h). O servidor remove cabeçalho e tag antes de
+// repassar o comando, então os handlers não mudam.
+//
+// As chaves ficam pré-processadas (estados ipad/opad do HMAC): verificar um
+// comando custa só os blocos da mensagem e do hash externo.
+#include "ble_server_priv.h"
+#include "ble_auth.h"
+#include "esp_log.h"
+#include "esp_random.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+
+static const char *TAG = "BLE_AUTH";
+
+typedef struct
+{
+    bool in_use;
+    uint16_t conn_handle;
+    ble_auth_session_t session;
+} auth_conn_t;
+
+static ble_auth_key_t keys[CONFIG_BLE_SERVER_AUTH_KEY_SLOTS];
+// Troca de chaves pode vir de qualquer tarefa; a verificação copia a chave
+static portMUX_TYPE keys_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// Sessões e buffer de linearização: apenas na task do host
+static auth_conn_t sessions[BLE_SERVER_MAX_CONNS];
+static uint8_t flat[BLE_ATT_ATTR_MAX_LEN];
+
+static ble_server_auth_stats_t stats;
+static uint64_t verify_us_total;
+
+static auth_conn_t *session_find(uint16_t conn_handle, bool create)
+{
+    auth_conn_t *free_slot = NULL;
+
+    for (int i = 0; i < BLE_SERVER_MAX_CONNS; i++)
+    {
+        if (sessions[i].in_use && sessions[i].conn_handle == conn_handle)
+        {
+            return &sessions[i];
+        }
+        if (!sessions[i].in_use && free_slot == NULL)
+        {
+            free_slot = &sessions[i];
+        }
+    }
+
+    if (!create || free_slot == NULL)
+    {
+        return NULL;
+    }
+
+    free_slot->in_use = true;
+    free_slot->conn_handle = conn_handle;
+    free_slot->session.active = false;
+    return free_slot;
+}
+
+static void count_reject(ble_auth_status_t status)
+{
+    switch (status)
+    {
+    case BLE_AUTH_ERR_FORMAT:
+        stats.rejected_format++;
+        break;
+    case BLE_AUTH_ERR_NO_SESSION:
+        stats.rejected_no_session++;
+        break;
+    case BLE_AUTH_ERR_KEY:
+        stats.rejected_key++;
+        break;
+    case BLE_AUTH_ERR_REPLAY:
+        stats.rejected_replay++;
+        break;
+    case BLE_AUTH_ERR_TAG:
+    default:
+        stats.rejected_tag++;
+        break;
+    }
+}
+
+// ===== Interface interna =====
+
+int ble_server_auth_on_read(uint16_t conn_handle, struct os_mbuf *om, void *arg)
+{
+    auth_conn_t *ac = session_find(conn_handle, true);
+    uint8_t nonce[BLE_AUTH_NONCE_LEN];
+
+    if (ac == NULL)
+    {
+        return BLE_ATT_ERR_INSUFFICIENT_RES;
+    }
+
+    // Cada leitura abre uma sessão nova: contadores anteriores deixam de valer
+    esp_fill_random(nonce, sizeof(nonce));
+    ble_auth_session_start(&ac->session, nonce);
+    stats.sessions++;
+
+    return os_mbuf_append(om, nonce, sizeof(nonce)) == 0 ? 0 : BLE_ATT_ERR_INSUFFICIENT_RES;
+}
+
+int ble_server_auth_check(uint16_t conn_handle, struct os_mbuf *om)
+{
+    int64_t started_at = esp_timer_get_time();
+    auth_conn_t *ac = session_find(conn_handle, false);
+    ble_auth_status_t status;
+    ble_mbuf_view_t view;
+
+    ble_mbuf_view_init(&view, om);
+
+    // Caso comum: write inteiro num único segmento, verificado no lugar
+    const uint8_t *msg = ble_mbuf_view_contig(&view, 0, view.len);
+    if (msg == NULL)
+    {
+        ble_mbuf_view_read(&view, 0, flat, view.len);
+        msg = flat;
+    }
+
+    if (ac == NULL)
+    {
+        status = view.len < BLE_AUTH_OVERHEAD ? BLE_AUTH_ERR_FORMAT : BLE_AUTH_ERR_NO_SESSION;
+    }
+    else
+    {
+        ble_auth_key_t key;
+
+        // Cópia da chave: ble_server_auth_set_key() pode trocá-la de outra tarefa
+        key.valid = false;
+        if (view.len > 0 && msg[0] < CONFIG_BLE_SERVER_AUTH_KEY_SLOTS)
+        {
+            portENTER_CRITICAL(&keys_lock);
+            key = keys[msg[0]];
+            portEXIT_CRITICAL(&keys_lock);
+        }
+
+        status = ble_auth_verify(&ac->session, &key, msg, view.len);
+    }
+
+    uint32_t us = (uint32_t)(esp_timer_get_time() - started_at);
+    if (status != BLE_AUTH_OK)
+    {
+        count_reject(status);
+        ESP_LOGW(TAG, "Comando recusado: conn=%d, motivo=%d", conn_handle, status);
+        return status == BLE_AUTH_ERR_FORMAT ? BLE_ATT_ERR_INVALID_ATTR_VALUE_LEN
+                                             : BLE_ATT_ERR_INSUFFICIENT_AUTHEN;
+    }
+
+    stats.verified++;
+    verify_us_total += us;
+    if (us > stats.verify_us_max)
+        stats.verify_us_max = us;
+
+    // Handlers recebem apenas o comando
+    os_mbuf_adj(om, BLE_AUTH_HDR_LEN);
+    os_mbuf_adj(om, -BLE_AUTH_TAG_LEN);
+    return 0;
+}
+
+void ble_server_auth_conn_close(uint16_t conn_handle)
+{
+    auth_conn_t *ac = session_find(conn_handle, false);
+
+    if (ac)
+    {
+        ac->session.active = false;
+        ac->in_use = false;
+    }
+}
+
+// ===== API Pública =====
+
+esp_err_t ble_server_auth_set_key(uint8_t key_id, const uint8_t *key, size_t len)
+{
+    ble_auth_key_t prepared;
+    ble_auth_key_t old;
+
+    if (key_id >= CONFIG_BLE_SERVER_AUTH_KEY_SLOTS || key == NULL || len == 0 || len > BLE_AUTH_KEY_MAX_LEN)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // Key schedule fora da seção crítica (SHA pode usar o acelerador)
+    if (ble_auth_key_init(&prepared, key, len) != 0)
+    {
+        return ESP_FAIL;
+    }
+
+    portENTER_CRITICAL(&keys_lock);
+    old = keys[key_id];
+    keys[key_id] = prepared;
+    portEXIT_CRITICAL(&keys_lock);
+
+    // Contexto preparado agora pertence ao slot
+    if (old.valid)
+    {
+        ble_auth_key_free(&old);
+    }
+    ESP_LOGI(TAG, "Chave %d configurada", key_id);
+    return ESP_OK;
+}
+
+esp_err_t ble_server_auth_clear_key(uint8_t key_id)
+{
+    ble_auth_key_t old;
+
+    if (key_id >= CONFIG_BLE_SERVER_AUTH_KEY_SLOTS)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    portENTER_CRITICAL(&keys_lock);
+    old = keys[key_id];
+    keys[key_id].valid = false;
+    portEXIT_CRITICAL(&keys_lock);
+
+    if (old.valid)
+    {
+        ble_auth_key_free(&old);
+    }
+    return ESP_OK;
+}
+
+esp_err_t ble_server_get_auth_stats(ble_server_auth_stats_t *out)
+{
+    if (out == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    *out = stats;
+    if (stats.verified > 0)
+    {
+        out->verify_us_avg = (uint32_t)(verify_us_total / stats.verified);
+    }
+    return ESP_OK;
+}
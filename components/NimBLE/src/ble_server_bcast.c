@@ -0,0 +1,264 @@
+// components/ble_server/src/ble_server_bcast.c
+// Broadcast de eventos da fechadura por advertising estendido + periódico
+// (BLE 5). Um set não conectável (instância 1) anuncia o UUID do serviço e
+// o trem periódico carrega os últimos eventos: qualquer número de
+// observadores (painéis, hubs) acompanha as mudanças de estado sem ocupar
+// um slot de conexão.
+//
+// Payload periódico (mais recente primeiro):
+//   [len][0xFF][company id LE][count] + count x [seq LE][uptime_s LE][code][value]
+#include "ble_server_priv.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "nimble/nimble_port.h"
+#include <string.h>
+
+#if CONFIG_BLE_SERVER_EVENT_BROADCAST
+
+static const char *TAG = "BLE_BCAST";
+
+#define BCAST_DEPTH CONFIG_BLE_SERVER_EVENT_BROADCAST_DEPTH
+#define BCAST_COMPANY_ID 0xFFFF
+#define BCAST_ENTRY_LEN 8
+#define BCAST_HDR_LEN 5 // AD len, AD type, company id, count
+#define BCAST_PAYLOAD_MAX (BCAST_HDR_LEN + BCAST_DEPTH * BCAST_ENTRY_LEN)
+// Intervalo do set estendido que aponta para o trem periódico (0,625 ms)
+#define BCAST_EXT_ITVL 800
+
+#if BCAST_PAYLOAD_MAX > CONFIG_BT_NIMBLE_EXT_ADV_MAX_SIZE
+#error "CONFIG_BT_NIMBLE_EXT_ADV_MAX_SIZE não comporta CONFIG_BLE_SERVER_EVENT_BROADCAST_DEPTH eventos"
+#endif
+#if CONFIG_BT_NIMBLE_MAX_EXT_ADV_INSTANCES < 2
+#error "Broadcast de eventos requer CONFIG_BT_NIMBLE_MAX_EXT_ADV_INSTANCES >= 2"
+#endif
+
+typedef struct
+{
+    uint16_t seq;
+    uint32_t uptime_s;
+    uint8_t code;
+    uint8_t value;
+} bcast_event_t;
+
+// Anel com os últimos eventos (head = próximo a escrever)
+static bcast_event_t events[BCAST_DEPTH];
+static uint8_t head;
+static uint8_t count;
+static uint16_t next_seq;
+static portMUX_TYPE bcast_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static struct ble_npl_event update_ev;
+static bool initialized; // update_ev pronto (após nimble_port_init)
+static bool started;
+
+// Codifica o anel no formato do payload periódico
+static uint8_t bcast_encode(uint8_t *buf)
+{
+    uint8_t len = BCAST_HDR_LEN;
+
+    portENTER_CRITICAL(&bcast_lock);
+    for (int i = 0; i < count; i++)
+    {
+        const bcast_event_t *ev = &events[(head + BCAST_DEPTH - 1 - i) % BCAST_DEPTH];
+        uint8_t *p = &buf[len];
+
+        p[0] = ev->seq & 0xFF;
+        p[1] = ev->seq >> 8;
+        p[2] = ev->uptime_s & 0xFF;
+        p[3] = (ev->uptime_s >> 8) & 0xFF;
+        p[4] = (ev->uptime_s >> 16) & 0xFF;
+        p[5] = (ev->uptime_s >> 24) & 0xFF;
+        p[6] = ev->code;
+        p[7] = ev->value;
+        len += BCAST_ENTRY_LEN;
+    }
+    buf[4] = count;
+    portEXIT_CRITICAL(&bcast_lock);
+
+    buf[0] = len - 1;
+    buf[1] = BLE_HS_ADV_TYPE_MFG_DATA;
+    buf[2] = BCAST_COMPANY_ID & 0xFF;
+    buf[3] = BCAST_COMPANY_ID >> 8;
+    return len;
+}
+
+// Envia o payload atual ao trem periódico (task do host)
+static int bcast_push(void)
+{
+    uint8_t buf[BCAST_PAYLOAD_MAX];
+    uint8_t len = bcast_encode(buf);
+
+    struct os_mbuf *om = os_msys_get_pkthdr(len, 0);
+    if (om == NULL)
+    {
+        return BLE_HS_ENOMEM;
+    }
+    if (os_mbuf_append(om, buf, len) != 0)
+    {
+        os_mbuf_free_chain(om);
+        return BLE_HS_ENOMEM;
+    }
+
+    // O mbuf é consumido mesmo em caso de erro
+#if CONFIG_BT_NIMBLE_PERIODIC_ADV_ENH
+    struct ble_gap_periodic_adv_set_data_params data_params = {0};
+    return ble_gap_periodic_adv_set_data(BLE_SERVER_ADV_INSTANCE_BCAST, om, &data_params);
+#else
+    return ble_gap_periodic_adv_set_data(BLE_SERVER_ADV_INSTANCE_BCAST, om);
+#endif
+}
+
+static void bcast_update_cb(struct ble_npl_event *ev)
+{
+    if (!started)
+    {
+        return;
+    }
+
+    int rc = bcast_push();
+    if (rc != 0)
+    {
+        ESP_LOGW(TAG, "Erro ao atualizar dados periódicos: %d", rc);
+    }
+}
+
+// ===== Interface interna =====
+
+void ble_server_bcast_init(void)
+{
+    ble_npl_event_init(&update_ev, bcast_update_cb, NULL);
+    initialized = true;
+}
+
+void ble_server_bcast_on_sync(void)
+{
+    struct ble_gap_ext_adv_params ext_params = {0};
+    struct ble_gap_periodic_adv_params per_params = {0};
+    uint8_t ext_data[18];
+    int rc;
+
+    // Set estendido não conectável/escaneável: só aponta para o trem periódico
+    ext_params.own_addr_type = BLE_OWN_ADDR_PUBLIC;
+    ext_params.primary_phy = BLE_HCI_LE_PHY_1M;
+    ext_params.secondary_phy = BLE_HCI_LE_PHY_1M;
+    ext_params.channel_map = 0x07; // Canais 37, 38 e 39
+    ext_params.tx_power = 127;     // Sem preferência
+    ext_params.sid = BLE_SERVER_ADV_INSTANCE_BCAST;
+    ext_params.itvl_min = BCAST_EXT_ITVL;
+    ext_params.itvl_max = BCAST_EXT_ITVL;
+
+    rc = ble_gap_ext_adv_configure(BLE_SERVER_ADV_INSTANCE_BCAST, &ext_params, NULL,
+                                   ble_server_gap_event, NULL);
+    if (rc != 0)
+    {
+        ESP_LOGE(TAG, "Erro ao configurar set de broadcast: %d", rc);
+        return;
+    }
+
+    // UUID do serviço para observadores filtrarem o set
+    ext_data[0] = 17;
+    ext_data[1] = BLE_HS_ADV_TYPE_COMP_UUIDS128;
+    memcpy(&ext_data[2], gatt_svr_svc_uuid.value, 16);
+
+    struct os_mbuf *om = os_msys_get_pkthdr(sizeof(ext_data), 0);
+    if (om == NULL || os_mbuf_append(om, ext_data, sizeof(ext_data)) != 0)
+    {
+        if (om)
+            os_mbuf_free_chain(om);
+        ESP_LOGE(TAG, "Erro ao alocar dados do set de broadcast");
+        return;
+    }
+    rc = ble_gap_ext_adv_set_data(BLE_SERVER_ADV_INSTANCE_BCAST, om);
+    if (rc != 0)
+    {
+        ESP_LOGE(TAG, "Erro ao configurar dados do set de broadcast: %d", rc);
+        return;
+    }
+
+    per_params.itvl_min = CONFIG_BLE_SERVER_EVENT_BROADCAST_ITVL;
+    per_params.itvl_max = CONFIG_BLE_SERVER_EVENT_BROADCAST_ITVL;
+
+    rc = ble_gap_periodic_adv_configure(BLE_SERVER_ADV_INSTANCE_BCAST, &per_params);
+    if (rc == 0)
+    {
+        rc = bcast_push();
+    }
+    if (rc == 0)
+    {
+#if CONFIG_BT_NIMBLE_PERIODIC_ADV_ENH
+        struct ble_gap_periodic_adv_start_params start_params = {0};
+        rc = ble_gap_periodic_adv_start(BLE_SERVER_ADV_INSTANCE_BCAST, &start_params);
+#else
+        rc = ble_gap_periodic_adv_start(BLE_SERVER_ADV_INSTANCE_BCAST);
+#endif
+    }
+    if (rc != 0)
+    {
+        ESP_LOGE(TAG, "Erro ao iniciar advertising periódico: %d", rc);
+        return;
+    }
+
+    rc = ble_gap_ext_adv_start(BLE_SERVER_ADV_INSTANCE_BCAST, 0, 0);
+    if (rc != 0)
+    {
+        ESP_LOGE(TAG, "Erro ao iniciar set de broadcast: %d", rc);
+        return;
+    }
+
+    started = true;
+    ESP_LOGI(TAG, "Broadcast de eventos: itvl periódico=%d, %d eventos",
+             CONFIG_BLE_SERVER_EVENT_BROADCAST_ITVL, BCAST_DEPTH);
+}
+
+void ble_server_bcast_on_reset(void)
+{
+    // Sets somem com o controlador; eventos seguem no buffer até o sync
+    started = false;
+}
+
+// ===== API Pública =====
+
+esp_err_t ble_server_broadcast_event(uint8_t code, uint8_t value)
+{
+    uint32_t uptime_s = (uint32_t)(esp_timer_get_time() / 1000000);
+
+    portENTER_CRITICAL(&bcast_lock);
+    events[head].seq = next_seq++;
+    events[head].uptime_s = uptime_s;
+    events[head].code = code;
+    events[head].value = value;
+    head = (head + 1) % BCAST_DEPTH;
+    if (count < BCAST_DEPTH)
+        count++;
+    portEXIT_CRITICAL(&bcast_lock);
+
+    // Atualização do trem periódico acontece na task do host. Antes de
+    // ble_server_init() o evento fica só no anel e vai no primeiro sync.
+    if (initialized)
+    {
+        ble_npl_eventq_put(nimble_port_get_dflt_eventq(), &update_ev);
+    }
+    return ESP_OK;
+}
+
+#else // !CONFIG_BLE_SERVER_EVENT_BROADCAST
+
+void ble_server_bcast_init(void)
+{
+}
+
+void ble_server_bcast_on_sync(void)
+{
+}
+
+void ble_server_bcast_on_reset(void)
+{
+}
+
+esp_err_t ble_server_broadcast_event(uint8_t code, uint8_t value)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+#endif
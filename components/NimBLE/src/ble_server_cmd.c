@@ -0,0 +1,200 @@
+// components/ble_server/src/ble_server_cmd.c
+// Pipeline assíncrono: escritas de comando são enfileiradas pela task do
+// host NimBLE e executadas por uma tarefa dedicada, liberando o host para
+// continuar processando eventos GAP/ATT enquanto o comando roda.
+#include "ble_server_priv.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+
+static const char *TAG = "BLE_CMD";
+
+// Item copiado por valor para a fila
+typedef struct
+{
+    uint16_t conn_handle;
+    uint16_t len;
+    int64_t enqueued_at; // esp_timer_get_time() na chegada
+    uint8_t data[CONFIG_BLE_SERVER_CMD_MAX_LEN];
+} ble_cmd_item_t;
+
+static QueueHandle_t cmd_queue = NULL;
+static TaskHandle_t cmd_task = NULL;
+
+// Estatísticas (protegidas por stats_lock: escritas pelo host e pela tarefa)
+static portMUX_TYPE stats_lock = portMUX_INITIALIZER_UNLOCKED;
+static ble_server_cmd_stats_t stats;
+static uint64_t wait_us_total;
+static uint64_t exec_us_total;
+
+// Conexão do comando em execução: o on_write roda na task do host ou na
+// tarefa de comandos, nunca nas duas
+static uint16_t origin_conn = BLE_SERVER_NOTIFY_ALL;
+
+// ===== Tarefa executora =====
+static void ble_cmd_task(void *param)
+{
+    ble_cmd_item_t item;
+
+    while (1)
+    {
+        if (xQueueReceive(cmd_queue, &item, portMAX_DELAY) != pdPASS)
+        {
+            continue;
+        }
+
+        int64_t started_at = esp_timer_get_time();
+
+        ble_server_cmd_exec(item.conn_handle, item.data, item.len);
+
+        int64_t finished_at = esp_timer_get_time();
+        uint32_t wait_us = (uint32_t)(started_at - item.enqueued_at);
+        uint32_t exec_us = (uint32_t)(finished_at - started_at);
+
+        portENTER_CRITICAL(&stats_lock);
+        stats.executed++;
+        wait_us_total += wait_us;
+        exec_us_total += exec_us;
+        if (wait_us > stats.wait_us_max)
+            stats.wait_us_max = wait_us;
+        if (exec_us > stats.exec_us_max)
+            stats.exec_us_max = exec_us;
+        portEXIT_CRITICAL(&stats_lock);
+
+        ESP_LOGD(TAG, "Comando executado: fila=%lu us, execução=%lu us",
+                 wait_us, exec_us);
+    }
+}
+
+// ===== Interface interna =====
+
+esp_err_t ble_server_cmd_init(void)
+{
+    if (!server_config.async_commands)
+    {
+        return ESP_OK;
+    }
+
+    cmd_queue = xQueueCreate(CONFIG_BLE_SERVER_CMD_QUEUE_LEN, sizeof(ble_cmd_item_t));
+    if (cmd_queue == NULL)
+    {
+        ESP_LOGE(TAG, "Falha ao criar fila de comandos!");
+        return ESP_ERR_NO_MEM;
+    }
+
+    BaseType_t ret = xTaskCreate(ble_cmd_task,
+                                 "ble_cmd",
+                                 CONFIG_BLE_SERVER_CMD_TASK_STACK_SIZE,
+                                 NULL,
+                                 CONFIG_BLE_SERVER_CMD_TASK_PRIORITY,
+                                 &cmd_task);
+    if (ret != pdPASS)
+    {
+        ESP_LOGE(TAG, "Falha ao criar tarefa de comandos!");
+        vQueueDelete(cmd_queue);
+        cmd_queue = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+
+    ESP_LOGI(TAG, "Pipeline de comandos ativo: %d posições x %d bytes",
+             CONFIG_BLE_SERVER_CMD_QUEUE_LEN, CONFIG_BLE_SERVER_CMD_MAX_LEN);
+    return ESP_OK;
+}
+
+void ble_server_cmd_exec(uint16_t conn_handle, uint8_t *data, uint16_t len)
+{
+    if (server_config.on_write == NULL)
+    {
+        return;
+    }
+
+    int64_t cb_at = ble_server_probe_now();
+    ble_server_diag_dispatch(conn_handle);
+    origin_conn = conn_handle;
+    server_config.on_write(data, len);
+    origin_conn = BLE_SERVER_NOTIFY_ALL;
+    ble_server_trace_end(BLE_SERVER_TRACE_APP_CB, BLE_SERVER_TRACE_CB_WRITE,
+                         conn_handle, cb_at, 0);
+    ble_server_diag_stage(BLE_SERVER_DIAG_STAGE_EXEC, cb_at);
+}
+
+void ble_server_cmd_set_origin(uint16_t conn_handle)
+{
+    origin_conn = conn_handle;
+}
+
+bool ble_server_cmd_is_async(void)
+{
+    return cmd_queue != NULL;
+}
+
+int ble_server_cmd_submit(uint16_t conn_handle, const struct os_mbuf *om)
+{
+    ble_cmd_item_t item;
+    uint16_t len = OS_MBUF_PKTLEN(om);
+
+    if (len > sizeof(item.data))
+    {
+        ESP_LOGW(TAG, "Comando muito grande: %d bytes (máx %d)", len, (int)sizeof(item.data));
+        return BLE_ATT_ERR_INVALID_ATTR_VALUE_LEN;
+    }
+
+    item.conn_handle = conn_handle;
+    item.len = len;
+    item.enqueued_at = esp_timer_get_time();
+    os_mbuf_copydata(om, 0, len, item.data);
+
+    // Nunca bloqueia a task do host: fila cheia = comando descartado
+    if (xQueueSend(cmd_queue, &item, 0) != pdPASS)
+    {
+        portENTER_CRITICAL(&stats_lock);
+        stats.dropped++;
+        portEXIT_CRITICAL(&stats_lock);
+
+        ESP_LOGW(TAG, "Fila de comandos cheia, comando descartado");
+        return BLE_ATT_ERR_INSUFFICIENT_RES;
+    }
+
+    uint32_t depth = uxQueueMessagesWaiting(cmd_queue);
+
+    portENTER_CRITICAL(&stats_lock);
+    stats.enqueued++;
+    if (depth > stats.depth_max)
+        stats.depth_max = depth;
+    portEXIT_CRITICAL(&stats_lock);
+
+    return 0;
+}
+
+// ===== API Pública =====
+
+uint16_t ble_server_cmd_conn_handle(void)
+{
+    return origin_conn;
+}
+
+esp_err_t ble_server_get_cmd_stats(ble_server_cmd_stats_t *out)
+{
+    if (out == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (cmd_queue == NULL)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    portENTER_CRITICAL(&stats_lock);
+    *out = stats;
+    if (stats.executed > 0)
+    {
+        out->wait_us_avg = (uint32_t)(wait_us_total / stats.executed);
+        out->exec_us_avg = (uint32_t)(exec_us_total / stats.executed);
+    }
+    portEXIT_CRITICAL(&stats_lock);
+
+    out->depth = uxQueueMessagesWaiting(cmd_queue);
+    return ESP_OK;
+}
@@ -0,0 +1,244 @@
+// components/ble_server/src/ble_server_coalesce.c
+// Agregador de notificações: registros pequenos que chegam dentro da janela
+// configurada são empacotados como [len][dados]... numa única notificação,
+// limitada pelo menor MTU entre os clientes inscritos.
+#include "ble_server_priv.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include <string.h>
+
+static const char *TAG = "BLE_COALESCE";
+
+// Payload máximo de uma notificação com o MTU preferido (cabeçalho ATT = 3)
+#define COALESCE_BUF_SIZE (CONFIG_BT_NIMBLE_ATT_PREFERRED_MTU - 3)
+
+static SemaphoreHandle_t coalesce_mutex = NULL;
+static esp_timer_handle_t window_timer = NULL;
+static uint8_t packet_buf[COALESCE_BUF_SIZE];
+static uint16_t packet_fill;
+static uint16_t packet_records;
+static ble_server_coalesce_stats_t stats;
+
+// Capacidade do pacote para os clientes atuais
+static uint16_t packet_capacity(void)
+{
+    uint16_t mtu = ble_server_conn_min_subscribed_mtu();
+    uint16_t cap = mtu > 3 ? mtu - 3 : 0;
+
+    return cap > COALESCE_BUF_SIZE ? COALESCE_BUF_SIZE : cap;
+}
+
+// Envia packet_buf[start, end), com `records` registros
+static void send_segment(uint16_t start, uint16_t end, uint16_t records)
+{
+    esp_err_t err = ble_server_notify(&packet_buf[start], end - start);
+    if (err == ESP_OK)
+    {
+        stats.packets++;
+        stats.packets_saved += records - 1;
+    }
+    else
+    {
+        stats.records_dropped += records;
+    }
+}
+
+// Envia o pacote acumulado (chamador segura coalesce_mutex). Um cliente com
+// MTU menor pode ter se inscrito durante a janela: o pacote é dividido nos
+// limites dos registros para caber na capacidade atual.
+static void flush_locked(void)
+{
+    uint16_t cap = packet_capacity();
+    uint16_t start = 0;
+    uint16_t pos = 0;
+    uint16_t records = 0;
+
+    if (packet_fill == 0)
+    {
+        return;
+    }
+
+    esp_timer_stop(window_timer);
+
+    while (pos < packet_fill)
+    {
+        uint16_t rec_len = 1 + packet_buf[pos];
+
+        // Registro maior que o novo MTU não pode ser entregue
+        if (rec_len > cap)
+        {
+            if (records > 0)
+                send_segment(start, pos, records);
+            stats.records_dropped++;
+            pos += rec_len;
+            start = pos;
+            records = 0;
+            continue;
+        }
+        if (pos + rec_len - start > cap)
+        {
+            send_segment(start, pos, records);
+            start = pos;
+            records = 0;
+        }
+        pos += rec_len;
+        records++;
+    }
+    if (records > 0)
+    {
+        send_segment(start, pos, records);
+    }
+
+    ESP_LOGD(TAG, "Pacote enviado: %d registros, %d bytes", packet_records, packet_fill);
+    packet_fill = 0;
+    packet_records = 0;
+}
+
+static void window_timer_cb(void *arg)
+{
+    xSemaphoreTake(coalesce_mutex, portMAX_DELAY);
+    stats.flush_window++;
+    flush_locked();
+    xSemaphoreGive(coalesce_mutex);
+}
+
+// ===== Interface interna =====
+
+esp_err_t ble_server_coalesce_init(void)
+{
+    if (server_config.coalesce_window_ms == 0)
+    {
+        return ESP_OK;
+    }
+
+    coalesce_mutex = xSemaphoreCreateMutex();
+    if (coalesce_mutex == NULL)
+    {
+        ESP_LOGE(TAG, "Falha ao criar Mutex!");
+        return ESP_ERR_NO_MEM;
+    }
+
+    const esp_timer_create_args_t timer_args = {
+        .callback = window_timer_cb,
+        .name = "ble_coalesce",
+    };
+    esp_err_t err = esp_timer_create(&timer_args, &window_timer);
+    if (err != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Falha ao criar timer: %s", esp_err_to_name(err));
+        vSemaphoreDelete(coalesce_mutex);
+        coalesce_mutex = NULL;
+        return err;
+    }
+
+    ESP_LOGI(TAG, "Agregação de notificações ativa: janela=%d ms", server_config.coalesce_window_ms);
+    return ESP_OK;
+}
+
+void ble_server_coalesce_on_mtu_change(void)
+{
+    if (coalesce_mutex == NULL)
+    {
+        return;
+    }
+
+    // Pacote já passou do novo limite: envia agora, dividido
+    xSemaphoreTake(coalesce_mutex, portMAX_DELAY);
+    if (packet_fill > packet_capacity())
+    {
+        stats.flush_full++;
+        flush_locked();
+    }
+    xSemaphoreGive(coalesce_mutex);
+}
+
+// ===== API Pública =====
+
+esp_err_t ble_server_notify_record(const uint8_t *data, uint8_t len)
+{
+    if (data == NULL || len == 0)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // Agregação desativada: cada registro vira uma notificação
+    if (coalesce_mutex == NULL)
+    {
+        uint8_t single[1 + UINT8_MAX];
+        single[0] = len;
+        memcpy(&single[1], data, len);
+        return ble_server_notify(single, len + 1);
+    }
+
+    xSemaphoreTake(coalesce_mutex, portMAX_DELAY);
+
+    uint16_t cap = packet_capacity();
+    if (cap == 0)
+    {
+        xSemaphoreGive(coalesce_mutex);
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (len + 1 > cap)
+    {
+        xSemaphoreGive(coalesce_mutex);
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    // Não cabe no pacote atual: envia o que já existe
+    if (packet_fill + 1 + len > cap)
+    {
+        stats.flush_full++;
+        flush_locked();
+    }
+
+    packet_buf[packet_fill++] = len;
+    memcpy(&packet_buf[packet_fill], data, len);
+    packet_fill += len;
+    packet_records++;
+    stats.records++;
+
+    // Primeiro registro abre a janela
+    if (packet_records == 1)
+    {
+        esp_timer_start_once(window_timer, (uint64_t)server_config.coalesce_window_ms * 1000);
+    }
+
+    xSemaphoreGive(coalesce_mutex);
+    return ESP_OK;
+}
+
+esp_err_t ble_server_notify_flush(void)
+{
+    if (coalesce_mutex == NULL)
+    {
+        return ESP_OK;
+    }
+
+    xSemaphoreTake(coalesce_mutex, portMAX_DELAY);
+    if (packet_fill > 0)
+    {
+        stats.flush_manual++;
+    }
+    flush_locked();
+    xSemaphoreGive(coalesce_mutex);
+    return ESP_OK;
+}
+
+esp_err_t ble_server_get_coalesce_stats(ble_server_coalesce_stats_t *out)
+{
+    if (out == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (coalesce_mutex == NULL)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    xSemaphoreTake(coalesce_mutex, portMAX_DELAY);
+    *out = stats;
+    xSemaphoreGive(coalesce_mutex);
+    return ESP_OK;
+}
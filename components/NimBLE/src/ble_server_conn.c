@@ -0,0 +1,267 @@
+// components/ble_server/src/ble_server_conn.c
+// Tabela de conexões: um slot por conexão permitida pelo controlador.
+// Escrita pela task do host (eventos GAP) e lida pela aplicação (notify).
+#include "ble_server_priv.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+
+static const char *TAG = "BLE_CONN";
+
+static ble_conn_t conns[BLE_SERVER_MAX_CONNS];
+static portMUX_TYPE conn_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// Busca sem lock (chamador segura conn_lock)
+static ble_conn_t *conn_find_locked(uint16_t handle)
+{
+    for (int i = 0; i < BLE_SERVER_MAX_CONNS; i++)
+    {
+        if (conns[i].in_use && conns[i].handle == handle)
+        {
+            return &conns[i];
+        }
+    }
+    return NULL;
+}
+
+static void conn_to_info(const ble_conn_t *conn, ble_server_conn_info_t *info)
+{
+    info->conn_handle = conn->handle;
+    info->mtu = conn->mtu;
+    info->subscribed = conn->subscribed;
+    info->encrypted = conn->encrypted;
+    info->authenticated = conn->authenticated;
+    info->bonded = conn->bonded;
+    info->key_size = conn->key_size;
+    info->connected_ms = (uint32_t)((esp_timer_get_time() - conn->connected_at) / 1000);
+    info->rx_writes = conn->rx_writes;
+    info->rx_bytes = conn->rx_bytes;
+    info->tx_notifies = conn->tx_notifies;
+    info->tx_errors = conn->tx_errors;
+}
+
+// ===== Interface interna =====
+
+void ble_server_conn_reset(void)
+{
+    portENTER_CRITICAL(&conn_lock);
+    for (int i = 0; i < BLE_SERVER_MAX_CONNS; i++)
+    {
+        conns[i].in_use = false;
+    }
+    portEXIT_CRITICAL(&conn_lock);
+}
+
+bool ble_server_conn_add(uint16_t handle)
+{
+    bool added = false;
+
+    portENTER_CRITICAL(&conn_lock);
+    for (int i = 0; i < BLE_SERVER_MAX_CONNS; i++)
+    {
+        if (!conns[i].in_use)
+        {
+            conns[i] = (ble_conn_t){
+                .in_use = true,
+                .handle = handle,
+                .mtu = BLE_ATT_MTU_DFLT,
+                .connected_at = esp_timer_get_time(),
+            };
+            added = true;
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&conn_lock);
+
+    if (!added)
+    {
+        ESP_LOGW(TAG, "Tabela de conexões cheia: handle=%d", handle);
+    }
+    return added;
+}
+
+void ble_server_conn_remove(uint16_t handle)
+{
+    portENTER_CRITICAL(&conn_lock);
+    ble_conn_t *conn = conn_find_locked(handle);
+    if (conn)
+    {
+        conn->in_use = false;
+    }
+    portEXIT_CRITICAL(&conn_lock);
+}
+
+int ble_server_conn_count(void)
+{
+    int count = 0;
+
+    portENTER_CRITICAL(&conn_lock);
+    for (int i = 0; i < BLE_SERVER_MAX_CONNS; i++)
+    {
+        if (conns[i].in_use)
+            count++;
+    }
+    portEXIT_CRITICAL(&conn_lock);
+
+    return count;
+}
+
+void ble_server_conn_set_mtu(uint16_t handle, uint16_t mtu)
+{
+    portENTER_CRITICAL(&conn_lock);
+    ble_conn_t *conn = conn_find_locked(handle);
+    if (conn)
+    {
+        conn->mtu = mtu;
+    }
+    portEXIT_CRITICAL(&conn_lock);
+}
+
+void ble_server_conn_set_subscribed(uint16_t handle, bool subscribed)
+{
+    portENTER_CRITICAL(&conn_lock);
+    ble_conn_t *conn = conn_find_locked(handle);
+    if (conn)
+    {
+        conn->subscribed = subscribed;
+    }
+    portEXIT_CRITICAL(&conn_lock);
+}
+
+bool ble_server_conn_is_subscribed(uint16_t handle)
+{
+    bool subscribed;
+
+    portENTER_CRITICAL(&conn_lock);
+    ble_conn_t *conn = conn_find_locked(handle);
+    subscribed = conn != NULL && conn->subscribed;
+    portEXIT_CRITICAL(&conn_lock);
+
+    return subscribed;
+}
+
+void ble_server_conn_refresh_security(uint16_t handle)
+{
+    struct ble_gap_conn_desc desc;
+
+    if (ble_gap_conn_find(handle, &desc) != 0)
+    {
+        return;
+    }
+
+    portENTER_CRITICAL(&conn_lock);
+    ble_conn_t *conn = conn_find_locked(handle);
+    if (conn)
+    {
+        conn->encrypted = desc.sec_state.encrypted;
+        conn->authenticated = desc.sec_state.authenticated;
+        conn->bonded = desc.sec_state.bonded;
+        conn->key_size = desc.sec_state.key_size;
+    }
+    portEXIT_CRITICAL(&conn_lock);
+}
+
+void ble_server_conn_on_rx(uint16_t handle, uint16_t len)
+{
+    portENTER_CRITICAL(&conn_lock);
+    ble_conn_t *conn = conn_find_locked(handle);
+    if (conn)
+    {
+        conn->rx_writes++;
+        conn->rx_bytes += len;
+    }
+    portEXIT_CRITICAL(&conn_lock);
+}
+
+void ble_server_conn_on_tx(uint16_t handle, bool ok)
+{
+    portENTER_CRITICAL(&conn_lock);
+    ble_conn_t *conn = conn_find_locked(handle);
+    if (conn)
+    {
+        if (ok)
+            conn->tx_notifies++;
+        else
+            conn->tx_errors++;
+    }
+    portEXIT_CRITICAL(&conn_lock);
+}
+
+int ble_server_conn_subscribers(uint16_t *handles, int max)
+{
+    int count = 0;
+
+    portENTER_CRITICAL(&conn_lock);
+    for (int i = 0; i < BLE_SERVER_MAX_CONNS && count < max; i++)
+    {
+        if (conns[i].in_use && conns[i].subscribed)
+        {
+            handles[count++] = conns[i].handle;
+        }
+    }
+    portEXIT_CRITICAL(&conn_lock);
+
+    return count;
+}
+
+uint16_t ble_server_conn_min_subscribed_mtu(void)
+{
+    uint16_t mtu = 0;
+
+    portENTER_CRITICAL(&conn_lock);
+    for (int i = 0; i < BLE_SERVER_MAX_CONNS; i++)
+    {
+        if (conns[i].in_use && conns[i].subscribed && (mtu == 0 || conns[i].mtu < mtu))
+        {
+            mtu = conns[i].mtu;
+        }
+    }
+    portEXIT_CRITICAL(&conn_lock);
+
+    return mtu;
+}
+
+// ===== API Pública =====
+
+esp_err_t ble_server_get_conn_info(uint16_t conn_handle, ble_server_conn_info_t *info)
+{
+    esp_err_t err = ESP_ERR_NOT_FOUND;
+
+    if (info == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    portENTER_CRITICAL(&conn_lock);
+    ble_conn_t *conn = conn_find_locked(conn_handle);
+    if (conn)
+    {
+        conn_to_info(conn, info);
+        err = ESP_OK;
+    }
+    portEXIT_CRITICAL(&conn_lock);
+
+    return err;
+}
+
+int ble_server_get_conns(ble_server_conn_info_t *infos, int max)
+{
+    int count = 0;
+
+    if (infos == NULL)
+    {
+        return 0;
+    }
+
+    portENTER_CRITICAL(&conn_lock);
+    for (int i = 0; i < BLE_SERVER_MAX_CONNS && count < max; i++)
+    {
+        if (conns[i].in_use)
+        {
+            conn_to_info(&conns[i], &infos[count++]);
+        }
+    }
+    portEXIT_CRITICAL(&conn_lock);
+
+    return count;
+}
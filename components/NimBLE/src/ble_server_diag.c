@@ -0,0 +1,360 @@
+// components/ble_server/src/ble_server_diag.c
+// Diagnóstico de latência dos comandos. Pontos de medição com o esp_timer
+// em cada etapa (chegada do write ATT, início e fim do on_write, primeira
+// notificação para a conexão) alimentam histogramas de buckets fixos;
+// cada characteristic tem contadores e o histograma do próprio handler.
+// Tudo é lido pela characteristic Diag (layout em ble_server.h). Os 120
+// bytes passam do MTU padrão: a leitura longa chama o handler a cada Read
+// Blob, então cada conexão guarda a cópia codificada no primeiro pedaço e
+// serve os seguintes dela.
+#include "ble_server_priv.h"
+#include "freertos/FreeRTOS.h"
+#include <string.h>
+
+#if CONFIG_BLE_SERVER_DIAG
+
+#define DIAG_VERSION 1
+#define DIAG_BUCKET0_US 250 // Limite superior do primeiro bucket; os seguintes dobram
+#define DIAG_HDR_LEN 4
+#define DIAG_HIST_LEN (BLE_SERVER_DIAG_BUCKETS * 2)
+#define DIAG_CHR_LEN (5 * 4 + DIAG_HIST_LEN)
+#define DIAG_READ_LEN (DIAG_HDR_LEN + BLE_SERVER_DIAG_STAGE_COUNT * DIAG_HIST_LEN + DIAG_CHR_LEN)
+#define DIAG_READ_LONG_US (3 * 1000 * 1000) // Read Blob atrasado além disso abre nova leitura
+
+typedef struct
+{
+    uint16_t counts[BLE_SERVER_DIAG_BUCKETS]; // Saturam em 0xFFFF
+} diag_hist_t;
+
+typedef struct
+{
+    uint32_t reads;
+    uint32_t writes;
+    uint32_t errors; // Acessos que retornaram erro ATT
+    uint32_t rx_bytes;
+    uint32_t tx_bytes;
+    diag_hist_t handler;
+} diag_chr_t;
+
+typedef struct
+{
+    uint16_t conn_handle;
+    int64_t arrived_at; // 0 = nenhum comando aguardando resultado
+} diag_pending_t;
+
+// Escritos pelo host, pela tarefa de comandos e por quem notifica
+static diag_hist_t stages[BLE_SERVER_DIAG_STAGE_COUNT];
+static diag_chr_t chrs[BLE_SERVER_MAX_CHRS];
+static diag_pending_t pending[BLE_SERVER_MAX_CONNS];
+static portMUX_TYPE diag_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// Cópia da leitura longa em andamento numa conexão
+typedef struct
+{
+    uint16_t conn_handle;
+    uint8_t blobs_left; // Read Blob ainda esperados; 0 = próxima leitura recopia
+    int64_t taken_at;
+    uint8_t buf[DIAG_READ_LEN];
+} diag_read_t;
+
+// Apenas na task do host
+static int chr_count;
+static uint8_t selected;
+static diag_read_t reads[BLE_SERVER_MAX_CONNS];
+
+static int diag_bucket(int64_t us)
+{
+    int bucket = 0;
+
+    for (int64_t limit = DIAG_BUCKET0_US; us >= limit && bucket < BLE_SERVER_DIAG_BUCKETS - 1; limit <<= 1)
+    {
+        bucket++;
+    }
+    return bucket;
+}
+
+// Chamar com diag_lock
+static void hist_add_locked(diag_hist_t *hist, int64_t us)
+{
+    uint16_t *count = &hist->counts[diag_bucket(us)];
+
+    if (*count < UINT16_MAX)
+        (*count)++;
+}
+
+static uint8_t *put_u16(uint8_t *p, uint16_t v)
+{
+    p[0] = v & 0xFF;
+    p[1] = v >> 8;
+    return p + 2;
+}
+
+static uint8_t *put_u32(uint8_t *p, uint32_t v)
+{
+    p[0] = v & 0xFF;
+    p[1] = (v >> 8) & 0xFF;
+    p[2] = (v >> 16) & 0xFF;
+    p[3] = v >> 24;
+    return p + 4;
+}
+
+static uint8_t *put_hist(uint8_t *p, const diag_hist_t *hist)
+{
+    for (int i = 0; i < BLE_SERVER_DIAG_BUCKETS; i++)
+    {
+        p = put_u16(p, hist->counts[i]);
+    }
+    return p;
+}
+
+// ===== Interface interna =====
+
+void ble_server_diag_init(int count)
+{
+    chr_count = count;
+}
+
+void ble_server_diag_access(uint8_t index, bool write, uint16_t len, int64_t started_at, int rc)
+{
+    int64_t us = esp_timer_get_time() - started_at;
+
+    if (index >= BLE_SERVER_MAX_CHRS)
+    {
+        return;
+    }
+
+    diag_chr_t *chr = &chrs[index];
+    portENTER_CRITICAL(&diag_lock);
+    if (write)
+    {
+        chr->writes++;
+        chr->rx_bytes += len;
+    }
+    else
+    {
+        chr->reads++;
+        chr->tx_bytes += len;
+    }
+    if (rc != 0)
+        chr->errors++;
+    hist_add_locked(&chr->handler, us);
+    portEXIT_CRITICAL(&diag_lock);
+}
+
+void ble_server_diag_cmd_arrival(uint16_t conn_handle, int64_t at)
+{
+    diag_pending_t *free_slot = NULL;
+
+    portENTER_CRITICAL(&diag_lock);
+    for (int i = 0; i < BLE_SERVER_MAX_CONNS; i++)
+    {
+        if (pending[i].arrived_at != 0 && pending[i].conn_handle == conn_handle)
+        {
+            // Comando anterior sem resultado: mede a partir do mais recente
+            free_slot = &pending[i];
+            break;
+        }
+        if (pending[i].arrived_at == 0 && free_slot == NULL)
+        {
+            free_slot = &pending[i];
+        }
+    }
+    if (free_slot)
+    {
+        free_slot->conn_handle = conn_handle;
+        free_slot->arrived_at = at;
+    }
+    portEXIT_CRITICAL(&diag_lock);
+}
+
+void ble_server_diag_dispatch(uint16_t conn_handle)
+{
+    int64_t now = esp_timer_get_time();
+
+    portENTER_CRITICAL(&diag_lock);
+    for (int i = 0; i < BLE_SERVER_MAX_CONNS; i++)
+    {
+        if (pending[i].arrived_at != 0 && pending[i].conn_handle == conn_handle)
+        {
+            hist_add_locked(&stages[BLE_SERVER_DIAG_STAGE_DISPATCH], now - pending[i].arrived_at);
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&diag_lock);
+}
+
+void ble_server_diag_stage(ble_server_diag_stage_t stage, int64_t started_at)
+{
+    int64_t us = esp_timer_get_time() - started_at;
+
+    portENTER_CRITICAL(&diag_lock);
+    hist_add_locked(&stages[stage], us);
+    portEXIT_CRITICAL(&diag_lock);
+}
+
+void ble_server_diag_on_notify(uint16_t conn_handle)
+{
+    int64_t now = esp_timer_get_time();
+
+    portENTER_CRITICAL(&diag_lock);
+    for (int i = 0; i < BLE_SERVER_MAX_CONNS; i++)
+    {
+        if (pending[i].arrived_at != 0 && pending[i].conn_handle == conn_handle)
+        {
+            hist_add_locked(&stages[BLE_SERVER_DIAG_STAGE_RESULT], now - pending[i].arrived_at);
+            pending[i].arrived_at = 0;
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&diag_lock);
+}
+
+void ble_server_diag_conn_close(uint16_t conn_handle)
+{
+    portENTER_CRITICAL(&diag_lock);
+    for (int i = 0; i < BLE_SERVER_MAX_CONNS; i++)
+    {
+        if (pending[i].conn_handle == conn_handle)
+        {
+            pending[i].arrived_at = 0;
+        }
+    }
+    portEXIT_CRITICAL(&diag_lock);
+
+    for (int i = 0; i < BLE_SERVER_MAX_CONNS; i++)
+    {
+        if (reads[i].conn_handle == conn_handle)
+        {
+            reads[i].taken_at = 0;
+            reads[i].blobs_left = 0;
+        }
+    }
+}
+
+// Codifica a partir de cópias tiradas sob o lock
+static void diag_encode(uint8_t *buf)
+{
+    diag_hist_t stage_copy[BLE_SERVER_DIAG_STAGE_COUNT];
+    diag_chr_t chr_copy;
+    uint8_t *p = buf;
+
+    portENTER_CRITICAL(&diag_lock);
+    memcpy(stage_copy, stages, sizeof(stage_copy));
+    chr_copy = chrs[selected];
+    portEXIT_CRITICAL(&diag_lock);
+
+    *p++ = DIAG_VERSION;
+    *p++ = (uint8_t)chr_count;
+    *p++ = BLE_SERVER_DIAG_BUCKETS;
+    *p++ = selected;
+    for (int i = 0; i < BLE_SERVER_DIAG_STAGE_COUNT; i++)
+    {
+        p = put_hist(p, &stage_copy[i]);
+    }
+    p = put_u32(p, chr_copy.reads);
+    p = put_u32(p, chr_copy.writes);
+    p = put_u32(p, chr_copy.errors);
+    p = put_u32(p, chr_copy.rx_bytes);
+    p = put_u32(p, chr_copy.tx_bytes);
+    put_hist(p, &chr_copy.handler);
+}
+
+// Cada resposta leva MTU - 1 bytes; o cliente pede Read Blob enquanto a
+// resposta vier cheia, inclusive um vazio se o valor for múltiplo exato
+static uint8_t diag_blobs_after_first(uint16_t conn_handle)
+{
+    uint16_t mtu = ble_att_mtu(conn_handle);
+
+    if (mtu < BLE_ATT_MTU_DFLT)
+    {
+        mtu = BLE_ATT_MTU_DFLT;
+    }
+    return DIAG_READ_LEN / (mtu - 1);
+}
+
+static diag_read_t *diag_read_slot(uint16_t conn_handle)
+{
+    diag_read_t *free_slot = NULL;
+
+    for (int i = 0; i < BLE_SERVER_MAX_CONNS; i++)
+    {
+        if (reads[i].taken_at != 0 && reads[i].conn_handle == conn_handle)
+        {
+            return &reads[i];
+        }
+        if (reads[i].taken_at == 0 && free_slot == NULL)
+        {
+            free_slot = &reads[i];
+        }
+    }
+    return free_slot;
+}
+
+static void diag_reads_invalidate(void)
+{
+    for (int i = 0; i < BLE_SERVER_MAX_CONNS; i++)
+    {
+        reads[i].blobs_left = 0;
+    }
+}
+
+int ble_server_diag_on_read(uint16_t conn_handle, struct os_mbuf *om, void *arg)
+{
+    int64_t now = esp_timer_get_time();
+    diag_read_t *rd = diag_read_slot(conn_handle);
+
+    if (rd == NULL)
+    {
+        uint8_t buf[DIAG_READ_LEN];
+
+        diag_encode(buf);
+        return os_mbuf_append(om, buf, sizeof(buf)) == 0 ? 0 : BLE_ATT_ERR_INSUFFICIENT_RES;
+    }
+
+    // O NimBLE recorta o valor pelo offset do Read Blob: os pedaços seguintes
+    // precisam sair da mesma cópia, senão o cliente remonta histogramas mistos
+    if (rd->blobs_left > 0 && now - rd->taken_at < DIAG_READ_LONG_US)
+    {
+        rd->blobs_left--;
+    }
+    else
+    {
+        diag_encode(rd->buf);
+        rd->conn_handle = conn_handle;
+        rd->taken_at = now;
+        rd->blobs_left = diag_blobs_after_first(conn_handle);
+    }
+
+    return os_mbuf_append(om, rd->buf, sizeof(rd->buf)) == 0 ? 0 : BLE_ATT_ERR_INSUFFICIENT_RES;
+}
+
+int ble_server_diag_on_write(uint16_t conn_handle, const ble_mbuf_view_t *view, void *arg)
+{
+    uint8_t index;
+
+    if (view->len != 1)
+    {
+        return BLE_ATT_ERR_INVALID_ATTR_VALUE_LEN;
+    }
+
+    ble_mbuf_view_read(view, 0, &index, 1);
+    if (index == BLE_SERVER_DIAG_RESET)
+    {
+        portENTER_CRITICAL(&diag_lock);
+        memset(stages, 0, sizeof(stages));
+        memset(chrs, 0, sizeof(chrs));
+        portEXIT_CRITICAL(&diag_lock);
+        diag_reads_invalidate();
+        return 0;
+    }
+    if (index >= chr_count)
+    {
+        return BLE_ATT_ERR_VALUE_NOT_ALLOWED;
+    }
+
+    selected = index;
+    diag_reads_invalidate();
+    return 0;
+}
+
+#endif
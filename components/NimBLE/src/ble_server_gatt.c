@@ -0,0 +1,340 @@
+// components/ble_server/src/ble_server_gatt.c
+// Registro declarativo de characteristics. As characteristics internas
+// (Command, Status, Data/Hora, Long Write, Auth) e as registradas pela aplicação
+// usam o mesmo mecanismo: a tabela do NimBLE é montada a partir das
+// declarações e cada acesso chega direto à entrada certa pelo `arg`, sem
+// comparar UUIDs.
+#include "ble_server_priv.h"
+#include "esp_log.h"
+#include "time_sync.h"
+#include <string.h>
+#include <time.h>
+
+static const char *TAG = "BLE_GATT";
+
+// ===== UUIDs (128-bit customizados) =====
+// Gerados com: uuidgen (Linux) ou online em uuidgenerator.net
+
+// Service UUID: Lock Control Service
+//"12345678-5678-1234-7856-12349abcdef0"
+const ble_uuid128_t gatt_svr_svc_uuid =
+    BLE_UUID128_INIT(
+        0x23, 0xd1, 0xbc, 0xea, 0x5f, 0x78, 0x23, 0x15,
+        0xde, 0xef, 0x12, 0x12, 0x23, 0x15, 0x00, 0x00);
+
+// Characteristic UUID: Command (Write)
+static const ble_uuid128_t gatt_svr_chr_cmd_uuid =
+    BLE_UUID128_INIT(
+        0x23, 0xd1, 0xbc, 0xea, 0x5f, 0x78, 0x23, 0x15,
+        0xde, 0xef, 0x12, 0x12, 0x25, 0x15, 0x00, 0x00);
+
+// Characteristic UUID: Status (Read + Notify)
+static const ble_uuid128_t gatt_svr_chr_status_uuid =
+    BLE_UUID128_INIT(
+        0x23, 0xd1, 0xbc, 0xea, 0x5f, 0x78, 0x23, 0x15,
+        0xde, 0xef, 0x12, 0x12, 0x24, 0x15, 0x00, 0x00);
+
+static const ble_uuid128_t gatt_svr_chr_datetime_uuid =
+    BLE_UUID128_INIT(
+        0x23, 0xd1, 0xbc, 0xea, 0x5f, 0x78, 0x23, 0x15,
+        0xde, 0xef, 0x12, 0x12, 0x26, 0x15, 0x00, 0x00);
+
+// Characteristic UUID: Long Write (objetos segmentados > 512 bytes)
+static const ble_uuid128_t gatt_svr_chr_longwr_uuid =
+    BLE_UUID128_INIT(
+        0x23, 0xd1, 0xbc, 0xea, 0x5f, 0x78, 0x23, 0x15,
+        0xde, 0xef, 0x12, 0x12, 0x27, 0x15, 0x00, 0x00);
+
+// Characteristic UUID: Auth (Read, nonce da sessão de comandos autenticados)
+static const ble_uuid128_t gatt_svr_chr_auth_uuid =
+    BLE_UUID128_INIT(
+        0x23, 0xd1, 0xbc, 0xea, 0x5f, 0x78, 0x23, 0x15,
+        0xde, 0xef, 0x12, 0x12, 0x28, 0x15, 0x00, 0x00);
+
+#if CONFIG_BLE_SERVER_DIAG
+// Characteristic UUID: Diag (Read + Write, latências e contadores)
+static const ble_uuid128_t gatt_svr_chr_diag_uuid =
+    BLE_UUID128_INIT(
+        0x23, 0xd1, 0xbc, 0xea, 0x5f, 0x78, 0x23, 0x15,
+        0xde, 0xef, 0x12, 0x12, 0x29, 0x15, 0x00, 0x00);
+#endif
+
+// ===== Estado =====
+uint16_t status_val_handle; // Handle da characteristic Status
+
+// ===== Characteristics internas =====
+
+// Caminho legado: copia o write para o on_write da aplicação. Fora de
+// cmd_on_write para o buffer de 512 bytes só ocupar a pilha do host quando
+// este caminho é usado (o GCC reserva o frame inteiro na entrada da função).
+static __attribute__((noinline)) int cmd_write_flat(uint16_t conn_handle, const ble_mbuf_view_t *view)
+{
+    uint8_t data[512];
+    uint16_t len = view->len;
+    if (len > sizeof(data))
+        len = sizeof(data);
+
+    ble_mbuf_view_read(view, 0, data, len);
+
+    // Chama callback da aplicação
+    ble_server_cmd_exec(conn_handle, data, len);
+    return 0;
+}
+
+// Command (Write)
+static int cmd_on_write(uint16_t conn_handle, const ble_mbuf_view_t *view, void *arg)
+{
+    ESP_LOGI(TAG, "Write recebido: %d bytes", view->len);
+    ble_server_policy_on_command(conn_handle);
+
+    // Caminho sem cópia: aplicação interpreta o mbuf no lugar
+    if (server_config.on_write_view)
+    {
+        int64_t cb_at = ble_server_probe_now();
+        ble_server_diag_dispatch(conn_handle);
+        ble_server_cmd_set_origin(conn_handle);
+        server_config.on_write_view(view);
+        ble_server_cmd_set_origin(BLE_SERVER_NOTIFY_ALL);
+        ble_server_trace_end(BLE_SERVER_TRACE_APP_CB, BLE_SERVER_TRACE_CB_WRITE_VIEW,
+                             conn_handle, cb_at, 0);
+        ble_server_diag_stage(BLE_SERVER_DIAG_STAGE_EXEC, cb_at);
+        return 0;
+    }
+
+    // Modo assíncrono: enfileira e responde o write imediatamente
+    if (ble_server_cmd_is_async())
+    {
+        return ble_server_cmd_submit(conn_handle, view->om);
+    }
+
+    return cmd_write_flat(conn_handle, view);
+}
+
+// Data e Hora (Write): [ano-2000][mês][dia][hora][min][seg][dia da semana]
+// opcionalmente seguido de [ms (LE, 2 bytes)] para referência sub-segundo.
+// Horário em UTC (TZ não configurado); ajusta o relógio via time_sync.
+#define DATETIME_LEN 7
+#define DATETIME_MS_LEN 9
+
+static int datetime_on_write(uint16_t conn_handle, const ble_mbuf_view_t *view, void *arg)
+{
+    uint8_t data[DATETIME_MS_LEN] = {0};
+    uint16_t ms = 0;
+
+    if (view->len != DATETIME_LEN && view->len != DATETIME_MS_LEN)
+    {
+        return BLE_ATT_ERR_INVALID_ATTR_VALUE_LEN;
+    }
+
+    ble_mbuf_view_read(view, 0, data, view->len);
+    if (view->len == DATETIME_MS_LEN)
+    {
+        ms = data[7] | (data[8] << 8);
+    }
+
+    struct tm tm = {
+        .tm_year = data[0] + 100,
+        .tm_mon = data[1] - 1,
+        .tm_mday = data[2],
+        .tm_hour = data[3],
+        .tm_min = data[4],
+        .tm_sec = data[5],
+    };
+    if (data[1] < 1 || data[1] > 12 || data[2] < 1 || data[2] > 31 ||
+        data[3] > 23 || data[4] > 59 || data[5] > 59 || ms > 999)
+    {
+        return BLE_ATT_ERR_VALUE_NOT_ALLOWED;
+    }
+
+    time_t t = mktime(&tm);
+    if (t == (time_t)-1)
+    {
+        return BLE_ATT_ERR_VALUE_NOT_ALLOWED;
+    }
+
+    ESP_LOGI(TAG, "Data/Hora: %02d/%02d/20%02d %02d:%02d:%02d.%03d",
+             data[2], data[1], data[0], data[3], data[4], data[5], ms);
+
+    time_sync_set((int64_t)t * 1000000 + (int64_t)ms * 1000,
+                  view->len == DATETIME_MS_LEN ? 1000 : 1000000);
+    return 0;
+}
+
+// Long Write (Write, aceita writes longos/preparados)
+static int longwr_on_write(uint16_t conn_handle, const ble_mbuf_view_t *view, void *arg)
+{
+    return ble_server_longwr_on_write(conn_handle, view->om);
+}
+
+static const ble_server_chr_def_t builtin_chrs[] = {
+    {
+        .uuid = &gatt_svr_chr_cmd_uuid.u,
+        .flags = BLE_GATT_CHR_F_WRITE | BLE_GATT_CHR_F_WRITE_NO_RSP,
+        .on_write = cmd_on_write,
+    },
+    {
+        .uuid = &gatt_svr_chr_status_uuid.u,
+        .flags = BLE_GATT_CHR_F_READ | BLE_GATT_CHR_F_NOTIFY,
+        .on_read = ble_server_status_on_read,
+        .val_handle = &status_val_handle,
+    },
+    {
+        .uuid = &gatt_svr_chr_datetime_uuid.u,
+        .flags = BLE_GATT_CHR_F_WRITE,
+        .on_write = datetime_on_write,
+    },
+    {
+        .uuid = &gatt_svr_chr_longwr_uuid.u,
+        .flags = BLE_GATT_CHR_F_WRITE,
+        .on_write = longwr_on_write,
+    },
+    {
+        .uuid = &gatt_svr_chr_auth_uuid.u,
+        .flags = BLE_GATT_CHR_F_READ,
+        .on_read = ble_server_auth_on_read,
+    },
+#if CONFIG_BLE_SERVER_DIAG
+    {
+        .uuid = &gatt_svr_chr_diag_uuid.u,
+        .flags = BLE_GATT_CHR_F_READ | BLE_GATT_CHR_F_WRITE,
+        .on_read = ble_server_diag_on_read,
+        .on_write = ble_server_diag_on_write,
+    },
+#endif
+};
+
+// Posições em builtin_chrs. Command, Data/Hora e Long Write são os writes
+// que mudam o dispositivo (fechadura, relógio, objetos da aplicação):
+// require_auth das três vem de auth_commands
+#define BUILTIN_CHR_CMD 0
+#define BUILTIN_CHR_DATETIME 2
+#define BUILTIN_CHR_LONGWR 3
+
+#define BUILTIN_CHR_COUNT (sizeof(builtin_chrs) / sizeof(builtin_chrs[0]))
+#define MAX_CHRS (BUILTIN_CHR_COUNT + CONFIG_BLE_SERVER_MAX_APP_CHRS)
+
+_Static_assert(BUILTIN_CHR_COUNT <= BLE_SERVER_BUILTIN_CHRS_MAX, "aumente BLE_SERVER_BUILTIN_CHRS_MAX");
+
+// ===== Registro =====
+
+// Declarações na ordem da tabela: internas primeiro, depois as da aplicação
+static ble_server_chr_def_t chr_registry[MAX_CHRS];
+static int chr_count;
+static int app_chr_count;
+static bool tables_built;
+
+// Tabelas do NimBLE: precisam existir enquanto o host roda
+static struct ble_gatt_chr_def chr_table[MAX_CHRS + 1];
+static struct ble_gatt_svc_def svc_table[2];
+
+// Acesso a qualquer characteristic: `arg` é a própria declaração
+static int gatt_svr_chr_access(uint16_t conn_handle, uint16_t attr_handle,
+                               struct ble_gatt_access_ctxt *ctxt, void *arg)
+{
+    const ble_server_chr_def_t *chr = arg;
+    int64_t started_at = ble_server_probe_now();
+    uint8_t index = (uint8_t)(chr - chr_registry);
+    int rc;
+
+    switch (ctxt->op)
+    {
+    case BLE_GATT_ACCESS_OP_READ_CHR:
+        rc = chr->on_read(conn_handle, ctxt->om, chr->arg);
+        ble_server_trace_end(BLE_SERVER_TRACE_READ, index, conn_handle, started_at, rc);
+        ble_server_diag_access(index, false, OS_MBUF_PKTLEN(ctxt->om), started_at, rc);
+        return rc;
+
+    case BLE_GATT_ACCESS_OP_WRITE_CHR:
+    {
+        ble_mbuf_view_t view;
+        uint16_t len = OS_MBUF_PKTLEN(ctxt->om);
+        ble_server_conn_on_rx(conn_handle, len);
+
+        // Handler só vê o comando: cabeçalho e tag saem do mbuf
+        rc = chr->require_auth ? ble_server_auth_check(conn_handle, ctxt->om) : 0;
+        if (rc == 0)
+        {
+            // Comando aceito: mede até a notificação do resultado
+            if (index == BUILTIN_CHR_CMD)
+            {
+                ble_server_diag_cmd_arrival(conn_handle, started_at);
+            }
+            ble_mbuf_view_init(&view, ctxt->om);
+            rc = chr->on_write(conn_handle, &view, chr->arg);
+        }
+        ble_server_trace_end(BLE_SERVER_TRACE_WRITE, index, conn_handle, started_at, rc);
+        ble_server_diag_access(index, true, len, started_at, rc);
+        return rc;
+    }
+
+    default:
+        ESP_LOGW(TAG, "Operação não suportada: %d", ctxt->op);
+        return BLE_ATT_ERR_UNLIKELY;
+    }
+}
+
+// ===== Interface interna =====
+
+const struct ble_gatt_svc_def *ble_server_gatt_build(void)
+{
+    // Internas vão para o início; as da aplicação já estão logo depois
+    memmove(&chr_registry[BUILTIN_CHR_COUNT], &chr_registry[0],
+            app_chr_count * sizeof(chr_registry[0]));
+    memcpy(&chr_registry[0], builtin_chrs, sizeof(builtin_chrs));
+    chr_registry[BUILTIN_CHR_CMD].require_auth = server_config.auth_commands;
+    chr_registry[BUILTIN_CHR_DATETIME].require_auth = server_config.auth_commands;
+    chr_registry[BUILTIN_CHR_LONGWR].require_auth = server_config.auth_commands;
+    chr_count = BUILTIN_CHR_COUNT + app_chr_count;
+    ble_server_diag_init(chr_count);
+
+    memset(chr_table, 0, sizeof(chr_table));
+    for (int i = 0; i < chr_count; i++)
+    {
+        chr_table[i].uuid = chr_registry[i].uuid;
+        chr_table[i].access_cb = gatt_svr_chr_access;
+        chr_table[i].arg = &chr_registry[i];
+        chr_table[i].flags = chr_registry[i].flags;
+        chr_table[i].val_handle = chr_registry[i].val_handle;
+    }
+
+    memset(svc_table, 0, sizeof(svc_table));
+    svc_table[0].type = BLE_GATT_SVC_TYPE_PRIMARY;
+    svc_table[0].uuid = &gatt_svr_svc_uuid.u;
+    svc_table[0].characteristics = chr_table;
+
+    tables_built = true;
+    ESP_LOGI(TAG, "Tabela GATT: %d characteristics (%d da aplicação)", chr_count, app_chr_count);
+    return svc_table;
+}
+
+// ===== API Pública =====
+
+esp_err_t ble_server_register_chr(const ble_server_chr_def_t *def)
+{
+    if (def == NULL || def->uuid == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // Cada flag de acesso precisa do handler correspondente
+    if ((def->flags & (BLE_GATT_CHR_F_READ | BLE_GATT_CHR_F_WRITE | BLE_GATT_CHR_F_WRITE_NO_RSP)) == 0 ||
+        ((def->flags & BLE_GATT_CHR_F_READ) && def->on_read == NULL) ||
+        ((def->flags & (BLE_GATT_CHR_F_WRITE | BLE_GATT_CHR_F_WRITE_NO_RSP)) && def->on_write == NULL))
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // A tabela do NimBLE é fixada em ble_server_init()
+    if (tables_built)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (app_chr_count == CONFIG_BLE_SERVER_MAX_APP_CHRS)
+    {
+        ESP_LOGE(TAG, "Limite de %d characteristics da aplicação atingido", CONFIG_BLE_SERVER_MAX_APP_CHRS);
+        return ESP_ERR_NO_MEM;
+    }
+
+    chr_registry[app_chr_count++] = *def;
+    return ESP_OK;
+}
@@ -0,0 +1,338 @@
+// components/ble_server/src/ble_server_l2cap.c
+// Canal L2CAP orientado a conexão (CoC) para transferências grandes: logs,
+// blobs de configuração e imagens de firmware. Controle de fluxo por
+// créditos (feito pelo NimBLE), SDUs de um pool fixo e callbacks de
+// streaming: o objeto inteiro nunca precisa estar na RAM.
+#include "ble_server_priv.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "nimble/nimble_port.h"
+
+static const char *TAG = "BLE_BULK";
+
+#if CONFIG_BT_NIMBLE_L2CAP_COC_MAX_NUM > 0
+
+#include "host/ble_l2cap.h"
+
+// Cada bloco comporta um SDU inteiro (cabeçalhos do mbuf incluídos)
+#define BULK_BLOCK_SIZE (CONFIG_BLE_SERVER_L2CAP_MTU + sizeof(struct os_mbuf) + sizeof(struct os_mbuf_pkthdr))
+#define BULK_BLOCK_COUNT CONFIG_BLE_SERVER_L2CAP_SDU_BUF_COUNT
+
+static os_membuf_t bulk_mem[OS_MEMPOOL_SIZE(BULK_BLOCK_COUNT, BULK_BLOCK_SIZE)];
+static struct os_mempool bulk_mempool;
+static struct os_mbuf_pool bulk_mbuf_pool;
+
+// Canal ativo (CONFIG_BT_NIMBLE_L2CAP_COC_MAX_NUM limita a um por vez)
+static struct
+{
+    struct ble_l2cap_chan *chan;
+    uint16_t conn_handle;
+    uint16_t peer_mtu;
+    int64_t rx_started_at;
+    uint32_t rx_bytes;
+} bulk_chan;
+
+// Transferência de saída em andamento
+static struct
+{
+    bool active;
+    ble_bulk_source_cb_t source;
+    void *arg;
+    int64_t started_at;
+    uint32_t bytes;
+} bulk_tx;
+
+static struct ble_npl_event tx_ev;
+static ble_server_bulk_stats_t stats;
+
+static uint32_t kbps(uint32_t bytes, int64_t started_at)
+{
+    int64_t us = esp_timer_get_time() - started_at;
+    return us > 0 ? (uint32_t)((uint64_t)bytes * 8000 / us) : 0;
+}
+
+static void bulk_tx_finish(esp_err_t status)
+{
+    uint32_t rate = kbps(bulk_tx.bytes, bulk_tx.started_at);
+
+    bulk_tx.active = false;
+    if (status == ESP_OK)
+    {
+        stats.tx_transfers++;
+        stats.tx_kbps_last = rate;
+    }
+    else
+    {
+        stats.tx_aborted++;
+    }
+
+    ESP_LOGI(TAG, "Envio %s: %lu bytes, %lu kbit/s",
+             status == ESP_OK ? "concluído" : "abortado", bulk_tx.bytes, rate);
+
+    if (server_config.bulk && server_config.bulk->on_tx_done)
+    {
+        server_config.bulk->on_tx_done(bulk_chan.conn_handle, status, bulk_tx.arg);
+    }
+}
+
+// Monta e envia SDUs até faltar crédito (task do host)
+static void bulk_tx_pump(struct ble_npl_event *ev)
+{
+    while (bulk_tx.active)
+    {
+        if (bulk_chan.chan == NULL)
+        {
+            bulk_tx_finish(ESP_ERR_INVALID_STATE);
+            return;
+        }
+
+        struct os_mbuf *sdu = os_mbuf_get_pkthdr(&bulk_mbuf_pool, 0);
+        if (sdu == NULL)
+        {
+            // Pool ocupado com RX: tenta de novo no próximo desbloqueio
+            return;
+        }
+
+        uint16_t max = bulk_chan.peer_mtu < CONFIG_BLE_SERVER_L2CAP_MTU ? bulk_chan.peer_mtu : CONFIG_BLE_SERVER_L2CAP_MTU;
+        uint8_t *dst = os_mbuf_extend(sdu, max);
+        if (dst == NULL)
+        {
+            os_mbuf_free_chain(sdu);
+            bulk_tx_finish(ESP_ERR_NO_MEM);
+            return;
+        }
+
+        // Fonte escreve direto no SDU
+        int n = bulk_tx.source(bulk_chan.conn_handle, dst, max, bulk_tx.arg);
+        if (n <= 0)
+        {
+            os_mbuf_free_chain(sdu);
+            bulk_tx_finish(n == 0 ? ESP_OK : ESP_FAIL);
+            return;
+        }
+        if (n < max)
+        {
+            os_mbuf_adj(sdu, -(int)(max - n));
+        }
+
+        int rc = ble_l2cap_send(bulk_chan.chan, sdu);
+        if (rc == 0 || rc == BLE_HS_ESTALLED)
+        {
+            bulk_tx.bytes += n;
+            stats.tx_bytes += n;
+
+            // Sem créditos: continua em BLE_L2CAP_EVENT_COC_TX_UNSTALLED
+            if (rc == BLE_HS_ESTALLED)
+            {
+                stats.tx_stalls++;
+                return;
+            }
+            continue;
+        }
+
+        os_mbuf_free_chain(sdu);
+        ESP_LOGE(TAG, "Erro ao enviar SDU: %d", rc);
+        bulk_tx_finish(ESP_FAIL);
+        return;
+    }
+}
+
+static int bulk_post_rx_buf(struct ble_l2cap_chan *chan)
+{
+    struct os_mbuf *sdu_rx = os_mbuf_get_pkthdr(&bulk_mbuf_pool, 0);
+    if (sdu_rx == NULL)
+    {
+        ESP_LOGE(TAG, "Pool de SDUs esgotado");
+        return BLE_HS_ENOMEM;
+    }
+
+    return ble_l2cap_recv_ready(chan, sdu_rx);
+}
+
+static int bulk_l2cap_event(struct ble_l2cap_event *event, void *arg)
+{
+    switch (event->type)
+    {
+    case BLE_L2CAP_EVENT_COC_ACCEPT:
+        // Primeiro buffer de recepção precisa ser entregue ao aceitar
+        return bulk_post_rx_buf(event->accept.chan);
+
+    case BLE_L2CAP_EVENT_COC_CONNECTED:
+    {
+        if (event->connect.status != 0)
+        {
+            ESP_LOGW(TAG, "Falha ao abrir canal: %d", event->connect.status);
+            return 0;
+        }
+
+        struct ble_l2cap_chan_info info;
+        ble_l2cap_get_chan_info(event->connect.chan, &info);
+
+        bulk_chan.chan = event->connect.chan;
+        bulk_chan.conn_handle = event->connect.conn_handle;
+        bulk_chan.peer_mtu = info.peer_coc_mtu;
+        bulk_chan.rx_started_at = esp_timer_get_time();
+        bulk_chan.rx_bytes = 0;
+        stats.channels_opened++;
+
+        ESP_LOGI(TAG, "Canal aberto: conn=%d, psm=0x%02x, mtu local/par=%d/%d",
+                 event->connect.conn_handle, info.psm, info.our_coc_mtu, info.peer_coc_mtu);
+        return 0;
+    }
+
+    case BLE_L2CAP_EVENT_COC_DISCONNECTED:
+        if (bulk_chan.rx_bytes > 0)
+        {
+            stats.rx_kbps_last = kbps(bulk_chan.rx_bytes, bulk_chan.rx_started_at);
+            ESP_LOGI(TAG, "Canal fechado: recebidos %lu bytes, %lu kbit/s",
+                     bulk_chan.rx_bytes, stats.rx_kbps_last);
+        }
+        bulk_chan.chan = NULL;
+        if (bulk_tx.active)
+        {
+            bulk_tx_finish(ESP_ERR_INVALID_STATE);
+        }
+        return 0;
+
+    case BLE_L2CAP_EVENT_COC_DATA_RECEIVED:
+    {
+        struct os_mbuf *sdu_rx = event->receive.sdu_rx;
+        ble_mbuf_view_t view;
+        int rc = 0;
+
+        ble_mbuf_view_init(&view, sdu_rx);
+        bulk_chan.rx_bytes += view.len;
+        stats.rx_bytes += view.len;
+
+        // Sink consome o SDU no lugar; o buffer volta ao pool em seguida
+        if (server_config.bulk->on_rx)
+        {
+            rc = server_config.bulk->on_rx(event->receive.conn_handle, &view, server_config.bulk->arg);
+        }
+        os_mbuf_free_chain(sdu_rx);
+
+        if (rc != 0)
+        {
+            ESP_LOGW(TAG, "Sink recusou os dados (%d), fechando canal", rc);
+            ble_l2cap_disconnect(event->receive.chan);
+            return 0;
+        }
+
+        return bulk_post_rx_buf(event->receive.chan);
+    }
+
+    case BLE_L2CAP_EVENT_COC_TX_UNSTALLED:
+        // Créditos devolvidos pelo par: continua o envio
+        ble_npl_eventq_put(nimble_port_get_dflt_eventq(), &tx_ev);
+        return 0;
+
+    default:
+        return 0;
+    }
+}
+
+// ===== Interface interna =====
+
+esp_err_t ble_server_bulk_init(void)
+{
+    if (server_config.bulk == NULL)
+    {
+        return ESP_OK;
+    }
+
+    int rc = os_mempool_init(&bulk_mempool, BULK_BLOCK_COUNT, BULK_BLOCK_SIZE, bulk_mem, "ble_bulk_sdu");
+    if (rc == 0)
+    {
+        rc = os_mbuf_pool_init(&bulk_mbuf_pool, &bulk_mempool, BULK_BLOCK_SIZE, BULK_BLOCK_COUNT);
+    }
+    if (rc != 0)
+    {
+        ESP_LOGE(TAG, "Erro ao criar pool de SDUs: %d", rc);
+        return ESP_FAIL;
+    }
+
+    ble_npl_event_init(&tx_ev, bulk_tx_pump, NULL);
+
+    rc = ble_l2cap_create_server(CONFIG_BLE_SERVER_L2CAP_PSM, CONFIG_BLE_SERVER_L2CAP_MTU,
+                                 bulk_l2cap_event, NULL);
+    if (rc != 0)
+    {
+        ESP_LOGE(TAG, "Erro ao criar servidor L2CAP: %d", rc);
+        return ESP_FAIL;
+    }
+
+    ESP_LOGI(TAG, "Canal bulk L2CAP: psm=0x%02x, mtu=%d, %d buffers",
+             CONFIG_BLE_SERVER_L2CAP_PSM, CONFIG_BLE_SERVER_L2CAP_MTU, BULK_BLOCK_COUNT);
+    return ESP_OK;
+}
+
+// ===== API Pública =====
+
+esp_err_t ble_server_bulk_send(ble_bulk_source_cb_t source, void *arg)
+{
+    if (source == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (server_config.bulk == NULL || bulk_chan.chan == NULL)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (bulk_tx.active)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    bulk_tx.source = source;
+    bulk_tx.arg = arg;
+    bulk_tx.bytes = 0;
+    bulk_tx.started_at = esp_timer_get_time();
+    bulk_tx.active = true;
+
+    // Envio acontece na task do host
+    ble_npl_eventq_put(nimble_port_get_dflt_eventq(), &tx_ev);
+    return ESP_OK;
+}
+
+esp_err_t ble_server_get_bulk_stats(ble_server_bulk_stats_t *out)
+{
+    if (out == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    *out = stats;
+    if (bulk_chan.chan != NULL && bulk_chan.rx_bytes > 0)
+    {
+        out->rx_kbps_last = kbps(bulk_chan.rx_bytes, bulk_chan.rx_started_at);
+    }
+    if (bulk_tx.active)
+    {
+        out->tx_kbps_last = kbps(bulk_tx.bytes, bulk_tx.started_at);
+    }
+    return ESP_OK;
+}
+
+#else // CONFIG_BT_NIMBLE_L2CAP_COC_MAX_NUM == 0
+
+esp_err_t ble_server_bulk_init(void)
+{
+    if (server_config.bulk != NULL)
+    {
+        ESP_LOGE(TAG, "Canal bulk requer CONFIG_BT_NIMBLE_L2CAP_COC_MAX_NUM > 0");
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    return ESP_OK;
+}
+
+esp_err_t ble_server_bulk_send(ble_bulk_source_cb_t source, void *arg)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t ble_server_get_bulk_stats(ble_server_bulk_stats_t *out)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+#endif
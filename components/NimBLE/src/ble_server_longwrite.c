@@ -0,0 +1,207 @@
+// components/ble_server/src/ble_server_longwrite.c
+// Remontagem de objetos maiores que um valor ATT (512 bytes). Cada write na
+// characteristic Long Write (simples ou longo/preparado, já executado pelo
+// NimBLE) carrega um segmento:
+//   [0] flags (FIRST/LAST/ABORT)  [1..4] offset (LE)  [5..] dados
+// Segmentos vão para um buffer do pool fixo, exclusivo da conexão, e o
+// objeto é entregue uma única vez à aplicação quando chega o LAST.
+#include "ble_server_priv.h"
+#include "esp_log.h"
+#include <string.h>
+
+static const char *TAG = "BLE_LONGWR";
+
+#define LONGWR_HDR_LEN 5
+
+// Buffers do pool (estáticos: sem heap no caminho de escrita)
+typedef struct
+{
+    bool in_use;
+    uint32_t len;
+    uint8_t data[CONFIG_BLE_SERVER_LONG_WRITE_MAX_LEN];
+} longwr_buf_t;
+
+// Remontagem em andamento por conexão
+typedef struct
+{
+    bool in_use;
+    uint16_t conn_handle;
+    longwr_buf_t *buf;
+} longwr_conn_t;
+
+static longwr_buf_t pool[CONFIG_BLE_SERVER_LONG_WRITE_POOL_SIZE];
+static longwr_conn_t assemblies[BLE_SERVER_MAX_CONNS];
+static ble_server_longwr_stats_t stats;
+
+static longwr_buf_t *pool_get(void)
+{
+    for (int i = 0; i < CONFIG_BLE_SERVER_LONG_WRITE_POOL_SIZE; i++)
+    {
+        if (!pool[i].in_use)
+        {
+            pool[i].in_use = true;
+            pool[i].len = 0;
+            return &pool[i];
+        }
+    }
+    return NULL;
+}
+
+static void assembly_release(longwr_conn_t *asm_conn)
+{
+    if (asm_conn->buf)
+    {
+        asm_conn->buf->in_use = false;
+        asm_conn->buf = NULL;
+    }
+    asm_conn->in_use = false;
+}
+
+static longwr_conn_t *assembly_find(uint16_t conn_handle, bool create)
+{
+    longwr_conn_t *free_slot = NULL;
+
+    for (int i = 0; i < BLE_SERVER_MAX_CONNS; i++)
+    {
+        if (assemblies[i].in_use && assemblies[i].conn_handle == conn_handle)
+        {
+            return &assemblies[i];
+        }
+        if (!assemblies[i].in_use && free_slot == NULL)
+        {
+            free_slot = &assemblies[i];
+        }
+    }
+
+    if (!create || free_slot == NULL)
+    {
+        return NULL;
+    }
+
+    free_slot->in_use = true;
+    free_slot->conn_handle = conn_handle;
+    free_slot->buf = NULL;
+    return free_slot;
+}
+
+// ===== Interface interna =====
+
+int ble_server_longwr_on_write(uint16_t conn_handle, const struct os_mbuf *om)
+{
+    ble_mbuf_view_t view;
+    uint32_t offset;
+    int flags;
+
+    ble_mbuf_view_init(&view, om);
+    flags = ble_mbuf_view_byte(&view, 0);
+    if (flags < 0 || !ble_mbuf_view_get_u32le(&view, 1, &offset))
+    {
+        return BLE_ATT_ERR_INVALID_ATTR_VALUE_LEN;
+    }
+
+    uint16_t chunk = view.len - LONGWR_HDR_LEN;
+    longwr_conn_t *asm_conn = assembly_find(conn_handle, flags & BLE_SERVER_LONGWR_FIRST);
+
+    if (flags & BLE_SERVER_LONGWR_ABORT)
+    {
+        if (asm_conn)
+        {
+            stats.aborted++;
+            assembly_release(asm_conn);
+        }
+        return 0;
+    }
+
+    if (asm_conn == NULL)
+    {
+        // Segmento intermediário sem FIRST
+        return BLE_ATT_ERR_INVALID_OFFSET;
+    }
+
+    // FIRST reinicia qualquer objeto anterior da mesma conexão
+    if (flags & BLE_SERVER_LONGWR_FIRST)
+    {
+        if (asm_conn->buf && asm_conn->buf->len > 0)
+        {
+            stats.aborted++;
+        }
+        if (asm_conn->buf == NULL)
+        {
+            asm_conn->buf = pool_get();
+        }
+        if (asm_conn->buf == NULL)
+        {
+            stats.pool_exhausted++;
+            assembly_release(asm_conn);
+            ESP_LOGW(TAG, "Pool de remontagem esgotado: conn=%d", conn_handle);
+            return BLE_ATT_ERR_INSUFFICIENT_RES;
+        }
+        asm_conn->buf->len = 0;
+    }
+
+    longwr_buf_t *buf = asm_conn->buf;
+
+    // Segmentos precisam chegar em ordem e caber no objeto máximo
+    if (offset != buf->len)
+    {
+        stats.aborted++;
+        assembly_release(asm_conn);
+        return BLE_ATT_ERR_INVALID_OFFSET;
+    }
+    if (buf->len + chunk > sizeof(buf->data))
+    {
+        stats.aborted++;
+        assembly_release(asm_conn);
+        ESP_LOGW(TAG, "Objeto excede %d bytes: conn=%d", CONFIG_BLE_SERVER_LONG_WRITE_MAX_LEN, conn_handle);
+        return BLE_ATT_ERR_INVALID_ATTR_VALUE_LEN;
+    }
+
+    ble_mbuf_view_read(&view, LONGWR_HDR_LEN, buf->data + buf->len, chunk);
+    buf->len += chunk;
+    stats.segments++;
+
+    if (flags & BLE_SERVER_LONGWR_LAST)
+    {
+        ESP_LOGI(TAG, "Objeto recebido: conn=%d, %lu bytes", conn_handle, buf->len);
+        stats.objects++;
+        stats.bytes += buf->len;
+
+        if (server_config.on_long_write)
+        {
+            int64_t cb_at = ble_server_probe_now();
+            server_config.on_long_write(conn_handle, buf->data, buf->len);
+            ble_server_trace_end(BLE_SERVER_TRACE_APP_CB, BLE_SERVER_TRACE_CB_LONG_WRITE,
+                                 conn_handle, cb_at, 0);
+        }
+        assembly_release(asm_conn);
+    }
+
+    return 0;
+}
+
+void ble_server_longwr_conn_close(uint16_t conn_handle)
+{
+    longwr_conn_t *asm_conn = assembly_find(conn_handle, false);
+
+    if (asm_conn)
+    {
+        if (asm_conn->buf && asm_conn->buf->len > 0)
+        {
+            stats.aborted++;
+        }
+        assembly_release(asm_conn);
+    }
+}
+
+// ===== API Pública =====
+
+esp_err_t ble_server_get_longwr_stats(ble_server_longwr_stats_t *out)
+{
+    if (out == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    *out = stats;
+    return ESP_OK;
+}
@@ -0,0 +1,262 @@
+// components/ble_server/src/ble_server_policy.c
+// Política de parâmetros de conexão: intervalo curto durante a rajada de
+// comandos após conectar, 2M PHY e data length máximo quando o par suporta,
+// e intervalo longo com slave latency quando a conexão fica ociosa.
+// Tudo roda na task do host (eventos GAP e callouts NimBLE).
+#include "ble_server_priv.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "nimble/nimble_port.h"
+
+static const char *TAG = "BLE_POLICY";
+
+// Maior PDU de dados LE e tempo correspondente em 1M PHY
+#define POLICY_DLE_MAX_OCTETS 251
+#define POLICY_DLE_MAX_TIME_US 2120
+
+typedef enum
+{
+    POLICY_STATE_FAST,
+    POLICY_STATE_IDLE,
+} policy_state_t;
+
+typedef struct
+{
+    bool in_use;
+    uint16_t conn_handle;
+    policy_state_t state;
+    int64_t connected_at;
+    int64_t window_at; // Gatilho do advertising que gerou a conexão (0 = desconhecido)
+    bool got_first_cmd;
+    struct ble_npl_callout idle_timer;
+} policy_conn_t;
+
+static policy_conn_t policy_conns[BLE_SERVER_MAX_CONNS];
+static ble_server_policy_stats_t stats;
+static uint64_t first_cmd_ms_total;
+static uint64_t approach_ms_total;
+
+static const struct ble_gap_upd_params fast_params = {
+    .itvl_min = CONFIG_BLE_SERVER_POLICY_FAST_ITVL_MIN,
+    .itvl_max = CONFIG_BLE_SERVER_POLICY_FAST_ITVL_MAX,
+    .latency = 0,
+    .supervision_timeout = CONFIG_BLE_SERVER_POLICY_SUPERVISION_TIMEOUT,
+    .min_ce_len = 0,
+    .max_ce_len = 0,
+};
+
+static const struct ble_gap_upd_params idle_params = {
+    .itvl_min = CONFIG_BLE_SERVER_POLICY_IDLE_ITVL_MIN,
+    .itvl_max = CONFIG_BLE_SERVER_POLICY_IDLE_ITVL_MAX,
+    .latency = CONFIG_BLE_SERVER_POLICY_IDLE_LATENCY,
+    .supervision_timeout = CONFIG_BLE_SERVER_POLICY_SUPERVISION_TIMEOUT,
+    .min_ce_len = 0,
+    .max_ce_len = 0,
+};
+
+static const char *policy_name(void)
+{
+    switch (server_config.conn_policy)
+    {
+    case BLE_SERVER_CONN_POLICY_FAST_THEN_IDLE:
+        return "fast-then-idle";
+    case BLE_SERVER_CONN_POLICY_NONE:
+    default:
+        return "none";
+    }
+}
+
+static policy_conn_t *policy_find(uint16_t conn_handle)
+{
+    for (int i = 0; i < BLE_SERVER_MAX_CONNS; i++)
+    {
+        if (policy_conns[i].in_use && policy_conns[i].conn_handle == conn_handle)
+        {
+            return &policy_conns[i];
+        }
+    }
+    return NULL;
+}
+
+static void policy_request(policy_conn_t *pc, policy_state_t state)
+{
+    const struct ble_gap_upd_params *params = state == POLICY_STATE_FAST ? &fast_params : &idle_params;
+
+    int rc = ble_gap_update_params(pc->conn_handle, params);
+    if (rc != 0)
+    {
+        ESP_LOGW(TAG, "Erro ao solicitar parâmetros: conn=%d, rc=%d", pc->conn_handle, rc);
+        return;
+    }
+
+    pc->state = state;
+    if (state == POLICY_STATE_FAST)
+        stats.fast_requests++;
+    else
+        stats.idle_requests++;
+}
+
+static void policy_arm_idle(policy_conn_t *pc)
+{
+    ble_npl_callout_reset(&pc->idle_timer,
+                          ble_npl_time_ms_to_ticks32(CONFIG_BLE_SERVER_POLICY_IDLE_TIMEOUT_MS));
+}
+
+// Sem comandos por IDLE_TIMEOUT_MS: relaxa o intervalo para economizar energia
+static void policy_idle_cb(struct ble_npl_event *ev)
+{
+    policy_conn_t *pc = ble_npl_event_get_arg(ev);
+
+    if (pc->in_use && pc->state == POLICY_STATE_FAST)
+    {
+        ESP_LOGI(TAG, "Conexão ociosa: conn=%d, relaxando intervalo", pc->conn_handle);
+        policy_request(pc, POLICY_STATE_IDLE);
+    }
+}
+
+// ===== Interface interna =====
+
+void ble_server_policy_init(void)
+{
+    for (int i = 0; i < BLE_SERVER_MAX_CONNS; i++)
+    {
+        policy_conns[i].in_use = false;
+        ble_npl_callout_init(&policy_conns[i].idle_timer, nimble_port_get_dflt_eventq(),
+                             policy_idle_cb, &policy_conns[i]);
+    }
+}
+
+void ble_server_policy_on_connect(uint16_t conn_handle)
+{
+    policy_conn_t *pc = NULL;
+
+    for (int i = 0; i < BLE_SERVER_MAX_CONNS; i++)
+    {
+        if (!policy_conns[i].in_use)
+        {
+            pc = &policy_conns[i];
+            break;
+        }
+    }
+    if (pc == NULL)
+    {
+        return;
+    }
+
+    pc->in_use = true;
+    pc->conn_handle = conn_handle;
+    pc->state = POLICY_STATE_FAST;
+    pc->connected_at = esp_timer_get_time();
+    if (!ble_server_adv_window(&pc->window_at))
+    {
+        pc->window_at = 0;
+    }
+    pc->got_first_cmd = false;
+
+    if (server_config.conn_policy == BLE_SERVER_CONN_POLICY_NONE)
+    {
+        return;
+    }
+
+    // Rajada de comandos logo após conectar: intervalo curto
+    policy_request(pc, POLICY_STATE_FAST);
+
+    // 2M PHY se o par suportar; o controlador mantém 1M caso contrário
+    int rc = ble_gap_set_prefered_le_phy(conn_handle, BLE_GAP_LE_PHY_2M_MASK,
+                                         BLE_GAP_LE_PHY_2M_MASK, BLE_GAP_LE_PHY_CODED_ANY);
+    if (rc != 0)
+    {
+        ESP_LOGW(TAG, "Erro ao solicitar 2M PHY: conn=%d, rc=%d", conn_handle, rc);
+    }
+
+    // Data length máximo já na conexão, sem esperar a troca de MTU: o
+    // controlador negocia com o par e o L2CAP bulk também aproveita
+    rc = ble_gap_set_data_len(conn_handle, POLICY_DLE_MAX_OCTETS, POLICY_DLE_MAX_TIME_US);
+    if (rc != 0)
+    {
+        ESP_LOGW(TAG, "Erro ao solicitar data length: conn=%d, rc=%d", conn_handle, rc);
+    }
+
+    policy_arm_idle(pc);
+}
+
+void ble_server_policy_on_command(uint16_t conn_handle)
+{
+    policy_conn_t *pc = policy_find(conn_handle);
+
+    if (pc == NULL)
+    {
+        return;
+    }
+
+    if (!pc->got_first_cmd)
+    {
+        uint32_t ms = (uint32_t)((esp_timer_get_time() - pc->connected_at) / 1000);
+
+        pc->got_first_cmd = true;
+        stats.first_cmd_count++;
+        first_cmd_ms_total += ms;
+        if (ms > stats.first_cmd_ms_max)
+            stats.first_cmd_ms_max = ms;
+
+        ESP_LOGI(TAG, "Tempo até o primeiro comando: %lu ms (conn=%d, política=%s)",
+                 ms, conn_handle, policy_name());
+
+        // Aproximação: do gatilho do advertising (desconexão/despertar) ao comando
+        if (pc->window_at != 0)
+        {
+            uint32_t approach_ms = (uint32_t)((esp_timer_get_time() - pc->window_at) / 1000);
+
+            stats.approach_count++;
+            approach_ms_total += approach_ms;
+            if (approach_ms > stats.approach_ms_max)
+                stats.approach_ms_max = approach_ms;
+
+            ESP_LOGI(TAG, "Gatilho do advertising até o primeiro comando: %lu ms", approach_ms);
+        }
+    }
+
+    if (server_config.conn_policy == BLE_SERVER_CONN_POLICY_NONE)
+    {
+        return;
+    }
+
+    // Atividade numa conexão relaxada: volta ao intervalo curto
+    if (pc->state == POLICY_STATE_IDLE)
+    {
+        policy_request(pc, POLICY_STATE_FAST);
+    }
+    policy_arm_idle(pc);
+}
+
+void ble_server_policy_on_disconnect(uint16_t conn_handle)
+{
+    policy_conn_t *pc = policy_find(conn_handle);
+
+    if (pc)
+    {
+        ble_npl_callout_stop(&pc->idle_timer);
+        pc->in_use = false;
+    }
+}
+
+// ===== API Pública =====
+
+esp_err_t ble_server_get_policy_stats(ble_server_policy_stats_t *out)
+{
+    if (out == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    *out = stats;
+    if (stats.first_cmd_count > 0)
+    {
+        out->first_cmd_ms_avg = (uint32_t)(first_cmd_ms_total / stats.first_cmd_count);
+    }
+    if (stats.approach_count > 0)
+    {
+        out->approach_ms_avg = (uint32_t)(approach_ms_total / stats.approach_count);
+    }
+    return ESP_OK;
+}
@@ -0,0 +1,429 @@
+// components/ble_server/src/ble_server_priv.h
+// Declarações internas compartilhadas entre os módulos do servidor BLE
+#ifndef BLE_SERVER_PRIV_H
+#define BLE_SERVER_PRIV_H
+
+#include "ble_server.h"
+#include "esp_timer.h"
+#include "host/ble_hs.h"
+
+#define BLE_SERVER_MAX_CONNS CONFIG_BT_NIMBLE_MAX_CONNECTIONS
+
+// Characteristics internas (no máximo) + as registradas pela aplicação
+#define BLE_SERVER_BUILTIN_CHRS_MAX 8
+#define BLE_SERVER_MAX_CHRS (BLE_SERVER_BUILTIN_CHRS_MAX + CONFIG_BLE_SERVER_MAX_APP_CHRS)
+
+// Configuração copiada em ble_server_init()
+extern ble_server_config_t server_config;
+
+// Handle da characteristic Status (notificações)
+extern uint16_t status_val_handle;
+
+// UUID do serviço Lock Control (anunciado no advertising)
+extern const ble_uuid128_t gatt_svr_svc_uuid;
+
+/**
+ * @brief Handler de eventos GAP (repassado a ble_gap_adv_start)
+ */
+int ble_server_gap_event(struct ble_gap_event *event, void *arg);
+
+// ===== Agendador de advertising (ble_server_adv.c) =====
+
+// Instâncias de advertising com CONFIG_BT_NIMBLE_EXT_ADV
+#define BLE_SERVER_ADV_INSTANCE_CONN 0  // Conectável, PDUs legados
+#define BLE_SERVER_ADV_INSTANCE_BCAST 1 // Broadcast de eventos (estendido + periódico)
+
+/**
+ * @brief Prepara estado e eventos (após nimble_port_init)
+ */
+void ble_server_adv_init(void);
+
+/**
+ * @brief (Re)inicia o advertising no perfil indicado, se há slots livres
+ *
+ * Executar na task do host.
+ */
+void ble_server_adv_start(ble_server_adv_profile_t profile);
+
+/**
+ * @brief Conexão estabelecida: fecha a contabilidade e retoma no mesmo perfil
+ */
+void ble_server_adv_on_connect(int status);
+
+/**
+ * @brief Desconexão: direcionado para o par (se bond) ou rajada rápida
+ */
+void ble_server_adv_on_disconnect(const struct ble_gap_conn_desc *desc);
+
+/**
+ * @brief Bonds mudaram: recarrega a accept list no próximo início
+ */
+void ble_server_adv_on_bonds_changed(void);
+
+/**
+ * @brief Informa se o advertising atual é uma janela aberta por gatilho
+ *
+ * @param window_at Recebe o momento do gatilho (boot, desconexão, pedido)
+ * @return true para janelas direcionada/rápida
+ */
+bool ble_server_adv_window(int64_t *window_at);
+
+/**
+ * @brief BLE_GAP_EVENT_ADV_COMPLETE: desce de perfil se a duração expirou
+ */
+void ble_server_adv_on_complete(int reason);
+
+/**
+ * @brief Host sincronizado: payloads precisam ser reenviados ao controlador
+ */
+void ble_server_adv_on_sync(void);
+
+/**
+ * @brief Reset do host: encerra a contabilidade do advertising em andamento
+ */
+void ble_server_adv_on_reset(void);
+
+/**
+ * @brief Atualiza estado e contador de mudanças no manufacturer data
+ *
+ * Pode ser chamada de qualquer tarefa; o envio acontece na task do host.
+ */
+void ble_server_adv_set_state(uint8_t state, uint16_t change_count);
+
+// ===== Broadcast de eventos (ble_server_bcast.c) =====
+
+/**
+ * @brief Prepara o evento de atualização (após nimble_port_init)
+ */
+void ble_server_bcast_init(void);
+
+/**
+ * @brief Configura e inicia o set de broadcast (host sincronizado)
+ *
+ * Sem efeito se CONFIG_BLE_SERVER_EVENT_BROADCAST está desativado.
+ */
+void ble_server_bcast_on_sync(void);
+
+/**
+ * @brief Reset do host: suspende as atualizações até o próximo sync
+ */
+void ble_server_bcast_on_reset(void);
+
+// Relógio dos pontos de medição: sem trace nem diagnóstico não lê o esp_timer
+static inline int64_t ble_server_probe_now(void)
+{
+#if CONFIG_BLE_SERVER_TRACE || CONFIG_BLE_SERVER_DIAG
+    return esp_timer_get_time();
+#else
+    return 0;
+#endif
+}
+
+// ===== Trace de eventos (ble_server_trace.c) =====
+
+#if CONFIG_BLE_SERVER_TRACE
+
+/**
+ * @brief Grava um registro no anel (qualquer tarefa, não bloqueia)
+ */
+void ble_server_trace(uint8_t type, uint8_t sub, uint16_t conn_handle, uint32_t value);
+
+/**
+ * @brief Grava um evento GAP com a conexão e o valor relevantes
+ */
+void ble_server_trace_gap(const struct ble_gap_event *event);
+
+/**
+ * @brief Grava a duração desde started_at (ble_server_probe_now) e o código de retorno
+ */
+void ble_server_trace_end(uint8_t type, uint8_t sub, uint16_t conn_handle, int64_t started_at, int rc);
+
+#else
+
+static inline void ble_server_trace(uint8_t type, uint8_t sub, uint16_t conn_handle, uint32_t value)
+{
+}
+
+static inline void ble_server_trace_gap(const struct ble_gap_event *event)
+{
+}
+
+static inline void ble_server_trace_end(uint8_t type, uint8_t sub, uint16_t conn_handle,
+                                        int64_t started_at, int rc)
+{
+}
+
+#endif
+
+// ===== Diagnóstico de latência (ble_server_diag.c) =====
+
+// Etapas medidas de um comando (ordem dos histogramas na characteristic Diag)
+typedef enum
+{
+    BLE_SERVER_DIAG_STAGE_DISPATCH = 0, // Chegada do write até o início do on_write
+    BLE_SERVER_DIAG_STAGE_EXEC,         // Duração do on_write
+    BLE_SERVER_DIAG_STAGE_RESULT,       // Chegada do write até a primeira notificação
+    BLE_SERVER_DIAG_STAGE_COUNT,
+} ble_server_diag_stage_t;
+
+#if CONFIG_BLE_SERVER_DIAG
+
+/**
+ * @brief Quantidade de characteristics da tabela montada
+ */
+void ble_server_diag_init(int chr_count);
+
+/**
+ * @brief Fim de um acesso GATT: contadores e histograma da characteristic
+ *
+ * @param index Posição na tabela
+ * @param len Bytes recebidos (write) ou enviados (read)
+ */
+void ble_server_diag_access(uint8_t index, bool write, uint16_t len, int64_t started_at, int rc);
+
+/**
+ * @brief Write na characteristic Command: início da medição do comando
+ */
+void ble_server_diag_cmd_arrival(uint16_t conn_handle, int64_t at);
+
+/**
+ * @brief on_write vai começar (host ou tarefa de comandos)
+ */
+void ble_server_diag_dispatch(uint16_t conn_handle);
+
+void ble_server_diag_stage(ble_server_diag_stage_t stage, int64_t started_at);
+
+/**
+ * @brief Notificação para a conexão: fecha a medição do comando pendente
+ */
+void ble_server_diag_on_notify(uint16_t conn_handle);
+
+void ble_server_diag_conn_close(uint16_t conn_handle);
+
+// Handlers da characteristic Diag
+int ble_server_diag_on_read(uint16_t conn_handle, struct os_mbuf *om, void *arg);
+int ble_server_diag_on_write(uint16_t conn_handle, const ble_mbuf_view_t *view, void *arg);
+
+#else
+
+static inline void ble_server_diag_init(int chr_count)
+{
+}
+
+static inline void ble_server_diag_access(uint8_t index, bool write, uint16_t len,
+                                          int64_t started_at, int rc)
+{
+}
+
+static inline void ble_server_diag_cmd_arrival(uint16_t conn_handle, int64_t at)
+{
+}
+
+static inline void ble_server_diag_dispatch(uint16_t conn_handle)
+{
+}
+
+static inline void ble_server_diag_stage(ble_server_diag_stage_t stage, int64_t started_at)
+{
+}
+
+static inline void ble_server_diag_on_notify(uint16_t conn_handle)
+{
+}
+
+static inline void ble_server_diag_conn_close(uint16_t conn_handle)
+{
+}
+
+#endif
+
+// ===== Registro de characteristics (ble_server_gatt.c) =====
+
+/**
+ * @brief Monta a tabela de serviços do NimBLE a partir das declarações
+ *
+ * Após esta chamada novos registros são recusados.
+ *
+ * @return Tabela pronta para ble_gatts_count_cfg()/ble_gatts_add_svcs()
+ */
+const struct ble_gatt_svc_def *ble_server_gatt_build(void);
+
+// ===== Registro de status (ble_server_status.c) =====
+
+/**
+ * @brief Handler de leitura da characteristic Status (task do host, sem lock)
+ *
+ * @return 0 ou código de erro ATT
+ */
+int ble_server_status_on_read(uint16_t conn_handle, struct os_mbuf *om, void *arg);
+
+// ===== Comandos autenticados (ble_server_auth.c) =====
+
+/**
+ * @brief Handler de leitura da characteristic Auth: abre sessão com nonce novo
+ *
+ * @return 0 ou código de erro ATT
+ */
+int ble_server_auth_on_read(uint16_t conn_handle, struct os_mbuf *om, void *arg);
+
+/**
+ * @brief Verifica um write autenticado e remove cabeçalho e tag do mbuf
+ *
+ * @return 0 se autêntico, senão código de erro ATT
+ */
+int ble_server_auth_check(uint16_t conn_handle, struct os_mbuf *om);
+
+/**
+ * @brief Encerra a sessão da conexão
+ */
+void ble_server_auth_conn_close(uint16_t conn_handle);
+
+// ===== Pipeline assíncrono de comandos (ble_server_cmd.c) =====
+
+/**
+ * @brief Cria a fila de comandos e a tarefa executora
+ *
+ * @return ESP_OK se sucesso
+ */
+esp_err_t ble_server_cmd_init(void);
+
+/**
+ * @brief Executa o on_write da aplicação para um comando da conexão
+ *
+ * Chamado pela tarefa de comandos ou, sem pipeline, pela task do host.
+ */
+void ble_server_cmd_exec(uint16_t conn_handle, uint8_t *data, uint16_t len);
+
+/**
+ * @brief Define a conexão retornada por ble_server_cmd_conn_handle()
+ *
+ * Para o on_write_view, chamado direto pela task do host.
+ */
+void ble_server_cmd_set_origin(uint16_t conn_handle);
+
+/**
+ * @brief Indica se o pipeline assíncrono está ativo
+ */
+bool ble_server_cmd_is_async(void);
+
+/**
+ * @brief Enfileira uma escrita para execução fora da task do host
+ *
+ * Chamado pelo handler da characteristic Command; não bloqueia.
+ *
+ * @param conn_handle Conexão de origem
+ * @param om Dados recebidos
+ * @return 0 ou código de erro ATT
+ */
+int ble_server_cmd_submit(uint16_t conn_handle, const struct os_mbuf *om);
+
+// ===== Tabela de conexões (ble_server_conn.c) =====
+
+typedef struct
+{
+    bool in_use;
+    uint16_t handle;
+    uint16_t mtu;
+    bool subscribed; // CCCD da characteristic Status habilitado
+    bool encrypted;
+    bool authenticated;
+    bool bonded;
+    uint8_t key_size;
+    int64_t connected_at;
+    uint32_t rx_writes;
+    uint32_t rx_bytes;
+    uint32_t tx_notifies;
+    uint32_t tx_errors;
+} ble_conn_t;
+
+void ble_server_conn_reset(void);
+bool ble_server_conn_add(uint16_t handle);
+void ble_server_conn_remove(uint16_t handle);
+int ble_server_conn_count(void);
+void ble_server_conn_set_mtu(uint16_t handle, uint16_t mtu);
+void ble_server_conn_set_subscribed(uint16_t handle, bool subscribed);
+bool ble_server_conn_is_subscribed(uint16_t handle);
+void ble_server_conn_refresh_security(uint16_t handle);
+void ble_server_conn_on_rx(uint16_t handle, uint16_t len);
+void ble_server_conn_on_tx(uint16_t handle, bool ok);
+
+/**
+ * @brief Copia os handles das conexões inscritas na characteristic Status
+ *
+ * @return Quantidade de handles copiados
+ */
+int ble_server_conn_subscribers(uint16_t *handles, int max);
+
+/**
+ * @brief Menor MTU entre as conexões inscritas
+ *
+ * @return MTU ou 0 se nenhuma conexão inscrita
+ */
+uint16_t ble_server_conn_min_subscribed_mtu(void);
+
+// ===== Fila de transmissão de notificações (ble_server_txq.c) =====
+
+/**
+ * @brief Prepara filas e eventos (após nimble_port_init)
+ */
+void ble_server_txq_init(void);
+
+/**
+ * @brief Agenda uma drenagem das filas na task do host
+ */
+void ble_server_txq_kick(void);
+
+void ble_server_txq_conn_open(uint16_t conn_handle);
+
+/**
+ * @brief Libera a fila da conexão, reportando pendências como falha
+ */
+void ble_server_txq_conn_close(uint16_t conn_handle);
+
+// ===== Política de conexão (ble_server_policy.c) =====
+
+void ble_server_policy_init(void);
+void ble_server_policy_on_connect(uint16_t conn_handle);
+void ble_server_policy_on_command(uint16_t conn_handle);
+void ble_server_policy_on_disconnect(uint16_t conn_handle);
+
+// ===== Canal bulk L2CAP (ble_server_l2cap.c) =====
+
+/**
+ * @brief Cria o pool de SDUs e o servidor L2CAP (se config->bulk definido)
+ *
+ * @return ESP_OK se sucesso
+ */
+esp_err_t ble_server_bulk_init(void);
+
+// ===== Remontagem de writes longos (ble_server_longwrite.c) =====
+
+/**
+ * @brief Processa um segmento escrito na characteristic Long Write
+ *
+ * @return 0 ou código de erro ATT
+ */
+int ble_server_longwr_on_write(uint16_t conn_handle, const struct os_mbuf *om);
+
+/**
+ * @brief Descarta a remontagem pendente da conexão
+ */
+void ble_server_longwr_conn_close(uint16_t conn_handle);
+
+// ===== Agregador de notificações (ble_server_coalesce.c) =====
+
+/**
+ * @brief Cria timer e mutex do agregador (se coalesce_window_ms > 0)
+ *
+ * @return ESP_OK se sucesso
+ */
+esp_err_t ble_server_coalesce_init(void);
+
+/**
+ * @brief Inscrição ou MTU mudou: envia antes o pacote que passou do novo limite
+ *
+ * Executar na task do host.
+ */
+void ble_server_coalesce_on_mtu_change(void);
+
+#endif
@@ -0,0 +1,170 @@
+// components/ble_server/src/ble_server_status.c
+// Registro de status servido pela characteristic Status. A aplicação publica
+// de qualquer tarefa; a task do host lê sem lock através de um snapshot
+// versionado (ble_snapshot.h) que já guarda os bytes codificados, então a
+// leitura é um único os_mbuf_append.
+//
+// Formato (little-endian, 20 bytes):
+//   [0..3]   state         (compatível com o valor de 4 bytes anterior)
+//   [4..7]   changed_ms    momento da última mudança de state
+//   [8..11]  change_count  mudanças de state desde o boot
+//   [12..15] op_count      contador de operações da aplicação
+//   [16..19] error_flags   bits de erro definidos pela aplicação
+#include "ble_server_priv.h"
+#include "ble_snapshot.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+
+static const char *TAG = "BLE_STATUS";
+
+#define STATUS_WIRE_LEN 20
+
+typedef struct
+{
+    ble_server_status_t status;
+    uint8_t encoded[STATUS_WIRE_LEN];
+} status_slot_t;
+
+// Registro zerado codifica para bytes zerados: válido antes de ble_server_init()
+static status_slot_t slots[2];
+static ble_snapshot_t status_snap = {
+    .size = sizeof(status_slot_t),
+    .slots = {&slots[0], &slots[1]},
+};
+// Serializa apenas os escritores; leitores nunca esperam
+static portMUX_TYPE status_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static void put_u32le(uint8_t *p, uint32_t v)
+{
+    p[0] = v & 0xFF;
+    p[1] = (v >> 8) & 0xFF;
+    p[2] = (v >> 16) & 0xFF;
+    p[3] = (v >> 24) & 0xFF;
+}
+
+static void status_encode(status_slot_t *slot)
+{
+    put_u32le(&slot->encoded[0], slot->status.state);
+    put_u32le(&slot->encoded[4], slot->status.changed_ms);
+    put_u32le(&slot->encoded[8], slot->status.change_count);
+    put_u32le(&slot->encoded[12], slot->status.op_count);
+    put_u32le(&slot->encoded[16], slot->status.error_flags);
+}
+
+// Slot publicado; estável enquanto o chamador segura status_lock
+static const status_slot_t *status_current_locked(void)
+{
+    uint32_t seq;
+    return ble_snapshot_read_begin(&status_snap, &seq);
+}
+
+// Publica um novo registro a partir do atual (chamador segura status_lock).
+// Retorna true se state mudou.
+static bool status_publish_locked(uint32_t state, uint32_t op_count, uint32_t error_flags,
+                                  ble_server_status_t *published)
+{
+    bool changed = false;
+
+    const status_slot_t *cur = status_current_locked();
+    status_slot_t *next = ble_snapshot_write_begin(&status_snap);
+
+    next->status = cur->status;
+    if (state != cur->status.state)
+    {
+        next->status.state = state;
+        next->status.changed_ms = (uint32_t)(esp_timer_get_time() / 1000);
+        next->status.change_count++;
+        changed = true;
+    }
+    next->status.op_count = op_count;
+    next->status.error_flags = error_flags;
+    status_encode(next);
+    *published = next->status;
+
+    ble_snapshot_write_end(&status_snap);
+    return changed;
+}
+
+// Reflete o novo estado no advertising (fora do lock)
+static void status_to_adv(const ble_server_status_t *status, bool changed)
+{
+    ble_server_adv_set_state((uint8_t)status->state, (uint16_t)status->change_count);
+
+    // Mudanças de estado entram no log transmitido aos observadores
+    if (changed)
+    {
+        ble_server_broadcast_event(BLE_SERVER_EVT_STATE_CHANGE, (uint8_t)status->state);
+    }
+}
+
+// ===== Interface interna =====
+
+int ble_server_status_on_read(uint16_t conn_handle, struct os_mbuf *om, void *arg)
+{
+    for (;;)
+    {
+        uint32_t seq;
+        const status_slot_t *slot = ble_snapshot_read_begin(&status_snap, &seq);
+
+        if (os_mbuf_append(om, slot->encoded, STATUS_WIRE_LEN) != 0)
+        {
+            return BLE_ATT_ERR_INSUFFICIENT_RES;
+        }
+        if (ble_snapshot_read_end(&status_snap, seq))
+        {
+            ESP_LOGD(TAG, "Read solicitado: conn=%d", conn_handle);
+            return 0;
+        }
+
+        // Escritor publicou duas vezes durante a cópia: descarta e repete
+        os_mbuf_adj(om, -STATUS_WIRE_LEN);
+    }
+}
+
+// ===== API Pública =====
+
+esp_err_t ble_server_update_read_value(uint32_t value)
+{
+    ble_server_status_t published;
+
+    portENTER_CRITICAL(&status_lock);
+    const status_slot_t *cur = status_current_locked();
+    bool changed = status_publish_locked(value, cur->status.op_count, cur->status.error_flags, &published);
+    portEXIT_CRITICAL(&status_lock);
+
+    status_to_adv(&published, changed);
+    ESP_LOGD(TAG, "Valor de leitura atualizado: %lu", value);
+    return ESP_OK;
+}
+
+esp_err_t ble_server_set_status(const ble_server_status_t *status)
+{
+    ble_server_status_t published;
+
+    if (status == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    portENTER_CRITICAL(&status_lock);
+    bool changed = status_publish_locked(status->state, status->op_count, status->error_flags, &published);
+    portEXIT_CRITICAL(&status_lock);
+
+    status_to_adv(&published, changed);
+    return ESP_OK;
+}
+
+esp_err_t ble_server_get_status(ble_server_status_t *out)
+{
+    status_slot_t slot;
+
+    if (out == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    ble_snapshot_read(&status_snap, &slot);
+    *out = slot.status;
+    return ESP_OK;
+}
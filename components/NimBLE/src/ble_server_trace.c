@@ -0,0 +1,225 @@
+// components/ble_server/src/ble_server_trace.c
+// Trace de eventos em RAM para investigar latência em campo ("destravar
+// demorou 3 s"): cada ponto grava um registro de 12 bytes num anel, com o
+// carimbo do esp_timer. Gravar custa uma seção crítica curta; o despejo na
+// serial acontece só quando pedido.
+#include "ble_server_priv.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include <stdio.h>
+#include <string.h>
+
+#if CONFIG_BLE_SERVER_TRACE
+
+#define TRACE_DEPTH CONFIG_BLE_SERVER_TRACE_RECORDS
+#define TRACE_NO_CONN 0xFFFF
+#define TRACE_VALUE_MAX 0xFFFFFF
+#define TRACE_RECS_PER_LINE 4
+
+_Static_assert(sizeof(ble_server_trace_rec_t) == 12, "registro do trace precisa ter 12 bytes");
+
+// Anel (head = próximo a escrever). Com `paused` os registros são contados
+// como perdidos: leitura e despejo percorrem o anel sem segurar o lock.
+static ble_server_trace_rec_t ring[TRACE_DEPTH];
+static uint16_t head;
+static uint16_t count;
+static uint32_t lost;
+static bool paused;
+static portMUX_TYPE trace_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// ===== Interface interna =====
+
+void ble_server_trace(uint8_t type, uint8_t sub, uint16_t conn_handle, uint32_t value)
+{
+    uint32_t now = (uint32_t)esp_timer_get_time();
+
+    portENTER_CRITICAL(&trace_lock);
+    if (paused)
+    {
+        lost++;
+    }
+    else
+    {
+        ble_server_trace_rec_t *rec = &ring[head];
+
+        rec->time_us = now;
+        rec->type = type;
+        rec->sub = sub;
+        rec->conn_handle = conn_handle;
+        rec->value = value;
+        head = (head + 1) % TRACE_DEPTH;
+        if (count < TRACE_DEPTH)
+            count++;
+        else
+            lost++;
+    }
+    portEXIT_CRITICAL(&trace_lock);
+}
+
+void ble_server_trace_gap(const struct ble_gap_event *event)
+{
+    uint16_t conn_handle = TRACE_NO_CONN;
+    uint32_t value = 0;
+
+    switch (event->type)
+    {
+    case BLE_GAP_EVENT_CONNECT:
+        conn_handle = event->connect.conn_handle;
+        value = (uint32_t)event->connect.status;
+        break;
+    case BLE_GAP_EVENT_DISCONNECT:
+        conn_handle = event->disconnect.conn.conn_handle;
+        value = (uint32_t)event->disconnect.reason;
+        break;
+    case BLE_GAP_EVENT_ADV_COMPLETE:
+        value = (uint32_t)event->adv_complete.reason;
+        break;
+    case BLE_GAP_EVENT_MTU:
+        conn_handle = event->mtu.conn_handle;
+        value = event->mtu.value;
+        break;
+    case BLE_GAP_EVENT_CONN_UPDATE:
+        conn_handle = event->conn_update.conn_handle;
+        value = (uint32_t)event->conn_update.status;
+        break;
+    case BLE_GAP_EVENT_ENC_CHANGE:
+        conn_handle = event->enc_change.conn_handle;
+        value = (uint32_t)event->enc_change.status;
+        break;
+    case BLE_GAP_EVENT_SUBSCRIBE:
+        conn_handle = event->subscribe.conn_handle;
+        value = event->subscribe.cur_notify;
+        break;
+    case BLE_GAP_EVENT_NOTIFY_TX:
+        conn_handle = event->notify_tx.conn_handle;
+        value = (uint32_t)event->notify_tx.status;
+        break;
+    default:
+        break;
+    }
+
+    ble_server_trace(BLE_SERVER_TRACE_GAP, event->type, conn_handle, value);
+}
+
+void ble_server_trace_end(uint8_t type, uint8_t sub, uint16_t conn_handle, int64_t started_at, int rc)
+{
+    int64_t us = esp_timer_get_time() - started_at;
+
+    if (us > TRACE_VALUE_MAX)
+        us = TRACE_VALUE_MAX;
+    ble_server_trace(type, sub, conn_handle, (uint32_t)us | ((uint32_t)(rc & 0xFF) << 24));
+}
+
+// Pausa a gravação e retorna posição do mais antigo e quantidade
+static void trace_pause(uint16_t *first, uint16_t *n, uint32_t *lost_out)
+{
+    portENTER_CRITICAL(&trace_lock);
+    paused = true;
+    *first = (head + TRACE_DEPTH - count) % TRACE_DEPTH;
+    *n = count;
+    *lost_out = lost;
+    portEXIT_CRITICAL(&trace_lock);
+}
+
+static void trace_resume(void)
+{
+    portENTER_CRITICAL(&trace_lock);
+    paused = false;
+    portEXIT_CRITICAL(&trace_lock);
+}
+
+// ===== API Pública =====
+
+int ble_server_trace_read(ble_server_trace_rec_t *recs, int max, uint32_t *lost_out)
+{
+    uint16_t first;
+    uint16_t n;
+    uint32_t lost_now;
+
+    if (recs == NULL || max <= 0)
+    {
+        return 0;
+    }
+
+    trace_pause(&first, &n, &lost_now);
+
+    // Mantém os mais recentes se o vetor for menor que o anel
+    int skip = n > max ? n - max : 0;
+    int copied = 0;
+    for (int i = skip; i < n; i++)
+    {
+        recs[copied++] = ring[(first + i) % TRACE_DEPTH];
+    }
+
+    trace_resume();
+
+    if (lost_out)
+    {
+        *lost_out = lost_now;
+    }
+    return copied;
+}
+
+esp_err_t ble_server_trace_dump(void)
+{
+    uint16_t first;
+    uint16_t n;
+    uint32_t lost_now;
+    char line[TRACE_RECS_PER_LINE * sizeof(ble_server_trace_rec_t) * 2 + 1];
+
+    trace_pause(&first, &n, &lost_now);
+
+    printf("BLE_TRACE begin v1 recs=%u lost=%lu now_us=%lld\n",
+           n, (unsigned long)lost_now, (long long)esp_timer_get_time());
+
+    for (int i = 0; i < n; i += TRACE_RECS_PER_LINE)
+    {
+        int pos = 0;
+
+        for (int j = i; j < n && j < i + TRACE_RECS_PER_LINE; j++)
+        {
+            const uint8_t *bytes = (const uint8_t *)&ring[(first + j) % TRACE_DEPTH];
+
+            for (size_t k = 0; k < sizeof(ble_server_trace_rec_t); k++)
+            {
+                pos += snprintf(&line[pos], sizeof(line) - pos, "%02x", bytes[k]);
+            }
+        }
+        printf("BLE_TRACE %s\n", line);
+    }
+
+    printf("BLE_TRACE end\n");
+    trace_resume();
+    return ESP_OK;
+}
+
+void ble_server_trace_clear(void)
+{
+    portENTER_CRITICAL(&trace_lock);
+    head = 0;
+    count = 0;
+    lost = 0;
+    portEXIT_CRITICAL(&trace_lock);
+}
+
+#else // !CONFIG_BLE_SERVER_TRACE
+
+int ble_server_trace_read(ble_server_trace_rec_t *recs, int max, uint32_t *lost)
+{
+    if (lost)
+    {
+        *lost = 0;
+    }
+    return 0;
+}
+
+esp_err_t ble_server_trace_dump(void)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+void ble_server_trace_clear(void)
+{
+}
+
+#endif
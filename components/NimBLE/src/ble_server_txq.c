@@ -0,0 +1,365 @@
+// components/ble_server/src/ble_server_txq.c
+// Fila de transmissão de notificações por conexão. A aplicação enfileira sem
+// bloquear; o envio acontece sempre na task do host (evento NimBLE), apenas
+// quando há mbufs livres acima da reserva. Sem crédito, a fila espera e é
+// drenada no próximo BLE_GAP_EVENT_NOTIFY_TX ou no timer de nova tentativa.
+#include "ble_server_priv.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "nimble/nimble_port.h"
+#include <string.h>
+
+static const char *TAG = "BLE_TXQ";
+
+typedef struct
+{
+    uint16_t len;
+    int64_t enqueued_at;
+    ble_server_sent_cb_t sent_cb;
+    void *cb_arg;
+    uint8_t data[CONFIG_BLE_SERVER_TXQ_SLOT_SIZE];
+} txq_entry_t;
+
+typedef struct
+{
+    bool in_use;
+    uint16_t conn_handle;
+    uint8_t head;
+    uint8_t count;
+    txq_entry_t entries[CONFIG_BLE_SERVER_TXQ_DEPTH];
+} txq_ring_t;
+
+static txq_ring_t rings[BLE_SERVER_MAX_CONNS];
+static portMUX_TYPE txq_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static struct ble_npl_event pump_ev;
+static struct ble_npl_callout retry_timer;
+
+static ble_server_txq_stats_t stats;
+static uint64_t delay_us_total;
+
+// Busca sem lock (chamador segura txq_lock)
+static txq_ring_t *ring_find_locked(uint16_t conn_handle)
+{
+    for (int i = 0; i < BLE_SERVER_MAX_CONNS; i++)
+    {
+        if (rings[i].in_use && rings[i].conn_handle == conn_handle)
+        {
+            return &rings[i];
+        }
+    }
+    return NULL;
+}
+
+// Crédito de envio: mantém uma reserva de mbufs para RX e ACL
+static bool txq_has_credit(void)
+{
+    return os_msys_num_free() > CONFIG_BLE_SERVER_TXQ_MSYS_RESERVE;
+}
+
+// Descarta a cabeça da fila e notifica o remetente (executado na task do host)
+static void ring_pop(txq_ring_t *ring, esp_err_t status)
+{
+    ble_server_sent_cb_t sent_cb;
+    void *cb_arg;
+    uint16_t conn_handle;
+
+    portENTER_CRITICAL(&txq_lock);
+    conn_handle = ring->conn_handle;
+    sent_cb = ring->entries[ring->head].sent_cb;
+    cb_arg = ring->entries[ring->head].cb_arg;
+    ring->head = (ring->head + 1) % CONFIG_BLE_SERVER_TXQ_DEPTH;
+    ring->count--;
+    portEXIT_CRITICAL(&txq_lock);
+
+    if (sent_cb)
+    {
+        int64_t cb_at = ble_server_probe_now();
+        sent_cb(conn_handle, status, cb_arg);
+        ble_server_trace_end(BLE_SERVER_TRACE_APP_CB, BLE_SERVER_TRACE_CB_SENT,
+                             conn_handle, cb_at, 0);
+    }
+}
+
+// Tenta enviar a cabeça da fila. Retorna false se faltou crédito/mbuf.
+static bool ring_send_head(txq_ring_t *ring)
+{
+    txq_entry_t *entry = &ring->entries[ring->head];
+
+    if (!txq_has_credit())
+    {
+        return false;
+    }
+
+    // CCCD desabilitado depois do enfileiramento: o cliente não quer mais
+    if (!ble_server_conn_is_subscribed(ring->conn_handle))
+    {
+        portENTER_CRITICAL(&txq_lock);
+        stats.dropped_error++;
+        portEXIT_CRITICAL(&txq_lock);
+        ring_pop(ring, ESP_ERR_INVALID_STATE);
+        return true;
+    }
+
+    struct os_mbuf *om = ble_hs_mbuf_from_flat(entry->data, entry->len);
+    if (om == NULL)
+    {
+        return false;
+    }
+
+    // O mbuf é consumido mesmo em caso de erro
+    int rc = ble_gattc_notify_custom(ring->conn_handle, status_val_handle, om);
+    if (rc == BLE_HS_ENOMEM)
+    {
+        return false;
+    }
+
+    // Espera desde o enfileiramento (novas tentativas por falta de mbuf incluídas)
+    ble_server_trace_end(BLE_SERVER_TRACE_NOTIFY, 0, ring->conn_handle, entry->enqueued_at, rc);
+
+    if (rc != 0)
+    {
+        ESP_LOGW(TAG, "Notificação descartada: conn=%d, rc=%d", ring->conn_handle, rc);
+        ble_server_conn_on_tx(ring->conn_handle, false);
+        portENTER_CRITICAL(&txq_lock);
+        stats.dropped_error++;
+        portEXIT_CRITICAL(&txq_lock);
+        ring_pop(ring, ESP_FAIL);
+        return true;
+    }
+
+    uint32_t delay_us = (uint32_t)(esp_timer_get_time() - entry->enqueued_at);
+
+    ble_server_conn_on_tx(ring->conn_handle, true);
+    portENTER_CRITICAL(&txq_lock);
+    stats.sent++;
+    delay_us_total += delay_us;
+    if (delay_us > stats.delay_us_max)
+        stats.delay_us_max = delay_us;
+    portEXIT_CRITICAL(&txq_lock);
+
+    ring_pop(ring, ESP_OK);
+    return true;
+}
+
+// Drena as filas alternando entre conexões (task do host)
+static void txq_pump(struct ble_npl_event *ev)
+{
+    bool progress = true;
+    bool blocked = false;
+
+    while (progress && !blocked)
+    {
+        progress = false;
+
+        for (int i = 0; i < BLE_SERVER_MAX_CONNS; i++)
+        {
+            txq_ring_t *ring = &rings[i];
+
+            if (!ring->in_use || ring->count == 0)
+            {
+                continue;
+            }
+
+            if (!ring_send_head(ring))
+            {
+                blocked = true;
+                break;
+            }
+            progress = true;
+        }
+    }
+
+    // Sem crédito: nova tentativa quando os mbufs forem liberados
+    if (blocked)
+    {
+        portENTER_CRITICAL(&txq_lock);
+        stats.retries++;
+        portEXIT_CRITICAL(&txq_lock);
+
+        if (!ble_npl_callout_is_active(&retry_timer))
+        {
+            ble_npl_callout_reset(&retry_timer, ble_npl_time_ms_to_ticks32(CONFIG_BLE_SERVER_TXQ_RETRY_MS));
+        }
+    }
+}
+
+// ===== Interface interna =====
+
+void ble_server_txq_init(void)
+{
+    memset(rings, 0, sizeof(rings));
+    ble_npl_event_init(&pump_ev, txq_pump, NULL);
+    ble_npl_callout_init(&retry_timer, nimble_port_get_dflt_eventq(), txq_pump, NULL);
+}
+
+void ble_server_txq_kick(void)
+{
+    ble_npl_eventq_put(nimble_port_get_dflt_eventq(), &pump_ev);
+}
+
+void ble_server_txq_conn_open(uint16_t conn_handle)
+{
+    portENTER_CRITICAL(&txq_lock);
+    for (int i = 0; i < BLE_SERVER_MAX_CONNS; i++)
+    {
+        if (!rings[i].in_use)
+        {
+            rings[i].in_use = true;
+            rings[i].conn_handle = conn_handle;
+            rings[i].head = 0;
+            rings[i].count = 0;
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&txq_lock);
+}
+
+void ble_server_txq_conn_close(uint16_t conn_handle)
+{
+    txq_ring_t *ring;
+
+    // Fecha a fila na mesma seção crítica da busca: enfileiramentos
+    // concorrentes deixam de encontrá-la e não entram durante a drenagem.
+    // O slot só é reaproveitado por conn_open, também na task do host.
+    portENTER_CRITICAL(&txq_lock);
+    ring = ring_find_locked(conn_handle);
+    if (ring)
+    {
+        ring->in_use = false;
+    }
+    portEXIT_CRITICAL(&txq_lock);
+
+    if (ring == NULL)
+    {
+        return;
+    }
+
+    // Pendências da conexão encerrada são descartadas e reportadas
+    while (ring->count > 0)
+    {
+        portENTER_CRITICAL(&txq_lock);
+        stats.dropped_error++;
+        portEXIT_CRITICAL(&txq_lock);
+        ring_pop(ring, ESP_ERR_INVALID_STATE);
+    }
+}
+
+// Copia a notificação para a fila de uma conexão
+static esp_err_t txq_enqueue_one(uint16_t conn_handle, const uint8_t *data, uint16_t len,
+                                 ble_server_sent_cb_t sent_cb, void *arg)
+{
+    esp_err_t err = ESP_OK;
+    int64_t now = esp_timer_get_time();
+
+    // Só quem habilitou o CCCD recebe notificações (também as respostas)
+    bool subscribed = ble_server_conn_is_subscribed(conn_handle);
+
+    portENTER_CRITICAL(&txq_lock);
+    txq_ring_t *ring = ring_find_locked(conn_handle);
+    if (ring == NULL)
+    {
+        err = ESP_ERR_NOT_FOUND;
+    }
+    else if (!subscribed)
+    {
+        err = ESP_ERR_INVALID_STATE;
+    }
+    else if (ring->count == CONFIG_BLE_SERVER_TXQ_DEPTH)
+    {
+        stats.dropped_full++;
+        err = ESP_ERR_NO_MEM;
+    }
+    else
+    {
+        txq_entry_t *entry = &ring->entries[(ring->head + ring->count) % CONFIG_BLE_SERVER_TXQ_DEPTH];
+        entry->len = len;
+        entry->enqueued_at = now;
+        entry->sent_cb = sent_cb;
+        entry->cb_arg = arg;
+        memcpy(entry->data, data, len);
+        ring->count++;
+
+        stats.enqueued++;
+        if (ring->count > stats.depth_max)
+            stats.depth_max = ring->count;
+    }
+    portEXIT_CRITICAL(&txq_lock);
+
+    if (err == ESP_OK)
+    {
+        ble_server_diag_on_notify(conn_handle);
+    }
+    else if (err == ESP_ERR_NO_MEM)
+    {
+        ESP_LOGW(TAG, "Fila de notificações cheia: conn=%d", conn_handle);
+    }
+
+    return err;
+}
+
+esp_err_t ble_server_notify_enqueue(uint16_t conn_handle, const uint8_t *data, uint16_t len,
+                                    ble_server_sent_cb_t sent_cb, void *arg)
+{
+    esp_err_t err;
+
+    if (data == NULL || len == 0)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (len > CONFIG_BLE_SERVER_TXQ_SLOT_SIZE)
+    {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    if (conn_handle != BLE_SERVER_NOTIFY_ALL)
+    {
+        err = txq_enqueue_one(conn_handle, data, len, sent_cb, arg);
+    }
+    else
+    {
+        // Uma cópia por cliente inscrito; sucesso se ao menos um aceitou
+        uint16_t handles[BLE_SERVER_MAX_CONNS];
+        int count = ble_server_conn_subscribers(handles, BLE_SERVER_MAX_CONNS);
+
+        err = count > 0 ? ESP_FAIL : ESP_ERR_INVALID_STATE;
+        for (int i = 0; i < count; i++)
+        {
+            if (txq_enqueue_one(handles[i], data, len, sent_cb, arg) == ESP_OK)
+            {
+                err = ESP_OK;
+            }
+        }
+    }
+
+    if (err == ESP_OK)
+    {
+        ble_server_txq_kick();
+    }
+    return err;
+}
+
+esp_err_t ble_server_get_txq_stats(ble_server_txq_stats_t *out)
+{
+    if (out == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    portENTER_CRITICAL(&txq_lock);
+    *out = stats;
+    if (stats.sent > 0)
+    {
+        out->delay_us_avg = (uint32_t)(delay_us_total / stats.sent);
+    }
+    out->pending = 0;
+    for (int i = 0; i < BLE_SERVER_MAX_CONNS; i++)
+    {
+        if (rings[i].in_use)
+            out->pending += rings[i].count;
+    }
+    portEXIT_CRITICAL(&txq_lock);
+
+    return ESP_OK;
+}
@@ -0,0 +1,68 @@
+// components/ble_server/src/ble_snapshot.c
+// Snapshot versionado: ver ble_snapshot.h
+#include "ble_snapshot.h"
+#include <string.h>
+
+void ble_snapshot_init(ble_snapshot_t *snap, void *slot0, void *slot1, size_t size, const void *initial)
+{
+    snap->slots[0] = slot0;
+    snap->slots[1] = slot1;
+    snap->size = size;
+    memcpy(slot0, initial, size);
+    memcpy(slot1, initial, size);
+    atomic_init(&snap->seq, 0);
+}
+
+void *ble_snapshot_write_begin(ble_snapshot_t *snap)
+{
+    uint32_t seq = atomic_load_explicit(&snap->seq, memory_order_relaxed);
+
+    // Ímpar antes de tocar no slot: um leitor que ainda copia este slot
+    // (duas publicações atrás) vê a sequência mudar e repete
+    atomic_store_explicit(&snap->seq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    // Slot inativo: leitores da publicação atual continuam íntegros
+    return snap->slots[((seq >> 1) + 1) & 1];
+}
+
+void ble_snapshot_write_end(ble_snapshot_t *snap)
+{
+    uint32_t seq = atomic_load_explicit(&snap->seq, memory_order_relaxed);
+
+    // Release: o conteúdo do slot fica visível antes da sequência par
+    atomic_store_explicit(&snap->seq, seq + 1, memory_order_release);
+}
+
+void ble_snapshot_publish(ble_snapshot_t *snap, const void *value)
+{
+    memcpy(ble_snapshot_write_begin(snap), value, snap->size);
+    ble_snapshot_write_end(snap);
+}
+
+const void *ble_snapshot_read_begin(const ble_snapshot_t *snap, uint32_t *seq)
+{
+    *seq = atomic_load_explicit(&((ble_snapshot_t *)snap)->seq, memory_order_acquire);
+    return snap->slots[(*seq >> 1) & 1];
+}
+
+bool ble_snapshot_read_end(const ble_snapshot_t *snap, uint32_t seq)
+{
+    // Garante que a cópia do slot terminou antes de reler a sequência
+    atomic_thread_fence(memory_order_acquire);
+    uint32_t now = atomic_load_explicit(&((ble_snapshot_t *)snap)->seq, memory_order_relaxed);
+
+    // Desde a última publicação antes da leitura (sequência par) cabe uma
+    // escrita completa no outro slot; a seguinte (+3) já reescreve o nosso
+    return (uint32_t)(now - (seq & ~1u)) <= 2;
+}
+
+void ble_snapshot_read(const ble_snapshot_t *snap, void *out)
+{
+    uint32_t seq;
+
+    do
+    {
+        memcpy(out, ble_snapshot_read_begin(snap, &seq), snap->size);
+    } while (!ble_snapshot_read_end(snap, seq));
+}
@@ -0,0 +1,75 @@
+// components/ble_server/src/ble_snapshot.h
+// Snapshot versionado (seqlock + buffer duplo) para um escritor e leitores
+// que nunca bloqueiam. Como num seqlock clássico a sequência fica ímpar
+// durante a escrita e par quando publicada; seq / 2 conta as publicações e
+// o slot ativo é (seq / 2) & 1. O escritor grava sempre no slot inativo,
+// então o leitor só precisa repetir se uma escrita começou no slot que ele
+// está lendo, a segunda depois da sequência lida.
+// C portável (sem FreeRTOS/NimBLE): os escritores devem ser serializados
+// pelo chamador.
+#ifndef BLE_SNAPSHOT_H
+#define BLE_SNAPSHOT_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct
+{
+    atomic_uint_fast32_t seq; // Ímpar durante a escrita; slot ativo = (seq >> 1) & 1
+    size_t size;
+    void *slots[2];
+} ble_snapshot_t;
+
+/**
+ * @brief Inicializa o snapshot com o valor inicial nos dois slots
+ *
+ * @param snap Snapshot
+ * @param slot0 Armazenamento do slot 0 (size bytes)
+ * @param slot1 Armazenamento do slot 1 (size bytes)
+ * @param size Tamanho do valor
+ * @param initial Valor inicial
+ */
+void ble_snapshot_init(ble_snapshot_t *snap, void *slot0, void *slot1, size_t size, const void *initial);
+
+/**
+ * @brief Retorna o slot livre para o escritor preencher
+ *
+ * O conteúdo é indefinido; grave o valor completo antes de publicar.
+ */
+void *ble_snapshot_write_begin(ble_snapshot_t *snap);
+
+/**
+ * @brief Publica o slot preenchido após ble_snapshot_write_begin()
+ */
+void ble_snapshot_write_end(ble_snapshot_t *snap);
+
+/**
+ * @brief Copia e publica um valor completo
+ */
+void ble_snapshot_publish(ble_snapshot_t *snap, const void *value);
+
+/**
+ * @brief Inicia uma leitura sem cópia
+ *
+ * @param snap Snapshot
+ * @param seq Recebe a sequência lida (repassar a ble_snapshot_read_end)
+ * @return Slot publicado; usar apenas até ble_snapshot_read_end
+ */
+const void *ble_snapshot_read_begin(const ble_snapshot_t *snap, uint32_t *seq);
+
+/**
+ * @brief Valida uma leitura iniciada com ble_snapshot_read_begin
+ *
+ * @return true se o slot não foi reescrito durante a leitura; false se o
+ *         dado pode estar rasgado e a leitura deve ser repetida
+ */
+bool ble_snapshot_read_end(const ble_snapshot_t *snap, uint32_t seq);
+
+/**
+ * @brief Copia um valor consistente (repete até validar)
+ */
+void ble_snapshot_read(const ble_snapshot_t *snap, void *out);
+
+#endif
@@ -0,0 +1,128 @@
+// components/audit_journal/include/audit_journal.h
+// Journal de auditoria append-only numa partição de flash dedicada.
+// Registros de 16 bytes com CRC, gravados em lote por uma tarefa própria;
+// setores reaproveitados em círculo (o mais antigo é apagado ao encher).
+//
+// Registro codificado (little-endian):
+//   [0..3] seq  [4..7] time_s  [8] type  [9] flags  [10..11] value  [12..15] CRC-32
+#ifndef AUDIT_JOURNAL_H
+#define AUDIT_JOURNAL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define AUDIT_JOURNAL_RECORD_LEN 16
+
+// time_s é tempo Unix; sem a flag, segundos desde o boot (relógio não sincronizado)
+#define AUDIT_FLAG_TIME_SYNCED 0x01
+
+    typedef struct
+    {
+        uint32_t seq;    // Sequência global, crescente
+        uint32_t time_s; // Momento do evento
+        uint8_t type;    // Código do evento (definido pela aplicação)
+        uint8_t flags;   // AUDIT_FLAG_*
+        uint16_t value;  // Valor associado
+    } audit_record_t;
+
+    // Posição de leitura: próximo seq a entregar (0 = mais antigo disponível)
+    typedef struct
+    {
+        uint32_t next_seq;
+    } audit_journal_cursor_t;
+
+    typedef struct
+    {
+        uint32_t appended;       // Registros aceitos
+        uint32_t dropped;        // Descartados por buffer cheio
+        uint32_t flushed;        // Registros gravados na flash
+        uint32_t flash_writes;   // Operações de escrita (lotes)
+        uint32_t sectors_erased; // Setores reaproveitados
+        uint32_t corrupt;        // Registros inválidos encontrados (escrita interrompida)
+        uint32_t oldest_seq;     // Registro mais antigo na flash
+        uint32_t next_seq;       // Próximo seq a ser atribuído
+        uint32_t pending;        // Registros na RAM aguardando gravação
+        uint32_t recover_us;     // Duração da varredura do boot
+    } audit_journal_stats_t;
+
+    /**
+     * @brief Localiza a partição, recupera a posição de escrita e cria a tarefa
+     *
+     * A varredura do boot descarta registros com CRC inválido (queda de
+     * energia durante uma escrita) e continua logo após eles.
+     *
+     * @return ESP_OK se sucesso, ESP_ERR_NOT_FOUND se a partição não existe
+     */
+    esp_err_t audit_journal_init(void);
+
+    /**
+     * @brief Acrescenta um evento (não bloqueia, não acessa a flash)
+     *
+     * Pode ser chamada de qualquer tarefa. O registro vai para a flash no
+     * próximo lote (CONFIG_AUDIT_JOURNAL_BATCH_RECORDS pendentes ou
+     * CONFIG_AUDIT_JOURNAL_FLUSH_MS).
+     *
+     * @param type Código do evento
+     * @param value Valor associado
+     * @return ESP_OK se aceito, ESP_ERR_NO_MEM se o buffer está cheio,
+     *         ESP_ERR_INVALID_STATE antes de audit_journal_init()
+     */
+    esp_err_t audit_journal_append(uint8_t type, uint16_t value);
+
+    /**
+     * @brief Grava imediatamente os registros pendentes (bloqueia)
+     *
+     * @return ESP_OK se sucesso
+     */
+    esp_err_t audit_journal_flush(void);
+
+    /**
+     * @brief Pede à tarefa de gravação o lote pendente agora (não bloqueia)
+     *
+     * Para tarefas que não podem esperar a flash, como a do host BLE.
+     */
+    void audit_journal_request_flush(void);
+
+    /**
+     * @brief Posiciona o cursor a partir de um seq (0 = mais antigo)
+     */
+    void audit_journal_cursor_init(audit_journal_cursor_t *cursor, uint32_t from_seq);
+
+    /**
+     * @brief Lê registros a partir do cursor, avançando-o
+     *
+     * Depois dos gravados vêm os ainda pendentes na RAM, na mesma ordem.
+     * Registros sobrescritos pelo reaproveitamento são pulados.
+     *
+     * @return Quantidade de registros lidos (0 = fim do journal)
+     */
+    int audit_journal_read(audit_journal_cursor_t *cursor, audit_record_t *records, int max);
+
+    /**
+     * @brief Lê registros já codificados, quantos couberem em cap
+     *
+     * Para streaming por BLE: cap = MTU - 3 entrega um pacote por chamada.
+     *
+     * @return Bytes escritos em buf (múltiplo de AUDIT_JOURNAL_RECORD_LEN)
+     */
+    size_t audit_journal_read_chunk(audit_journal_cursor_t *cursor, uint8_t *buf, size_t cap);
+
+    /**
+     * @brief Lê as estatísticas do journal
+     *
+     * @param stats Estrutura preenchida com os contadores atuais
+     * @return ESP_OK se sucesso
+     */
+    esp_err_t audit_journal_get_stats(audit_journal_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
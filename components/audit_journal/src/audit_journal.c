@@ -0,0 +1,596 @@
+// components/audit_journal/src/audit_journal.c
+// Layout: a partição é um anel de setores de 4 KB, cada um com 256 slots de
+// registro. A posição de escrita (setor/slot) avança em ordem; ao encher um
+// setor o próximo é apagado (o mais antigo do anel) antes de receber dados.
+// Nada além dos registros vai para a flash: a varredura do boot reconstrói
+// o primeiro seq de cada setor e a posição de escrita a partir deles.
+//
+// Queda de energia: um slot gravado pela metade fica com CRC inválido, é
+// pulado na leitura e a escrita continua depois dele. Um apagamento
+// interrompido é refeito ao entrar de novo no setor.
+#include "audit_journal.h"
+#include "esp_log.h"
+#include "esp_partition.h"
+#include "esp_rom_crc.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "time_sync.h"
+#include <stdlib.h>
+#include <string.h>
+
+static const char *TAG = "AUDIT";
+
+#define SECTOR_SIZE 4096
+#define RECS_PER_SECTOR (SECTOR_SIZE / AUDIT_JOURNAL_RECORD_LEN)
+#define RECORD_CRC_OFFSET 12
+#define IO_RECORDS 32 // Slots por operação de leitura/escrita (512 bytes)
+#define SEQ_NONE UINT32_MAX
+#define BUF_RECORDS CONFIG_AUDIT_JOURNAL_BUFFER_RECORDS
+
+typedef enum
+{
+    SLOT_ERASED,
+    SLOT_VALID,
+    SLOT_CORRUPT,
+} slot_state_t;
+
+// Partição e índice em RAM (protegidos por flash_lock)
+static const esp_partition_t *part;
+static uint32_t num_sectors;
+static uint32_t *sector_first; // seq do primeiro registro válido (SEQ_NONE se nenhum)
+static uint32_t head_sector;   // Posição de escrita
+static uint32_t head_index;
+static uint8_t io_buf[IO_RECORDS * AUDIT_JOURNAL_RECORD_LEN];
+static SemaphoreHandle_t flash_lock;
+
+// Registros pendentes (anel) e seq: portMUX, nunca tocam a flash
+static audit_record_t pending[BUF_RECORDS];
+static uint32_t pending_tail; // Mais antigo
+static uint32_t pending_count;
+static uint32_t next_seq = 1; // 0 fica para "mais antigo" no cursor
+static portMUX_TYPE pending_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static TaskHandle_t writer_task;
+static audit_journal_stats_t stats;
+
+// ===== Codificação =====
+
+static void put_u32le(uint8_t *p, uint32_t v)
+{
+    p[0] = v & 0xFF;
+    p[1] = (v >> 8) & 0xFF;
+    p[2] = (v >> 16) & 0xFF;
+    p[3] = (v >> 24) & 0xFF;
+}
+
+static uint32_t get_u32le(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static void record_encode(const audit_record_t *rec, uint8_t *p)
+{
+    put_u32le(&p[0], rec->seq);
+    put_u32le(&p[4], rec->time_s);
+    p[8] = rec->type;
+    p[9] = rec->flags;
+    p[10] = rec->value & 0xFF;
+    p[11] = (rec->value >> 8) & 0xFF;
+    put_u32le(&p[RECORD_CRC_OFFSET], esp_rom_crc32_le(0, p, RECORD_CRC_OFFSET));
+}
+
+static slot_state_t record_decode(const uint8_t *p, audit_record_t *rec)
+{
+    bool erased = true;
+
+    for (int i = 0; i < AUDIT_JOURNAL_RECORD_LEN; i++)
+    {
+        if (p[i] != 0xFF)
+        {
+            erased = false;
+            break;
+        }
+    }
+    if (erased)
+    {
+        return SLOT_ERASED;
+    }
+    if (get_u32le(&p[RECORD_CRC_OFFSET]) != esp_rom_crc32_le(0, p, RECORD_CRC_OFFSET))
+    {
+        return SLOT_CORRUPT;
+    }
+
+    rec->seq = get_u32le(&p[0]);
+    rec->time_s = get_u32le(&p[4]);
+    rec->type = p[8];
+    rec->flags = p[9];
+    rec->value = p[10] | (p[11] << 8);
+    return SLOT_VALID;
+}
+
+// ===== Acesso à flash (com flash_lock) =====
+
+static size_t slot_addr(uint32_t sector, uint32_t index)
+{
+    return (size_t)sector * SECTOR_SIZE + (size_t)index * AUDIT_JOURNAL_RECORD_LEN;
+}
+
+static esp_err_t slots_read(uint32_t sector, uint32_t index, uint32_t count)
+{
+    return esp_partition_read(part, slot_addr(sector, index), io_buf, count * AUDIT_JOURNAL_RECORD_LEN);
+}
+
+// Percorre o setor: primeiro seq válido, último slot usado e maior seq
+static void sector_scan(uint32_t sector, uint32_t *first, int *last_used, uint32_t *max_seq, uint32_t *corrupt)
+{
+    audit_record_t rec;
+
+    *first = SEQ_NONE;
+    *last_used = -1;
+    *max_seq = 0;
+    *corrupt = 0;
+
+    for (uint32_t i = 0; i < RECS_PER_SECTOR; i += IO_RECORDS)
+    {
+        if (slots_read(sector, i, IO_RECORDS) != ESP_OK)
+        {
+            return;
+        }
+        for (uint32_t j = 0; j < IO_RECORDS; j++)
+        {
+            slot_state_t state = record_decode(&io_buf[j * AUDIT_JOURNAL_RECORD_LEN], &rec);
+            if (state == SLOT_ERASED)
+            {
+                continue;
+            }
+
+            *last_used = i + j;
+            if (state == SLOT_CORRUPT)
+            {
+                (*corrupt)++;
+                continue;
+            }
+            if (*first == SEQ_NONE)
+            {
+                *first = rec.seq;
+            }
+            if (rec.seq > *max_seq)
+            {
+                *max_seq = rec.seq;
+            }
+        }
+    }
+}
+
+static void recover(void)
+{
+    uint32_t max_seq = 0;
+    uint32_t first, seq, corrupt;
+    int last_used;
+    int head_last_used = -1;
+    bool found = false;
+
+    head_sector = 0;
+    for (uint32_t s = 0; s < num_sectors; s++)
+    {
+        sector_scan(s, &first, &last_used, &seq, &corrupt);
+        sector_first[s] = first;
+
+        // Setor de escrita: o que tem o maior seq
+        if (first != SEQ_NONE && (!found || seq > max_seq))
+        {
+            found = true;
+            max_seq = seq;
+            head_sector = s;
+            head_last_used = last_used;
+            stats.corrupt = corrupt;
+        }
+        else if (!found && s == 0)
+        {
+            head_last_used = last_used;
+        }
+    }
+
+    if (!found)
+    {
+        // Journal vazio: começa no setor 0, apagando restos se houver
+        if (head_last_used >= 0)
+        {
+            esp_partition_erase_range(part, 0, SECTOR_SIZE);
+            stats.sectors_erased++;
+        }
+        head_index = 0;
+        return;
+    }
+
+    head_index = head_last_used + 1;
+    next_seq = max_seq + 1;
+}
+
+static esp_err_t sector_advance(void)
+{
+    uint32_t next = (head_sector + 1) % num_sectors;
+
+    // Reaproveita o setor mais antigo
+    esp_err_t err = esp_partition_erase_range(part, next * SECTOR_SIZE, SECTOR_SIZE);
+    if (err != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Erro ao apagar setor %lu: %s", next, esp_err_to_name(err));
+        return err;
+    }
+
+    sector_first[next] = SEQ_NONE;
+    head_sector = next;
+    head_index = 0;
+    stats.sectors_erased++;
+    return ESP_OK;
+}
+
+static esp_err_t flush_locked(void)
+{
+    for (;;)
+    {
+        uint32_t tail, count;
+
+        portENTER_CRITICAL(&pending_lock);
+        tail = pending_tail;
+        count = pending_count;
+        portEXIT_CRITICAL(&pending_lock);
+
+        if (count == 0)
+        {
+            return ESP_OK;
+        }
+
+        if (head_index >= RECS_PER_SECTOR)
+        {
+            esp_err_t err = sector_advance();
+            if (err != ESP_OK)
+            {
+                return err;
+            }
+        }
+
+        // Lote contíguo dentro do setor; os slots pendentes não mudam até
+        // serem liberados abaixo
+        uint32_t n = count;
+        if (n > RECS_PER_SECTOR - head_index)
+            n = RECS_PER_SECTOR - head_index;
+        if (n > IO_RECORDS)
+            n = IO_RECORDS;
+
+        for (uint32_t i = 0; i < n; i++)
+        {
+            record_encode(&pending[(tail + i) % BUF_RECORDS], &io_buf[i * AUDIT_JOURNAL_RECORD_LEN]);
+        }
+
+        esp_err_t err = esp_partition_write(part, slot_addr(head_sector, head_index), io_buf,
+                                            n * AUDIT_JOURNAL_RECORD_LEN);
+        if (err != ESP_OK)
+        {
+            // Slots podem ter ficado parcialmente gravados: pula e tenta depois
+            ESP_LOGE(TAG, "Erro ao gravar lote: %s", esp_err_to_name(err));
+            head_index += n;
+            return err;
+        }
+
+        if (sector_first[head_sector] == SEQ_NONE)
+        {
+            sector_first[head_sector] = pending[tail % BUF_RECORDS].seq;
+        }
+        head_index += n;
+
+        portENTER_CRITICAL(&pending_lock);
+        pending_tail = (tail + n) % BUF_RECORDS;
+        pending_count -= n;
+        stats.flushed += n;
+        stats.flash_writes++;
+        portEXIT_CRITICAL(&pending_lock);
+    }
+}
+
+// Setor e slot de onde a leitura de seq começa
+static bool locate(uint32_t seq, uint32_t *sector, uint32_t *index)
+{
+    uint32_t best = SEQ_NONE;
+    uint32_t oldest = SEQ_NONE;
+    audit_record_t rec;
+
+    for (uint32_t s = 0; s < num_sectors; s++)
+    {
+        uint32_t first = sector_first[s];
+        if (first == SEQ_NONE)
+        {
+            continue;
+        }
+        if (first <= seq && (best == SEQ_NONE || first > sector_first[best]))
+        {
+            best = s;
+        }
+        if (oldest == SEQ_NONE || first < sector_first[oldest])
+        {
+            oldest = s;
+        }
+    }
+
+    if (oldest == SEQ_NONE)
+    {
+        return false;
+    }
+    if (best == SEQ_NONE)
+    {
+        // seq já foi sobrescrito (ou 0): começa do mais antigo
+        *sector = oldest;
+        *index = 0;
+        return true;
+    }
+
+    // Sem slots corrompidos o registro está na posição exata
+    *sector = best;
+    *index = 0;
+    uint32_t guess = seq - sector_first[best];
+    if (guess < RECS_PER_SECTOR && slots_read(best, guess, 1) == ESP_OK &&
+        record_decode(io_buf, &rec) == SLOT_VALID && rec.seq == seq)
+    {
+        *index = guess;
+    }
+    return true;
+}
+
+static void writer_task_fn(void *arg)
+{
+    for (;;)
+    {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(CONFIG_AUDIT_JOURNAL_FLUSH_MS));
+
+        xSemaphoreTake(flash_lock, portMAX_DELAY);
+        flush_locked();
+        xSemaphoreGive(flash_lock);
+    }
+}
+
+// ===== API Pública =====
+
+esp_err_t audit_journal_init(void)
+{
+    if (part != NULL)
+    {
+        return ESP_OK;
+    }
+
+    const esp_partition_t *p = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY,
+                                                        CONFIG_AUDIT_JOURNAL_PARTITION_LABEL);
+    if (p == NULL)
+    {
+        ESP_LOGE(TAG, "Partição '%s' não encontrada", CONFIG_AUDIT_JOURNAL_PARTITION_LABEL);
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    num_sectors = p->size / SECTOR_SIZE;
+    if (num_sectors < 2)
+    {
+        ESP_LOGE(TAG, "Partição precisa de ao menos 2 setores");
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    sector_first = malloc(num_sectors * sizeof(uint32_t));
+    flash_lock = xSemaphoreCreateMutex();
+    if (sector_first == NULL || flash_lock == NULL)
+    {
+        free(sector_first);
+        sector_first = NULL;
+        if (flash_lock)
+        {
+            vSemaphoreDelete(flash_lock);
+            flash_lock = NULL;
+        }
+        return ESP_ERR_NO_MEM;
+    }
+
+    int64_t started_at = esp_timer_get_time();
+    part = p;
+    recover();
+    stats.recover_us = (uint32_t)(esp_timer_get_time() - started_at);
+
+    if (xTaskCreate(writer_task_fn, "audit_wr", CONFIG_AUDIT_JOURNAL_TASK_STACK_SIZE, NULL,
+                    CONFIG_AUDIT_JOURNAL_TASK_PRIORITY, &writer_task) != pdPASS)
+    {
+        ESP_LOGE(TAG, "Erro ao criar tarefa de gravação");
+        part = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+
+    ESP_LOGI(TAG, "Journal: %lu setores, próximo seq=%lu, setor=%lu slot=%lu, %lu inválidos, varredura %lu us",
+             num_sectors, next_seq, head_sector, head_index, stats.corrupt, stats.recover_us);
+    return ESP_OK;
+}
+
+esp_err_t audit_journal_append(uint8_t type, uint16_t value)
+{
+    time_sync_stamp_t stamp;
+    audit_record_t rec;
+    bool kick;
+
+    if (part == NULL)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    time_sync_stamp(&stamp);
+    rec.time_s = (uint32_t)((stamp.synced ? stamp.wall_us : stamp.mono_us) / 1000000);
+    rec.flags = stamp.synced ? AUDIT_FLAG_TIME_SYNCED : 0;
+    rec.type = type;
+    rec.value = value;
+
+    portENTER_CRITICAL(&pending_lock);
+    if (pending_count == BUF_RECORDS)
+    {
+        stats.dropped++;
+        portEXIT_CRITICAL(&pending_lock);
+        return ESP_ERR_NO_MEM;
+    }
+    rec.seq = next_seq++;
+    pending[(pending_tail + pending_count) % BUF_RECORDS] = rec;
+    pending_count++;
+    stats.appended++;
+    kick = pending_count == CONFIG_AUDIT_JOURNAL_BATCH_RECORDS;
+    portEXIT_CRITICAL(&pending_lock);
+
+    // Lote completo: grava sem esperar o intervalo
+    if (kick)
+    {
+        xTaskNotifyGive(writer_task);
+    }
+    return ESP_OK;
+}
+
+esp_err_t audit_journal_flush(void)
+{
+    if (part == NULL)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    xSemaphoreTake(flash_lock, portMAX_DELAY);
+    esp_err_t err = flush_locked();
+    xSemaphoreGive(flash_lock);
+    return err;
+}
+
+void audit_journal_request_flush(void)
+{
+    if (part != NULL)
+    {
+        xTaskNotifyGive(writer_task);
+    }
+}
+
+void audit_journal_cursor_init(audit_journal_cursor_t *cursor, uint32_t from_seq)
+{
+    cursor->next_seq = from_seq;
+}
+
+int audit_journal_read(audit_journal_cursor_t *cursor, audit_record_t *records, int max)
+{
+    uint32_t sector, index;
+    audit_record_t rec;
+    int n = 0;
+
+    if (part == NULL || max <= 0)
+    {
+        return 0;
+    }
+
+    xSemaphoreTake(flash_lock, portMAX_DELAY);
+
+    if (locate(cursor->next_seq, &sector, &index))
+    {
+        // Percorre em ordem até a posição de escrita
+        while (n < max)
+        {
+            if (sector == head_sector && index >= head_index)
+            {
+                break;
+            }
+            if (index >= RECS_PER_SECTOR)
+            {
+                sector = (sector + 1) % num_sectors;
+                index = 0;
+                continue;
+            }
+
+            uint32_t end = sector == head_sector ? head_index : RECS_PER_SECTOR;
+            uint32_t count = end - index;
+            if (count > IO_RECORDS)
+                count = IO_RECORDS;
+
+            if (slots_read(sector, index, count) != ESP_OK)
+            {
+                break;
+            }
+            for (uint32_t j = 0; j < count && n < max; j++)
+            {
+                if (record_decode(&io_buf[j * AUDIT_JOURNAL_RECORD_LEN], &rec) == SLOT_VALID &&
+                    rec.seq >= cursor->next_seq)
+                {
+                    records[n++] = rec;
+                    cursor->next_seq = rec.seq + 1;
+                }
+            }
+            index += count;
+        }
+    }
+
+    // Depois da flash, os pendentes na RAM: com flash_lock nenhum lote está
+    // sendo gravado, então eles continuam exatamente do último gravado
+    portENTER_CRITICAL(&pending_lock);
+    for (uint32_t i = 0; i < pending_count && n < max; i++)
+    {
+        rec = pending[(pending_tail + i) % BUF_RECORDS];
+        if (rec.seq >= cursor->next_seq)
+        {
+            records[n++] = rec;
+            cursor->next_seq = rec.seq + 1;
+        }
+    }
+    portEXIT_CRITICAL(&pending_lock);
+
+    xSemaphoreGive(flash_lock);
+    return n;
+}
+
+size_t audit_journal_read_chunk(audit_journal_cursor_t *cursor, uint8_t *buf, size_t cap)
+{
+    audit_record_t recs[8];
+    size_t len = 0;
+
+    while (cap - len >= AUDIT_JOURNAL_RECORD_LEN)
+    {
+        int max = (cap - len) / AUDIT_JOURNAL_RECORD_LEN;
+        if (max > 8)
+            max = 8;
+
+        int n = audit_journal_read(cursor, recs, max);
+        for (int i = 0; i < n; i++)
+        {
+            record_encode(&recs[i], &buf[len]);
+            len += AUDIT_JOURNAL_RECORD_LEN;
+        }
+        if (n < max)
+        {
+            break;
+        }
+    }
+    return len;
+}
+
+esp_err_t audit_journal_get_stats(audit_journal_stats_t *out)
+{
+    if (out == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    portENTER_CRITICAL(&pending_lock);
+    *out = stats;
+    out->next_seq = next_seq;
+    out->pending = pending_count;
+    portEXIT_CRITICAL(&pending_lock);
+
+    out->oldest_seq = 0;
+    if (part != NULL)
+    {
+        xSemaphoreTake(flash_lock, portMAX_DELAY);
+        for (uint32_t s = 0; s < num_sectors; s++)
+        {
+            if (sector_first[s] != SEQ_NONE && (out->oldest_seq == 0 || sector_first[s] < out->oldest_seq))
+            {
+                out->oldest_seq = sector_first[s];
+            }
+        }
+        xSemaphoreGive(flash_lock);
+    }
+    return ESP_OK;
+}
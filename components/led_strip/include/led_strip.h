@@ -50,6 +50,58 @@ esp_err_t led_strip_set_pixel(led_strip_handle_t strip, uint32_t index, uint32_t
  */
 esp_err_t led_strip_set_pixel_rgbw(led_strip_handle_t strip, uint32_t index, uint32_t red, uint32_t green, uint32_t blue, uint32_t white);
 
+/**
+ * @brief Set a range of pixels from a color array
+ *
+ * @note When `color_fmt` matches the strip's color component format, the pixels are copied without reordering
+ *
+ * @param strip: LED strip
+ * @param start: index of the first pixel to set
+ * @param count: number of pixels to set
+ * @param colors: packed source pixels, `count * color_fmt.format.num_components` bytes
+ * @param color_fmt: order and number of the color components in `colors`, e.g. `LED_STRIP_COLOR_COMPONENT_FMT_RGB`.
+ *                   A 3-component source sets white to 0 on RGBW strips; the white of a 4-component source is dropped on RGB strips
+ *
+ * @return
+ *      - ESP_OK: Set pixels successfully
+ *      - ESP_ERR_INVALID_ARG: Set pixels failed because of invalid parameters
+ *      - ESP_ERR_NOT_SUPPORTED: The backend does not support bulk writes
+ */
+esp_err_t led_strip_set_pixels(led_strip_handle_t strip, uint32_t start, uint32_t count, const uint8_t *colors, led_color_component_format_t color_fmt);
+
+/**
+ * @brief Set a range of pixels to the same color
+ *
+ * @param strip: LED strip
+ * @param start: index of the first pixel to set
+ * @param count: number of pixels to set
+ * @param red: red part of color
+ * @param green: green part of color
+ * @param blue: blue part of color
+ * @param white: white part of color, ignored if the LED doesn't have 4 components
+ *
+ * @return
+ *      - ESP_OK: Fill pixels successfully
+ *      - ESP_ERR_INVALID_ARG: Fill pixels failed because of invalid parameters
+ *      - ESP_ERR_NOT_SUPPORTED: The backend does not support bulk writes
+ */
+esp_err_t led_strip_fill(led_strip_handle_t strip, uint32_t start, uint32_t count, uint32_t red, uint32_t green, uint32_t blue, uint32_t white);
+
+/**
+ * @brief Copy a range of pixels inside the strip, e.g. to scroll an animation
+ *
+ * @param strip: LED strip
+ * @param dst_index: index of the first destination pixel
+ * @param src_index: index of the first source pixel
+ * @param count: number of pixels to copy, the ranges may overlap
+ *
+ * @return
+ *      - ESP_OK: Copy pixels successfully
+ *      - ESP_ERR_INVALID_ARG: Copy pixels failed because of invalid parameters
+ *      - ESP_ERR_NOT_SUPPORTED: The backend does not support bulk writes
+ */
+esp_err_t led_strip_copy_range(led_strip_handle_t strip, uint32_t dst_index, uint32_t src_index, uint32_t count);
+
 /**
  * @brief Set HSV for a specific pixel
  *
@@ -80,6 +132,38 @@ esp_err_t led_strip_set_pixel_hsv(led_strip_handle_t strip, uint32_t index, uint
  */
 esp_err_t led_strip_refresh(led_strip_handle_t strip);
 
+/**
+ * @brief Start refreshing memory colors to LEDs, return without waiting for the transmission
+ *
+ * @note The previous asynchronous refresh (if any) is waited for before the new one starts,
+ *       so frames are never dropped.
+ * @note With the RMT `double_buffer` flag, pixels can be set right after this call returns: the frame
+ *       being sent lives in the other buffer. Without it, wait for `led_strip_refresh_wait_done` before
+ *       modifying pixels again.
+ *
+ * @param strip: LED strip
+ *
+ * @return
+ *      - ESP_OK: Refresh started successfully
+ *      - ESP_ERR_NOT_SUPPORTED: The backend does not support asynchronous refresh
+ *      - ESP_FAIL: Refresh failed because some other error occurred
+ */
+esp_err_t led_strip_refresh_async(led_strip_handle_t strip);
+
+/**
+ * @brief Wait for the pending asynchronous refresh to finish
+ *
+ * @param strip: LED strip
+ * @param timeout_ms: timeout value, -1 means wait forever
+ *
+ * @return
+ *      - ESP_OK: Refresh finished (or nothing was pending)
+ *      - ESP_ERR_TIMEOUT: Refresh still in progress after timeout_ms
+ *      - ESP_ERR_NOT_SUPPORTED: The backend does not support asynchronous refresh
+ *      - ESP_FAIL: Wait failed because some other error occurred
+ */
+esp_err_t led_strip_refresh_wait_done(led_strip_handle_t strip, int32_t timeout_ms);
+
 /**
  * @brief Clear LED strip (turn off all LEDs)
  *
@@ -15,6 +15,17 @@
 extern "C" {
 #endif
 
+/**
+ * @brief Callback invoked when a refresh has been sent out to the strip
+ *
+ * @note This callback runs in ISR context, it must not block
+ *
+ * @param strip: LED strip handle
+ * @param user_ctx: User context passed in `led_strip_rmt_config_t::user_ctx`
+ * @return Whether a high priority task has been woken up by this callback
+ */
+typedef bool (*led_strip_refresh_done_cb_t)(led_strip_handle_t strip, void *user_ctx);
+
 /**
  * @brief LED Strip RMT specific configuration
  */
@@ -22,9 +33,13 @@ typedef struct {
     rmt_clock_source_t clk_src; /*!< RMT clock source */
     uint32_t resolution_hz;     /*!< RMT tick resolution, if set to zero, a default resolution (10MHz) will be applied */
     size_t mem_block_symbols;   /*!< How many RMT symbols can one RMT channel hold at one time. Set to 0 will fallback to use the default size. */
+    led_strip_refresh_done_cb_t on_refresh_done; /*!< Called (in ISR context) when each refresh completes, can be NULL */
+    void *user_ctx;             /*!< User context passed to `on_refresh_done` */
     /*!< Extra RMT specific driver flags */
     struct led_strip_rmt_extra_config {
         uint32_t with_dma: 1;   /*!< Use DMA to transmit data */
+        uint32_t keep_enabled: 1; /*!< Keep the RMT channel enabled between refreshes instead of enabling/disabling it on every frame */
+        uint32_t double_buffer: 1; /*!< Allocate a second pixel buffer, so pixels can be drawn while the previous frame is being sent by `led_strip_refresh_async` */
     } flags;                    /*!< Extra driver flags */
 } led_strip_rmt_config_t;
 
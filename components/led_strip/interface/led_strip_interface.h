@@ -7,6 +7,7 @@
 
 #include <stdint.h>
 #include "esp_err.h"
+#include "led_strip_types.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -51,6 +52,52 @@ struct led_strip_t {
      */
     esp_err_t (*set_pixel_rgbw)(led_strip_t *strip, uint32_t index, uint32_t red, uint32_t green, uint32_t blue, uint32_t white);
 
+    /**
+     * @brief Set a range of pixels from a color array
+     *
+     * @param strip: LED strip
+     * @param start: index of the first pixel to set
+     * @param count: number of pixels to set
+     * @param colors: packed source pixels, `count * color_fmt.format.num_components` bytes
+     * @param color_fmt: order and number (3 or 4) of the color components in `colors`, already validated
+     *
+     * @return
+     *      - ESP_OK: Set pixels successfully
+     *      - ESP_ERR_INVALID_ARG: Set pixels failed because the range exceeds the strip
+     */
+    esp_err_t (*set_pixels)(led_strip_t *strip, uint32_t start, uint32_t count, const uint8_t *colors, led_color_component_format_t color_fmt);
+
+    /**
+     * @brief Set a range of pixels to the same color
+     *
+     * @param strip: LED strip
+     * @param start: index of the first pixel to set
+     * @param count: number of pixels to set
+     * @param red: red part of color
+     * @param green: green part of color
+     * @param blue: blue part of color
+     * @param white: white part of color, ignored if the LED doesn't have 4 components
+     *
+     * @return
+     *      - ESP_OK: Fill pixels successfully
+     *      - ESP_ERR_INVALID_ARG: Fill pixels failed because the range exceeds the strip
+     */
+    esp_err_t (*fill)(led_strip_t *strip, uint32_t start, uint32_t count, uint32_t red, uint32_t green, uint32_t blue, uint32_t white);
+
+    /**
+     * @brief Copy a range of pixels inside the strip (ranges may overlap)
+     *
+     * @param strip: LED strip
+     * @param dst_index: index of the first destination pixel
+     * @param src_index: index of the first source pixel
+     * @param count: number of pixels to copy
+     *
+     * @return
+     *      - ESP_OK: Copy pixels successfully
+     *      - ESP_ERR_INVALID_ARG: Copy pixels failed because a range exceeds the strip
+     */
+    esp_err_t (*copy_range)(led_strip_t *strip, uint32_t dst_index, uint32_t src_index, uint32_t count);
+
     /**
      * @brief Refresh memory colors to LEDs
      *
@@ -66,6 +113,30 @@ struct led_strip_t {
      */
     esp_err_t (*refresh)(led_strip_t *strip);
 
+    /**
+     * @brief Start sending memory colors to LEDs without waiting for the transmission to finish
+     *
+     * @param strip: LED strip
+     *
+     * @return
+     *      - ESP_OK: Refresh started successfully
+     *      - ESP_FAIL: Refresh failed because some other error occurred
+     */
+    esp_err_t (*refresh_async)(led_strip_t *strip);
+
+    /**
+     * @brief Wait for the pending asynchronous refresh to finish
+     *
+     * @param strip: LED strip
+     * @param timeout_ms: timeout value, -1 means wait forever
+     *
+     * @return
+     *      - ESP_OK: Refresh finished
+     *      - ESP_ERR_TIMEOUT: Refresh still in progress after timeout_ms
+     *      - ESP_FAIL: Wait failed because some other error occurred
+     */
+    esp_err_t (*wait_refresh_done)(led_strip_t *strip, int32_t timeout_ms);
+
     /**
      * @brief Clear LED strip (turn off all LEDs)
      *
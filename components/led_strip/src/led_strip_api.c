@@ -5,6 +5,7 @@
  */
 #include "esp_log.h"
 #include "esp_check.h"
+#include "esp_bit_defs.h"
 #include "led_strip.h"
 #include "led_strip_interface.h"
 
@@ -75,12 +76,57 @@ esp_err_t led_strip_set_pixel_rgbw(led_strip_handle_t strip, uint32_t index, uin
     return strip->set_pixel_rgbw(strip, index, red, green, blue, white);
 }
 
+esp_err_t led_strip_set_pixels(led_strip_handle_t strip, uint32_t start, uint32_t count, const uint8_t *colors, led_color_component_format_t color_fmt)
+{
+    ESP_RETURN_ON_FALSE(strip && (colors || count == 0), ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    ESP_RETURN_ON_FALSE(strip->set_pixels, ESP_ERR_NOT_SUPPORTED, TAG, "bulk write not supported");
+    // check the validation of the source color component format
+    uint8_t mask = BIT(color_fmt.format.r_pos) | BIT(color_fmt.format.g_pos) | BIT(color_fmt.format.b_pos);
+    if (color_fmt.format.num_components == 3) {
+        ESP_RETURN_ON_FALSE(mask == 0x07, ESP_ERR_INVALID_ARG, TAG, "invalid order argument");
+    } else if (color_fmt.format.num_components == 4) {
+        mask |= BIT(color_fmt.format.w_pos);
+        ESP_RETURN_ON_FALSE(mask == 0x0F, ESP_ERR_INVALID_ARG, TAG, "invalid order argument");
+    } else {
+        ESP_RETURN_ON_FALSE(false, ESP_ERR_INVALID_ARG, TAG, "invalid number of color components: %d", color_fmt.format.num_components);
+    }
+    return strip->set_pixels(strip, start, count, colors, color_fmt);
+}
+
+esp_err_t led_strip_fill(led_strip_handle_t strip, uint32_t start, uint32_t count, uint32_t red, uint32_t green, uint32_t blue, uint32_t white)
+{
+    ESP_RETURN_ON_FALSE(strip, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    ESP_RETURN_ON_FALSE(strip->fill, ESP_ERR_NOT_SUPPORTED, TAG, "bulk write not supported");
+    return strip->fill(strip, start, count, red, green, blue, white);
+}
+
+esp_err_t led_strip_copy_range(led_strip_handle_t strip, uint32_t dst_index, uint32_t src_index, uint32_t count)
+{
+    ESP_RETURN_ON_FALSE(strip, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    ESP_RETURN_ON_FALSE(strip->copy_range, ESP_ERR_NOT_SUPPORTED, TAG, "bulk write not supported");
+    return strip->copy_range(strip, dst_index, src_index, count);
+}
+
 esp_err_t led_strip_refresh(led_strip_handle_t strip)
 {
     ESP_RETURN_ON_FALSE(strip, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
     return strip->refresh(strip);
 }
 
+esp_err_t led_strip_refresh_async(led_strip_handle_t strip)
+{
+    ESP_RETURN_ON_FALSE(strip, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    ESP_RETURN_ON_FALSE(strip->refresh_async, ESP_ERR_NOT_SUPPORTED, TAG, "async refresh not supported");
+    return strip->refresh_async(strip);
+}
+
+esp_err_t led_strip_refresh_wait_done(led_strip_handle_t strip, int32_t timeout_ms)
+{
+    ESP_RETURN_ON_FALSE(strip, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    ESP_RETURN_ON_FALSE(strip->wait_refresh_done, ESP_ERR_NOT_SUPPORTED, TAG, "async refresh not supported");
+    return strip->wait_refresh_done(strip, timeout_ms);
+}
+
 esp_err_t led_strip_clear(led_strip_handle_t strip)
 {
     ESP_RETURN_ON_FALSE(strip, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
@@ -8,6 +8,7 @@
 #include <sys/cdefs.h>
 #include "esp_log.h"
 #include "esp_check.h"
+#include "esp_attr.h"
 #include "driver/rmt_tx.h"
 #include "led_strip.h"
 #include "led_strip_interface.h"
@@ -31,9 +32,21 @@ typedef struct {
     uint32_t strip_len;
     uint8_t bytes_per_pixel;
     led_color_component_format_t component_fmt;
-    uint8_t pixel_buf[];
+    led_strip_refresh_done_cb_t on_refresh_done;
+    void *user_ctx;
+    bool keep_enabled;  // channel stays enabled between refreshes
+    bool enabled;       // channel is currently enabled
+    uint8_t *pixel_buf; // buffer written by set_pixel
+    uint8_t *tx_buf;    // buffer of the last frame sent, same as pixel_buf without double buffering
+    uint8_t pixel_mem[];
 } led_strip_rmt_obj;
 
+static bool IRAM_ATTR led_strip_rmt_trans_done(rmt_channel_handle_t tx_chan, const rmt_tx_done_event_data_t *edata, void *user_ctx)
+{
+    led_strip_rmt_obj *rmt_strip = (led_strip_rmt_obj *)user_ctx;
+    return rmt_strip->on_refresh_done(&rmt_strip->base, rmt_strip->user_ctx);
+}
+
 static esp_err_t led_strip_rmt_set_pixel(led_strip_t *strip, uint32_t index, uint32_t red, uint32_t green, uint32_t blue)
 {
     led_strip_rmt_obj *rmt_strip = __containerof(strip, led_strip_rmt_obj, base);
@@ -71,21 +84,139 @@ static esp_err_t led_strip_rmt_set_pixel_rgbw(led_strip_t *strip, uint32_t index
     return ESP_OK;
 }
 
-static esp_err_t led_strip_rmt_refresh(led_strip_t *strip)
+static esp_err_t led_strip_rmt_set_pixels(led_strip_t *strip, uint32_t start, uint32_t count, const uint8_t *colors, led_color_component_format_t color_fmt)
+{
+    led_strip_rmt_obj *rmt_strip = __containerof(strip, led_strip_rmt_obj, base);
+    ESP_RETURN_ON_FALSE(start <= rmt_strip->strip_len && count <= rmt_strip->strip_len - start, ESP_ERR_INVALID_ARG, TAG, "range out of maximum number of LEDs");
+
+    led_color_component_format_t component_fmt = rmt_strip->component_fmt;
+    uint8_t bytes_per_pixel = rmt_strip->bytes_per_pixel;
+    uint8_t *pixel_buf = rmt_strip->pixel_buf + start * bytes_per_pixel;
+
+    // same layout as the strip: straight copy
+    if (color_fmt.format_id == component_fmt.format_id) {
+        memcpy(pixel_buf, colors, count * bytes_per_pixel);
+        return ESP_OK;
+    }
+
+    uint8_t src_stride = color_fmt.format.num_components;
+    uint8_t r_pos = component_fmt.format.r_pos, g_pos = component_fmt.format.g_pos, b_pos = component_fmt.format.b_pos;
+    uint8_t src_r = color_fmt.format.r_pos, src_g = color_fmt.format.g_pos, src_b = color_fmt.format.b_pos;
+    if (bytes_per_pixel == 3) {
+        for (uint32_t i = 0; i < count; i++) {
+            pixel_buf[r_pos] = colors[src_r];
+            pixel_buf[g_pos] = colors[src_g];
+            pixel_buf[b_pos] = colors[src_b];
+            pixel_buf += 3;
+            colors += src_stride;
+        }
+    } else {
+        uint8_t w_pos = component_fmt.format.w_pos, src_w = color_fmt.format.w_pos;
+        for (uint32_t i = 0; i < count; i++) {
+            pixel_buf[r_pos] = colors[src_r];
+            pixel_buf[g_pos] = colors[src_g];
+            pixel_buf[b_pos] = colors[src_b];
+            pixel_buf[w_pos] = src_stride == 4 ? colors[src_w] : 0;
+            pixel_buf += 4;
+            colors += src_stride;
+        }
+    }
+
+    return ESP_OK;
+}
+
+static esp_err_t led_strip_rmt_fill(led_strip_t *strip, uint32_t start, uint32_t count, uint32_t red, uint32_t green, uint32_t blue, uint32_t white)
 {
     led_strip_rmt_obj *rmt_strip = __containerof(strip, led_strip_rmt_obj, base);
+    ESP_RETURN_ON_FALSE(start <= rmt_strip->strip_len && count <= rmt_strip->strip_len - start, ESP_ERR_INVALID_ARG, TAG, "range out of maximum number of LEDs");
+    if (count == 0) {
+        return ESP_OK;
+    }
+
+    led_color_component_format_t component_fmt = rmt_strip->component_fmt;
+    uint8_t bytes_per_pixel = rmt_strip->bytes_per_pixel;
+    uint8_t *pixel_buf = rmt_strip->pixel_buf + start * bytes_per_pixel;
+
+    pixel_buf[component_fmt.format.r_pos] = red & 0xFF;
+    pixel_buf[component_fmt.format.g_pos] = green & 0xFF;
+    pixel_buf[component_fmt.format.b_pos] = blue & 0xFF;
+    if (component_fmt.format.num_components > 3) {
+        pixel_buf[component_fmt.format.w_pos] = white & 0xFF;
+    }
+    // replicate the first pixel, doubling the copied block each time
+    size_t total = count * bytes_per_pixel;
+    for (size_t done = bytes_per_pixel; done < total; done *= 2) {
+        memcpy(pixel_buf + done, pixel_buf, done < total - done ? done : total - done);
+    }
+
+    return ESP_OK;
+}
+
+static esp_err_t led_strip_rmt_copy_range(led_strip_t *strip, uint32_t dst_index, uint32_t src_index, uint32_t count)
+{
+    led_strip_rmt_obj *rmt_strip = __containerof(strip, led_strip_rmt_obj, base);
+    uint32_t strip_len = rmt_strip->strip_len;
+    ESP_RETURN_ON_FALSE(dst_index <= strip_len && count <= strip_len - dst_index &&
+                        src_index <= strip_len && count <= strip_len - src_index, ESP_ERR_INVALID_ARG, TAG, "range out of maximum number of LEDs");
+
+    uint8_t bytes_per_pixel = rmt_strip->bytes_per_pixel;
+    memmove(rmt_strip->pixel_buf + dst_index * bytes_per_pixel, rmt_strip->pixel_buf + src_index * bytes_per_pixel, count * bytes_per_pixel);
+    return ESP_OK;
+}
+
+static esp_err_t led_strip_rmt_wait_refresh_done(led_strip_t *strip, int32_t timeout_ms)
+{
+    led_strip_rmt_obj *rmt_strip = __containerof(strip, led_strip_rmt_obj, base);
+    if (!rmt_strip->enabled) {
+        // nothing in flight
+        return ESP_OK;
+    }
+    esp_err_t ret = rmt_tx_wait_all_done(rmt_strip->rmt_chan, timeout_ms);
+    if (ret == ESP_ERR_TIMEOUT) {
+        return ret;
+    }
+    ESP_RETURN_ON_ERROR(ret, TAG, "flush RMT channel failed");
+    if (!rmt_strip->keep_enabled) {
+        ESP_RETURN_ON_ERROR(rmt_disable(rmt_strip->rmt_chan), TAG, "disable RMT channel failed");
+        rmt_strip->enabled = false;
+    }
+    return ESP_OK;
+}
+
+static esp_err_t led_strip_rmt_refresh_async(led_strip_t *strip)
+{
+    led_strip_rmt_obj *rmt_strip = __containerof(strip, led_strip_rmt_obj, base);
+    uint32_t frame_len = rmt_strip->strip_len * rmt_strip->bytes_per_pixel;
     rmt_transmit_config_t tx_conf = {
         .loop_count = 0,
     };
 
-    ESP_RETURN_ON_ERROR(rmt_enable(rmt_strip->rmt_chan), TAG, "enable RMT channel failed");
+    if (rmt_strip->enabled) {
+        // the previous frame must be out before its buffer is reused
+        ESP_RETURN_ON_ERROR(rmt_tx_wait_all_done(rmt_strip->rmt_chan, -1), TAG, "flush RMT channel failed");
+    } else {
+        ESP_RETURN_ON_ERROR(rmt_enable(rmt_strip->rmt_chan), TAG, "enable RMT channel failed");
+        rmt_strip->enabled = true;
+    }
     ESP_RETURN_ON_ERROR(rmt_transmit(rmt_strip->rmt_chan, rmt_strip->strip_encoder, rmt_strip->pixel_buf,
-                                     rmt_strip->strip_len * rmt_strip->bytes_per_pixel, &tx_conf), TAG, "transmit pixels by RMT failed");
-    ESP_RETURN_ON_ERROR(rmt_tx_wait_all_done(rmt_strip->rmt_chan, -1), TAG, "flush RMT channel failed");
-    ESP_RETURN_ON_ERROR(rmt_disable(rmt_strip->rmt_chan), TAG, "disable RMT channel failed");
+                                     frame_len, &tx_conf), TAG, "transmit pixels by RMT failed");
+
+    if (rmt_strip->tx_buf != rmt_strip->pixel_buf) {
+        // swap: the frame in flight becomes the front buffer, drawing continues from a copy of it
+        uint8_t *front = rmt_strip->pixel_buf;
+        rmt_strip->pixel_buf = rmt_strip->tx_buf;
+        rmt_strip->tx_buf = front;
+        memcpy(rmt_strip->pixel_buf, front, frame_len);
+    }
     return ESP_OK;
 }
 
+static esp_err_t led_strip_rmt_refresh(led_strip_t *strip)
+{
+    ESP_RETURN_ON_ERROR(led_strip_rmt_refresh_async(strip), TAG, "start refresh failed");
+    return led_strip_rmt_wait_refresh_done(strip, -1);
+}
+
 static esp_err_t led_strip_rmt_clear(led_strip_t *strip)
 {
     led_strip_rmt_obj *rmt_strip = __containerof(strip, led_strip_rmt_obj, base);
@@ -97,6 +228,10 @@ static esp_err_t led_strip_rmt_clear(led_strip_t *strip)
 static esp_err_t led_strip_rmt_del(led_strip_t *strip)
 {
     led_strip_rmt_obj *rmt_strip = __containerof(strip, led_strip_rmt_obj, base);
+    if (rmt_strip->enabled) {
+        ESP_RETURN_ON_ERROR(rmt_tx_wait_all_done(rmt_strip->rmt_chan, -1), TAG, "flush RMT channel failed");
+        ESP_RETURN_ON_ERROR(rmt_disable(rmt_strip->rmt_chan), TAG, "disable RMT channel failed");
+    }
     ESP_RETURN_ON_ERROR(rmt_del_channel(rmt_strip->rmt_chan), TAG, "delete RMT channel failed");
     ESP_RETURN_ON_ERROR(rmt_del_encoder(rmt_strip->strip_encoder), TAG, "delete strip encoder failed");
     free(rmt_strip);
@@ -128,8 +263,11 @@ esp_err_t led_strip_new_rmt_device(const led_strip_config_t *led_config, const l
     }
     // TODO: we assume each color component is 8 bits, may need to support other configurations in the future, e.g. 10bits per color component?
     uint8_t bytes_per_pixel = component_fmt.format.num_components;
-    rmt_strip = calloc(1, sizeof(led_strip_rmt_obj) + led_config->max_leds * bytes_per_pixel);
+    uint32_t num_bufs = rmt_config->flags.double_buffer ? 2 : 1;
+    rmt_strip = calloc(1, sizeof(led_strip_rmt_obj) + num_bufs * led_config->max_leds * bytes_per_pixel);
     ESP_GOTO_ON_FALSE(rmt_strip, ESP_ERR_NO_MEM, err, TAG, "no mem for rmt strip");
+    rmt_strip->pixel_buf = rmt_strip->pixel_mem;
+    rmt_strip->tx_buf = rmt_strip->pixel_mem + (num_bufs - 1) * led_config->max_leds * bytes_per_pixel;
     uint32_t resolution = rmt_config->resolution_hz ? rmt_config->resolution_hz : LED_STRIP_RMT_DEFAULT_RESOLUTION;
 
     // for backward compatibility, if the user does not set the clk_src, use the default value
@@ -159,12 +297,31 @@ esp_err_t led_strip_new_rmt_device(const led_strip_config_t *led_config, const l
     };
     ESP_GOTO_ON_ERROR(rmt_new_led_strip_encoder(&strip_encoder_conf, &rmt_strip->strip_encoder), err, TAG, "create LED strip encoder failed");
 
+    if (rmt_config->on_refresh_done) {
+        rmt_strip->on_refresh_done = rmt_config->on_refresh_done;
+        rmt_strip->user_ctx = rmt_config->user_ctx;
+        rmt_tx_event_callbacks_t cbs = {
+            .on_trans_done = led_strip_rmt_trans_done,
+        };
+        ESP_GOTO_ON_ERROR(rmt_tx_register_event_callbacks(rmt_strip->rmt_chan, &cbs, rmt_strip), err, TAG, "register RMT callbacks failed");
+    }
+    rmt_strip->keep_enabled = rmt_config->flags.keep_enabled;
+    if (rmt_strip->keep_enabled) {
+        ESP_GOTO_ON_ERROR(rmt_enable(rmt_strip->rmt_chan), err, TAG, "enable RMT channel failed");
+        rmt_strip->enabled = true;
+    }
+
     rmt_strip->component_fmt = component_fmt;
     rmt_strip->bytes_per_pixel = bytes_per_pixel;
     rmt_strip->strip_len = led_config->max_leds;
     rmt_strip->base.set_pixel = led_strip_rmt_set_pixel;
     rmt_strip->base.set_pixel_rgbw = led_strip_rmt_set_pixel_rgbw;
+    rmt_strip->base.set_pixels = led_strip_rmt_set_pixels;
+    rmt_strip->base.fill = led_strip_rmt_fill;
+    rmt_strip->base.copy_range = led_strip_rmt_copy_range;
     rmt_strip->base.refresh = led_strip_rmt_refresh;
+    rmt_strip->base.refresh_async = led_strip_rmt_refresh_async;
+    rmt_strip->base.wait_refresh_done = led_strip_rmt_wait_refresh_done;
     rmt_strip->base.clear = led_strip_rmt_clear;
     rmt_strip->base.del = led_strip_rmt_del;
 
@@ -172,6 +329,9 @@ esp_err_t led_strip_new_rmt_device(const led_strip_config_t *led_config, const l
     return ESP_OK;
 err:
     if (rmt_strip) {
+        if (rmt_strip->enabled) {
+            rmt_disable(rmt_strip->rmt_chan);
+        }
         if (rmt_strip->rmt_chan) {
             rmt_del_channel(rmt_strip->rmt_chan);
         }
@@ -13,6 +13,7 @@
 #include "led_strip.h"
 #include "led_strip_interface.h"
 #include "esp_heap_caps.h"
+#include "esp_attr.h"
 
 #define LED_STRIP_SPI_DEFAULT_RESOLUTION (2.5 * 1000 * 1000) // 2.5MHz resolution
 #define LED_STRIP_SPI_DEFAULT_TRANS_QUEUE_SIZE 4
@@ -32,20 +33,34 @@ typedef struct {
     uint8_t pixel_buf[];
 } led_strip_spi_obj;
 
-// please make sure to zero-initialize the buf before calling this function
-static void __led_strip_spi_bit(uint8_t data, uint8_t *buf)
+#if CONFIG_LED_STRIP_SPI_LUT_IN_DRAM
+#define LED_STRIP_SPI_LUT_ATTR DRAM_ATTR
+#else
+#define LED_STRIP_SPI_LUT_ATTR
+#endif
+
+// Each color of 1 bit is represented by 3 bits of SPI, low_level:100 ,high_level:110
+// So a color byte occupies 3 bytes of SPI, MSB first: bit n of the color byte sets bit (3n + 1) of the symbol
+#define SPI_SYMBOL(d) (0x924924UL | (((d) & BIT(0)) << 1) | (((d) & BIT(1)) << 3) | (((d) & BIT(2)) << 5) | \
+                       (((d) & BIT(3)) << 7) | (((d) & BIT(4)) << 9) | (((d) & BIT(5)) << 11) | \
+                       (((d) & BIT(6)) << 13) | (((d) & BIT(7)) << 15))
+#define SPI_LUT_ENTRY(d) { (uint8_t)(SPI_SYMBOL(d) >> 16), (uint8_t)(SPI_SYMBOL(d) >> 8), (uint8_t)SPI_SYMBOL(d) }
+#define SPI_LUT_4(d) SPI_LUT_ENTRY(d), SPI_LUT_ENTRY((d) + 1), SPI_LUT_ENTRY((d) + 2), SPI_LUT_ENTRY((d) + 3)
+#define SPI_LUT_16(d) SPI_LUT_4(d), SPI_LUT_4((d) + 4), SPI_LUT_4((d) + 8), SPI_LUT_4((d) + 12)
+#define SPI_LUT_64(d) SPI_LUT_16(d), SPI_LUT_16((d) + 16), SPI_LUT_16((d) + 32), SPI_LUT_16((d) + 48)
+
+// SPI symbols of every color byte, built at compile time
+static const LED_STRIP_SPI_LUT_ATTR uint8_t s_spi_symbols[256][SPI_BYTES_PER_COLOR_BYTE] = {
+    SPI_LUT_64(0), SPI_LUT_64(64), SPI_LUT_64(128), SPI_LUT_64(192),
+};
+
+// The symbol overwrites the 3 bytes, no need to clear the buf beforehand
+static inline void __led_strip_spi_bit(uint8_t data, uint8_t *buf)
 {
-    // Each color of 1 bit is represented by 3 bits of SPI, low_level:100 ,high_level:110
-    // So a color byte occupies 3 bytes of SPI.
-    *(buf + 2) |= data & BIT(0) ? BIT(2) | BIT(1) : BIT(2);
-    *(buf + 2) |= data & BIT(1) ? BIT(5) | BIT(4) : BIT(5);
-    *(buf + 2) |= data & BIT(2) ? BIT(7) : 0x00;
-    *(buf + 1) |= BIT(0);
-    *(buf + 1) |= data & BIT(3) ? BIT(3) | BIT(2) : BIT(3);
-    *(buf + 1) |= data & BIT(4) ? BIT(6) | BIT(5) : BIT(6);
-    *(buf + 0) |= data & BIT(5) ? BIT(1) | BIT(0) : BIT(1);
-    *(buf + 0) |= data & BIT(6) ? BIT(4) | BIT(3) : BIT(4);
-    *(buf + 0) |= data & BIT(7) ? BIT(7) | BIT(6) : BIT(7);
+    const uint8_t *symbol = s_spi_symbols[data];
+    buf[0] = symbol[0];
+    buf[1] = symbol[1];
+    buf[2] = symbol[2];
 }
 
 static esp_err_t led_strip_spi_set_pixel(led_strip_t *strip, uint32_t index, uint32_t red, uint32_t green, uint32_t blue)
@@ -56,7 +71,6 @@ static esp_err_t led_strip_spi_set_pixel(led_strip_t *strip, uint32_t index, uin
     uint32_t start = index * spi_strip->bytes_per_pixel * SPI_BYTES_PER_COLOR_BYTE;
     uint8_t *pixel_buf = spi_strip->pixel_buf;
     led_color_component_format_t component_fmt = spi_strip->component_fmt;
-    memset(pixel_buf + start, 0, spi_strip->bytes_per_pixel * SPI_BYTES_PER_COLOR_BYTE);
 
     __led_strip_spi_bit(red, &pixel_buf[start + SPI_BYTES_PER_COLOR_BYTE * component_fmt.format.r_pos]);
     __led_strip_spi_bit(green, &pixel_buf[start + SPI_BYTES_PER_COLOR_BYTE * component_fmt.format.g_pos]);
@@ -78,7 +92,6 @@ static esp_err_t led_strip_spi_set_pixel_rgbw(led_strip_t *strip, uint32_t index
     // LED_PIXEL_FORMAT_GRBW takes 96bits(12bytes)
     uint32_t start = index * spi_strip->bytes_per_pixel * SPI_BYTES_PER_COLOR_BYTE;
     uint8_t *pixel_buf = spi_strip->pixel_buf;
-    memset(pixel_buf + start, 0, spi_strip->bytes_per_pixel * SPI_BYTES_PER_COLOR_BYTE);
 
     __led_strip_spi_bit(red, &pixel_buf[start + SPI_BYTES_PER_COLOR_BYTE * component_fmt.format.r_pos]);
     __led_strip_spi_bit(green, &pixel_buf[start + SPI_BYTES_PER_COLOR_BYTE * component_fmt.format.g_pos]);
@@ -88,6 +101,85 @@ static esp_err_t led_strip_spi_set_pixel_rgbw(led_strip_t *strip, uint32_t index
     return ESP_OK;
 }
 
+static esp_err_t led_strip_spi_set_pixels(led_strip_t *strip, uint32_t start, uint32_t count, const uint8_t *colors, led_color_component_format_t color_fmt)
+{
+    led_strip_spi_obj *spi_strip = __containerof(strip, led_strip_spi_obj, base);
+    ESP_RETURN_ON_FALSE(start <= spi_strip->strip_len && count <= spi_strip->strip_len - start, ESP_ERR_INVALID_ARG, TAG, "range out of maximum number of LEDs");
+
+    led_color_component_format_t component_fmt = spi_strip->component_fmt;
+    uint8_t bytes_per_pixel = spi_strip->bytes_per_pixel;
+    uint8_t *pixel_buf = spi_strip->pixel_buf + start * bytes_per_pixel * SPI_BYTES_PER_COLOR_BYTE;
+
+    // same layout as the strip: encode the source bytes in order
+    if (color_fmt.format_id == component_fmt.format_id) {
+        for (uint32_t i = 0; i < count * bytes_per_pixel; i++) {
+            __led_strip_spi_bit(colors[i], pixel_buf);
+            pixel_buf += SPI_BYTES_PER_COLOR_BYTE;
+        }
+        return ESP_OK;
+    }
+
+    uint8_t src_stride = color_fmt.format.num_components;
+    uint8_t *r_buf = pixel_buf + SPI_BYTES_PER_COLOR_BYTE * component_fmt.format.r_pos;
+    uint8_t *g_buf = pixel_buf + SPI_BYTES_PER_COLOR_BYTE * component_fmt.format.g_pos;
+    uint8_t *b_buf = pixel_buf + SPI_BYTES_PER_COLOR_BYTE * component_fmt.format.b_pos;
+    uint8_t *w_buf = pixel_buf + SPI_BYTES_PER_COLOR_BYTE * component_fmt.format.w_pos;
+    uint8_t src_r = color_fmt.format.r_pos, src_g = color_fmt.format.g_pos, src_b = color_fmt.format.b_pos, src_w = color_fmt.format.w_pos;
+    uint32_t stride = bytes_per_pixel * SPI_BYTES_PER_COLOR_BYTE;
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t offset = i * stride;
+        __led_strip_spi_bit(colors[src_r], r_buf + offset);
+        __led_strip_spi_bit(colors[src_g], g_buf + offset);
+        __led_strip_spi_bit(colors[src_b], b_buf + offset);
+        if (bytes_per_pixel > 3) {
+            __led_strip_spi_bit(src_stride == 4 ? colors[src_w] : 0, w_buf + offset);
+        }
+        colors += src_stride;
+    }
+
+    return ESP_OK;
+}
+
+static esp_err_t led_strip_spi_fill(led_strip_t *strip, uint32_t start, uint32_t count, uint32_t red, uint32_t green, uint32_t blue, uint32_t white)
+{
+    led_strip_spi_obj *spi_strip = __containerof(strip, led_strip_spi_obj, base);
+    ESP_RETURN_ON_FALSE(start <= spi_strip->strip_len && count <= spi_strip->strip_len - start, ESP_ERR_INVALID_ARG, TAG, "range out of maximum number of LEDs");
+    if (count == 0) {
+        return ESP_OK;
+    }
+
+    led_color_component_format_t component_fmt = spi_strip->component_fmt;
+    uint32_t stride = spi_strip->bytes_per_pixel * SPI_BYTES_PER_COLOR_BYTE;
+    uint8_t *pixel_buf = spi_strip->pixel_buf + start * stride;
+
+    __led_strip_spi_bit(red, &pixel_buf[SPI_BYTES_PER_COLOR_BYTE * component_fmt.format.r_pos]);
+    __led_strip_spi_bit(green, &pixel_buf[SPI_BYTES_PER_COLOR_BYTE * component_fmt.format.g_pos]);
+    __led_strip_spi_bit(blue, &pixel_buf[SPI_BYTES_PER_COLOR_BYTE * component_fmt.format.b_pos]);
+    if (component_fmt.format.num_components > 3) {
+        __led_strip_spi_bit(white, &pixel_buf[SPI_BYTES_PER_COLOR_BYTE * component_fmt.format.w_pos]);
+    }
+    // replicate the first encoded pixel, doubling the copied block each time
+    size_t total = count * stride;
+    for (size_t done = stride; done < total; done *= 2) {
+        memcpy(pixel_buf + done, pixel_buf, done < total - done ? done : total - done);
+    }
+
+    return ESP_OK;
+}
+
+static esp_err_t led_strip_spi_copy_range(led_strip_t *strip, uint32_t dst_index, uint32_t src_index, uint32_t count)
+{
+    led_strip_spi_obj *spi_strip = __containerof(strip, led_strip_spi_obj, base);
+    uint32_t strip_len = spi_strip->strip_len;
+    ESP_RETURN_ON_FALSE(dst_index <= strip_len && count <= strip_len - dst_index &&
+                        src_index <= strip_len && count <= strip_len - src_index, ESP_ERR_INVALID_ARG, TAG, "range out of maximum number of LEDs");
+
+    // pixels are already encoded, move the SPI symbols as they are
+    uint32_t stride = spi_strip->bytes_per_pixel * SPI_BYTES_PER_COLOR_BYTE;
+    memmove(spi_strip->pixel_buf + dst_index * stride, spi_strip->pixel_buf + src_index * stride, count * stride);
+    return ESP_OK;
+}
+
 static esp_err_t led_strip_spi_refresh(led_strip_t *strip)
 {
     led_strip_spi_obj *spi_strip = __containerof(strip, led_strip_spi_obj, base);
@@ -106,7 +198,6 @@ static esp_err_t led_strip_spi_clear(led_strip_t *strip)
 {
     led_strip_spi_obj *spi_strip = __containerof(strip, led_strip_spi_obj, base);
     //Write zero to turn off all leds
-    memset(spi_strip->pixel_buf, 0, spi_strip->strip_len * spi_strip->bytes_per_pixel * SPI_BYTES_PER_COLOR_BYTE);
     uint8_t *buf = spi_strip->pixel_buf;
     for (int index = 0; index < spi_strip->strip_len * spi_strip->bytes_per_pixel; index++) {
         __led_strip_spi_bit(0, buf);
@@ -215,6 +306,9 @@ esp_err_t led_strip_new_spi_device(const led_strip_config_t *led_config, const l
     spi_strip->strip_len = led_config->max_leds;
     spi_strip->base.set_pixel = led_strip_spi_set_pixel;
     spi_strip->base.set_pixel_rgbw = led_strip_spi_set_pixel_rgbw;
+    spi_strip->base.set_pixels = led_strip_spi_set_pixels;
+    spi_strip->base.fill = led_strip_spi_fill;
+    spi_strip->base.copy_range = led_strip_spi_copy_range;
     spi_strip->base.refresh = led_strip_spi_refresh;
     spi_strip->base.clear = led_strip_spi_clear;
     spi_strip->base.del = led_strip_spi_del;
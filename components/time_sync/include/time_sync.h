@@ -0,0 +1,93 @@
+// components/time_sync/include/time_sync.h
+// Relógio de parede sincronizado por referências externas (ex.: celular via
+// BLE), com correção de drift e ajuste gradual. Carimbos de tempo saem do
+// esp_timer e de alguns campos em RAM: sem syscalls nem leitura do RTC.
+#ifndef TIME_SYNC_H
+#define TIME_SYNC_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    // Carimbo de tempo de um evento
+    typedef struct
+    {
+        int64_t mono_us; // Monotônico desde o boot (esp_timer)
+        int64_t wall_us; // Tempo Unix em us (desde o boot se synced == false)
+        bool synced;     // Já houve ao menos uma sincronização
+    } time_sync_stamp_t;
+
+    // Estatísticas da sincronização
+    typedef struct
+    {
+        uint32_t syncs;          // Referências aplicadas
+        uint32_t steps;          // Ajustes de uma vez (settimeofday)
+        uint32_t slews;          // Ajustes graduais (adjtime)
+        int64_t last_offset_us;  // Erro medido na última referência
+        int32_t drift_ppb;       // Drift estimado do oscilador (partes por bilhão)
+        uint32_t since_sync_s;   // Tempo desde a última referência
+        int64_t slew_pending_us; // Correção gradual ainda não aplicada
+        uint32_t drift_rejected; // Estimativas de drift fora do limite (descartadas)
+    } time_sync_stats_t;
+
+    /**
+     * @brief Aplica uma referência de tempo
+     *
+     * Diferenças acima de CONFIG_TIME_SYNC_STEP_THRESHOLD_MS ajustam o relógio
+     * de uma vez; abaixo disso a correção é gradual, sem saltos. Duas
+     * referências atualizam a estimativa de drift quando o intervalo entre
+     * elas é de pelo menos CONFIG_TIME_SYNC_DRIFT_MIN_INTERVAL_S e longo o
+     * bastante para que a resolução delas erre o drift em no máximo
+     * CONFIG_TIME_SYNC_DRIFT_MAX_ERROR_PPM. O relógio do sistema
+     * (gettimeofday) acompanha.
+     *
+     * @param wall_us Tempo Unix da referência em us
+     * @param resolution_us Resolução da referência (1000000 para segundos
+     *        inteiros, 1000 com milissegundos)
+     * @return ESP_OK se aplicada, ESP_ERR_INVALID_ARG se negativa
+     */
+    esp_err_t time_sync_set(int64_t wall_us, uint32_t resolution_us);
+
+    /**
+     * @brief Tempo de parede atual (us), corrigido de drift e ajuste gradual
+     *
+     * Pode ser chamada de qualquer tarefa; custo de uma leitura do
+     * esp_timer e algumas operações inteiras.
+     */
+    int64_t time_sync_wall_us(void);
+
+    /**
+     * @brief Preenche o carimbo monotônico + parede do instante atual
+     */
+    void time_sync_stamp(time_sync_stamp_t *stamp);
+
+    /**
+     * @brief Converte um instante monotônico passado em tempo de parede
+     *
+     * Útil para carimbar eventos registrados com esp_timer_get_time().
+     */
+    int64_t time_sync_mono_to_wall(int64_t mono_us);
+
+    /**
+     * @brief Indica se já houve ao menos uma sincronização
+     */
+    bool time_sync_is_synced(void);
+
+    /**
+     * @brief Lê as estatísticas da sincronização
+     *
+     * @param stats Estrutura preenchida
+     * @return ESP_OK se sucesso
+     */
+    esp_err_t time_sync_get_stats(time_sync_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,238 @@
+// components/time_sync/src/time_sync.c
+// Modelo do relógio: wall(t) = base_wall + dt + drift(dt) + slew(dt), com
+// dt = t - base_mono. Cada referência rebaseia o modelo no valor previsto
+// (sem salto) e agenda o erro como correção gradual; o drift é estimado
+// comparando o tempo real decorrido entre duas referências com o do esp_timer,
+// só quando o intervalo é longo o bastante para a resolução delas.
+#include "time_sync.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include <sys/time.h>
+
+static const char *TAG = "TIME_SYNC";
+
+#define STEP_THRESHOLD_US ((int64_t)CONFIG_TIME_SYNC_STEP_THRESHOLD_MS * 1000)
+#define DRIFT_MIN_INTERVAL_US ((int64_t)CONFIG_TIME_SYNC_DRIFT_MIN_INTERVAL_S * 1000000)
+#define DRIFT_MAX_PPB ((int32_t)CONFIG_TIME_SYNC_DRIFT_MAX_PPM * 1000)
+#define DRIFT_MAX_ERROR_PPM CONFIG_TIME_SYNC_DRIFT_MAX_ERROR_PPM
+
+typedef struct
+{
+    bool synced;
+    int64_t base_mono;
+    int64_t base_wall;
+    int32_t drift_ppb;
+    int64_t slew_us; // Correção gradual a partir de base_mono (com sinal)
+} clock_model_t;
+
+// Modelo lido por qualquer tarefa; campos de 64 bits exigem o lock
+static clock_model_t model;
+static portMUX_TYPE model_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// Estado de sincronização: apenas em time_sync_set()/get_stats()
+static int64_t drift_ref_mono; // Referência usada na última estimativa de drift
+static int64_t drift_ref_wall;
+static uint32_t drift_ref_res_us;
+static bool drift_estimated;
+static int64_t last_sync_mono;
+static time_sync_stats_t stats;
+
+// dt * ppb / 1e9 sem estourar 64 bits em intervalos longos
+static int64_t scale_ppb(int64_t dt, int32_t ppb)
+{
+    return (dt / 1000000) * ppb / 1000 + (dt % 1000000) * ppb / 1000000000;
+}
+
+static int64_t slew_applied(const clock_model_t *m, int64_t dt)
+{
+    if (dt <= 0 || m->slew_us == 0)
+    {
+        return 0;
+    }
+
+    int64_t max = dt * CONFIG_TIME_SYNC_SLEW_PPM / 1000000;
+    if (m->slew_us > 0)
+        return m->slew_us < max ? m->slew_us : max;
+    return -m->slew_us < max ? m->slew_us : -max;
+}
+
+static int64_t model_wall(const clock_model_t *m, int64_t mono)
+{
+    int64_t dt = mono - m->base_mono;
+
+    return m->base_wall + dt + scale_ppb(dt, m->drift_ppb) + slew_applied(m, dt);
+}
+
+static void model_copy(clock_model_t *out)
+{
+    portENTER_CRITICAL(&model_lock);
+    *out = model;
+    portEXIT_CRITICAL(&model_lock);
+}
+
+// Relógio do sistema acompanha o modelo (fora do lock: são syscalls)
+static void system_clock_step(int64_t wall_us)
+{
+    struct timeval tv = {
+        .tv_sec = wall_us / 1000000,
+        .tv_usec = wall_us % 1000000,
+    };
+    settimeofday(&tv, NULL);
+}
+
+static bool system_clock_slew(int64_t delta_us)
+{
+    struct timeval delta = {
+        .tv_sec = delta_us / 1000000,
+        .tv_usec = delta_us % 1000000,
+    };
+    return adjtime(&delta, NULL) == 0;
+}
+
+// ===== API Pública =====
+
+// Intervalo em que a resolução das duas referências erra o drift em no
+// máximo DRIFT_MAX_ERROR_PPM (1 s + 1 s a 5 ppm: 400000 s; 1 ms + 1 ms: 400 s)
+static int64_t drift_interval_for(uint32_t res_a_us, uint32_t res_b_us)
+{
+    int64_t interval = ((int64_t)res_a_us + res_b_us) * 1000000 / DRIFT_MAX_ERROR_PPM;
+
+    return interval > DRIFT_MIN_INTERVAL_US ? interval : DRIFT_MIN_INTERVAL_US;
+}
+
+static void drift_rebase(int64_t mono, int64_t wall_us, uint32_t resolution_us)
+{
+    drift_ref_mono = mono;
+    drift_ref_wall = wall_us;
+    drift_ref_res_us = resolution_us;
+}
+
+esp_err_t time_sync_set(int64_t wall_us, uint32_t resolution_us)
+{
+    clock_model_t m;
+    int64_t now = esp_timer_get_time();
+
+    if (wall_us < 0)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    model_copy(&m);
+    int64_t predicted = model_wall(&m, now);
+    int64_t error = wall_us - predicted;
+    bool step = !m.synced || error > STEP_THRESHOLD_US || error < -STEP_THRESHOLD_US;
+
+    // Drift: tempo real decorrido contra o do esp_timer, independente das
+    // correções aplicadas no meio. Um salto indica referência anterior ruim
+    // (ou relógio acertado à mão) e não entra na estimativa.
+    int64_t interval = now - drift_ref_mono;
+    if (!step && interval >= drift_interval_for(drift_ref_res_us, resolution_us))
+    {
+        int64_t real = wall_us - drift_ref_wall;
+        int64_t ppb = (real - interval) * 1000 / (interval / 1000000);
+
+        // Fora do limite uma das referências é ruim: descarta e recomeça daqui
+        if (ppb > DRIFT_MAX_PPB || ppb < -DRIFT_MAX_PPB)
+        {
+            ESP_LOGW(TAG, "Estimativa de drift descartada: %lld ppb", ppb);
+            stats.drift_rejected++;
+        }
+        else
+        {
+            // Primeira estimativa direto; depois média com a anterior
+            m.drift_ppb = (int32_t)(drift_estimated ? (m.drift_ppb + ppb) / 2 : ppb);
+            drift_estimated = true;
+        }
+        drift_rebase(now, wall_us, resolution_us);
+    }
+    else if (!step && resolution_us < drift_ref_res_us)
+    {
+        // Referência mais fina: a estimativa sai dela bem mais cedo
+        drift_rebase(now, wall_us, resolution_us);
+    }
+
+    if (step)
+    {
+        m.base_wall = wall_us;
+        m.slew_us = 0;
+        m.synced = true;
+        drift_rebase(now, wall_us, resolution_us);
+    }
+    else
+    {
+        // Continua do valor previsto e absorve o erro aos poucos
+        m.base_wall = predicted;
+        m.slew_us = error;
+    }
+    m.base_mono = now;
+
+    portENTER_CRITICAL(&model_lock);
+    model = m;
+    portEXIT_CRITICAL(&model_lock);
+
+    if (step || !system_clock_slew(error))
+    {
+        system_clock_step(wall_us);
+        stats.steps++;
+    }
+    else
+    {
+        stats.slews++;
+    }
+
+    stats.syncs++;
+    stats.last_offset_us = error;
+    last_sync_mono = now;
+
+    ESP_LOGI(TAG, "Referência aplicada: erro=%lld us, %s, drift=%ld ppb",
+             error, step ? "ajuste direto" : "ajuste gradual", (long)m.drift_ppb);
+    return ESP_OK;
+}
+
+int64_t time_sync_wall_us(void)
+{
+    return time_sync_mono_to_wall(esp_timer_get_time());
+}
+
+void time_sync_stamp(time_sync_stamp_t *stamp)
+{
+    clock_model_t m;
+
+    stamp->mono_us = esp_timer_get_time();
+    model_copy(&m);
+    stamp->wall_us = model_wall(&m, stamp->mono_us);
+    stamp->synced = m.synced;
+}
+
+int64_t time_sync_mono_to_wall(int64_t mono_us)
+{
+    clock_model_t m;
+
+    model_copy(&m);
+    return model_wall(&m, mono_us);
+}
+
+bool time_sync_is_synced(void)
+{
+    return model.synced;
+}
+
+esp_err_t time_sync_get_stats(time_sync_stats_t *out)
+{
+    clock_model_t m;
+
+    if (out == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    int64_t now = esp_timer_get_time();
+    model_copy(&m);
+
+    *out = stats;
+    out->drift_ppb = m.drift_ppb;
+    out->since_sync_s = m.synced ? (uint32_t)((now - last_sync_mono) / 1000000) : 0;
+    out->slew_pending_us = m.slew_us - slew_applied(&m, now - m.base_mono);
+    return ESP_OK;
+}
@@ -1,54 +1,305 @@
 #include <stdio.h>
+#include <string.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "esp_log.h"
 #include "esp_chip_info.h"
 #include "esp_flash.h"
 #include "ble_server.h"
+#include "ble_cmd_proto.h"
+#include "host/ble_gatt.h"
+#include "audit_journal.h"
 #include "status_led.h"
 
 static const char *TAG = "APP_MAIN";
 int contador = 0;
 int contador2 = 0;
 
-// Callback: Dados recebidos via Write
-void on_ble_write(uint8_t *data, uint16_t len)
+// ===== Ações da fechadura =====
+static uint8_t lock_state = 0; // 0 = Travado, 1 = Destravado
+
+// Eventos do journal de auditoria
+#define AUDIT_EVT_UNLOCK 0x01 // value = contador de operações
+#define AUDIT_EVT_LOCK 0x02
+
+// Publica o registro lido pela characteristic Status
+static void lock_publish_status(void)
 {
-    ESP_LOGI(TAG, "Comando recebido: %.*s", len, data);
+    ble_server_status_t status = {
+        .state = lock_state,
+        .op_count = contador2,
+    };
+    ble_server_set_status(&status);
+}
 
-    if (strncmp((char *)data, "UNLOCK", 6) == 0)
-    {
-        contador2++;
-        ESP_LOGI(TAG, "🔓 Destravando fechadura... Contador: %d", contador2);
-        status_led_set_color(LED_COLOR_GREEN); // Simples assim!
+static void lock_unlock(void)
+{
+    contador2++;
+    ESP_LOGI(TAG, "🔓 Destravando fechadura... Contador: %d", contador2);
+    status_led_set_color(LED_COLOR_GREEN); // Simples assim!
+
+    // Simula destrave
+    vTaskDelay(pdMS_TO_TICKS(500));
+
+    // Atualiza status
+    lock_state = 1;
+    lock_publish_status();
+    audit_journal_append(AUDIT_EVT_UNLOCK, (uint16_t)contador2);
+}
+
+static void lock_lock(void)
+{
+    ESP_LOGI(TAG, "🔒 Travando fechadura...");
+    status_led_set_color(LED_COLOR_RED);
+
+    lock_state = 0;
+    lock_publish_status();
+    audit_journal_append(AUDIT_EVT_LOCK, (uint16_t)contador2);
+}
+
+// ===== Protocolo binário (opcode, seq, len, payload) =====
+#define CMD_OP_UNLOCK 0x01
+#define CMD_OP_LOCK 0x02
+#define CMD_OP_GET_STATUS 0x03
+
+static ble_cmd_status_t cmd_unlock(const ble_cmd_frame_t *req, ble_cmd_resp_t *resp, void *arg)
+{
+    lock_unlock();
+    resp->payload[0] = lock_state;
+    resp->len = 1;
+    return BLE_CMD_STATUS_OK;
+}
+
+static ble_cmd_status_t cmd_lock(const ble_cmd_frame_t *req, ble_cmd_resp_t *resp, void *arg)
+{
+    lock_lock();
+    resp->payload[0] = lock_state;
+    resp->len = 1;
+    return BLE_CMD_STATUS_OK;
+}
+
+static ble_cmd_status_t cmd_get_status(const ble_cmd_frame_t *req, ble_cmd_resp_t *resp, void *arg)
+{
+    resp->payload[0] = lock_state;
+    resp->len = 1;
+    return BLE_CMD_STATUS_OK;
+}
+
+static const ble_cmd_def_t cmd_defs[] = {
+    {.opcode = CMD_OP_UNLOCK, .min_len = 0, .max_len = 0, .handler = cmd_unlock},
+    {.opcode = CMD_OP_LOCK, .min_len = 0, .max_len = 0, .handler = cmd_lock},
+    {.opcode = CMD_OP_GET_STATUS, .min_len = 0, .max_len = 0, .handler = cmd_get_status},
+};
 
-        // Simula destrave
-        vTaskDelay(pdMS_TO_TICKS(500));
+static ble_cmd_table_t cmd_table;
 
-        // Atualiza status
-        ble_server_update_read_value(1); // 1 = Destravado
+// Resposta do comando: só para a conexão que o enviou
+static void cmd_reply(const uint8_t *data, uint16_t len)
+{
+    ble_server_notify_enqueue(ble_server_cmd_conn_handle(), data, len, NULL, NULL);
+}
 
-        // uint8_t status[] = "LOCKED_NOW";
-        // ble_server_notify(status, sizeof(status));
-        // contador2 = 0;
-        // return;
+// Legado: comandos ASCII, comparados pelo tamanho exato
+static void on_ascii_command(const uint8_t *data, uint16_t len)
+{
+    ESP_LOGI(TAG, "Comando recebido: %.*s", len, data);
+
+    if (len == 6 && memcmp(data, "UNLOCK", 6) == 0)
+    {
+        lock_unlock();
 
         // Envia notificação
         uint8_t status[] = "UNLOCKED";
-        ble_server_notify(status, sizeof(status));
+        cmd_reply(status, sizeof(status));
     }
-    else if (strncmp((char *)data, "LOCK", 4) == 0)
+    else if (len == 4 && memcmp(data, "LOCK", 4) == 0)
     {
-        ESP_LOGI(TAG, "🔒 Travando fechadura...");
-        status_led_set_color(LED_COLOR_RED);
-
-        ble_server_update_read_value(0); // 0 = Travado
+        lock_lock();
 
         uint8_t status[] = "LOCKED";
-        ble_server_notify(status, sizeof(status));
+        cmd_reply(status, sizeof(status));
+    }
+    else
+    {
+        ESP_LOGW(TAG, "Comando desconhecido (%d bytes)", len);
+    }
+}
+
+// Callback: Dados recebidos via Write (executado na tarefa de comandos)
+void on_ble_write(uint8_t *data, uint16_t len)
+{
+    ble_cmd_frame_t frame;
+    uint8_t resp[BLE_CMD_RESP_MAX_LEN];
+    size_t resp_len;
+
+    // Um frame binário válido nunca é todo imprimível (len caberia só em
+    // writes de 8 KB), então texto vai direto para os comandos legados
+    if (ble_cmd_is_text(data, len))
+    {
+        on_ascii_command(data, len);
+        return;
+    }
+
+    if (ble_cmd_frame_parse(data, len, &frame) == BLE_CMD_STATUS_OK)
+    {
+        resp_len = ble_cmd_dispatch(&cmd_table, &frame, resp, sizeof(resp));
+        ESP_LOGI(TAG, "Comando binário: op=0x%02x seq=%d status=%d",
+                 frame.opcode, frame.seq, resp[2]);
+    }
+    else
+    {
+        // Malformado: o cliente recebe o erro em vez de silêncio
+        resp_len = ble_cmd_resp_bad_frame(data, len, resp, sizeof(resp));
+        ESP_LOGW(TAG, "Frame binário inválido (%d bytes)", len);
+    }
+
+    cmd_reply(resp, resp_len);
+}
+
+// ===== Characteristic Audit (leitura do journal) =====
+// Write: [seq inicial (LE, 4 bytes)], 0 = mais antigo
+// Read: próximos registros de 16 bytes que cabem no MTU (vazio = fim); cada
+// conexão tem o próprio cursor
+static const ble_uuid128_t audit_chr_uuid =
+    BLE_UUID128_INIT(
+        0x23, 0xd1, 0xbc, 0xea, 0x5f, 0x78, 0x23, 0x15,
+        0xde, 0xef, 0x12, 0x12, 0x30, 0x15, 0x00, 0x00);
+
+#define AUDIT_READ_RECORDS 4                     // Registros por pedaço copiado para o mbuf
+#define AUDIT_READ_LONG_TICKS pdMS_TO_TICKS(3000) // Read Blob atrasado além disso é nova leitura
+
+// Leitura do journal por conexão. Uma resposta cheia (MTU - 1 bytes) faz o
+// cliente pedir Read Blob, e o NimBLE chama o handler de novo recortando o
+// valor pelo offset: esse pedido repete o último pedaço (um registro não
+// muda depois de acrescentado) em vez de avançar o cursor.
+typedef struct
+{
+    bool used;
+    bool blob_pending; // Último pedaço veio cheio: a próxima leitura é o Read Blob
+    uint16_t conn_handle;
+    TickType_t taken_at;
+    audit_journal_cursor_t cursor;     // Próxima leitura
+    audit_journal_cursor_t chunk_from; // Início do último pedaço
+} audit_reader_t;
+
+// Apenas na task do host (acessos GATT e on_ble_disconnect)
+static audit_reader_t audit_readers[CONFIG_BT_NIMBLE_MAX_CONNECTIONS];
+
+static audit_reader_t *audit_reader(uint16_t conn_handle)
+{
+    audit_reader_t *free_slot = NULL;
+
+    for (int i = 0; i < CONFIG_BT_NIMBLE_MAX_CONNECTIONS; i++)
+    {
+        if (audit_readers[i].used && audit_readers[i].conn_handle == conn_handle)
+        {
+            return &audit_readers[i];
+        }
+        if (!audit_readers[i].used && free_slot == NULL)
+        {
+            free_slot = &audit_readers[i];
+        }
+    }
+
+    if (free_slot != NULL)
+    {
+        memset(free_slot, 0, sizeof(*free_slot));
+        free_slot->used = true;
+        free_slot->conn_handle = conn_handle;
+    }
+    return free_slot;
+}
+
+static void audit_reader_release(uint16_t conn_handle)
+{
+    for (int i = 0; i < CONFIG_BT_NIMBLE_MAX_CONNECTIONS; i++)
+    {
+        if (audit_readers[i].used && audit_readers[i].conn_handle == conn_handle)
+        {
+            audit_readers[i].used = false;
+        }
+    }
+}
+
+static int audit_on_read(uint16_t conn_handle, struct os_mbuf *om, void *arg)
+{
+    audit_reader_t *rd = audit_reader(conn_handle);
+    ble_server_conn_info_t info;
+    uint8_t piece[AUDIT_READ_RECORDS * AUDIT_JOURNAL_RECORD_LEN];
+    size_t cap = 20;
+    size_t len = 0;
+
+    if (rd == NULL)
+    {
+        return BLE_ATT_ERR_INSUFFICIENT_RES;
+    }
+
+    // Resposta de leitura carrega MTU - 1 bytes
+    if (ble_server_get_conn_info(conn_handle, &info) == ESP_OK && info.mtu > 1)
+    {
+        cap = info.mtu - 1;
+    }
+
+    TickType_t now = xTaskGetTickCount();
+    bool blob = rd->blob_pending && now - rd->taken_at < AUDIT_READ_LONG_TICKS;
+    if (blob)
+    {
+        rd->cursor = rd->chunk_from;
+    }
+    rd->chunk_from = rd->cursor;
+    rd->taken_at = now;
+
+    // Em pedaços pequenos: a pilha da task do host não comporta um MTU inteiro
+    while (cap - len >= AUDIT_JOURNAL_RECORD_LEN)
+    {
+        size_t want = cap - len < sizeof(piece) ? cap - len : sizeof(piece);
+        size_t n = audit_journal_read_chunk(&rd->cursor, piece, want);
+
+        if (n > 0 && os_mbuf_append(om, piece, n) != 0)
+        {
+            return BLE_ATT_ERR_INSUFFICIENT_RES;
+        }
+        len += n;
+        if (n < want - want % AUDIT_JOURNAL_RECORD_LEN)
+        {
+            break;
+        }
+    }
+
+    // O valor nunca passa de MTU - 1: só o pedaço novo e cheio tem Read Blob
+    rd->blob_pending = !blob && len == cap;
+    return 0;
+}
+
+static int audit_on_write(uint16_t conn_handle, const ble_mbuf_view_t *view, void *arg)
+{
+    audit_reader_t *rd = audit_reader(conn_handle);
+    uint32_t from_seq;
+
+    if (view->len != sizeof(from_seq) || !ble_mbuf_view_get_u32le(view, 0, &from_seq))
+    {
+        return BLE_ATT_ERR_INVALID_ATTR_VALUE_LEN;
+    }
+    if (rd == NULL)
+    {
+        return BLE_ATT_ERR_INSUFFICIENT_RES;
     }
+
+    // A leitura já entrega os registros ainda na RAM; a gravação fica com a
+    // tarefa do journal, fora da task do host
+    audit_journal_request_flush();
+    audit_journal_cursor_init(&rd->cursor, from_seq);
+    rd->blob_pending = false;
+    return 0;
 }
 
+static const ble_server_chr_def_t audit_chr = {
+    .uuid = &audit_chr_uuid.u,
+    .flags = BLE_GATT_CHR_F_READ | BLE_GATT_CHR_F_WRITE,
+    .on_read = audit_on_read,
+    .on_write = audit_on_write,
+};
+
 // Callback: Cliente conectou
 void on_ble_connect(uint16_t conn_handle)
 {
@@ -57,10 +308,17 @@ void on_ble_connect(uint16_t conn_handle)
 }
 
 // Callback: Cliente desconectou
-void on_ble_disconnect(void)
+void on_ble_disconnect(uint16_t conn_handle)
 {
-    ESP_LOGI(TAG, "📴 Cliente desconectado");
-    status_led_set_color(LED_COLOR_PURPLE);
+    ESP_LOGI(TAG, "📴 Cliente desconectado: handle=%d", conn_handle);
+    audit_reader_release(conn_handle);
+
+    // Outros clientes podem continuar conectados
+    ble_server_conn_info_t conns[CONFIG_BT_NIMBLE_MAX_CONNECTIONS];
+    if (ble_server_get_conns(conns, CONFIG_BT_NIMBLE_MAX_CONNECTIONS) == 0)
+    {
+        status_led_set_color(LED_COLOR_PURPLE);
+    }
 }
 
 void app_main(void)
@@ -97,8 +355,23 @@ void app_main(void)
         .on_write = on_ble_write,
         .on_connect = on_ble_connect,
         .on_disconnect = on_ble_disconnect,
+        .async_commands = true, // on_write roda fora da task do host NimBLE
+        .conn_policy = BLE_SERVER_CONN_POLICY_FAST_THEN_IDLE,
     };
 
+    // Tabela de despacho dos opcodes binários
+    if (ble_cmd_table_init(&cmd_table, cmd_defs, sizeof(cmd_defs) / sizeof(cmd_defs[0]), NULL) != 0)
+    {
+        ESP_LOGE(TAG, "Tabela de comandos inválida");
+        return;
+    }
+
+    // Journal de auditoria (partição "audit"); sem ele a fechadura segue funcionando
+    if (audit_journal_init() == ESP_OK)
+    {
+        ESP_ERROR_CHECK(ble_server_register_chr(&audit_chr));
+    }
+
     // Inicializa servidor
     ESP_ERROR_CHECK(ble_server_init(&config));
 
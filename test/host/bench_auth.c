@@ -0,0 +1,257 @@
+// test/host/bench_auth.c
+// Verificação dos comandos autenticados (ble_auth.c) no host. Confere os
+// estados ipad/opad pré-processados contra o RFC 4231 e a tag de
+// ble_auth_sign() contra um HMAC completo, depois mede a verificação com a
+// chave pré-processada contra o HMAC com key schedule a cada comando (o que
+// ble_auth_key_init() evita). O SHA-256 é o portável do simulador, não o
+// acelerador do ESP32: os números servem para comparar os dois caminhos.
+//   bench_auth [--quick]
+#include "ble_auth.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define SHA256_BLOCK_LEN 64
+#define SHA256_LEN 32
+
+static int failures;
+
+#define CHECK(cond)                                                    \
+    do                                                                 \
+    {                                                                  \
+        if (!(cond))                                                   \
+        {                                                              \
+            printf("FALHA %s:%d: %s\n", __FILE__, __LINE__, #cond);    \
+            failures++;                                                \
+        }                                                              \
+    } while (0)
+
+static volatile uint32_t sink;
+
+static int64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+// HMAC-SHA256 completo: key schedule (blocos ipad/opad) a cada chamada
+static void hmac_full(const uint8_t *key, size_t key_len, const uint8_t *a, size_t a_len,
+                      const uint8_t *b, size_t b_len, uint8_t out[SHA256_LEN])
+{
+    mbedtls_sha256_context sha;
+    uint8_t pad[SHA256_BLOCK_LEN];
+    uint8_t inner[SHA256_LEN];
+
+    mbedtls_sha256_init(&sha);
+    memset(pad, 0x36, sizeof(pad));
+    for (size_t i = 0; i < key_len; i++)
+        pad[i] ^= key[i];
+    mbedtls_sha256_starts(&sha, 0);
+    mbedtls_sha256_update(&sha, pad, sizeof(pad));
+    mbedtls_sha256_update(&sha, a, a_len);
+    mbedtls_sha256_update(&sha, b, b_len);
+    mbedtls_sha256_finish(&sha, inner);
+
+    memset(pad, 0x5c, sizeof(pad));
+    for (size_t i = 0; i < key_len; i++)
+        pad[i] ^= key[i];
+    mbedtls_sha256_starts(&sha, 0);
+    mbedtls_sha256_update(&sha, pad, sizeof(pad));
+    mbedtls_sha256_update(&sha, inner, sizeof(inner));
+    mbedtls_sha256_finish(&sha, out);
+    mbedtls_sha256_free(&sha);
+}
+
+// HMAC-SHA256 a partir dos estados pré-processados de ble_auth_key_t
+static void hmac_precomputed(const ble_auth_key_t *key, const uint8_t *data, size_t len, uint8_t out[SHA256_LEN])
+{
+    mbedtls_sha256_context sha;
+    uint8_t inner[SHA256_LEN];
+
+    mbedtls_sha256_init(&sha);
+    mbedtls_sha256_clone(&sha, &key->inner);
+    mbedtls_sha256_update(&sha, data, len);
+    mbedtls_sha256_finish(&sha, inner);
+    mbedtls_sha256_clone(&sha, &key->outer);
+    mbedtls_sha256_update(&sha, inner, sizeof(inner));
+    mbedtls_sha256_finish(&sha, out);
+    mbedtls_sha256_free(&sha);
+}
+
+static void hex_decode(const char *hex, uint8_t *out)
+{
+    for (size_t i = 0; hex[2 * i]; i++)
+    {
+        unsigned v;
+        sscanf(&hex[2 * i], "%2x", &v);
+        out[i] = (uint8_t)v;
+    }
+}
+
+// RFC 4231, casos 1 a 4 (chaves de até um bloco, como BLE_AUTH_KEY_MAX_LEN)
+static void test_rfc4231(void)
+{
+    static const struct
+    {
+        uint8_t key_byte; // 0 = chave 0x01..0x19 (caso 4)
+        size_t key_len;
+        const char *data; // NULL = data_byte repetido 50 vezes
+        uint8_t data_byte;
+        const char *mac;
+    } vectors[] = {
+        {0x0b, 20, "Hi There", 0, "b0344c61d8db38535ca8afceaf0bf12b881dc200c9833da726e9376c2e32cff7"},
+        {0, 4, "what do ya want for nothing?", 0,
+         "5bdcc146bf60754e6a042426089575c75a003f089d2739839dec58b964ec3843"},
+        {0xaa, 20, NULL, 0xdd, "773ea91e36800e46854db8ebd09181a72959098b3ef8c122d9635514ced565fe"},
+        {0, 25, NULL, 0xcd, "82558a389a443c0ea4cc819899f2083a85f0faa3e578f8077a2e3ff46729665b"},
+    };
+
+    for (size_t v = 0; v < sizeof(vectors) / sizeof(vectors[0]); v++)
+    {
+        uint8_t key_bytes[32];
+        uint8_t data[50];
+        size_t data_len;
+        uint8_t expected[SHA256_LEN];
+        uint8_t mac[SHA256_LEN];
+        ble_auth_key_t key;
+
+        if (v == 1)
+            memcpy(key_bytes, "Jefe", 4);
+        else
+            for (size_t i = 0; i < vectors[v].key_len; i++)
+                key_bytes[i] = vectors[v].key_byte ? vectors[v].key_byte : (uint8_t)(i + 1);
+
+        if (vectors[v].data)
+        {
+            data_len = strlen(vectors[v].data);
+            memcpy(data, vectors[v].data, data_len);
+        }
+        else
+        {
+            data_len = sizeof(data);
+            memset(data, vectors[v].data_byte, data_len);
+        }
+        hex_decode(vectors[v].mac, expected);
+
+        CHECK(ble_auth_key_init(&key, key_bytes, vectors[v].key_len) == 0);
+        hmac_precomputed(&key, data, data_len, mac);
+        CHECK(memcmp(mac, expected, sizeof(mac)) == 0);
+        hmac_full(key_bytes, vectors[v].key_len, data, data_len, NULL, 0, mac);
+        CHECK(memcmp(mac, expected, sizeof(mac)) == 0);
+        ble_auth_key_free(&key);
+    }
+}
+
+// Tag de ble_auth_sign() = HMAC(chave, nonce || cabeçalho || comando) truncado
+static void test_sign_verify(void)
+{
+    static const uint8_t secret[32] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16};
+    static const uint8_t cmd[] = {0x01, 0x07, 0x00, 0x00};
+    uint8_t nonce[BLE_AUTH_NONCE_LEN];
+    uint8_t msg[64];
+    uint8_t mac[SHA256_LEN];
+    ble_auth_key_t key;
+    ble_auth_session_t session;
+
+    for (int i = 0; i < BLE_AUTH_NONCE_LEN; i++)
+        nonce[i] = (uint8_t)(0xf0 - i);
+    CHECK(ble_auth_key_init(&key, secret, sizeof(secret)) == 0);
+    ble_auth_session_start(&session, nonce);
+
+    size_t len = ble_auth_sign(&key, &session, 2, 1, cmd, sizeof(cmd), msg, sizeof(msg));
+    CHECK(len == sizeof(cmd) + BLE_AUTH_OVERHEAD);
+    hmac_full(secret, sizeof(secret), nonce, sizeof(nonce), msg, len - BLE_AUTH_TAG_LEN, mac);
+    CHECK(memcmp(mac, &msg[len - BLE_AUTH_TAG_LEN], BLE_AUTH_TAG_LEN) == 0);
+
+    CHECK(ble_auth_verify(&session, &key, msg, len) == BLE_AUTH_OK);
+    CHECK(ble_auth_verify(&session, &key, msg, len) == BLE_AUTH_ERR_REPLAY);
+    msg[len - 1] ^= 1;
+    session.last_counter = 0;
+    CHECK(ble_auth_verify(&session, &key, msg, len) == BLE_AUTH_ERR_TAG);
+    ble_auth_key_free(&key);
+}
+
+static void report(const char *name, size_t cmd_len, int ops, int64_t ns)
+{
+    printf("%-26s %3zu B %8.0f ns/cmd %10.0f cmd/s\n", name, cmd_len, (double)ns / ops,
+           (double)ops * 1e9 / ns);
+}
+
+static void bench(int iters)
+{
+    static const size_t sizes[] = {4, 20, 64};
+    static const uint8_t secret[32] = {0x42};
+    uint8_t nonce[BLE_AUTH_NONCE_LEN] = {0};
+    uint8_t cmd[64];
+    uint8_t msg[64 + BLE_AUTH_OVERHEAD];
+    uint8_t mac[SHA256_LEN];
+    ble_auth_key_t key;
+    ble_auth_session_t session;
+
+    memset(cmd, 0x5a, sizeof(cmd));
+    ble_auth_key_init(&key, secret, sizeof(secret));
+    ble_auth_session_start(&session, nonce);
+
+    int64_t t0 = now_ns();
+    for (int i = 0; i < iters; i++)
+    {
+        ble_auth_key_t k;
+        ble_auth_key_init(&k, secret, sizeof(secret));
+        sink += k.inner.state[0];
+        ble_auth_key_free(&k);
+    }
+    printf("ble_auth_key_init: %.0f ns (uma vez por chave)\n", (double)(now_ns() - t0) / iters);
+
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++)
+    {
+        size_t len = ble_auth_sign(&key, &session, 0, 1, cmd, sizes[s], msg, sizeof(msg));
+
+        t0 = now_ns();
+        for (int i = 0; i < iters; i++)
+        {
+            session.last_counter = 0;
+            if (ble_auth_verify(&session, &key, msg, len) != BLE_AUTH_OK)
+            {
+                failures++;
+                return;
+            }
+        }
+        int64_t precomputed = now_ns() - t0;
+
+        t0 = now_ns();
+        for (int i = 0; i < iters; i++)
+        {
+            hmac_full(secret, sizeof(secret), nonce, sizeof(nonce), msg, len - BLE_AUTH_TAG_LEN, mac);
+            sink += ble_auth_tag_equal(mac, &msg[len - BLE_AUTH_TAG_LEN]);
+        }
+        int64_t full = now_ns() - t0;
+
+        report("verify (chave pronta)", sizes[s], iters, precomputed);
+        report("HMAC (key schedule)", sizes[s], iters, full);
+        printf("  ganho: %.2fx\n", (double)full / precomputed);
+    }
+    ble_auth_key_free(&key);
+}
+
+int main(int argc, char **argv)
+{
+    bool quick = argc > 1 && strcmp(argv[1], "--quick") == 0;
+
+    test_rfc4231();
+    test_sign_verify();
+    if (failures)
+    {
+        printf("%d falhas\n", failures);
+        return EXIT_FAILURE;
+    }
+
+    bench(quick ? 2000 : 200000);
+    if (failures)
+    {
+        printf("verificação falhou durante o benchmark\n");
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,203 @@
+// test/host/bench_cmd_proto.c
+// Comandos/s do protocolo binário (ble_cmd_proto.c) no host: parse,
+// despacho com a tabela da aplicação e a decodificação completa do
+// on_ble_write() (texto legado, frame válido, opcode desconhecido e
+// malformado misturados). Sem log nem notificação: mede só o protocolo.
+//   bench_cmd_proto [--quick]
+#include "ble_cmd_proto.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static volatile uint32_t sink;
+static uint8_t lock_state;
+
+static ble_cmd_status_t cmd_unlock(const ble_cmd_frame_t *req, ble_cmd_resp_t *resp, void *arg)
+{
+    lock_state = 1;
+    resp->payload[0] = lock_state;
+    resp->len = 1;
+    return BLE_CMD_STATUS_OK;
+}
+
+static ble_cmd_status_t cmd_lock(const ble_cmd_frame_t *req, ble_cmd_resp_t *resp, void *arg)
+{
+    lock_state = 0;
+    resp->payload[0] = lock_state;
+    resp->len = 1;
+    return BLE_CMD_STATUS_OK;
+}
+
+static ble_cmd_status_t cmd_get_status(const ble_cmd_frame_t *req, ble_cmd_resp_t *resp, void *arg)
+{
+    resp->payload[0] = lock_state;
+    resp->len = 1;
+    return BLE_CMD_STATUS_OK;
+}
+
+// Mesma tabela do src/main.c
+static const ble_cmd_def_t cmd_defs[] = {
+    {.opcode = 0x01, .min_len = 0, .max_len = 0, .handler = cmd_unlock},
+    {.opcode = 0x02, .min_len = 0, .max_len = 0, .handler = cmd_lock},
+    {.opcode = 0x03, .min_len = 0, .max_len = 0, .handler = cmd_get_status},
+};
+
+static ble_cmd_table_t cmd_table;
+
+typedef struct
+{
+    const uint8_t *data;
+    uint16_t len;
+} input_t;
+
+static const uint8_t in_unlock[] = {0x01, 0x01, 0x00, 0x00};
+static const uint8_t in_lock[] = {0x02, 0x02, 0x00, 0x00};
+static const uint8_t in_status[] = {0x03, 0x03, 0x00, 0x00};
+static const uint8_t in_unknown[] = {0x42, 0x04, 0x00, 0x00};
+static const uint8_t in_bad_len[] = {0x01, 0x05, 0x02, 0x00, 0xaa, 0xbb};
+static const uint8_t in_mismatch[] = {0x01, 0x06, 0x08, 0x00, 0xaa};
+static const uint8_t in_text_unlock[] = "UNLOCK";
+static const uint8_t in_text_lock[] = "LOCK";
+
+// Mistura de tráfego: maioria de comandos válidos
+static const input_t mix[] = {
+    {in_unlock, sizeof(in_unlock)},
+    {in_status, sizeof(in_status)},
+    {in_lock, sizeof(in_lock)},
+    {in_status, sizeof(in_status)},
+    {in_text_unlock, 6},
+    {in_unknown, sizeof(in_unknown)},
+    {in_text_lock, 4},
+    {in_bad_len, sizeof(in_bad_len)},
+    {in_mismatch, sizeof(in_mismatch)},
+    {in_status, sizeof(in_status)},
+};
+
+#define MIX_COUNT (sizeof(mix) / sizeof(mix[0]))
+
+static int64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static void report(const char *name, long ops, int64_t ns)
+{
+    printf("%-30s %10ld cmds %7.1f ns/cmd %8.2f Mcmd/s\n", name, ops, (double)ns / ops,
+           (double)ops * 1000.0 / ns);
+}
+
+// Legado do on_ascii_command(): tamanho exato + memcmp
+static uint32_t ascii_command(const uint8_t *data, uint16_t len)
+{
+    if (len == 6 && memcmp(data, "UNLOCK", 6) == 0)
+        return 1;
+    if (len == 4 && memcmp(data, "LOCK", 4) == 0)
+        return 2;
+    return 0;
+}
+
+// Mesmo caminho do on_ble_write(), devolvendo algo dependente do resultado
+static uint32_t decode(const uint8_t *data, uint16_t len)
+{
+    ble_cmd_frame_t frame;
+    uint8_t resp[BLE_CMD_RESP_MAX_LEN];
+    size_t resp_len;
+
+    if (ble_cmd_is_text(data, len))
+    {
+        return ascii_command(data, len);
+    }
+
+    if (ble_cmd_frame_parse(data, len, &frame) == BLE_CMD_STATUS_OK)
+        resp_len = ble_cmd_dispatch(&cmd_table, &frame, resp, sizeof(resp));
+    else
+        resp_len = ble_cmd_resp_bad_frame(data, len, resp, sizeof(resp));
+
+    return resp[2] + (uint32_t)resp_len;
+}
+
+static void bench_parse(long iters)
+{
+    ble_cmd_frame_t frame;
+    uint32_t acc = 0;
+
+    int64_t t0 = now_ns();
+    for (long i = 0; i < iters; i++)
+    {
+        acc += ble_cmd_frame_parse(in_status, sizeof(in_status), &frame);
+        acc += frame.opcode;
+    }
+    report("parse", iters, now_ns() - t0);
+    sink += acc;
+}
+
+static void bench_dispatch(long iters)
+{
+    ble_cmd_frame_t frame;
+    uint8_t resp[BLE_CMD_RESP_MAX_LEN];
+    uint32_t acc = 0;
+
+    int64_t t0 = now_ns();
+    for (long i = 0; i < iters; i++)
+    {
+        ble_cmd_frame_parse(in_status, sizeof(in_status), &frame);
+        acc += ble_cmd_dispatch(&cmd_table, &frame, resp, sizeof(resp));
+        acc += resp[4];
+    }
+    report("parse + despacho", iters, now_ns() - t0);
+    sink += acc;
+}
+
+static void bench_text(long iters)
+{
+    uint32_t acc = 0;
+
+    int64_t t0 = now_ns();
+    for (long i = 0; i < iters; i++)
+    {
+        acc += decode(in_text_unlock, 6);
+    }
+    report("texto legado (UNLOCK)", iters, now_ns() - t0);
+    sink += acc;
+}
+
+static void bench_mix(long iters)
+{
+    uint32_t acc = 0;
+
+    int64_t t0 = now_ns();
+    for (long i = 0; i < iters; i++)
+    {
+        const input_t *in = &mix[i % MIX_COUNT];
+        acc += decode(in->data, in->len);
+    }
+    report("on_ble_write (misto)", iters, now_ns() - t0);
+    sink += acc;
+}
+
+int main(int argc, char **argv)
+{
+    bool quick = argc > 1 && strcmp(argv[1], "--quick") == 0;
+    long iters = quick ? 200000 : 20000000;
+
+    if (ble_cmd_table_init(&cmd_table, cmd_defs, sizeof(cmd_defs) / sizeof(cmd_defs[0]), NULL) != 0)
+    {
+        return EXIT_FAILURE;
+    }
+
+    // Confere o caminho antes de medir: GET_STATUS responde OK com 1 byte
+    if (decode(in_status, sizeof(in_status)) != BLE_CMD_STATUS_OK + BLE_CMD_RESP_HDR_LEN + 1)
+    {
+        printf("decodificação inesperada\n");
+        return EXIT_FAILURE;
+    }
+
+    bench_parse(iters);
+    bench_dispatch(iters);
+    bench_text(iters);
+    bench_mix(iters);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,220 @@
+// test/host/bench_gatt_dispatch.c
+// Custo por acesso GATT em função do número de characteristics registradas
+// (ble_server_register_chr). O despacho usa o `arg` da characteristic, então
+// o custo não deve crescer com N; para comparação, mede também a busca
+// antiga por cadeia de ble_uuid_cmp() sobre os mesmos UUIDs (só a busca,
+// sem o caminho ATT). Cada N roda num processo filho: o servidor aceita um
+// ble_server_init() por processo.
+//   bench_gatt_dispatch [--quick] [N]
+#include "ble_server.h"
+#include "ble_sim.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+static const int counts[] = {1, 8, 16, CONFIG_BLE_SERVER_MAX_APP_CHRS};
+
+static ble_uuid128_t uuids[CONFIG_BLE_SERVER_MAX_APP_CHRS];
+static uint16_t val_handles[CONFIG_BLE_SERVER_MAX_APP_CHRS];
+static volatile uint32_t sink;
+static int iters;
+
+static int chr_read(uint16_t conn_handle, struct os_mbuf *om, void *arg)
+{
+    uint32_t value = (uint32_t)(uintptr_t)arg;
+    return os_mbuf_append(om, &value, sizeof(value)) == 0 ? 0 : BLE_ATT_ERR_INSUFFICIENT_RES;
+}
+
+static int chr_write(uint16_t conn_handle, const ble_mbuf_view_t *view, void *arg)
+{
+    sink += (uint32_t)(uintptr_t)arg;
+    return 0;
+}
+
+static int64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+// UUIDs com a mesma base: diferem só nos bytes 12 e 13, como os do servidor
+static void make_uuids(int count)
+{
+    static const uint8_t base[16] = {0x23, 0xd1, 0xbc, 0xea, 0x5f, 0x78, 0x23, 0x15,
+                                     0xde, 0xef, 0x12, 0x12, 0x00, 0x00, 0x00, 0x00};
+
+    for (int i = 0; i < count; i++)
+    {
+        uuids[i].u.type = BLE_UUID_TYPE_128;
+        memcpy(uuids[i].value, base, sizeof(base));
+        uuids[i].value[12] = (uint8_t)(0x40 + i);
+        uuids[i].value[13] = 0x16;
+    }
+}
+
+// Despacho antigo: compara o UUID da characteristic com cada declaração
+static int chain_lookup(const ble_uuid_t *uuid, int count)
+{
+    for (int i = 0; i < count; i++)
+    {
+        if (ble_uuid_cmp(uuid, &uuids[i].u) == 0)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static double bench_read(uint16_t conn, uint16_t handle)
+{
+    uint8_t buf[8];
+
+    int64_t t0 = now_ns();
+    for (int i = 0; i < iters; i++)
+    {
+        if (ble_sim_read(conn, handle, 0, buf, sizeof(buf)) != 4)
+        {
+            printf("read falhou\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    return (double)(now_ns() - t0) / iters;
+}
+
+static double bench_write(uint16_t conn, uint16_t handle)
+{
+    uint8_t data[4] = {1, 2, 3, 4};
+
+    int64_t t0 = now_ns();
+    for (int i = 0; i < iters; i++)
+    {
+        if (ble_sim_write(conn, handle, data, sizeof(data)) != 0)
+        {
+            printf("write falhou\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    return (double)(now_ns() - t0) / iters;
+}
+
+static double bench_chain(int count)
+{
+    // UUID vindo do ATT (cópia), como o ctxt->chr->uuid do NimBLE
+    ble_uuid128_t target = uuids[count - 1];
+    int found = 0;
+
+    int64_t t0 = now_ns();
+    for (int i = 0; i < iters; i++)
+    {
+        found += chain_lookup(&target.u, count);
+    }
+    double ns = (double)(now_ns() - t0) / iters;
+    sink += found;
+    return ns;
+}
+
+static int run_count(int count)
+{
+    ble_server_config_t config = {.device_name = "BenchLock"};
+    ble_sim_peer_t phone = {.id_addr = {BLE_ADDR_PUBLIC, {1, 2, 3, 4, 5, 6}}};
+
+    make_uuids(count);
+    for (int i = 0; i < count; i++)
+    {
+        ble_server_chr_def_t def = {
+            .uuid = &uuids[i].u,
+            .flags = BLE_GATT_CHR_F_READ | BLE_GATT_CHR_F_WRITE,
+            .on_read = chr_read,
+            .on_write = chr_write,
+            .arg = (void *)(uintptr_t)i,
+            .val_handle = &val_handles[i],
+        };
+
+        if (ble_server_register_chr(&def) != ESP_OK)
+        {
+            printf("registro %d falhou\n", i);
+            return EXIT_FAILURE;
+        }
+    }
+
+    ble_sim_init();
+    if (ble_server_init(&config) != ESP_OK)
+    {
+        return EXIT_FAILURE;
+    }
+    ble_sim_sync();
+    ble_sim_run(0);
+    uint16_t conn = ble_sim_connect(&phone);
+    if (conn == BLE_SIM_NO_CONN)
+    {
+        return EXIT_FAILURE;
+    }
+    ble_sim_run(0);
+
+    // Cada handle precisa chegar ao handler da própria declaração
+    for (int i = 0; i < count; i++)
+    {
+        uint32_t value = 0;
+
+        if (ble_sim_read(conn, val_handles[i], 0, (uint8_t *)&value, sizeof(value)) != 4 ||
+            value != (uint32_t)i)
+        {
+            printf("N=%d: handle 0x%04x despachou para a characteristic errada\n", count, val_handles[i]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    double read_first = bench_read(conn, val_handles[0]);
+    double read_last = bench_read(conn, val_handles[count - 1]);
+    double write_last = bench_write(conn, val_handles[count - 1]);
+    double chain = bench_chain(count);
+
+    printf("%4d %12.0f %12.0f %12.0f %14.1f\n", count, read_first, read_last, write_last, chain);
+    return EXIT_SUCCESS;
+}
+
+int main(int argc, char **argv)
+{
+    int only = 0;
+    bool quick = false;
+    int status = EXIT_SUCCESS;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--quick") == 0)
+            quick = true;
+        else
+            only = atoi(argv[i]);
+    }
+    iters = quick ? 2000 : 200000;
+
+    if (only > 0 && only <= CONFIG_BLE_SERVER_MAX_APP_CHRS)
+    {
+        return run_count(only);
+    }
+
+    printf("%d acessos por caso (ns/acesso); busca UUID = cadeia de ble_uuid_cmp até a última\n", iters);
+    printf("%4s %12s %12s %12s %14s\n", "N", "read[0]", "read[N-1]", "write[N-1]", "busca UUID");
+    fflush(stdout);
+    for (size_t i = 0; i < sizeof(counts) / sizeof(counts[0]); i++)
+    {
+        pid_t pid = fork();
+        if (pid == 0)
+        {
+            int rc = run_count(counts[i]);
+            fflush(stdout);
+            _exit(rc);
+        }
+
+        int child;
+        if (pid < 0 || waitpid(pid, &child, 0) < 0 || !WIFEXITED(child) || WEXITSTATUS(child) != 0)
+        {
+            status = EXIT_FAILURE;
+        }
+    }
+    return status;
+}
@@ -0,0 +1,326 @@
+// test/host/bench_led_bulk.c
+// Escrita em bloco do led_strip (set_pixels, fill, copy_range) nos backends
+// SPI e RMT. Primeiro confere que cada uma deixa o buffer transmitido igual
+// ao de um laço de led_strip_set_pixel() com as mesmas cores; depois mede
+// pixels/s de cada uma contra esse laço, com quadros de 256 LEDs GRB e GRBW.
+// set_pixels roda com a fonte no formato da fita (cópia direta) e com fonte
+// RGB (reordenação).
+//   bench_led_bulk [--quick]
+#include "led_fake.h"
+#include "led_strip.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define STRIP_LEDS 256
+#define MAX_FRAME_LEN (STRIP_LEDS * 4 * 3) // GRBW no SPI: 3 bytes por byte de cor
+
+static int failures;
+
+#define CHECK(cond)                                                    \
+    do                                                                 \
+    {                                                                  \
+        if (!(cond))                                                   \
+        {                                                              \
+            printf("FALHA %s:%d: %s\n", __FILE__, __LINE__, #cond);    \
+            failures++;                                                \
+        }                                                              \
+    } while (0)
+
+static volatile uint32_t sink;
+
+static int64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+typedef enum
+{
+    BACKEND_SPI,
+    BACKEND_RMT,
+} backend_t;
+
+static const char *backend_name(backend_t backend)
+{
+    return backend == BACKEND_SPI ? "SPI" : "RMT";
+}
+
+static led_strip_handle_t new_strip(backend_t backend, led_color_component_format_t fmt)
+{
+    led_strip_config_t config = {
+        .strip_gpio_num = 8,
+        .max_leds = STRIP_LEDS,
+        .led_model = LED_MODEL_WS2812,
+        .color_component_format = fmt,
+    };
+    led_strip_handle_t strip = NULL;
+    esp_err_t rc;
+
+    if (backend == BACKEND_SPI)
+    {
+        led_strip_spi_config_t spi_config = {.spi_bus = SPI2_HOST, .flags.with_dma = true};
+        rc = led_strip_new_spi_device(&config, &spi_config, &strip);
+    }
+    else
+    {
+        led_strip_rmt_config_t rmt_config = {.resolution_hz = 10 * 1000 * 1000};
+        rc = led_strip_new_rmt_device(&config, &rmt_config, &strip);
+    }
+    return rc == ESP_OK ? strip : NULL;
+}
+
+// Copia o quadro que o refresh() mandaria para a fita
+static size_t frame(backend_t backend, led_strip_handle_t strip, uint8_t out[MAX_FRAME_LEN])
+{
+    size_t len = 0;
+    const uint8_t *tx;
+
+    if (led_strip_refresh(strip) != ESP_OK)
+    {
+        return 0;
+    }
+    tx = backend == BACKEND_SPI ? led_fake_spi_last_tx(&len) : led_fake_rmt_last_tx(&len);
+    if (tx == NULL || len > MAX_FRAME_LEN)
+    {
+        return 0;
+    }
+    memcpy(out, tx, len);
+    return len;
+}
+
+// Cores do LED i, as mesmas em qualquer ordem de componentes
+static uint8_t color_r(uint32_t i, int n)
+{
+    return (uint8_t)(i + n);
+}
+
+static uint8_t color_g(uint32_t i, int n)
+{
+    return (uint8_t)(i * 3);
+}
+
+static uint8_t color_b(uint32_t i, int n)
+{
+    return (uint8_t)(i * 7 + 1);
+}
+
+static uint8_t color_w(uint32_t i, int n)
+{
+    return (uint8_t)(255 - i);
+}
+
+// Fonte de STRIP_LEDS pixels no formato fmt, cores do quadro n
+static void make_colors(uint8_t *colors, led_color_component_format_t fmt, int n)
+{
+    uint8_t stride = fmt.format.num_components;
+
+    for (uint32_t i = 0; i < STRIP_LEDS; i++)
+    {
+        uint8_t *px = &colors[i * stride];
+        px[fmt.format.r_pos] = color_r(i, n);
+        px[fmt.format.g_pos] = color_g(i, n);
+        px[fmt.format.b_pos] = color_b(i, n);
+        if (stride == 4)
+            px[fmt.format.w_pos] = color_w(i, n);
+    }
+}
+
+// Referência: um led_strip_set_pixel() (ou _rgbw) por LED
+static void set_pixel_loop(led_strip_handle_t strip, bool with_white, int n)
+{
+    for (uint32_t i = 0; i < STRIP_LEDS; i++)
+    {
+        if (with_white)
+            led_strip_set_pixel_rgbw(strip, i, color_r(i, n), color_g(i, n), color_b(i, n), color_w(i, n));
+        else
+            led_strip_set_pixel(strip, i, color_r(i, n), color_g(i, n), color_b(i, n));
+    }
+}
+
+// ===== Equivalência =====
+
+static void check_frames(backend_t backend, const char *fmt_name, const char *what, led_strip_handle_t strip,
+                         const uint8_t *expected, size_t expected_len)
+{
+    static uint8_t got[MAX_FRAME_LEN];
+    size_t len = frame(backend, strip, got);
+
+    if (len != expected_len || memcmp(got, expected, len) != 0)
+    {
+        printf("FALHA %s %s %s: quadro diferente do laço de set_pixel\n", backend_name(backend), fmt_name, what);
+        failures++;
+    }
+}
+
+static void test_backend(backend_t backend, const char *fmt_name, led_color_component_format_t fmt)
+{
+    static uint8_t expected[MAX_FRAME_LEN];
+    static uint8_t colors[STRIP_LEDS * 4];
+    led_strip_handle_t strip = new_strip(backend, fmt);
+    bool rgbw = fmt.format.num_components == 4;
+    size_t len;
+
+    CHECK(strip != NULL);
+    if (strip == NULL)
+    {
+        return;
+    }
+
+    // set_pixels no formato da fita e com fonte RGB (branco 0)
+    set_pixel_loop(strip, rgbw, 0);
+    len = frame(backend, strip, expected);
+    CHECK(len > 0);
+    led_strip_clear(strip);
+    make_colors(colors, fmt, 0);
+    CHECK(led_strip_set_pixels(strip, 0, STRIP_LEDS, colors, fmt) == ESP_OK);
+    check_frames(backend, fmt_name, "set_pixels (mesmo formato)", strip, expected, len);
+
+    set_pixel_loop(strip, false, 0);
+    len = frame(backend, strip, expected);
+    led_strip_clear(strip);
+    make_colors(colors, LED_STRIP_COLOR_COMPONENT_FMT_RGB, 0);
+    CHECK(led_strip_set_pixels(strip, 0, STRIP_LEDS, colors, LED_STRIP_COLOR_COMPONENT_FMT_RGB) == ESP_OK);
+    check_frames(backend, fmt_name, "set_pixels (RGB)", strip, expected, len);
+
+    // fill de um trecho no meio, o resto intacto
+    set_pixel_loop(strip, false, 0);
+    for (uint32_t i = 10; i < 10 + 200; i++)
+    {
+        if (rgbw)
+            led_strip_set_pixel_rgbw(strip, i, 0x12, 0x34, 0x56, 0x78);
+        else
+            led_strip_set_pixel(strip, i, 0x12, 0x34, 0x56);
+    }
+    len = frame(backend, strip, expected);
+    set_pixel_loop(strip, false, 0);
+    CHECK(led_strip_fill(strip, 10, 200, 0x12, 0x34, 0x56, 0x78) == ESP_OK);
+    check_frames(backend, fmt_name, "fill", strip, expected, len);
+
+    // copy_range sobreposto: rolagem de 1 LED para a frente
+    for (uint32_t i = 0; i < STRIP_LEDS; i++)
+    {
+        uint32_t src = i == 0 ? 0 : i - 1;
+        led_strip_set_pixel(strip, i, color_r(src, 0), color_g(src, 0), color_b(src, 0));
+    }
+    len = frame(backend, strip, expected);
+    set_pixel_loop(strip, false, 0);
+    CHECK(led_strip_copy_range(strip, 1, 0, STRIP_LEDS - 1) == ESP_OK);
+    check_frames(backend, fmt_name, "copy_range", strip, expected, len);
+
+    CHECK(led_strip_set_pixels(strip, 1, STRIP_LEDS, colors, LED_STRIP_COLOR_COMPONENT_FMT_RGB) == ESP_ERR_INVALID_ARG);
+    CHECK(led_strip_fill(strip, STRIP_LEDS, 1, 0, 0, 0, 0) == ESP_ERR_INVALID_ARG);
+    CHECK(led_strip_copy_range(strip, 0, 1, STRIP_LEDS) == ESP_ERR_INVALID_ARG);
+
+    led_strip_del(strip);
+}
+
+// ===== Benchmark =====
+
+static void report(const char *name, long pixels, int64_t ns, int64_t base_ns)
+{
+    printf("  %-26s %7.2f ns/pixel %8.2f Mpixel/s %7.2fx\n", name, (double)ns / pixels,
+           (double)pixels * 1000.0 / ns, (double)base_ns / ns);
+}
+
+static void bench_backend(backend_t backend, const char *fmt_name, led_color_component_format_t fmt, int frames)
+{
+    static uint8_t same_colors[STRIP_LEDS * 4];
+    static uint8_t rgb_colors[STRIP_LEDS * 3];
+    led_strip_handle_t strip = new_strip(backend, fmt);
+    long pixels = (long)frames * STRIP_LEDS;
+    int64_t t0;
+
+    if (strip == NULL)
+    {
+        failures++;
+        return;
+    }
+    make_colors(same_colors, fmt, 0);
+    make_colors(rgb_colors, LED_STRIP_COLOR_COMPONENT_FMT_RGB, 0);
+    printf("%s %s\n", backend_name(backend), fmt_name);
+
+    t0 = now_ns();
+    for (int n = 0; n < frames; n++)
+    {
+        for (uint32_t i = 0; i < STRIP_LEDS; i++)
+        {
+            led_strip_set_pixel(strip, i, rgb_colors[i * 3], rgb_colors[i * 3 + 1], rgb_colors[i * 3 + 2]);
+        }
+        sink += n;
+    }
+    int64_t loop_ns = now_ns() - t0;
+    report("set_pixel por LED", pixels, loop_ns, loop_ns);
+
+    t0 = now_ns();
+    for (int n = 0; n < frames; n++)
+    {
+        led_strip_set_pixels(strip, 0, STRIP_LEDS, same_colors, fmt);
+        sink += n;
+    }
+    report("set_pixels mesmo formato", pixels, now_ns() - t0, loop_ns);
+
+    t0 = now_ns();
+    for (int n = 0; n < frames; n++)
+    {
+        led_strip_set_pixels(strip, 0, STRIP_LEDS, rgb_colors, LED_STRIP_COLOR_COMPONENT_FMT_RGB);
+        sink += n;
+    }
+    report("set_pixels fonte RGB", pixels, now_ns() - t0, loop_ns);
+
+    t0 = now_ns();
+    for (int n = 0; n < frames; n++)
+    {
+        led_strip_fill(strip, 0, STRIP_LEDS, n, 0x34, 0x56, 0x78);
+    }
+    report("fill", pixels, now_ns() - t0, loop_ns);
+
+    // Rolagem: todos menos um LED andam uma posição
+    t0 = now_ns();
+    for (int n = 0; n < frames; n++)
+    {
+        led_strip_copy_range(strip, 1, 0, STRIP_LEDS - 1);
+    }
+    report("copy_range (rolagem)", pixels, now_ns() - t0, loop_ns);
+
+    led_strip_del(strip);
+}
+
+int main(int argc, char **argv)
+{
+    static const struct
+    {
+        const char *name;
+        led_color_component_format_t fmt;
+    } formats[] = {
+        {"GRB", LED_STRIP_COLOR_COMPONENT_FMT_GRB},
+        {"GRBW", LED_STRIP_COLOR_COMPONENT_FMT_GRBW},
+    };
+    bool quick = argc > 1 && strcmp(argv[1], "--quick") == 0;
+
+    for (int b = BACKEND_SPI; b <= BACKEND_RMT; b++)
+    {
+        for (size_t f = 0; f < sizeof(formats) / sizeof(formats[0]); f++)
+        {
+            test_backend((backend_t)b, formats[f].name, formats[f].fmt);
+        }
+    }
+    if (failures)
+    {
+        printf("%d falhas\n", failures);
+        return EXIT_FAILURE;
+    }
+
+    int frames = quick ? 200 : 20000;
+    printf("%d quadros de %d LEDs por caso; ganho sobre o laço de set_pixel\n", frames, STRIP_LEDS);
+    for (int b = BACKEND_SPI; b <= BACKEND_RMT; b++)
+    {
+        for (size_t f = 0; f < sizeof(formats) / sizeof(formats[0]); f++)
+        {
+            bench_backend((backend_t)b, formats[f].name, formats[f].fmt, frames);
+        }
+    }
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,353 @@
+// test/host/bench_led_spi.c
+// Codificador SPI do led_strip (led_strip_spi_dev.c) no host. Compara, bit a
+// bit, o buffer que vai para o SPI com o do codificador antigo (teste de bit
+// com |= sobre o pixel zerado por memset), com o buffer cheio de lixo antes
+// para provar que a tabela dispensa a limpeza. Depois mede pixels/s do
+// set_pixel e do clear antigos contra os atuais, com quadros de 256 LEDs.
+//   bench_led_spi [--quick]
+#include "esp_bit_defs.h"
+#include "led_fake.h"
+#include "led_strip.h"
+#include "led_strip_interface.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define STRIP_LEDS 256
+#define SPI_BYTES_PER_COLOR_BYTE 3
+
+static int failures;
+
+#define CHECK(cond)                                                    \
+    do                                                                 \
+    {                                                                  \
+        if (!(cond))                                                   \
+        {                                                              \
+            printf("FALHA %s:%d: %s\n", __FILE__, __LINE__, #cond);    \
+            failures++;                                                \
+        }                                                              \
+    } while (0)
+
+static volatile uint32_t sink;
+
+static int64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+// ===== Codificador antigo =====
+// Cópia do led_strip_spi_dev.c anterior à tabela: mesmo objeto, mesma
+// checagem de índice e chamada por ponteiro, como pelo led_strip_t
+
+typedef struct
+{
+    uint32_t strip_len;
+    uint8_t bytes_per_pixel;
+    led_color_component_format_t component_fmt;
+    uint8_t pixel_buf[];
+} old_strip_t;
+
+static void old_spi_bit(uint8_t data, uint8_t *buf)
+{
+    *(buf + 2) |= data & BIT(0) ? BIT(2) | BIT(1) : BIT(2);
+    *(buf + 2) |= data & BIT(1) ? BIT(5) | BIT(4) : BIT(5);
+    *(buf + 2) |= data & BIT(2) ? BIT(7) : 0x00;
+    *(buf + 1) |= BIT(0);
+    *(buf + 1) |= data & BIT(3) ? BIT(3) | BIT(2) : BIT(3);
+    *(buf + 1) |= data & BIT(4) ? BIT(6) | BIT(5) : BIT(6);
+    *(buf + 0) |= data & BIT(5) ? BIT(1) | BIT(0) : BIT(1);
+    *(buf + 0) |= data & BIT(6) ? BIT(4) | BIT(3) : BIT(4);
+    *(buf + 0) |= data & BIT(7) ? BIT(7) | BIT(6) : BIT(7);
+}
+
+static esp_err_t old_set_pixel(old_strip_t *strip, uint32_t index, uint32_t red, uint32_t green, uint32_t blue)
+{
+    if (index >= strip->strip_len)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    uint32_t start = index * strip->bytes_per_pixel * SPI_BYTES_PER_COLOR_BYTE;
+    uint8_t *pixel_buf = strip->pixel_buf;
+    led_color_component_format_t fmt = strip->component_fmt;
+    memset(pixel_buf + start, 0, strip->bytes_per_pixel * SPI_BYTES_PER_COLOR_BYTE);
+
+    old_spi_bit(red, &pixel_buf[start + SPI_BYTES_PER_COLOR_BYTE * fmt.format.r_pos]);
+    old_spi_bit(green, &pixel_buf[start + SPI_BYTES_PER_COLOR_BYTE * fmt.format.g_pos]);
+    old_spi_bit(blue, &pixel_buf[start + SPI_BYTES_PER_COLOR_BYTE * fmt.format.b_pos]);
+    if (fmt.format.num_components > 3)
+    {
+        old_spi_bit(0, &pixel_buf[start + SPI_BYTES_PER_COLOR_BYTE * fmt.format.w_pos]);
+    }
+    return ESP_OK;
+}
+
+static esp_err_t old_set_pixel_rgbw(old_strip_t *strip, uint32_t index, uint32_t red, uint32_t green, uint32_t blue,
+                                    uint32_t white)
+{
+    if (index >= strip->strip_len || strip->component_fmt.format.num_components != 4)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    uint32_t start = index * strip->bytes_per_pixel * SPI_BYTES_PER_COLOR_BYTE;
+    uint8_t *pixel_buf = strip->pixel_buf;
+    led_color_component_format_t fmt = strip->component_fmt;
+    memset(pixel_buf + start, 0, strip->bytes_per_pixel * SPI_BYTES_PER_COLOR_BYTE);
+
+    old_spi_bit(red, &pixel_buf[start + SPI_BYTES_PER_COLOR_BYTE * fmt.format.r_pos]);
+    old_spi_bit(green, &pixel_buf[start + SPI_BYTES_PER_COLOR_BYTE * fmt.format.g_pos]);
+    old_spi_bit(blue, &pixel_buf[start + SPI_BYTES_PER_COLOR_BYTE * fmt.format.b_pos]);
+    old_spi_bit(white, &pixel_buf[start + SPI_BYTES_PER_COLOR_BYTE * fmt.format.w_pos]);
+    return ESP_OK;
+}
+
+static esp_err_t old_clear(old_strip_t *strip)
+{
+    memset(strip->pixel_buf, 0, strip->strip_len * strip->bytes_per_pixel * SPI_BYTES_PER_COLOR_BYTE);
+    uint8_t *buf = strip->pixel_buf;
+    for (uint32_t index = 0; index < strip->strip_len * strip->bytes_per_pixel; index++)
+    {
+        old_spi_bit(0, buf);
+        buf += SPI_BYTES_PER_COLOR_BYTE;
+    }
+    return ESP_OK;
+}
+
+// Ponteiros voláteis: o antigo também era chamado pelo led_strip_t, sem inline
+static esp_err_t (*volatile old_set_pixel_fn)(old_strip_t *, uint32_t, uint32_t, uint32_t, uint32_t) = old_set_pixel;
+static esp_err_t (*volatile old_clear_fn)(old_strip_t *) = old_clear;
+
+static old_strip_t *old_strip_new(led_color_component_format_t fmt)
+{
+    uint8_t bytes_per_pixel = fmt.format.num_components;
+    old_strip_t *strip = calloc(1, sizeof(*strip) + STRIP_LEDS * bytes_per_pixel * SPI_BYTES_PER_COLOR_BYTE);
+
+    strip->strip_len = STRIP_LEDS;
+    strip->bytes_per_pixel = bytes_per_pixel;
+    strip->component_fmt = fmt;
+    return strip;
+}
+
+static size_t old_strip_len(const old_strip_t *strip)
+{
+    return strip->strip_len * strip->bytes_per_pixel * SPI_BYTES_PER_COLOR_BYTE;
+}
+
+static led_strip_handle_t new_strip(led_color_component_format_t fmt)
+{
+    led_strip_config_t config = {
+        .strip_gpio_num = 8,
+        .max_leds = STRIP_LEDS,
+        .led_model = LED_MODEL_WS2812,
+        .color_component_format = fmt,
+    };
+    led_strip_spi_config_t spi_config = {
+        .spi_bus = SPI2_HOST,
+        .flags.with_dma = true,
+    };
+    led_strip_handle_t strip = NULL;
+
+    if (led_strip_new_spi_device(&config, &spi_config, &strip) != ESP_OK)
+    {
+        return NULL;
+    }
+    return strip;
+}
+
+// Buffer enviado pelo refresh() do driver atual
+static const uint8_t *new_strip_tx(led_strip_handle_t strip, size_t *len)
+{
+    *len = 0;
+    if (led_strip_refresh(strip) != ESP_OK)
+    {
+        return NULL;
+    }
+    return led_fake_spi_last_tx(len);
+}
+
+// ===== Equivalência =====
+
+static const struct
+{
+    const char *name;
+    led_color_component_format_t fmt;
+} formats[] = {
+    {"GRB", LED_STRIP_COLOR_COMPONENT_FMT_GRB},
+    {"RGB", LED_STRIP_COLOR_COMPONENT_FMT_RGB},
+    {"GRBW", LED_STRIP_COLOR_COMPONENT_FMT_GRBW},
+    {"RGBW", LED_STRIP_COLOR_COMPONENT_FMT_RGBW},
+};
+
+#define FORMAT_COUNT (sizeof(formats) / sizeof(formats[0]))
+
+static void check_same(const char *fmt_name, const char *what, led_strip_handle_t strip, const old_strip_t *old)
+{
+    size_t len;
+    const uint8_t *tx = new_strip_tx(strip, &len);
+
+    CHECK(tx != NULL && len == old_strip_len(old));
+    if (tx == NULL || len != old_strip_len(old))
+    {
+        return;
+    }
+    for (size_t i = 0; i < len; i++)
+    {
+        if (tx[i] != old->pixel_buf[i])
+        {
+            printf("FALHA %s %s: byte %zu (LED %zu) = 0x%02x, antigo 0x%02x\n", fmt_name, what, i,
+                   i / (old->bytes_per_pixel * SPI_BYTES_PER_COLOR_BYTE), tx[i], old->pixel_buf[i]);
+            failures++;
+            return;
+        }
+    }
+}
+
+// Sobre o LED i: vermelho i, verde 255-i, azul i^0x5a, branco 7i. Cada canal
+// passa por todos os 256 valores em 256 LEDs
+static void test_equivalence(void)
+{
+    for (size_t f = 0; f < FORMAT_COUNT; f++)
+    {
+        led_strip_handle_t strip = new_strip(formats[f].fmt);
+        old_strip_t *old = old_strip_new(formats[f].fmt);
+        bool rgbw = formats[f].fmt.format.num_components == 4;
+
+        CHECK(strip != NULL);
+        if (strip == NULL)
+        {
+            free(old);
+            continue;
+        }
+
+        // Lixo no buffer: a tabela sobrescreve os 3 bytes, sem memset
+        for (uint32_t i = 0; i < STRIP_LEDS; i++)
+        {
+            if (rgbw)
+                led_strip_set_pixel_rgbw(strip, i, 0xff, 0xa5, 0x3c, 0xff);
+            else
+                led_strip_set_pixel(strip, i, 0xff, 0xa5, 0x3c);
+        }
+
+        for (uint32_t i = 0; i < STRIP_LEDS; i++)
+        {
+            CHECK(led_strip_set_pixel(strip, i, i, 255 - i, i ^ 0x5a) == ESP_OK);
+            old_set_pixel(old, i, i, 255 - i, i ^ 0x5a);
+        }
+        check_same(formats[f].name, "set_pixel", strip, old);
+
+        if (rgbw)
+        {
+            for (uint32_t i = 0; i < STRIP_LEDS; i++)
+            {
+                CHECK(led_strip_set_pixel_rgbw(strip, i, i, 255 - i, i ^ 0x5a, (i * 7) & 0xff) == ESP_OK);
+                old_set_pixel_rgbw(old, i, i, 255 - i, i ^ 0x5a, (i * 7) & 0xff);
+            }
+            check_same(formats[f].name, "set_pixel_rgbw", strip, old);
+        }
+        else
+        {
+            CHECK(led_strip_set_pixel_rgbw(strip, 0, 1, 2, 3, 4) == ESP_ERR_INVALID_ARG);
+        }
+
+        CHECK(led_strip_set_pixel(strip, STRIP_LEDS, 1, 2, 3) == ESP_ERR_INVALID_ARG);
+
+        CHECK(led_strip_clear(strip) == ESP_OK);
+        old_clear(old);
+        check_same(formats[f].name, "clear", strip, old);
+
+        led_strip_del(strip);
+        free(old);
+    }
+}
+
+// ===== Benchmark =====
+
+static void report(const char *name, long pixels, int64_t ns)
+{
+    printf("%-22s %7.2f ns/pixel %8.2f Mpixel/s\n", name, (double)ns / pixels, (double)pixels * 1000.0 / ns);
+}
+
+static void bench_format(const char *fmt_name, led_color_component_format_t fmt, int frames)
+{
+    led_strip_handle_t strip = new_strip(fmt);
+    old_strip_t *old = old_strip_new(fmt);
+    long pixels = (long)frames * STRIP_LEDS;
+    int64_t t0;
+
+    if (strip == NULL)
+    {
+        failures++;
+        free(old);
+        return;
+    }
+    printf("%s (%u bytes SPI por quadro)\n", fmt_name, (unsigned)old_strip_len(old));
+
+    t0 = now_ns();
+    for (int n = 0; n < frames; n++)
+    {
+        for (uint32_t i = 0; i < STRIP_LEDS; i++)
+        {
+            old_set_pixel_fn(old, i, i + n, i * 3, i * 7);
+        }
+        sink += old->pixel_buf[n % STRIP_LEDS];
+    }
+    int64_t old_ns = now_ns() - t0;
+
+    t0 = now_ns();
+    for (int n = 0; n < frames; n++)
+    {
+        for (uint32_t i = 0; i < STRIP_LEDS; i++)
+        {
+            strip->set_pixel(strip, i, i + n, i * 3, i * 7);
+        }
+        sink += n;
+    }
+    int64_t new_ns = now_ns() - t0;
+
+    report("set_pixel antigo", pixels, old_ns);
+    report("set_pixel tabela", pixels, new_ns);
+    printf("  ganho: %.2fx\n", (double)old_ns / new_ns);
+
+    t0 = now_ns();
+    for (int n = 0; n < frames; n++)
+    {
+        old_clear_fn(old);
+        sink += old->pixel_buf[n % STRIP_LEDS];
+    }
+    old_ns = now_ns() - t0;
+
+    t0 = now_ns();
+    for (int n = 0; n < frames; n++)
+    {
+        strip->clear(strip);
+    }
+    new_ns = now_ns() - t0;
+
+    report("clear antigo", pixels, old_ns);
+    report("clear tabela", pixels, new_ns);
+    printf("  ganho: %.2fx\n", (double)old_ns / new_ns);
+
+    led_strip_del(strip);
+    free(old);
+}
+
+int main(int argc, char **argv)
+{
+    bool quick = argc > 1 && strcmp(argv[1], "--quick") == 0;
+
+    test_equivalence();
+    if (failures)
+    {
+        printf("%d falhas\n", failures);
+        return EXIT_FAILURE;
+    }
+    printf("buffer SPI idêntico ao do codificador antigo (GRB, RGB, GRBW, RGBW)\n");
+
+    int frames = quick ? 200 : 20000;
+    printf("%d quadros de %d LEDs por caso\n", frames, STRIP_LEDS);
+    bench_format("GRB", LED_STRIP_COLOR_COMPONENT_FMT_GRB, frames);
+    bench_format("GRBW", LED_STRIP_COLOR_COMPONENT_FMT_GRBW, frames);
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
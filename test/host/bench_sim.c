@@ -0,0 +1,188 @@
+// test/host/bench_sim.c
+// Custo por operação do servidor BLE no simulador: despacho GATT (write no
+// Command, read do Status), notificação direta e fila de notificações com o
+// controlador drenando. Os tempos incluem o host simulado; servem para
+// comparar versões do servidor na mesma máquina, não para prever o ESP32.
+//   bench_sim [--quick]
+#include "ble_server.h"
+#include "ble_sim.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static const ble_uuid128_t cmd_uuid = BLE_UUID128_INIT(
+    0x23, 0xd1, 0xbc, 0xea, 0x5f, 0x78, 0x23, 0x15, 0xde, 0xef, 0x12, 0x12, 0x25, 0x15, 0x00, 0x00);
+static const ble_uuid128_t status_uuid = BLE_UUID128_INIT(
+    0x23, 0xd1, 0xbc, 0xea, 0x5f, 0x78, 0x23, 0x15, 0xde, 0xef, 0x12, 0x12, 0x24, 0x15, 0x00, 0x00);
+
+static volatile uint32_t sink;
+static uint32_t sent;
+
+static void app_on_write(uint8_t *data, uint16_t len)
+{
+    sink += data[0] + len;
+}
+
+static void app_sent(uint16_t conn_handle, esp_err_t status, void *arg)
+{
+    sent++;
+}
+
+static int64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static void report(const char *name, int ops, int64_t ns, uint32_t bytes)
+{
+    printf("%-28s %8d ops %9.0f ns/op", name, ops, (double)ns / ops);
+    if (bytes)
+    {
+        printf(" %8.1f MB/s", (double)bytes * 1000.0 / ns);
+    }
+    printf("\n");
+}
+
+static void bench_write(uint16_t conn, uint16_t handle, uint16_t len, uint16_t chunk, int iters)
+{
+    uint8_t data[BLE_ATT_ATTR_MAX_LEN];
+    char name[40];
+
+    memset(data, 0x5a, sizeof(data));
+    ble_sim_set_rx_chunk(chunk);
+    int64_t t0 = now_ns();
+    for (int i = 0; i < iters; i++)
+    {
+        if (ble_sim_write(conn, handle, data, len) != 0)
+        {
+            printf("write falhou\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    int64_t ns = now_ns() - t0;
+    ble_sim_set_rx_chunk(0);
+
+    snprintf(name, sizeof(name), "write %u B (seg %u)", len, chunk ? chunk : len);
+    report(name, iters, ns, (uint32_t)len * iters);
+}
+
+static void bench_read(uint16_t conn, uint16_t handle, int iters)
+{
+    uint8_t buf[64];
+
+    int64_t t0 = now_ns();
+    for (int i = 0; i < iters; i++)
+    {
+        if (ble_sim_read(conn, handle, 0, buf, sizeof(buf)) != 20)
+        {
+            printf("read falhou\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    report("read Status", iters, now_ns() - t0, 20u * iters);
+}
+
+static void bench_notify_direct(uint16_t len, int iters)
+{
+    uint8_t data[BLE_ATT_ATTR_MAX_LEN];
+    char name[40];
+
+    memset(data, 0xa5, sizeof(data));
+    ble_sim_notify_clear();
+    int64_t t0 = now_ns();
+    for (int i = 0; i < iters; i++)
+    {
+        ble_server_notify(data, len);
+        ble_sim_run(0);
+    }
+    int64_t ns = now_ns() - t0;
+
+    snprintf(name, sizeof(name), "notify direto %u B", len);
+    report(name, iters, ns, (uint32_t)len * iters);
+}
+
+// Rajadas do tamanho da fila; o controlador drena entre elas
+static void bench_notify_queue(uint16_t conn, uint16_t len, int iters)
+{
+    uint8_t data[CONFIG_BLE_SERVER_TXQ_SLOT_SIZE];
+    ble_server_txq_stats_t stats;
+    char name[40];
+    int queued = 0;
+
+    memset(data, 0x3c, sizeof(data));
+    sent = 0;
+    int64_t t0 = now_ns();
+    while (queued < iters)
+    {
+        for (int i = 0; i < CONFIG_BLE_SERVER_TXQ_DEPTH && queued < iters; i++)
+        {
+            if (ble_server_notify_enqueue(conn, data, len, app_sent, NULL) != ESP_OK)
+            {
+                break;
+            }
+            queued++;
+        }
+        ble_sim_run(0);
+    }
+    while (sent < (uint32_t)iters)
+    {
+        ble_sim_run(CONFIG_BLE_SERVER_TXQ_RETRY_MS);
+    }
+    int64_t ns = now_ns() - t0;
+
+    snprintf(name, sizeof(name), "notify na fila %u B", len);
+    report(name, iters, ns, (uint32_t)len * iters);
+
+    ble_server_get_txq_stats(&stats);
+    printf("  txq (acumulado): enviadas=%lu novas tentativas=%lu espera máx=%lu us\n",
+           (unsigned long)stats.sent, (unsigned long)stats.retries, (unsigned long)stats.delay_us_max);
+}
+
+int main(int argc, char **argv)
+{
+    bool quick = argc > 1 && strcmp(argv[1], "--quick") == 0;
+    int iters = quick ? 2000 : 200000;
+    ble_server_config_t config = {
+        .device_name = "BenchLock",
+        .on_write = app_on_write,
+    };
+    ble_sim_peer_t phone = {.id_addr = {BLE_ADDR_PUBLIC, {1, 2, 3, 4, 5, 6}}};
+    ble_sim_stats_t stats;
+
+    ble_sim_init();
+    if (ble_server_init(&config) != ESP_OK)
+    {
+        return EXIT_FAILURE;
+    }
+    ble_sim_sync();
+    ble_sim_run(0);
+
+    uint16_t conn = ble_sim_connect(&phone);
+    if (conn == BLE_SIM_NO_CONN)
+    {
+        return EXIT_FAILURE;
+    }
+    ble_sim_mtu(conn, 247);
+    uint16_t cmd_handle = ble_sim_find_chr(&cmd_uuid.u);
+    uint16_t status_handle = ble_sim_find_chr(&status_uuid.u);
+    ble_sim_subscribe(conn, status_handle, true);
+    ble_sim_run(0);
+
+    printf("simulador: %d iterações por caso\n", iters);
+    bench_write(conn, cmd_handle, 20, 0, iters);
+    bench_write(conn, cmd_handle, 244, 0, iters);
+    bench_write(conn, cmd_handle, 244, 32, iters);
+    bench_read(conn, status_handle, iters);
+    bench_notify_direct(20, iters);
+    bench_notify_direct(244, iters);
+    bench_notify_queue(conn, 20, iters);
+    bench_notify_queue(conn, 244, iters);
+
+    ble_sim_get_stats(&stats);
+    printf("msys: mínimo livre=%lu de %d blocos\n", (unsigned long)stats.msys_min_free,
+           CONFIG_BT_NIMBLE_MSYS_1_BLOCK_COUNT);
+    return EXIT_SUCCESS;
+}
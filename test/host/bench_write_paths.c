@@ -0,0 +1,204 @@
+// test/host/bench_write_paths.c
+// Writes no Command pelos dois caminhos do servidor no simulador: on_write
+// (cópia para o buffer de 512 bytes na pilha do host) e on_write_view
+// (visão sobre a cadeia de mbufs, sem cópia). Mede bytes/s e o pico de
+// pilha da thread que faz o papel da task do host, com a pilha pintada
+// antes de cada caso. Cada caminho roda num processo filho: o servidor
+// aceita um ble_server_init() por processo.
+//   bench_write_paths [--quick] [flat|view]
+#include "ble_server.h"
+#include "ble_sim.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#define STACK_SIZE (64 * 1024)
+#define STACK_PAINT 0xA5
+
+static const ble_uuid128_t cmd_uuid = BLE_UUID128_INIT(
+    0x23, 0xd1, 0xbc, 0xea, 0x5f, 0x78, 0x23, 0x15, 0xde, 0xef, 0x12, 0x12, 0x25, 0x15, 0x00, 0x00);
+
+static const uint16_t sizes[] = {20, 128, 244, 512};
+
+static volatile uint32_t sink;
+static uint16_t conn;
+static uint16_t cmd_handle;
+static int iters;
+
+// Mesmo trabalho nos dois caminhos: soma todos os bytes
+static void app_on_write(uint8_t *data, uint16_t len)
+{
+    uint32_t sum = 0;
+
+    for (uint16_t i = 0; i < len; i++)
+    {
+        sum += data[i];
+    }
+    sink += sum;
+}
+
+static void app_on_write_view(const ble_mbuf_view_t *view)
+{
+    ble_mbuf_seg_t seg;
+    uint32_t sum = 0;
+
+    for (bool ok = ble_mbuf_view_seg_first(view, &seg); ok; ok = ble_mbuf_view_seg_next(&seg))
+    {
+        for (uint16_t i = 0; i < seg.len; i++)
+        {
+            sum += seg.data[i];
+        }
+    }
+    sink += sum;
+}
+
+static int64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+typedef struct
+{
+    uint16_t len;
+    int64_t ns;
+    int errors;
+} write_case_t;
+
+static void *write_main(void *arg)
+{
+    write_case_t *wc = arg;
+    uint8_t data[BLE_ATT_ATTR_MAX_LEN];
+
+    if (wc->len == 0)
+    {
+        return NULL; // Linha de base: thread vazia
+    }
+
+    for (int i = 0; i < wc->len; i++)
+    {
+        data[i] = (uint8_t)i;
+    }
+
+    int64_t t0 = now_ns();
+    for (int i = 0; i < iters; i++)
+    {
+        if (ble_sim_write(conn, cmd_handle, data, wc->len) != 0)
+        {
+            wc->errors++;
+        }
+    }
+    wc->ns = now_ns() - t0;
+    return NULL;
+}
+
+// Roda o caso numa thread com pilha pintada; retorna os bytes tocados
+static size_t run_painted(write_case_t *wc)
+{
+    static uint8_t stack[STACK_SIZE] __attribute__((aligned(64)));
+    pthread_attr_t attr;
+    pthread_t thread;
+    size_t untouched = 0;
+
+    memset(stack, STACK_PAINT, sizeof(stack));
+    pthread_attr_init(&attr);
+    pthread_attr_setstack(&attr, stack, sizeof(stack));
+    pthread_create(&thread, &attr, write_main, wc);
+    pthread_join(thread, NULL);
+    pthread_attr_destroy(&attr);
+
+    // A pilha cresce para baixo: conta a pintura intacta a partir do fim
+    while (untouched < sizeof(stack) && stack[untouched] == STACK_PAINT)
+    {
+        untouched++;
+    }
+    return sizeof(stack) - untouched;
+}
+
+static int run_mode(bool view)
+{
+    ble_server_config_t config = {.device_name = "BenchLock"};
+    ble_sim_peer_t phone = {.id_addr = {BLE_ADDR_PUBLIC, {1, 2, 3, 4, 5, 6}}};
+    const char *name = view ? "view" : "flat";
+
+    if (view)
+        config.on_write_view = app_on_write_view;
+    else
+        config.on_write = app_on_write;
+
+    ble_sim_init();
+    if (ble_server_init(&config) != ESP_OK)
+    {
+        return EXIT_FAILURE;
+    }
+    ble_sim_sync();
+    ble_sim_run(0);
+    conn = ble_sim_connect(&phone);
+    ble_sim_mtu(conn, 247);
+    ble_sim_run(0);
+    cmd_handle = ble_sim_find_chr(&cmd_uuid.u);
+
+    write_case_t base = {0};
+    size_t base_stack = run_painted(&base);
+
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++)
+    {
+        write_case_t wc = {.len = sizes[i]};
+        size_t stack = run_painted(&wc);
+
+        if (wc.errors)
+        {
+            printf("%s: %d writes falharam\n", name, wc.errors);
+            return EXIT_FAILURE;
+        }
+        printf("%-5s %4u B  %8.0f ns/write  %8.1f MB/s  pilha %5zu B\n", name, wc.len,
+               (double)wc.ns / iters, (double)wc.len * iters * 1000.0 / wc.ns, stack - base_stack);
+    }
+    return EXIT_SUCCESS;
+}
+
+int main(int argc, char **argv)
+{
+    const char *only = NULL;
+    bool quick = false;
+    int status = EXIT_SUCCESS;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--quick") == 0)
+            quick = true;
+        else
+            only = argv[i];
+    }
+    iters = quick ? 2000 : 200000;
+
+    if (only)
+    {
+        return run_mode(strcmp(only, "view") == 0);
+    }
+
+    printf("%d writes por caso; pilha acima de uma thread vazia (inclui o simulador)\n", iters);
+    fflush(stdout);
+    for (int view = 0; view <= 1; view++)
+    {
+        pid_t pid = fork();
+        if (pid == 0)
+        {
+            int rc = run_mode(view);
+            fflush(stdout);
+            _exit(rc);
+        }
+
+        int child;
+        if (pid < 0 || waitpid(pid, &child, 0) < 0 || !WIFEXITED(child) || WEXITSTATUS(child) != 0)
+        {
+            status = EXIT_FAILURE;
+        }
+    }
+    return status;
+}
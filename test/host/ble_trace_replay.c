@@ -0,0 +1,558 @@
+// test/host/ble_trace_replay.c
+// Reprodução no Linux de um trace capturado no dispositivo
+// (ble_server_trace_dump). Lê o despejo da serial (linhas "BLE_TRACE ..."
+// no meio do log), imprime a linha do tempo e repete as entradas do trace no
+// servidor real rodando no simulador, nos mesmos instantes:
+//   - GAP: conexão, MTU, pareamento, inscrição, desconexão e reset do host
+//   - reads e writes nas characteristics (pelo índice gravado)
+//   - os callbacks da aplicação demoram o que demoraram em campo
+// O que o servidor produz (notificações, advertising, callbacks) sai no
+// trace do replay, comparado ao gravado no fim. O payload dos writes não é
+// gravado: o replay usa um valor válido por characteristic.
+//   ble_trace_replay [--check] [--quiet] <log da serial>
+// --check falha se algum acesso repetido retornar um código diferente do
+// gravado ou se uma conexão for recusada.
+#include "ble_server.h"
+#include "ble_sim.h"
+#include "esp_timer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define MAX_RECS 4096
+#define MAX_TRACE_CONNS 16
+#define NO_CONN 0xFFFF
+#define DURATION(v) ((v) & 0xFFFFFF)
+#define RC(v) ((uint8_t)((v) >> 24))
+
+typedef struct
+{
+    uint32_t time_us;
+    uint8_t type;
+    uint8_t sub;
+    uint16_t conn_handle;
+    uint32_t value;
+} trace_rec_t;
+
+static trace_rec_t recs[MAX_RECS];
+static int rec_count;
+
+// Ordem das characteristics internas em ble_server_gatt.c (índice do trace)
+static const char *const builtin_names[] = {"Command", "Status", "DateTime", "LongWrite", "Auth", "Diag"};
+#define BUILTIN_COUNT (int)(sizeof(builtin_names) / sizeof(builtin_names[0]))
+
+static const char *const cb_names[] = {"on_write", "on_write_view", "on_long_write",
+                                       "on_connect", "on_disconnect", "sent"};
+#define CB_COUNT (int)(sizeof(cb_names) / sizeof(cb_names[0]))
+
+// ===== Leitura do despejo =====
+
+static uint32_t get_u32le(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static int hex_nibble(char c)
+{
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    return -1;
+}
+
+// Decodifica uma linha de registros; retorna quantos ou -1 se malformada
+static int parse_hex_line(const char *hex)
+{
+    uint8_t rec[12];
+    size_t len = strcspn(hex, "\r\n ");
+    int n = 0;
+
+    if (len == 0 || len % (2 * sizeof(rec)) != 0)
+    {
+        return -1;
+    }
+
+    for (size_t off = 0; off < len; off += 2 * sizeof(rec))
+    {
+        for (size_t i = 0; i < sizeof(rec); i++)
+        {
+            int hi = hex_nibble(hex[off + 2 * i]);
+            int lo = hex_nibble(hex[off + 2 * i + 1]);
+            if (hi < 0 || lo < 0)
+            {
+                return -1;
+            }
+            rec[i] = (uint8_t)(hi << 4 | lo);
+        }
+        if (rec_count == MAX_RECS)
+        {
+            return -1;
+        }
+        recs[rec_count++] = (trace_rec_t){
+            .time_us = get_u32le(&rec[0]),
+            .type = rec[4],
+            .sub = rec[5],
+            .conn_handle = (uint16_t)(rec[6] | rec[7] << 8),
+            .value = get_u32le(&rec[8]),
+        };
+        n++;
+    }
+    return n;
+}
+
+// Usa o primeiro despejo completo do arquivo; o resto do log é ignorado
+static int load_dump(const char *path, uint32_t *lost)
+{
+    FILE *f = fopen(path, "r");
+    char line[1024];
+    int declared = -1;
+
+    if (f == NULL)
+    {
+        perror(path);
+        return -1;
+    }
+
+    while (fgets(line, sizeof(line), f))
+    {
+        const char *p = strstr(line, "BLE_TRACE ");
+        unsigned long lost_now;
+
+        if (p == NULL)
+        {
+            continue;
+        }
+        p += strlen("BLE_TRACE ");
+
+        if (strncmp(p, "begin ", 6) == 0)
+        {
+            if (sscanf(p, "begin v1 recs=%d lost=%lu", &declared, &lost_now) != 2)
+            {
+                fprintf(stderr, "%s: versão do despejo não suportada: %s", path, p);
+                break;
+            }
+            *lost = (uint32_t)lost_now;
+            rec_count = 0;
+        }
+        else if (strncmp(p, "end", 3) == 0 && declared >= 0)
+        {
+            fclose(f);
+            if (rec_count != declared)
+            {
+                fprintf(stderr, "%s: %d registros, o cabeçalho declara %d\n", path, rec_count, declared);
+                return -1;
+            }
+            return rec_count;
+        }
+        else if (declared >= 0 && parse_hex_line(p) < 0)
+        {
+            fprintf(stderr, "%s: linha de registros inválida: %s", path, p);
+            break;
+        }
+    }
+
+    fclose(f);
+    fprintf(stderr, "%s: nenhum despejo BLE_TRACE completo\n", path);
+    return -1;
+}
+
+// ===== Linha do tempo =====
+
+static const char *gap_name(uint8_t sub)
+{
+    switch (sub)
+    {
+    case BLE_GAP_EVENT_CONNECT:
+        return "connect";
+    case BLE_GAP_EVENT_DISCONNECT:
+        return "disconnect";
+    case BLE_GAP_EVENT_CONN_UPDATE:
+        return "conn_update";
+    case BLE_GAP_EVENT_ADV_COMPLETE:
+        return "adv_complete";
+    case BLE_GAP_EVENT_ENC_CHANGE:
+        return "enc_change";
+    case BLE_GAP_EVENT_SUBSCRIBE:
+        return "subscribe";
+    case BLE_GAP_EVENT_MTU:
+        return "mtu";
+    case BLE_GAP_EVENT_NOTIFY_TX:
+        return "notify_tx";
+    default:
+        return "evento";
+    }
+}
+
+static void chr_name(uint8_t index, char *out, size_t cap)
+{
+    if (index < BUILTIN_COUNT)
+        snprintf(out, cap, "%s", builtin_names[index]);
+    else
+        snprintf(out, cap, "app[%d]", index - BUILTIN_COUNT);
+}
+
+static void print_rec(const trace_rec_t *rec, uint32_t t0)
+{
+    char conn[8] = "-";
+    char chr[16];
+
+    if (rec->conn_handle != NO_CONN)
+    {
+        snprintf(conn, sizeof(conn), "%u", rec->conn_handle);
+    }
+    printf("%12.3f ms  conn %-3s ", (double)(uint32_t)(rec->time_us - t0) / 1000.0, conn);
+
+    switch (rec->type)
+    {
+    case BLE_SERVER_TRACE_GAP:
+        printf("gap %s (%u)\n", gap_name(rec->sub), (unsigned)rec->value);
+        break;
+    case BLE_SERVER_TRACE_READ:
+    case BLE_SERVER_TRACE_WRITE:
+        chr_name(rec->sub, chr, sizeof(chr));
+        printf("%s %s: %u us rc=%u\n", rec->type == BLE_SERVER_TRACE_READ ? "read" : "write", chr,
+               (unsigned)DURATION(rec->value), RC(rec->value));
+        break;
+    case BLE_SERVER_TRACE_NOTIFY:
+        printf("notify %s: %u us rc=%u\n", rec->sub ? "direta" : "fila", (unsigned)DURATION(rec->value),
+               RC(rec->value));
+        break;
+    case BLE_SERVER_TRACE_APP_CB:
+        printf("app %s: %u us\n", rec->sub < CB_COUNT ? cb_names[rec->sub] : "?",
+               (unsigned)DURATION(rec->value));
+        break;
+    case BLE_SERVER_TRACE_RESET:
+        printf("reset do host (motivo %u)\n", (unsigned)rec->value);
+        break;
+    default:
+        printf("tipo %u sub %u valor 0x%08x\n", rec->type, rec->sub, (unsigned)rec->value);
+        break;
+    }
+}
+
+// ===== Aplicação do replay =====
+// Os callbacks consomem, em ordem, as durações gravadas para o mesmo callback
+
+static int cb_next[CB_COUNT];
+
+static void spend_recorded(uint8_t cb)
+{
+    for (int i = cb_next[cb]; i < rec_count; i++)
+    {
+        if (recs[i].type == BLE_SERVER_TRACE_APP_CB && recs[i].sub == cb)
+        {
+            uint32_t us = DURATION(recs[i].value);
+            struct timespec ts = {.tv_sec = us / 1000000, .tv_nsec = (long)(us % 1000000) * 1000};
+
+            cb_next[cb] = i + 1;
+            nanosleep(&ts, NULL);
+            return;
+        }
+    }
+    cb_next[cb] = rec_count;
+}
+
+// Como o on_ble_write() de src/main.c: responde só a quem enviou
+static void replay_on_write(uint8_t *data, uint16_t len)
+{
+    uint8_t resp[5] = {data[0] | 0x80, len > 1 ? data[1] : 0, 0, 1, 0};
+
+    spend_recorded(BLE_SERVER_TRACE_CB_WRITE);
+    ble_server_notify_enqueue(ble_server_cmd_conn_handle(), resp, sizeof(resp), NULL, NULL);
+}
+
+static void replay_on_connect(uint16_t conn_handle)
+{
+    spend_recorded(BLE_SERVER_TRACE_CB_CONNECT);
+}
+
+static void replay_on_disconnect(uint16_t conn_handle)
+{
+    spend_recorded(BLE_SERVER_TRACE_CB_DISCONNECT);
+}
+
+static bool cmd_idle(void *arg)
+{
+    ble_server_cmd_stats_t stats;
+
+    ble_server_get_cmd_stats(&stats);
+    return stats.executed + stats.dropped >= stats.enqueued;
+}
+
+// ===== Replay =====
+
+static uint16_t conn_map[MAX_TRACE_CONNS];
+static int mismatches;
+static int refused;
+static int skipped;
+
+static uint16_t sim_conn(uint16_t trace_conn)
+{
+    return trace_conn < MAX_TRACE_CONNS ? conn_map[trace_conn] : BLE_SIM_NO_CONN;
+}
+
+// Valor válido para cada characteristic interna (o trace não guarda payload)
+static int replay_write(uint16_t conn, uint8_t index)
+{
+    static const uint8_t get_status[] = {0x03, 0x00, 0x00, 0x00};
+    static const uint8_t datetime[] = {24, 3, 15, 12, 34, 56, 5};
+    static const uint8_t diag_select[] = {0};
+    static const uint8_t other[] = {0};
+    uint16_t handle = ble_sim_chr_by_index(index);
+
+    switch (index)
+    {
+    case 0:
+        return ble_sim_write(conn, handle, get_status, sizeof(get_status));
+    case 2:
+        return ble_sim_write(conn, handle, datetime, sizeof(datetime));
+    case 5:
+        return ble_sim_write(conn, handle, diag_select, sizeof(diag_select));
+    default:
+        return ble_sim_write(conn, handle, other, sizeof(other));
+    }
+}
+
+static void check_rc(const trace_rec_t *rec, int rc, bool quiet)
+{
+    if (rc != RC(rec->value))
+    {
+        mismatches++;
+        if (!quiet)
+            printf("%26s replay: rc=%d (gravado %u)\n", "", rc, RC(rec->value));
+    }
+}
+
+static void replay_rec(const trace_rec_t *rec, bool quiet)
+{
+    uint16_t conn = sim_conn(rec->conn_handle);
+    uint8_t buf[BLE_ATT_ATTR_MAX_LEN];
+    int rc;
+
+    switch (rec->type)
+    {
+    case BLE_SERVER_TRACE_GAP:
+        switch (rec->sub)
+        {
+        case BLE_GAP_EVENT_CONNECT:
+            if (rec->value == 0 && rec->conn_handle < MAX_TRACE_CONNS)
+            {
+                ble_sim_peer_t peer = {.id_addr = {BLE_ADDR_PUBLIC, {(uint8_t)rec->conn_handle, 0x5e, 0x1d, 0x00, 0x00, 0xc0}}};
+
+                conn_map[rec->conn_handle] = ble_sim_connect(&peer);
+                if (conn_map[rec->conn_handle] == BLE_SIM_NO_CONN)
+                {
+                    refused++;
+                    if (!quiet)
+                        printf("%26s replay: conexão recusada (sem advertising)\n", "");
+                }
+            }
+            break;
+        case BLE_GAP_EVENT_DISCONNECT:
+            if (conn != BLE_SIM_NO_CONN)
+            {
+                ble_sim_disconnect(conn, (int)rec->value);
+                conn_map[rec->conn_handle] = BLE_SIM_NO_CONN;
+            }
+            break;
+        case BLE_GAP_EVENT_MTU:
+            if (conn != BLE_SIM_NO_CONN)
+                ble_sim_mtu(conn, (uint16_t)rec->value);
+            break;
+        case BLE_GAP_EVENT_ENC_CHANGE:
+            if (conn != BLE_SIM_NO_CONN && rec->value == 0)
+                ble_sim_encrypt(conn, true);
+            break;
+        case BLE_GAP_EVENT_SUBSCRIBE:
+            // O trace não guarda o atributo: Status é a única com notify
+            if (conn != BLE_SIM_NO_CONN)
+                ble_sim_subscribe(conn, ble_sim_chr_by_index(1), rec->value != 0);
+            break;
+        default:
+            break; // Produzidos pelo servidor ou pelo controlador
+        }
+        break;
+
+    case BLE_SERVER_TRACE_READ:
+        if (conn == BLE_SIM_NO_CONN || ble_sim_chr_by_index(rec->sub) == 0)
+        {
+            skipped++;
+            break;
+        }
+        rc = ble_sim_read(conn, ble_sim_chr_by_index(rec->sub), 0, buf, sizeof(buf));
+        check_rc(rec, rc < 0 ? -rc : 0, quiet);
+        break;
+
+    case BLE_SERVER_TRACE_WRITE:
+        if (conn == BLE_SIM_NO_CONN || ble_sim_chr_by_index(rec->sub) == 0)
+        {
+            skipped++;
+            break;
+        }
+        check_rc(rec, replay_write(conn, rec->sub), quiet);
+        break;
+
+    case BLE_SERVER_TRACE_RESET:
+        ble_sim_host_reset((int)rec->value);
+        ble_sim_run(0);
+        ble_sim_sync();
+        for (int i = 0; i < MAX_TRACE_CONNS; i++)
+            conn_map[i] = BLE_SIM_NO_CONN;
+        break;
+
+    default:
+        break; // Notificações e callbacks: saída do servidor
+    }
+}
+
+// ===== Comparação =====
+
+typedef struct
+{
+    uint32_t n;
+    uint64_t sum;
+    uint32_t max;
+} dur_stats_t;
+
+// Chave: tipo e sub (GAP fica de fora: não tem duração)
+static dur_stats_t recorded[8][256];
+static dur_stats_t replayed[8][256];
+
+static void accumulate(dur_stats_t table[8][256], const trace_rec_t *rec)
+{
+    if (rec->type < BLE_SERVER_TRACE_READ || rec->type > BLE_SERVER_TRACE_APP_CB)
+    {
+        return;
+    }
+
+    dur_stats_t *s = &table[rec->type][rec->sub];
+    uint32_t us = DURATION(rec->value);
+    s->n++;
+    s->sum += us;
+    if (us > s->max)
+        s->max = us;
+}
+
+static void print_compare(void)
+{
+    static const char *const type_names[] = {"", "", "read", "write", "notify", "app"};
+
+    // Cabeçalho alinhado à mão: printf conta bytes, não caracteres acentuados
+    printf("\n%s\n", "duração (us)              campo      média        máx | replay      média        máx");
+    for (int t = BLE_SERVER_TRACE_READ; t <= BLE_SERVER_TRACE_APP_CB; t++)
+    {
+        for (int sub = 0; sub < 256; sub++)
+        {
+            const dur_stats_t *a = &recorded[t][sub];
+            const dur_stats_t *b = &replayed[t][sub];
+            char name[32];
+            char what[16];
+
+            if (a->n == 0 && b->n == 0)
+                continue;
+
+            if (t == BLE_SERVER_TRACE_APP_CB)
+                snprintf(what, sizeof(what), "%s", sub < CB_COUNT ? cb_names[sub] : "?");
+            else if (t == BLE_SERVER_TRACE_NOTIFY)
+                snprintf(what, sizeof(what), "%s", sub ? "direta" : "fila");
+            else
+                chr_name((uint8_t)sub, what, sizeof(what));
+            snprintf(name, sizeof(name), "%s %s", type_names[t], what);
+
+            printf("%-24s %6u %10.0f %10u | %6u %10.0f %10u\n", name, (unsigned)a->n,
+                   a->n ? (double)a->sum / a->n : 0.0, (unsigned)a->max, (unsigned)b->n,
+                   b->n ? (double)b->sum / b->n : 0.0, (unsigned)b->max);
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    const char *path = NULL;
+    bool check = false;
+    bool quiet = false;
+    uint32_t lost = 0;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--check") == 0)
+            check = true;
+        else if (strcmp(argv[i], "--quiet") == 0)
+            quiet = true;
+        else
+            path = argv[i];
+    }
+    if (path == NULL)
+    {
+        fprintf(stderr, "uso: %s [--check] [--quiet] <log da serial>\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    if (load_dump(path, &lost) <= 0)
+    {
+        return EXIT_FAILURE;
+    }
+
+    uint32_t t0 = recs[0].time_us;
+    printf("%d registros, %lu perdidos no dispositivo, %.3f s de trace\n", rec_count, (unsigned long)lost,
+           (double)(uint32_t)(recs[rec_count - 1].time_us - t0) / 1e6);
+
+    ble_server_config_t config = {
+        .device_name = "Replay",
+        .on_write = replay_on_write,
+        .on_connect = replay_on_connect,
+        .on_disconnect = replay_on_disconnect,
+        .async_commands = true, // Como a aplicação em src/main.c
+    };
+
+    for (int i = 0; i < MAX_TRACE_CONNS; i++)
+        conn_map[i] = BLE_SIM_NO_CONN;
+    ble_sim_init();
+    if (ble_server_init(&config) != ESP_OK)
+    {
+        return EXIT_FAILURE;
+    }
+    ble_sim_sync();
+    ble_sim_run(0);
+    ble_server_trace_clear();
+
+    // Cada registro acontece no mesmo deslocamento desde o início do trace;
+    // o tempo real gasto pelos callbacks já conta no relógio do simulador
+    int64_t start = esp_timer_get_time();
+    for (int i = 0; i < rec_count; i++)
+    {
+        int64_t due = start + (uint32_t)(recs[i].time_us - t0);
+        int64_t now = esp_timer_get_time();
+
+        ble_sim_wait(cmd_idle, NULL, 10000);
+        if (due > now)
+            ble_sim_run((uint32_t)((due - now) / 1000));
+        if (!quiet)
+            print_rec(&recs[i], t0);
+        replay_rec(&recs[i], quiet);
+        accumulate(recorded, &recs[i]);
+    }
+    ble_sim_wait(cmd_idle, NULL, 10000);
+    ble_sim_run(100);
+
+    static ble_server_trace_rec_t out[CONFIG_BLE_SERVER_TRACE_RECORDS];
+    uint32_t replay_lost;
+    int n = ble_server_trace_read(out, CONFIG_BLE_SERVER_TRACE_RECORDS, &replay_lost);
+    for (int i = 0; i < n; i++)
+    {
+        trace_rec_t rec = {out[i].time_us, out[i].type, out[i].sub, out[i].conn_handle, out[i].value};
+        accumulate(replayed, &rec);
+    }
+    print_compare();
+
+    printf("\nreplay: %d códigos diferentes do gravado, %d conexões recusadas, %d acessos sem conexão%s\n",
+           mismatches, refused, skipped, replay_lost ? " (trace do replay transbordou)" : "");
+    if (check && (mismatches || refused))
+    {
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,326 @@
+// test/host/fuzz_cmd_proto.c
+// Fuzz do protocolo binário de comandos (ble_cmd_proto.c) na mesma
+// sequência do on_ble_write() da aplicação: texto vai para o legado, frame
+// válido é despachado, malformado recebe BAD_FRAME. Cada entrada confere as
+// invariantes da resposta.
+//
+// Com -DBLE_FUZZ_LIBFUZZER=ON (clang) vira alvo do libFuzzer:
+//   fuzz_cmd_proto corpus/cmd_proto
+// Sem libFuzzer, main() repete o corpus e depois mutações determinísticas
+// dele (xorshift com semente fixa), sob ASan/UBSan quando disponíveis:
+//   fuzz_cmd_proto [--iterations N] <diretório ou arquivo>...
+#include "ble_cmd_proto.h"
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define FUZZ_MAX_INPUT 600 // Maior que o valor de uma characteristic (512)
+
+#define FUZZ_CHECK(cond)                                                          \
+    do                                                                            \
+    {                                                                             \
+        if (!(cond))                                                              \
+        {                                                                         \
+            fprintf(stderr, "invariante violada %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+            abort();                                                              \
+        }                                                                         \
+    } while (0)
+
+// ===== Tabela de teste =====
+// Opcodes da aplicação (sem payload) e outros que exercitam payload, resposta
+// longa demais e status de erro do handler
+
+static ble_cmd_status_t handler_state(const ble_cmd_frame_t *req, ble_cmd_resp_t *resp, void *arg)
+{
+    resp->payload[0] = req->opcode & 1;
+    resp->len = 1;
+    return BLE_CMD_STATUS_OK;
+}
+
+static ble_cmd_status_t handler_echo(const ble_cmd_frame_t *req, ble_cmd_resp_t *resp, void *arg)
+{
+    memcpy(resp->payload, req->payload, req->len);
+    resp->len = (uint8_t)req->len;
+    return BLE_CMD_STATUS_OK;
+}
+
+static ble_cmd_status_t handler_overflow(const ble_cmd_frame_t *req, ble_cmd_resp_t *resp, void *arg)
+{
+    resp->len = BLE_CMD_RESP_MAX_PAYLOAD + 1;
+    return BLE_CMD_STATUS_OK;
+}
+
+static ble_cmd_status_t handler_busy(const ble_cmd_frame_t *req, ble_cmd_resp_t *resp, void *arg)
+{
+    // Lê o payload inteiro: ASan acusa se o parser apontar para fora
+    uint8_t sum = 0;
+    for (uint16_t i = 0; i < req->len; i++)
+    {
+        sum ^= req->payload[i];
+    }
+    resp->payload[0] = sum;
+    resp->len = 1;
+    return BLE_CMD_STATUS_BUSY;
+}
+
+static const ble_cmd_def_t defs[] = {
+    {.opcode = 0x01, .min_len = 0, .max_len = 0, .handler = handler_state},
+    {.opcode = 0x02, .min_len = 0, .max_len = 0, .handler = handler_state},
+    {.opcode = 0x03, .min_len = 0, .max_len = 0, .handler = handler_state},
+    {.opcode = 0x10, .min_len = 1, .max_len = BLE_CMD_RESP_MAX_PAYLOAD, .handler = handler_echo},
+    {.opcode = 0x11, .min_len = 0, .max_len = 4, .handler = handler_overflow},
+    {.opcode = 0x12, .min_len = 0, .max_len = 512, .handler = handler_busy},
+};
+
+static ble_cmd_table_t table;
+static unsigned long status_count[8];
+static unsigned long text_count;
+
+static const ble_cmd_def_t *def_find(uint8_t opcode)
+{
+    for (size_t i = 0; i < sizeof(defs) / sizeof(defs[0]); i++)
+    {
+        if (defs[i].opcode == opcode)
+        {
+            return &defs[i];
+        }
+    }
+    return NULL;
+}
+
+static void fuzz_one(const uint8_t *data, size_t size)
+{
+    ble_cmd_frame_t frame;
+    uint8_t resp[BLE_CMD_RESP_MAX_LEN];
+    size_t resp_len;
+
+    if (table.defs == NULL)
+    {
+        FUZZ_CHECK(ble_cmd_table_init(&table, defs, sizeof(defs) / sizeof(defs[0]), NULL) == 0);
+    }
+
+    if (ble_cmd_is_text(data, size))
+    {
+        // Texto declara len >= 0x2020: nunca é um frame válido desse tamanho
+        FUZZ_CHECK(size >= 0x2024 || ble_cmd_frame_parse(data, size, &frame) != BLE_CMD_STATUS_OK);
+        text_count++;
+        return;
+    }
+
+    if (ble_cmd_frame_parse(data, size, &frame) == BLE_CMD_STATUS_OK)
+    {
+        FUZZ_CHECK(size >= BLE_CMD_HDR_LEN);
+        FUZZ_CHECK((size_t)frame.len + BLE_CMD_HDR_LEN == size);
+        FUZZ_CHECK(frame.payload == data + BLE_CMD_HDR_LEN);
+        FUZZ_CHECK(!(frame.opcode & BLE_CMD_RESP_FLAG));
+
+        resp_len = ble_cmd_dispatch(&table, &frame, resp, sizeof(resp));
+        FUZZ_CHECK(resp_len >= BLE_CMD_RESP_HDR_LEN && resp_len <= BLE_CMD_RESP_MAX_LEN);
+        FUZZ_CHECK(resp[0] == (frame.opcode | BLE_CMD_RESP_FLAG));
+        FUZZ_CHECK(resp[1] == frame.seq);
+        FUZZ_CHECK(resp[3] == resp_len - BLE_CMD_RESP_HDR_LEN);
+
+        const ble_cmd_def_t *def = def_find(frame.opcode);
+        if (def == NULL)
+        {
+            FUZZ_CHECK(resp[2] == BLE_CMD_STATUS_UNKNOWN_OPCODE && resp[3] == 0);
+        }
+        else if (frame.len < def->min_len || frame.len > def->max_len)
+        {
+            FUZZ_CHECK(resp[2] == BLE_CMD_STATUS_BAD_LENGTH && resp[3] == 0);
+        }
+        else if (def->handler == handler_overflow)
+        {
+            FUZZ_CHECK(resp[2] == BLE_CMD_STATUS_FAILED && resp[3] == 0);
+        }
+        else if (def->handler == handler_echo)
+        {
+            FUZZ_CHECK(resp[2] == BLE_CMD_STATUS_OK && resp[3] == frame.len);
+            FUZZ_CHECK(memcmp(&resp[4], frame.payload, frame.len) == 0);
+        }
+
+        // Sem espaço para o cabeçalho nada é escrito
+        FUZZ_CHECK(ble_cmd_dispatch(&table, &frame, resp, BLE_CMD_RESP_HDR_LEN - 1) == 0);
+    }
+    else
+    {
+        resp_len = ble_cmd_resp_bad_frame(data, size, resp, sizeof(resp));
+        FUZZ_CHECK(resp_len == BLE_CMD_RESP_HDR_LEN);
+        FUZZ_CHECK(resp[0] == ((size > 0 ? data[0] : 0) | BLE_CMD_RESP_FLAG));
+        FUZZ_CHECK(resp[1] == (size > 1 ? data[1] : 0));
+        FUZZ_CHECK(resp[2] == BLE_CMD_STATUS_BAD_FRAME && resp[3] == 0);
+    }
+
+    status_count[resp[2] & 7]++;
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    fuzz_one(data, size);
+    return 0;
+}
+
+#ifndef BLE_FUZZ_LIBFUZZER
+
+// ===== Repetição do corpus e mutações =====
+
+#define CORPUS_MAX 256
+
+typedef struct
+{
+    uint8_t data[FUZZ_MAX_INPUT];
+    size_t len;
+} corpus_entry_t;
+
+static corpus_entry_t corpus[CORPUS_MAX];
+static int corpus_count;
+static uint32_t rnd = 0x9E3779B9;
+
+static uint32_t next_rand(void)
+{
+    rnd ^= rnd << 13;
+    rnd ^= rnd >> 17;
+    rnd ^= rnd << 5;
+    return rnd;
+}
+
+static void load_file(const char *path)
+{
+    FILE *f = fopen(path, "rb");
+
+    if (f == NULL || corpus_count == CORPUS_MAX)
+    {
+        if (f)
+            fclose(f);
+        return;
+    }
+    corpus[corpus_count].len = fread(corpus[corpus_count].data, 1, FUZZ_MAX_INPUT, f);
+    fclose(f);
+    corpus_count++;
+}
+
+static void load_path(const char *path)
+{
+    DIR *dir = opendir(path);
+
+    if (dir == NULL)
+    {
+        load_file(path);
+        return;
+    }
+
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL)
+    {
+        char file[1024];
+
+        if (entry->d_name[0] == '.')
+        {
+            continue;
+        }
+        snprintf(file, sizeof(file), "%s/%s", path, entry->d_name);
+        load_file(file);
+    }
+    closedir(dir);
+}
+
+// Mutação no estilo do libFuzzer; às vezes corrige o len do cabeçalho para
+// a entrada passar do parser e chegar ao despacho
+static size_t mutate(uint8_t *buf, size_t len)
+{
+    int rounds = 1 + next_rand() % 4;
+
+    for (int r = 0; r < rounds; r++)
+    {
+        uint32_t pos = len ? next_rand() % len : 0;
+
+        switch (next_rand() % 7)
+        {
+        case 0:
+            if (len)
+                buf[pos] ^= (uint8_t)(1u << (next_rand() % 8));
+            break;
+        case 1:
+            if (len)
+                buf[pos] = (uint8_t)next_rand();
+            break;
+        case 2:
+            len = len ? next_rand() % len : 0;
+            break;
+        case 3:
+            if (len < FUZZ_MAX_INPUT)
+            {
+                memmove(&buf[pos + 1], &buf[pos], len - pos);
+                buf[pos] = (uint8_t)next_rand();
+                len++;
+            }
+            break;
+        case 4:
+        {
+            size_t extra = next_rand() % 64;
+            if (len + extra > FUZZ_MAX_INPUT)
+                extra = FUZZ_MAX_INPUT - len;
+            for (size_t i = 0; i < extra; i++)
+                buf[len + i] = (uint8_t)next_rand();
+            len += extra;
+            break;
+        }
+        case 5:
+            if (len >= BLE_CMD_HDR_LEN)
+            {
+                buf[2] = (uint8_t)(len - BLE_CMD_HDR_LEN);
+                buf[3] = (uint8_t)((len - BLE_CMD_HDR_LEN) >> 8);
+            }
+            break;
+        default:
+            if (len)
+                buf[0] = (uint8_t)(next_rand() % 0x14);
+            break;
+        }
+    }
+    return len;
+}
+
+int main(int argc, char **argv)
+{
+    long iterations = 200000;
+    uint8_t buf[FUZZ_MAX_INPUT];
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--iterations") == 0 && i + 1 < argc)
+            iterations = strtol(argv[++i], NULL, 0);
+        else
+            load_path(argv[i]);
+    }
+    if (corpus_count == 0)
+    {
+        fprintf(stderr, "uso: %s [--iterations N] <corpus>...\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    for (int i = 0; i < corpus_count; i++)
+    {
+        fuzz_one(corpus[i].data, corpus[i].len);
+    }
+
+    for (long n = 0; n < iterations; n++)
+    {
+        const corpus_entry_t *seed = &corpus[next_rand() % corpus_count];
+
+        memcpy(buf, seed->data, seed->len);
+        size_t len = mutate(buf, seed->len);
+        fuzz_one(buf, len);
+    }
+
+    printf("corpus=%d mutações=%ld texto=%lu ok=%lu bad_frame=%lu unknown=%lu bad_length=%lu "
+           "failed=%lu busy=%lu\n",
+           corpus_count, iterations, text_count,
+           status_count[BLE_CMD_STATUS_OK], status_count[BLE_CMD_STATUS_BAD_FRAME],
+           status_count[BLE_CMD_STATUS_UNKNOWN_OPCODE], status_count[BLE_CMD_STATUS_BAD_LENGTH],
+           status_count[BLE_CMD_STATUS_FAILED], status_count[BLE_CMD_STATUS_BUSY]);
+    return EXIT_SUCCESS;
+}
+
+#endif
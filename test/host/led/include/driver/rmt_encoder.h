@@ -0,0 +1,12 @@
+// test/host/led/include/driver/rmt_encoder.h
+// O encoder do led_strip não é compilado no host: rmt_new_led_strip_encoder()
+// está em led/led_fake.c e devolve um handle vazio
+#ifndef DRIVER_RMT_ENCODER_H
+#define DRIVER_RMT_ENCODER_H
+
+#include "driver/rmt_types.h"
+#include "esp_err.h"
+
+esp_err_t rmt_del_encoder(rmt_encoder_handle_t encoder);
+
+#endif
@@ -0,0 +1,47 @@
+// test/host/led/include/driver/rmt_tx.h
+// Subconjunto do canal TX do RMT usado pelo backend RMT do led_strip. As
+// funções estão em led/led_fake.c: rmt_transmit() guarda o buffer e termina
+// na hora, chamando on_trans_done se registrado.
+#ifndef DRIVER_RMT_TX_H
+#define DRIVER_RMT_TX_H
+
+#include "driver/rmt_encoder.h"
+#include "driver/rmt_types.h"
+#include "esp_bit_defs.h"
+#include "esp_err.h"
+
+typedef struct
+{
+    int gpio_num;
+    rmt_clock_source_t clk_src;
+    uint32_t resolution_hz;
+    size_t mem_block_symbols;
+    size_t trans_queue_depth;
+    struct
+    {
+        uint32_t invert_out : 1;
+        uint32_t with_dma : 1;
+    } flags;
+} rmt_tx_channel_config_t;
+
+typedef struct
+{
+    int loop_count;
+} rmt_transmit_config_t;
+
+typedef struct
+{
+    rmt_tx_done_callback_t on_trans_done;
+} rmt_tx_event_callbacks_t;
+
+esp_err_t rmt_new_tx_channel(const rmt_tx_channel_config_t *config, rmt_channel_handle_t *ret_chan);
+esp_err_t rmt_del_channel(rmt_channel_handle_t channel);
+esp_err_t rmt_enable(rmt_channel_handle_t channel);
+esp_err_t rmt_disable(rmt_channel_handle_t channel);
+esp_err_t rmt_transmit(rmt_channel_handle_t tx_channel, rmt_encoder_handle_t encoder, const void *payload,
+                       size_t payload_bytes, const rmt_transmit_config_t *config);
+esp_err_t rmt_tx_wait_all_done(rmt_channel_handle_t tx_channel, int timeout_ms);
+esp_err_t rmt_tx_register_event_callbacks(rmt_channel_handle_t tx_channel, const rmt_tx_event_callbacks_t *cbs,
+                                          void *user_data);
+
+#endif
@@ -0,0 +1,24 @@
+// test/host/led/include/driver/rmt_types.h
+// Tipos do driver RMT citados em led_strip_rmt.h e no backend RMT
+#ifndef DRIVER_RMT_TYPES_H
+#define DRIVER_RMT_TYPES_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef int rmt_clock_source_t;
+#define RMT_CLK_SRC_DEFAULT 1
+
+typedef struct rmt_channel_t *rmt_channel_handle_t;
+typedef struct rmt_encoder_t *rmt_encoder_handle_t;
+
+typedef struct
+{
+    size_t num_symbols;
+} rmt_tx_done_event_data_t;
+
+typedef bool (*rmt_tx_done_callback_t)(rmt_channel_handle_t tx_chan, const rmt_tx_done_event_data_t *edata,
+                                       void *user_ctx);
+
+#endif
@@ -0,0 +1,68 @@
+// test/host/led/include/driver/spi_master.h
+// Subconjunto do driver SPI usado pelo backend SPI do led_strip. As funções
+// estão em led/led_fake.c e guardam a última transmissão. BIT() chega por
+// aqui como pelos headers hal/soc do ESP-IDF.
+#ifndef DRIVER_SPI_MASTER_H
+#define DRIVER_SPI_MASTER_H
+
+#include "esp_bit_defs.h"
+#include "esp_err.h"
+#include <stddef.h>
+#include <stdint.h>
+
+typedef enum
+{
+    SPI1_HOST,
+    SPI2_HOST,
+    SPI3_HOST,
+} spi_host_device_t;
+
+typedef int spi_clock_source_t;
+#define SPI_CLK_SRC_DEFAULT 1
+
+typedef enum
+{
+    SPI_DMA_DISABLED,
+    SPI_DMA_CH_AUTO = 3,
+} spi_common_dma_t;
+
+typedef struct spi_device_t *spi_device_handle_t;
+
+typedef struct
+{
+    int mosi_io_num;
+    int miso_io_num;
+    int sclk_io_num;
+    int quadwp_io_num;
+    int quadhd_io_num;
+    int max_transfer_sz;
+} spi_bus_config_t;
+
+typedef struct
+{
+    spi_clock_source_t clock_source;
+    uint8_t command_bits;
+    uint8_t address_bits;
+    uint8_t dummy_bits;
+    int clock_speed_hz;
+    uint8_t mode;
+    int spics_io_num;
+    int queue_size;
+} spi_device_interface_config_t;
+
+typedef struct
+{
+    size_t length; // Bits
+    const void *tx_buffer;
+    void *rx_buffer;
+} spi_transaction_t;
+
+esp_err_t spi_bus_initialize(spi_host_device_t host, const spi_bus_config_t *config, spi_common_dma_t dma);
+esp_err_t spi_bus_free(spi_host_device_t host);
+esp_err_t spi_bus_add_device(spi_host_device_t host, const spi_device_interface_config_t *config,
+                             spi_device_handle_t *handle);
+esp_err_t spi_bus_remove_device(spi_device_handle_t handle);
+esp_err_t spi_device_get_actual_freq(spi_device_handle_t handle, int *freq_khz);
+esp_err_t spi_device_transmit(spi_device_handle_t handle, spi_transaction_t *trans);
+
+#endif
@@ -0,0 +1,15 @@
+// test/host/led/include/esp_attr.h
+// Atributos de seção do ESP-IDF: no host tudo fica na RAM comum
+#ifndef ESP_ATTR_H
+#define ESP_ATTR_H
+
+#define IRAM_ATTR
+#define DRAM_ATTR
+
+// O newlib do ESP-IDF define __containerof em sys/cdefs.h; a glibc não
+#ifndef __containerof
+#include <stddef.h>
+#define __containerof(ptr, type, member) ((type *)((char *)(ptr) - offsetof(type, member)))
+#endif
+
+#endif
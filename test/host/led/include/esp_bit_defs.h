@@ -0,0 +1,7 @@
+// test/host/led/include/esp_bit_defs.h
+#ifndef ESP_BIT_DEFS_H
+#define ESP_BIT_DEFS_H
+
+#define BIT(nr) (1UL << (nr))
+
+#endif
@@ -0,0 +1,9 @@
+// test/host/led/include/esp_idf_version.h
+#ifndef ESP_IDF_VERSION_H
+#define ESP_IDF_VERSION_H
+
+#define ESP_IDF_VERSION_MAJOR 5
+#define ESP_IDF_VERSION_MINOR 5
+#define ESP_IDF_VERSION_PATCH 0
+
+#endif
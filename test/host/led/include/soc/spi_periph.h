@@ -0,0 +1,14 @@
+// test/host/led/include/soc/spi_periph.h
+#ifndef SOC_SPI_PERIPH_H
+#define SOC_SPI_PERIPH_H
+
+#include <stdint.h>
+
+typedef struct
+{
+    uint32_t spid_out;
+} spi_signal_conn_t;
+
+extern const spi_signal_conn_t spi_periph_signal[3];
+
+#endif
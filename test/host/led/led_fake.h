@@ -0,0 +1,16 @@
+// test/host/led/led_fake.h
+// Fakes dos drivers usados pelo componente led_strip no host (led_fake.c).
+// Cada transmissão só é registrada: o teste lê o buffer que iria para o fio.
+#ifndef LED_FAKE_H
+#define LED_FAKE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Último buffer passado a spi_device_transmit() e seu tamanho em bytes
+const uint8_t *led_fake_spi_last_tx(size_t *len);
+
+// Último buffer de pixels passado a rmt_transmit() e seu tamanho em bytes
+const uint8_t *led_fake_rmt_last_tx(size_t *len);
+
+#endif
@@ -0,0 +1,1709 @@
+// test/host/sim/ble_sim.c
+// Host NimBLE simulado: GAP (advertising, conexões, segurança), GATT server
+// com tabela de atributos indexada por handle, notificações passando por um
+// "controlador" que segura os mbufs até transmitir, store de bonds, NPL e
+// port. Estado protegido pela seção crítica global; callbacks do servidor
+// nunca rodam com ela presa.
+#include "ble_sim.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "host/ble_hs.h"
+#include "host/util/util.h"
+#include "nimble/nimble_port.h"
+#include "nimble/nimble_port_freertos.h"
+#include "services/gap/ble_svc_gap.h"
+#include "services/gatt/ble_svc_gatt.h"
+#include "sim_internal.h"
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#define SIM_MAX_ATTRS 512
+#define SIM_FIRST_HANDLE 0x10
+#define SIM_MAX_INFLIGHT 64
+#define SIM_MAX_BONDS CONFIG_BT_NIMBLE_MAX_BONDS
+#define SIM_MAX_CONNS CONFIG_BT_NIMBLE_MAX_CONNECTIONS
+
+typedef enum
+{
+    ATTR_NONE = 0,
+    ATTR_SVC,
+    ATTR_CHR_DECL,
+    ATTR_CHR_VAL,
+    ATTR_CCCD,
+} attr_type_t;
+
+typedef struct
+{
+    attr_type_t type;
+    const struct ble_gatt_chr_def *chr; // Characteristic (declaração, valor, CCCD)
+} sim_attr_t;
+
+typedef struct
+{
+    bool used;
+    struct ble_gap_conn_desc desc;
+    uint16_t mtu;
+    bool rpa;
+    ble_gap_event_fn *cb;
+    void *cb_arg;
+    bool update_pending; // CONN_UPDATE a entregar
+    bool phy_pending;    // PHY_UPDATE_COMPLETE a entregar
+    uint8_t phy;
+    uint8_t cccd[SIM_MAX_ATTRS]; // Bit 0 notify, bit 1 indicate (por handle do valor)
+} sim_conn_t;
+
+typedef struct
+{
+    uint16_t conn_handle;
+    uint16_t attr_handle;
+    struct os_mbuf *om;
+} sim_inflight_t;
+
+typedef struct
+{
+    ble_addr_t addr;
+    bool irk;
+} sim_bond_t;
+
+static sim_attr_t attrs[SIM_MAX_ATTRS];
+static uint16_t next_handle;
+
+static sim_conn_t conns[SIM_MAX_CONNS];
+static uint16_t next_conn_handle;
+
+static ble_sim_adv_t adv;
+static int64_t adv_expires_us; // INT64_MAX = sem duração
+static ble_gap_event_fn *adv_cb;
+static void *adv_cb_arg;
+
+static sim_inflight_t inflight[SIM_MAX_INFLIGHT];
+static int inflight_count;
+static bool tx_paused;
+static uint16_t rx_chunk;
+
+static ble_sim_notify_t notify_log[BLE_SIM_NOTIFY_LOG];
+static int notify_head;
+static int notify_count;
+
+static sim_bond_t bonds[SIM_MAX_BONDS];
+static int bond_count;
+
+static struct ble_npl_eventq dflt_eventq;
+static struct ble_npl_callout *callouts; // Callouts já iniciados
+static bool synced;
+static int infer_auto_failures;
+static int adv_start_failures;
+static bool port_stop;
+static char device_name[32];
+
+static ble_sim_stats_t stats;
+
+struct ble_hs_cfg ble_hs_cfg;
+
+static const uint8_t our_addr[6] = {0x01, 0x00, 0x00, 0xc3, 0x32, 0xe5};
+
+static int64_t min64(int64_t a, int64_t b)
+{
+    return a < b ? a : b;
+}
+
+static bool addr_eq(const ble_addr_t *a, const ble_addr_t *b)
+{
+    return a->type == b->type && memcmp(a->val, b->val, sizeof(a->val)) == 0;
+}
+
+// Busca sem lock (chamador segura a seção crítica)
+static sim_conn_t *conn_find_locked(uint16_t conn_handle)
+{
+    for (int i = 0; i < SIM_MAX_CONNS; i++)
+    {
+        if (conns[i].used && conns[i].desc.conn_handle == conn_handle)
+        {
+            return &conns[i];
+        }
+    }
+    return NULL;
+}
+
+static void conn_event(ble_gap_event_fn *cb, void *arg, struct ble_gap_event *event)
+{
+    if (cb)
+    {
+        cb(event, arg);
+    }
+}
+
+// ===== NPL =====
+
+void ble_npl_event_init(struct ble_npl_event *ev, ble_npl_event_fn *fn, void *arg)
+{
+    memset(ev, 0, sizeof(*ev));
+    ev->fn = fn;
+    ev->arg = arg;
+}
+
+void *ble_npl_event_get_arg(struct ble_npl_event *ev)
+{
+    return ev->arg;
+}
+
+void ble_npl_eventq_put(struct ble_npl_eventq *evq, struct ble_npl_event *ev)
+{
+    sim_critical_enter();
+    if (!ev->queued)
+    {
+        ev->queued = true;
+        TAILQ_INSERT_TAIL(&evq->head, ev, next);
+    }
+    sim_critical_exit();
+}
+
+static struct ble_npl_event *eventq_get(struct ble_npl_eventq *evq)
+{
+    struct ble_npl_event *ev;
+
+    sim_critical_enter();
+    ev = TAILQ_FIRST(&evq->head);
+    if (ev)
+    {
+        TAILQ_REMOVE(&evq->head, ev, next);
+        ev->queued = false;
+    }
+    sim_critical_exit();
+    return ev;
+}
+
+static void eventq_remove(struct ble_npl_eventq *evq, struct ble_npl_event *ev)
+{
+    if (ev->queued)
+    {
+        TAILQ_REMOVE(&evq->head, ev, next);
+        ev->queued = false;
+    }
+}
+
+void ble_npl_callout_init(struct ble_npl_callout *co, struct ble_npl_eventq *evq,
+                          ble_npl_event_fn *fn, void *arg)
+{
+    sim_critical_enter();
+    memset(co, 0, sizeof(*co));
+    ble_npl_event_init(&co->ev, fn, arg);
+    co->evq = evq;
+    sim_critical_exit();
+}
+
+static void callout_track_locked(struct ble_npl_callout *co)
+{
+    for (struct ble_npl_callout *c = callouts; c != NULL; c = c->next_callout)
+    {
+        if (c == co)
+        {
+            return;
+        }
+    }
+    co->next_callout = callouts;
+    callouts = co;
+}
+
+int ble_npl_callout_reset(struct ble_npl_callout *co, ble_npl_time_t ticks)
+{
+    sim_critical_enter();
+    callout_track_locked(co);
+    co->active = true;
+    co->expires_us = sim_clock_us() + (int64_t)ticks * 1000;
+    sim_critical_exit();
+    return 0;
+}
+
+void ble_npl_callout_stop(struct ble_npl_callout *co)
+{
+    sim_critical_enter();
+    co->active = false;
+    eventq_remove(co->evq, &co->ev);
+    sim_critical_exit();
+}
+
+bool ble_npl_callout_is_active(struct ble_npl_callout *co)
+{
+    return co->active;
+}
+
+ble_npl_time_t ble_npl_time_ms_to_ticks32(uint32_t ms)
+{
+    return ms;
+}
+
+// Callouts vencidos viram eventos na fila, como no NimBLE
+static int callouts_fire(int64_t now)
+{
+    int fired = 0;
+
+    sim_critical_enter();
+    for (struct ble_npl_callout *c = callouts; c != NULL; c = c->next_callout)
+    {
+        if (c->active && c->expires_us <= now)
+        {
+            c->active = false;
+            if (!c->ev.queued)
+            {
+                c->ev.queued = true;
+                TAILQ_INSERT_TAIL(&c->evq->head, &c->ev, next);
+            }
+            fired++;
+        }
+    }
+    sim_critical_exit();
+    return fired;
+}
+
+static int64_t callouts_next(void)
+{
+    int64_t next = INT64_MAX;
+
+    sim_critical_enter();
+    for (struct ble_npl_callout *c = callouts; c != NULL; c = c->next_callout)
+    {
+        if (c->active)
+            next = min64(next, c->expires_us);
+    }
+    sim_critical_exit();
+    return next;
+}
+
+// ===== Port =====
+
+esp_err_t nimble_port_init(void)
+{
+    return ESP_OK;
+}
+
+esp_err_t nimble_port_deinit(void)
+{
+    return ESP_OK;
+}
+
+// Não usado pelos testes (a task do host não é criada); mantido para quem
+// quiser rodar o host numa thread
+void nimble_port_run(void)
+{
+    port_stop = false;
+    while (!port_stop)
+    {
+        if (ble_sim_run(0) == 0)
+        {
+            vTaskDelay(1);
+        }
+    }
+}
+
+int nimble_port_stop(void)
+{
+    port_stop = true;
+    return 0;
+}
+
+struct ble_npl_eventq *nimble_port_get_dflt_eventq(void)
+{
+    return &dflt_eventq;
+}
+
+void nimble_port_freertos_init(TaskFunction_t host_task_fn)
+{
+}
+
+void nimble_port_freertos_deinit(void)
+{
+}
+
+// ===== Serviços padrão, identidade, store =====
+
+int ble_svc_gap_device_name_set(const char *name)
+{
+    if (strlen(name) >= sizeof(device_name))
+    {
+        return BLE_HS_EINVAL;
+    }
+    strcpy(device_name, name);
+    return 0;
+}
+
+const char *ble_svc_gap_device_name(void)
+{
+    return device_name;
+}
+
+void ble_svc_gap_init(void)
+{
+}
+
+void ble_svc_gatt_init(void)
+{
+}
+
+int ble_hs_synced(void)
+{
+    return synced;
+}
+
+int ble_hs_id_infer_auto(int privacy, uint8_t *out_addr_type)
+{
+    if (infer_auto_failures > 0)
+    {
+        infer_auto_failures--;
+        return BLE_HS_ENOADDR;
+    }
+    *out_addr_type = BLE_OWN_ADDR_PUBLIC;
+    return 0;
+}
+
+int ble_hs_id_copy_addr(uint8_t id_addr_type, uint8_t *out_id_addr, int *out_is_nrpa)
+{
+    if (id_addr_type != BLE_ADDR_PUBLIC)
+    {
+        return BLE_HS_ENOADDR;
+    }
+    if (out_id_addr)
+    {
+        memcpy(out_id_addr, our_addr, sizeof(our_addr));
+    }
+    if (out_is_nrpa)
+    {
+        *out_is_nrpa = 0;
+    }
+    return 0;
+}
+
+void ble_store_config_init(void)
+{
+}
+
+int ble_store_read_peer_sec(const struct ble_store_key_sec *key_sec, struct ble_store_value_sec *value_sec)
+{
+    int rc = BLE_HS_ENOENT;
+
+    sim_critical_enter();
+    for (int i = 0; i < bond_count; i++)
+    {
+        if (addr_eq(&bonds[i].addr, &key_sec->peer_addr))
+        {
+            memset(value_sec, 0, sizeof(*value_sec));
+            value_sec->peer_addr = bonds[i].addr;
+            value_sec->key_size = 16;
+            value_sec->ltk_present = 1;
+            value_sec->irk_present = bonds[i].irk;
+            rc = 0;
+            break;
+        }
+    }
+    sim_critical_exit();
+    return rc;
+}
+
+int ble_store_util_bonded_peers(ble_addr_t *out_peer_id_addrs, int *out_num_peers, int max_peers)
+{
+    int rc = 0;
+
+    sim_critical_enter();
+    if (bond_count > max_peers)
+    {
+        rc = BLE_HS_ENOMEM;
+    }
+    else
+    {
+        for (int i = 0; i < bond_count; i++)
+        {
+            out_peer_id_addrs[i] = bonds[i].addr;
+        }
+        *out_num_peers = bond_count;
+    }
+    sim_critical_exit();
+    return rc;
+}
+
+int ble_store_util_delete_peer(const ble_addr_t *peer_id_addr)
+{
+    int rc = BLE_HS_ENOENT;
+
+    sim_critical_enter();
+    for (int i = 0; i < bond_count; i++)
+    {
+        if (addr_eq(&bonds[i].addr, peer_id_addr))
+        {
+            bonds[i] = bonds[--bond_count];
+            rc = 0;
+            break;
+        }
+    }
+    sim_critical_exit();
+    return rc;
+}
+
+int ble_store_util_status_rr(struct ble_store_status_event *event, void *arg)
+{
+    return 0;
+}
+
+// ===== ATT / mbufs =====
+
+int ble_uuid_cmp(const ble_uuid_t *uuid1, const ble_uuid_t *uuid2)
+{
+    if (uuid1->type != uuid2->type)
+    {
+        return (int)uuid1->type - (int)uuid2->type;
+    }
+    if (uuid1->type == BLE_UUID_TYPE_16)
+    {
+        return (int)((const ble_uuid16_t *)uuid1)->value - (int)((const ble_uuid16_t *)uuid2)->value;
+    }
+    return memcmp(((const ble_uuid128_t *)uuid1)->value, ((const ble_uuid128_t *)uuid2)->value, 16);
+}
+
+uint16_t ble_att_mtu(uint16_t conn_handle)
+{
+    uint16_t mtu = 0;
+
+    sim_critical_enter();
+    sim_conn_t *conn = conn_find_locked(conn_handle);
+    if (conn)
+    {
+        mtu = conn->mtu;
+    }
+    sim_critical_exit();
+    return mtu;
+}
+
+struct os_mbuf *ble_hs_mbuf_from_flat(const void *buf, uint16_t len)
+{
+    struct os_mbuf *om = os_msys_get_pkthdr(len, 0);
+
+    if (om == NULL)
+    {
+        return NULL;
+    }
+    if (os_mbuf_append(om, buf, len) != 0)
+    {
+        os_mbuf_free_chain(om);
+        return NULL;
+    }
+    return om;
+}
+
+// ===== GATT server =====
+
+int ble_gatts_count_cfg(const struct ble_gatt_svc_def *defs)
+{
+    for (const struct ble_gatt_svc_def *svc = defs; svc->type != BLE_GATT_SVC_TYPE_END; svc++)
+    {
+        if (svc->uuid == NULL)
+        {
+            return BLE_HS_EINVAL;
+        }
+        for (const struct ble_gatt_chr_def *chr = svc->characteristics; chr && chr->uuid; chr++)
+        {
+            if (chr->access_cb == NULL)
+            {
+                return BLE_HS_EINVAL;
+            }
+        }
+    }
+    return 0;
+}
+
+static int attr_add(attr_type_t type, const struct ble_gatt_chr_def *chr)
+{
+    if (next_handle >= SIM_MAX_ATTRS)
+    {
+        return 0;
+    }
+    attrs[next_handle].type = type;
+    attrs[next_handle].chr = chr;
+    return next_handle++;
+}
+
+int ble_gatts_add_svcs(const struct ble_gatt_svc_def *svcs)
+{
+    for (const struct ble_gatt_svc_def *svc = svcs; svc->type != BLE_GATT_SVC_TYPE_END; svc++)
+    {
+        if (attr_add(ATTR_SVC, NULL) == 0)
+        {
+            return BLE_HS_ENOMEM;
+        }
+        for (const struct ble_gatt_chr_def *chr = svc->characteristics; chr && chr->uuid; chr++)
+        {
+            int val;
+
+            if (attr_add(ATTR_CHR_DECL, chr) == 0 || (val = attr_add(ATTR_CHR_VAL, chr)) == 0)
+            {
+                return BLE_HS_ENOMEM;
+            }
+            if (chr->val_handle)
+            {
+                *chr->val_handle = (uint16_t)val;
+            }
+            if ((chr->flags & (BLE_GATT_CHR_F_NOTIFY | BLE_GATT_CHR_F_INDICATE)) &&
+                attr_add(ATTR_CCCD, chr) == 0)
+            {
+                return BLE_HS_ENOMEM;
+            }
+        }
+    }
+    return 0;
+}
+
+static const sim_attr_t *attr_value(uint16_t handle)
+{
+    if (handle >= SIM_MAX_ATTRS || attrs[handle].type != ATTR_CHR_VAL)
+    {
+        return NULL;
+    }
+    return &attrs[handle];
+}
+
+uint16_t ble_sim_find_chr(const ble_uuid_t *uuid)
+{
+    for (uint16_t h = SIM_FIRST_HANDLE; h < next_handle; h++)
+    {
+        if (attrs[h].type == ATTR_CHR_VAL && ble_uuid_cmp(attrs[h].chr->uuid, uuid) == 0)
+        {
+            return h;
+        }
+    }
+    return 0;
+}
+
+uint16_t ble_sim_chr_by_index(int index)
+{
+    for (uint16_t h = SIM_FIRST_HANDLE; h < next_handle; h++)
+    {
+        if (attrs[h].type == ATTR_CHR_VAL && index-- == 0)
+        {
+            return h;
+        }
+    }
+    return 0;
+}
+
+// O mbuf é consumido mesmo em caso de erro; fica com o "controlador" até a
+// transmissão em ble_sim_run()
+int ble_gattc_notify_custom(uint16_t conn_handle, uint16_t att_handle, struct os_mbuf *om)
+{
+    int rc = 0;
+
+    sim_critical_enter();
+    if (conn_find_locked(conn_handle) == NULL)
+    {
+        rc = BLE_HS_ENOTCONN;
+    }
+    else if (inflight_count == SIM_MAX_INFLIGHT)
+    {
+        rc = BLE_HS_ENOMEM;
+    }
+    else
+    {
+        inflight[inflight_count].conn_handle = conn_handle;
+        inflight[inflight_count].attr_handle = att_handle;
+        inflight[inflight_count].om = om;
+        inflight_count++;
+        om = NULL;
+    }
+    sim_critical_exit();
+
+    if (om)
+    {
+        os_mbuf_free_chain(om);
+    }
+    return rc;
+}
+
+// Transmite o que está no "controlador": registra no log, libera os mbufs e
+// avisa a conexão com NOTIFY_TX
+static int inflight_transmit(void)
+{
+    int sent = 0;
+
+    while (!tx_paused)
+    {
+        sim_inflight_t item;
+        ble_gap_event_fn *cb = NULL;
+        void *cb_arg = NULL;
+
+        sim_critical_enter();
+        if (inflight_count == 0)
+        {
+            sim_critical_exit();
+            break;
+        }
+        item = inflight[0];
+        memmove(&inflight[0], &inflight[1], (inflight_count - 1) * sizeof(inflight[0]));
+        inflight_count--;
+
+        sim_conn_t *conn = conn_find_locked(item.conn_handle);
+        if (conn)
+        {
+            uint16_t len = OS_MBUF_PKTLEN(item.om);
+            if (len > conn->mtu - 3)
+                len = conn->mtu - 3;
+
+            int slot = (notify_head + notify_count) % BLE_SIM_NOTIFY_LOG;
+            if (notify_count == BLE_SIM_NOTIFY_LOG)
+            {
+                notify_head = (notify_head + 1) % BLE_SIM_NOTIFY_LOG;
+            }
+            else
+            {
+                notify_count++;
+            }
+            notify_log[slot].conn_handle = item.conn_handle;
+            notify_log[slot].attr_handle = item.attr_handle;
+            notify_log[slot].len = len;
+            os_mbuf_copydata(item.om, 0, len, notify_log[slot].data);
+
+            stats.notifies++;
+            stats.notify_bytes += len;
+            cb = conn->cb;
+            cb_arg = conn->cb_arg;
+        }
+        sim_critical_exit();
+
+        os_mbuf_free_chain(item.om);
+        sent++;
+
+        if (cb)
+        {
+            struct ble_gap_event event = {.type = BLE_GAP_EVENT_NOTIFY_TX};
+            event.notify_tx.status = 0;
+            event.notify_tx.conn_handle = item.conn_handle;
+            event.notify_tx.attr_handle = item.attr_handle;
+            cb(&event, cb_arg);
+        }
+    }
+    return sent;
+}
+
+// ===== GAP =====
+
+int ble_gap_adv_start(uint8_t own_addr_type, const ble_addr_t *direct_addr, int32_t duration_ms,
+                      const struct ble_gap_adv_params *adv_params, ble_gap_event_fn *cb, void *cb_arg)
+{
+    int rc = 0;
+
+    sim_critical_enter();
+    if (!synced)
+    {
+        rc = BLE_HS_ENOTSYNCED;
+    }
+    else if (adv.active)
+    {
+        rc = BLE_HS_EALREADY;
+    }
+    else if (adv_params->conn_mode == BLE_GAP_CONN_MODE_DIR && direct_addr == NULL)
+    {
+        rc = BLE_HS_EINVAL;
+    }
+    else if (adv_start_failures > 0)
+    {
+        adv_start_failures--;
+        rc = BLE_HS_ECONTROLLER;
+    }
+    else
+    {
+        adv.active = true;
+        adv.own_addr_type = own_addr_type;
+        adv.directed = adv_params->conn_mode == BLE_GAP_CONN_MODE_DIR;
+        if (adv.directed)
+            adv.peer = *direct_addr;
+        else
+            memset(&adv.peer, 0, sizeof(adv.peer));
+        adv.duration_ms = duration_ms;
+        adv.params = *adv_params;
+        adv_expires_us = duration_ms == BLE_HS_FOREVER ? INT64_MAX
+                                                       : sim_clock_us() + (int64_t)duration_ms * 1000;
+        adv_cb = cb;
+        adv_cb_arg = cb_arg;
+        stats.adv_starts++;
+    }
+    sim_critical_exit();
+    return rc;
+}
+
+int ble_gap_adv_stop(void)
+{
+    int rc = 0;
+
+    sim_critical_enter();
+    if (!adv.active)
+    {
+        rc = BLE_HS_EALREADY;
+    }
+    adv.active = false;
+    sim_critical_exit();
+    return rc;
+}
+
+int ble_gap_adv_active(void)
+{
+    return adv.active;
+}
+
+int ble_gap_adv_set_data(const uint8_t *data, int data_len)
+{
+    if (data_len > BLE_HS_ADV_MAX_SZ)
+    {
+        return BLE_HS_EMSGSIZE;
+    }
+    sim_critical_enter();
+    memcpy(adv.adv_data, data, data_len);
+    adv.adv_len = (uint8_t)data_len;
+    sim_critical_exit();
+    return 0;
+}
+
+int ble_gap_adv_rsp_set_data(const uint8_t *data, int data_len)
+{
+    if (data_len > BLE_HS_ADV_MAX_SZ)
+    {
+        return BLE_HS_EMSGSIZE;
+    }
+    sim_critical_enter();
+    memcpy(adv.rsp_data, data, data_len);
+    adv.rsp_len = (uint8_t)data_len;
+    sim_critical_exit();
+    return 0;
+}
+
+#if CONFIG_BT_NIMBLE_EXT_ADV
+// Advertising estendido: só o set 0 (conectável) é simulado, sobre o mesmo
+// estado do legado. Como no NimBLE, um set de PDUs legados direcionado não
+// aceita dados nem scan response, e só um set escaneável aceita esta.
+static struct ble_gap_ext_adv_params ext_params;
+static bool ext_configured;
+static ble_gap_event_fn *ext_cb;
+static void *ext_cb_arg;
+
+int ble_gap_ext_adv_configure(uint8_t instance, const struct ble_gap_ext_adv_params *params,
+                              int8_t *selected_tx_power, ble_gap_event_fn *cb, void *cb_arg)
+{
+    int rc = 0;
+
+    sim_critical_enter();
+    if (instance != 0)
+    {
+        rc = BLE_HS_EINVAL;
+    }
+    else if (adv.active)
+    {
+        rc = BLE_HS_EBUSY;
+    }
+    else
+    {
+        ext_params = *params;
+        ext_configured = true;
+        ext_cb = cb;
+        ext_cb_arg = cb_arg;
+    }
+    sim_critical_exit();
+
+    if (selected_tx_power)
+    {
+        *selected_tx_power = 0;
+    }
+    return rc;
+}
+
+static int ext_adv_set_data(uint8_t instance, struct os_mbuf *data, bool rsp)
+{
+    int len = OS_MBUF_PKTLEN(data);
+    int rc = 0;
+
+    sim_critical_enter();
+    if (instance != 0 || !ext_configured)
+    {
+        rc = BLE_HS_EINVAL;
+    }
+    else if ((ext_params.legacy_pdu && ext_params.directed) || (rsp && !ext_params.scannable))
+    {
+        rc = BLE_HS_EINVAL;
+    }
+    else if (len > BLE_HS_ADV_MAX_SZ)
+    {
+        rc = BLE_HS_EINVAL;
+    }
+    else if (rsp)
+    {
+        os_mbuf_copydata(data, 0, len, adv.rsp_data);
+        adv.rsp_len = (uint8_t)len;
+    }
+    else
+    {
+        os_mbuf_copydata(data, 0, len, adv.adv_data);
+        adv.adv_len = (uint8_t)len;
+    }
+    if (rc != 0)
+    {
+        stats.adv_data_rejected++;
+    }
+    sim_critical_exit();
+
+    // O mbuf é consumido mesmo em caso de erro
+    os_mbuf_free_chain(data);
+    return rc;
+}
+
+int ble_gap_ext_adv_set_data(uint8_t instance, struct os_mbuf *data)
+{
+    return ext_adv_set_data(instance, data, false);
+}
+
+int ble_gap_ext_adv_rsp_set_data(uint8_t instance, struct os_mbuf *data)
+{
+    return ext_adv_set_data(instance, data, true);
+}
+
+int ble_gap_ext_adv_start(uint8_t instance, int duration, int max_events)
+{
+    struct ble_gap_ext_adv_params p;
+    struct ble_gap_adv_params params = {0};
+
+    sim_critical_enter();
+    bool configured = instance == 0 && ext_configured;
+    p = ext_params;
+    sim_critical_exit();
+
+    if (!configured)
+    {
+        return BLE_HS_EINVAL;
+    }
+
+    if (p.directed)
+    {
+        params.conn_mode = BLE_GAP_CONN_MODE_DIR;
+        params.disc_mode = BLE_GAP_DISC_MODE_NON;
+    }
+    else
+    {
+        params.conn_mode = p.connectable ? BLE_GAP_CONN_MODE_UND : BLE_GAP_CONN_MODE_NON;
+        params.disc_mode = BLE_GAP_DISC_MODE_GEN;
+    }
+    params.itvl_min = (uint16_t)p.itvl_min;
+    params.itvl_max = (uint16_t)p.itvl_max;
+    params.channel_map = p.channel_map;
+    params.filter_policy = p.filter_policy;
+    params.high_duty_cycle = p.high_duty_directed;
+
+    // Duração em unidades de 10 ms (0 = até conectar)
+    return ble_gap_adv_start(p.own_addr_type, p.directed ? &p.peer : NULL,
+                             duration ? duration * 10 : BLE_HS_FOREVER, &params, ext_cb, ext_cb_arg);
+}
+
+int ble_gap_ext_adv_stop(uint8_t instance)
+{
+    return instance == 0 ? ble_gap_adv_stop() : BLE_HS_EINVAL;
+}
+
+bool ble_gap_ext_adv_active(uint8_t instance)
+{
+    return instance == 0 && adv.active;
+}
+#endif
+
+int ble_gap_wl_set(const ble_addr_t *addrs, uint8_t white_list_count)
+{
+    int rc = 0;
+
+    sim_critical_enter();
+    if (white_list_count > sizeof(adv.accept_list) / sizeof(adv.accept_list[0]))
+    {
+        rc = BLE_HS_EINVAL;
+    }
+    else if (adv.active)
+    {
+        // Controlador recusa alterar a lista em uso
+        rc = BLE_HS_EBUSY;
+    }
+    else
+    {
+        memcpy(adv.accept_list, addrs, white_list_count * sizeof(ble_addr_t));
+        adv.accept_count = white_list_count;
+    }
+    sim_critical_exit();
+    return rc;
+}
+
+int ble_gap_conn_find(uint16_t handle, struct ble_gap_conn_desc *out_desc)
+{
+    int rc = BLE_HS_ENOTCONN;
+
+    sim_critical_enter();
+    sim_conn_t *conn = conn_find_locked(handle);
+    if (conn)
+    {
+        if (out_desc)
+        {
+            *out_desc = conn->desc;
+        }
+        rc = 0;
+    }
+    sim_critical_exit();
+    return rc;
+}
+
+int ble_gap_update_params(uint16_t conn_handle, const struct ble_gap_upd_params *params)
+{
+    int rc = 0;
+
+    sim_critical_enter();
+    sim_conn_t *conn = conn_find_locked(conn_handle);
+    if (conn == NULL)
+    {
+        rc = BLE_HS_ENOTCONN;
+    }
+    else if (conn->update_pending)
+    {
+        rc = BLE_HS_EALREADY;
+    }
+    else
+    {
+        // Central aceita o máximo pedido
+        conn->desc.conn_itvl = params->itvl_max;
+        conn->desc.conn_latency = params->latency;
+        conn->desc.supervision_timeout = params->supervision_timeout;
+        conn->update_pending = true;
+        stats.conn_updates++;
+    }
+    sim_critical_exit();
+    return rc;
+}
+
+int ble_gap_set_prefered_le_phy(uint16_t conn_handle, uint8_t tx_phys_mask, uint8_t rx_phys_mask, uint16_t phy_opts)
+{
+    int rc = 0;
+
+    sim_critical_enter();
+    sim_conn_t *conn = conn_find_locked(conn_handle);
+    if (conn == NULL)
+    {
+        rc = BLE_HS_ENOTCONN;
+    }
+    else
+    {
+        conn->phy = (tx_phys_mask & BLE_GAP_LE_PHY_2M_MASK) ? BLE_HCI_LE_PHY_2M : BLE_HCI_LE_PHY_1M;
+        conn->phy_pending = true;
+        stats.phy_requests++;
+    }
+    sim_critical_exit();
+    return rc;
+}
+
+int ble_gap_set_data_len(uint16_t conn_handle, uint16_t tx_octets, uint16_t tx_time)
+{
+    int rc = 0;
+
+    sim_critical_enter();
+    if (conn_find_locked(conn_handle) == NULL)
+    {
+        rc = BLE_HS_ENOTCONN;
+    }
+    else
+    {
+        stats.data_len_requests++;
+        stats.data_len_octets = tx_octets;
+        stats.data_len_time_us = tx_time;
+    }
+    sim_critical_exit();
+    return rc;
+}
+
+// Eventos adiados: respostas do central a pedidos do servidor
+static int conn_deferred_events(void)
+{
+    int delivered = 0;
+
+    for (int i = 0; i < SIM_MAX_CONNS; i++)
+    {
+        struct ble_gap_event event;
+        ble_gap_event_fn *cb = NULL;
+        void *cb_arg = NULL;
+
+        memset(&event, 0, sizeof(event));
+        sim_critical_enter();
+        if (conns[i].used && conns[i].update_pending)
+        {
+            conns[i].update_pending = false;
+            event.type = BLE_GAP_EVENT_CONN_UPDATE;
+            event.conn_update.status = 0;
+            event.conn_update.conn_handle = conns[i].desc.conn_handle;
+            cb = conns[i].cb;
+            cb_arg = conns[i].cb_arg;
+        }
+        else if (conns[i].used && conns[i].phy_pending)
+        {
+            conns[i].phy_pending = false;
+            event.type = BLE_GAP_EVENT_PHY_UPDATE_COMPLETE;
+            event.phy_updated.status = 0;
+            event.phy_updated.conn_handle = conns[i].desc.conn_handle;
+            event.phy_updated.tx_phy = conns[i].phy;
+            event.phy_updated.rx_phy = conns[i].phy;
+            cb = conns[i].cb;
+            cb_arg = conns[i].cb_arg;
+        }
+        sim_critical_exit();
+
+        if (cb)
+        {
+            cb(&event, cb_arg);
+            delivered++;
+            i--; // Pode haver outro evento pendente na mesma conexão
+        }
+    }
+    return delivered;
+}
+
+// Duração do advertising esgotada sem conexão
+static int adv_expire(int64_t now)
+{
+    ble_gap_event_fn *cb = NULL;
+    void *cb_arg = NULL;
+
+    sim_critical_enter();
+    if (adv.active && adv_expires_us <= now)
+    {
+        adv.active = false;
+        cb = adv_cb;
+        cb_arg = adv_cb_arg;
+    }
+    sim_critical_exit();
+
+    if (cb == NULL)
+    {
+        return 0;
+    }
+
+    struct ble_gap_event event = {.type = BLE_GAP_EVENT_ADV_COMPLETE};
+    event.adv_complete.reason = BLE_HS_ETIMEOUT;
+    cb(&event, cb_arg);
+    return 1;
+}
+
+// ===== Laço do host =====
+
+// Executa tudo o que já venceu; retorna quantos itens rodaram
+static int host_step(void)
+{
+    int64_t now = sim_clock_us();
+    int count = 0;
+
+    callouts_fire(now);
+    count += sim_timers_fire(now);
+    count += adv_expire(now);
+    count += inflight_transmit();
+    count += conn_deferred_events();
+
+    struct ble_npl_event *ev;
+    while ((ev = eventq_get(&dflt_eventq)) != NULL)
+    {
+        ev->fn(ev);
+        count++;
+        sim_critical_enter();
+        stats.events++;
+        sim_critical_exit();
+    }
+    return count;
+}
+
+static int64_t next_deadline(void)
+{
+    int64_t next = min64(callouts_next(), sim_timers_next());
+
+    sim_critical_enter();
+    if (adv.active)
+        next = min64(next, adv_expires_us);
+    sim_critical_exit();
+    return next;
+}
+
+int ble_sim_run(uint32_t ms)
+{
+    int64_t end = sim_clock_us() + (int64_t)ms * 1000;
+    int total = 0;
+
+    for (;;)
+    {
+        int n = host_step();
+        total += n;
+        if (n > 0)
+        {
+            continue;
+        }
+
+        int64_t now = sim_clock_us();
+        if (now >= end)
+        {
+            break;
+        }
+        sim_clock_advance(min64(next_deadline(), end) - now);
+    }
+    return total;
+}
+
+bool ble_sim_wait(bool (*cond)(void *arg), void *arg, uint32_t timeout_ms)
+{
+    struct timespec start;
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (;;)
+    {
+        host_step();
+        if (cond(arg))
+        {
+            return true;
+        }
+
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        int64_t elapsed_ms = (int64_t)(now.tv_sec - start.tv_sec) * 1000 + (now.tv_nsec - start.tv_nsec) / 1000000;
+        if (elapsed_ms >= timeout_ms)
+        {
+            return false;
+        }
+        vTaskDelay(1);
+    }
+}
+
+// ===== Ciclo de vida =====
+
+void ble_sim_init(void)
+{
+    sim_critical_enter();
+    memset(attrs, 0, sizeof(attrs));
+    next_handle = SIM_FIRST_HANDLE;
+    memset(conns, 0, sizeof(conns));
+    next_conn_handle = 1;
+    memset(&adv, 0, sizeof(adv));
+    adv_expires_us = INT64_MAX;
+    adv_cb = NULL;
+#if CONFIG_BT_NIMBLE_EXT_ADV
+    ext_configured = false;
+#endif
+    inflight_count = 0;
+    tx_paused = false;
+    rx_chunk = 0;
+    notify_head = 0;
+    notify_count = 0;
+    bond_count = 0;
+    TAILQ_INIT(&dflt_eventq.head);
+    callouts = NULL;
+    synced = false;
+    infer_auto_failures = 0;
+    adv_start_failures = 0;
+    device_name[0] = '\0';
+    memset(&stats, 0, sizeof(stats));
+    memset(&ble_hs_cfg, 0, sizeof(ble_hs_cfg));
+    sim_critical_exit();
+
+    sim_msys_init();
+    sim_timers_reset();
+}
+
+void ble_sim_sync(void)
+{
+    sim_critical_enter();
+    synced = true;
+    sim_critical_exit();
+
+    if (ble_hs_cfg.sync_cb)
+    {
+        ble_hs_cfg.sync_cb();
+    }
+}
+
+void ble_sim_host_reset(int reason)
+{
+    sim_critical_enter();
+    synced = false;
+    adv.active = false;
+    sim_critical_exit();
+
+    for (int i = 0; i < SIM_MAX_CONNS; i++)
+    {
+        if (conns[i].used)
+        {
+            ble_sim_disconnect(conns[i].desc.conn_handle, reason);
+        }
+    }
+
+    if (ble_hs_cfg.reset_cb)
+    {
+        ble_hs_cfg.reset_cb(reason);
+    }
+}
+
+void ble_sim_fail_infer_auto(int count)
+{
+    infer_auto_failures = count;
+}
+
+void ble_sim_fail_adv_start(int count)
+{
+    adv_start_failures = count;
+}
+
+// ===== Ações do central =====
+
+// Filtros do controlador. Sem lista de resolução: um par com RPA não
+// bate com endereço de identidade nenhum.
+static bool adv_accepts_locked(const ble_sim_peer_t *peer)
+{
+    if (!adv.active)
+    {
+        return false;
+    }
+    if (adv.directed)
+    {
+        return !peer->rpa && addr_eq(&adv.peer, &peer->id_addr);
+    }
+    if (adv.params.filter_policy == BLE_HCI_ADV_FILT_CONN || adv.params.filter_policy == BLE_HCI_ADV_FILT_BOTH)
+    {
+        if (peer->rpa)
+        {
+            return false;
+        }
+        for (int i = 0; i < adv.accept_count; i++)
+        {
+            if (addr_eq(&adv.accept_list[i], &peer->id_addr))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+    return true;
+}
+
+uint16_t ble_sim_connect(const ble_sim_peer_t *peer)
+{
+    sim_conn_t *conn = NULL;
+
+    sim_critical_enter();
+    if (adv_accepts_locked(peer))
+    {
+        for (int i = 0; i < SIM_MAX_CONNS; i++)
+        {
+            if (!conns[i].used)
+            {
+                conn = &conns[i];
+                break;
+            }
+        }
+    }
+    if (conn == NULL)
+    {
+        stats.connects_refused++;
+        sim_critical_exit();
+        return BLE_SIM_NO_CONN;
+    }
+
+    memset(conn, 0, sizeof(*conn));
+    conn->used = true;
+    conn->rpa = peer->rpa;
+    conn->mtu = BLE_ATT_MTU_DFLT;
+    conn->cb = adv_cb;
+    conn->cb_arg = adv_cb_arg;
+    conn->desc.conn_handle = next_conn_handle++;
+    conn->desc.our_id_addr.type = BLE_ADDR_PUBLIC;
+    memcpy(conn->desc.our_id_addr.val, our_addr, sizeof(our_addr));
+    conn->desc.our_ota_addr = conn->desc.our_id_addr;
+    conn->desc.peer_id_addr = peer->id_addr;
+    conn->desc.peer_ota_addr = peer->id_addr;
+    if (peer->rpa)
+    {
+        // Endereço no ar: RPA qualquer (dois bits altos 01)
+        conn->desc.peer_ota_addr.type = BLE_ADDR_RANDOM;
+        conn->desc.peer_ota_addr.val[5] = (conn->desc.peer_ota_addr.val[5] & 0x3f) | 0x40;
+    }
+    conn->desc.conn_itvl = 24;
+    conn->desc.supervision_timeout = 400;
+    conn->desc.role = 1; // Periférico
+
+    uint16_t handle = conn->desc.conn_handle;
+    ble_gap_event_fn *cb = conn->cb;
+    void *cb_arg = conn->cb_arg;
+    adv.active = false;
+    stats.connects++;
+    sim_critical_exit();
+
+    struct ble_gap_event event = {.type = BLE_GAP_EVENT_CONNECT};
+    event.connect.status = 0;
+    event.connect.conn_handle = handle;
+    conn_event(cb, cb_arg, &event);
+
+#if CONFIG_BT_NIMBLE_EXT_ADV
+    // O set estendido termina com a conexão: ADV_COMPLETE com reason 0
+    memset(&event, 0, sizeof(event));
+    event.type = BLE_GAP_EVENT_ADV_COMPLETE;
+    event.adv_complete.conn_handle = handle;
+    conn_event(cb, cb_arg, &event);
+#endif
+    return handle;
+}
+
+void ble_sim_disconnect(uint16_t conn_handle, int reason)
+{
+    struct ble_gap_event event;
+    uint16_t subscribed[SIM_MAX_ATTRS];
+    int num_subscribed = 0;
+    ble_gap_event_fn *cb;
+    void *cb_arg;
+
+    memset(&event, 0, sizeof(event));
+    sim_critical_enter();
+    sim_conn_t *conn = conn_find_locked(conn_handle);
+    if (conn == NULL)
+    {
+        sim_critical_exit();
+        return;
+    }
+
+    for (int h = SIM_FIRST_HANDLE; h < next_handle; h++)
+    {
+        if (conn->cccd[h])
+        {
+            subscribed[num_subscribed++] = (uint16_t)h;
+        }
+    }
+
+    // Notificações ainda no controlador são descartadas
+    for (int i = 0; i < inflight_count;)
+    {
+        if (inflight[i].conn_handle == conn_handle)
+        {
+            os_mbuf_free_chain(inflight[i].om);
+            inflight[i] = inflight[--inflight_count];
+        }
+        else
+        {
+            i++;
+        }
+    }
+
+    event.disconnect.reason = reason;
+    event.disconnect.conn = conn->desc;
+    cb = conn->cb;
+    cb_arg = conn->cb_arg;
+    conn->used = false;
+    sim_critical_exit();
+
+    // Como o NimBLE: inscrições encerradas antes do DISCONNECT
+    for (int i = 0; i < num_subscribed; i++)
+    {
+        struct ble_gap_event sub = {.type = BLE_GAP_EVENT_SUBSCRIBE};
+        sub.subscribe.conn_handle = conn_handle;
+        sub.subscribe.attr_handle = subscribed[i];
+        sub.subscribe.reason = BLE_GAP_SUBSCRIBE_REASON_TERM;
+        sub.subscribe.prev_notify = 1;
+        sub.subscribe.cur_notify = 0;
+        conn_event(cb, cb_arg, &sub);
+    }
+
+    event.type = BLE_GAP_EVENT_DISCONNECT;
+    conn_event(cb, cb_arg, &event);
+}
+
+void ble_sim_mtu(uint16_t conn_handle, uint16_t mtu)
+{
+    ble_gap_event_fn *cb = NULL;
+    void *cb_arg = NULL;
+
+    if (mtu > CONFIG_BT_NIMBLE_ATT_PREFERRED_MTU)
+        mtu = CONFIG_BT_NIMBLE_ATT_PREFERRED_MTU;
+    if (mtu < BLE_ATT_MTU_DFLT)
+        mtu = BLE_ATT_MTU_DFLT;
+
+    sim_critical_enter();
+    sim_conn_t *conn = conn_find_locked(conn_handle);
+    if (conn)
+    {
+        conn->mtu = mtu;
+        cb = conn->cb;
+        cb_arg = conn->cb_arg;
+    }
+    sim_critical_exit();
+
+    struct ble_gap_event event = {.type = BLE_GAP_EVENT_MTU};
+    event.mtu.conn_handle = conn_handle;
+    event.mtu.channel_id = 4; // ATT
+    event.mtu.value = mtu;
+    conn_event(cb, cb_arg, &event);
+}
+
+void ble_sim_encrypt(uint16_t conn_handle, bool bond)
+{
+    ble_gap_event_fn *cb = NULL;
+    void *cb_arg = NULL;
+
+    sim_critical_enter();
+    sim_conn_t *conn = conn_find_locked(conn_handle);
+    if (conn)
+    {
+        conn->desc.sec_state.encrypted = 1;
+        conn->desc.sec_state.key_size = 16;
+        conn->desc.sec_state.bonded = bond;
+        cb = conn->cb;
+        cb_arg = conn->cb_arg;
+
+        if (bond)
+        {
+            int i;
+            for (i = 0; i < bond_count; i++)
+            {
+                if (addr_eq(&bonds[i].addr, &conn->desc.peer_id_addr))
+                    break;
+            }
+            if (i == bond_count && bond_count < SIM_MAX_BONDS)
+                bond_count++;
+            if (i < bond_count)
+            {
+                bonds[i].addr = conn->desc.peer_id_addr;
+                bonds[i].irk = conn->rpa;
+            }
+        }
+    }
+    sim_critical_exit();
+
+    struct ble_gap_event event = {.type = BLE_GAP_EVENT_ENC_CHANGE};
+    event.enc_change.status = 0;
+    event.enc_change.conn_handle = conn_handle;
+    conn_event(cb, cb_arg, &event);
+}
+
+int ble_sim_subscribe(uint16_t conn_handle, uint16_t val_handle, bool notify)
+{
+    const sim_attr_t *attr = attr_value(val_handle);
+    ble_gap_event_fn *cb = NULL;
+    void *cb_arg = NULL;
+    uint8_t prev = 0;
+
+    if (attr == NULL || !(attr->chr->flags & (BLE_GATT_CHR_F_NOTIFY | BLE_GATT_CHR_F_INDICATE)))
+    {
+        return BLE_ATT_ERR_INVALID_HANDLE;
+    }
+
+    sim_critical_enter();
+    sim_conn_t *conn = conn_find_locked(conn_handle);
+    if (conn)
+    {
+        prev = conn->cccd[val_handle];
+        conn->cccd[val_handle] = notify ? 1 : 0;
+        cb = conn->cb;
+        cb_arg = conn->cb_arg;
+    }
+    sim_critical_exit();
+
+    if (cb == NULL)
+    {
+        return BLE_ATT_ERR_UNLIKELY;
+    }
+
+    struct ble_gap_event event = {.type = BLE_GAP_EVENT_SUBSCRIBE};
+    event.subscribe.conn_handle = conn_handle;
+    event.subscribe.attr_handle = val_handle;
+    event.subscribe.reason = BLE_GAP_SUBSCRIBE_REASON_WRITE;
+    event.subscribe.prev_notify = prev & 1;
+    event.subscribe.cur_notify = notify;
+    cb(&event, cb_arg);
+    return 0;
+}
+
+int ble_sim_write(uint16_t conn_handle, uint16_t val_handle, const void *data, uint16_t len)
+{
+    const sim_attr_t *attr = attr_value(val_handle);
+    const uint8_t *src = data;
+
+    if (attr == NULL)
+    {
+        return BLE_ATT_ERR_INVALID_HANDLE;
+    }
+    if (!(attr->chr->flags & (BLE_GATT_CHR_F_WRITE | BLE_GATT_CHR_F_WRITE_NO_RSP)))
+    {
+        return BLE_ATT_ERR_WRITE_NOT_PERMITTED;
+    }
+    if (len > BLE_ATT_ATTR_MAX_LEN)
+    {
+        return BLE_ATT_ERR_INVALID_ATTR_VALUE_LEN;
+    }
+    if (ble_gap_conn_find(conn_handle, NULL) != 0)
+    {
+        return BLE_ATT_ERR_UNLIKELY;
+    }
+
+    // Cadeia com segmentos de rx_chunk bytes (0 = blocos cheios)
+    struct os_mbuf *om = os_msys_get_pkthdr(len, 0);
+    if (om == NULL)
+    {
+        return BLE_ATT_ERR_INSUFFICIENT_RES;
+    }
+    uint16_t chunk = rx_chunk ? rx_chunk : len;
+    for (uint16_t off = 0; off < len; off += chunk)
+    {
+        uint16_t n = len - off < chunk ? len - off : chunk;
+        struct os_mbuf *last = om;
+
+        while (SLIST_NEXT(last, om_next) != NULL)
+        {
+            last = SLIST_NEXT(last, om_next);
+        }
+        if (last->om_len > 0)
+        {
+            struct os_mbuf *seg = sim_msys_get();
+            if (seg == NULL)
+            {
+                os_mbuf_free_chain(om);
+                return BLE_ATT_ERR_INSUFFICIENT_RES;
+            }
+            SLIST_NEXT(last, om_next) = seg;
+        }
+        if (os_mbuf_append(om, src + off, n) != 0)
+        {
+            os_mbuf_free_chain(om);
+            return BLE_ATT_ERR_INSUFFICIENT_RES;
+        }
+    }
+
+    struct ble_gatt_access_ctxt ctxt = {.op = BLE_GATT_ACCESS_OP_WRITE_CHR, .om = om};
+    ctxt.chr = attr->chr;
+    int rc = attr->chr->access_cb(conn_handle, val_handle, &ctxt, attr->chr->arg);
+    os_mbuf_free_chain(ctxt.om);
+    return rc;
+}
+
+int ble_sim_read(uint16_t conn_handle, uint16_t val_handle, uint16_t offset, uint8_t *out, uint16_t cap)
+{
+    const sim_attr_t *attr = attr_value(val_handle);
+
+    if (attr == NULL)
+    {
+        return -BLE_ATT_ERR_INVALID_HANDLE;
+    }
+    if (!(attr->chr->flags & BLE_GATT_CHR_F_READ))
+    {
+        return -BLE_ATT_ERR_READ_NOT_PERMITTED;
+    }
+
+    uint16_t mtu = ble_att_mtu(conn_handle);
+    if (mtu == 0)
+    {
+        return -BLE_ATT_ERR_UNLIKELY;
+    }
+
+    struct os_mbuf *om = os_msys_get_pkthdr(0, 0);
+    if (om == NULL)
+    {
+        return -BLE_ATT_ERR_INSUFFICIENT_RES;
+    }
+
+    struct ble_gatt_access_ctxt ctxt = {.op = BLE_GATT_ACCESS_OP_READ_CHR, .om = om};
+    ctxt.chr = attr->chr;
+    int rc = attr->chr->access_cb(conn_handle, val_handle, &ctxt, attr->chr->arg);
+    if (rc != 0)
+    {
+        os_mbuf_free_chain(ctxt.om);
+        return -rc;
+    }
+
+    // NimBLE recorta pelo offset e pelo MTU depois do callback
+    uint16_t len = OS_MBUF_PKTLEN(ctxt.om);
+    if (offset > len)
+    {
+        os_mbuf_free_chain(ctxt.om);
+        return -BLE_ATT_ERR_INVALID_OFFSET;
+    }
+    uint16_t n = len - offset;
+    if (n > mtu - 1)
+        n = mtu - 1;
+    if (n > cap)
+        n = cap;
+    os_mbuf_copydata(ctxt.om, offset, n, out);
+    os_mbuf_free_chain(ctxt.om);
+    return n;
+}
+
+int ble_sim_read_long(uint16_t conn_handle, uint16_t val_handle, uint8_t *out, uint16_t cap,
+                      void (*between)(void *arg), void *arg)
+{
+    uint16_t mtu = ble_att_mtu(conn_handle);
+    uint16_t off = 0;
+
+    for (;;)
+    {
+        int n = ble_sim_read(conn_handle, val_handle, off, out + off, cap - off);
+        if (n < 0)
+        {
+            return n;
+        }
+        off += n;
+        if (n < mtu - 1 || off >= cap)
+        {
+            return off;
+        }
+        if (between)
+        {
+            between(arg);
+        }
+    }
+}
+
+// ===== Controlador e inspeção =====
+
+void ble_sim_set_tx_paused(bool paused)
+{
+    sim_critical_enter();
+    tx_paused = paused;
+    sim_critical_exit();
+}
+
+void ble_sim_set_rx_chunk(uint16_t chunk)
+{
+    rx_chunk = chunk;
+}
+
+bool ble_sim_notify_pop(ble_sim_notify_t *out)
+{
+    bool found = false;
+
+    sim_critical_enter();
+    if (notify_count > 0)
+    {
+        *out = notify_log[notify_head];
+        notify_head = (notify_head + 1) % BLE_SIM_NOTIFY_LOG;
+        notify_count--;
+        found = true;
+    }
+    sim_critical_exit();
+    return found;
+}
+
+void ble_sim_notify_clear(void)
+{
+    sim_critical_enter();
+    notify_head = 0;
+    notify_count = 0;
+    sim_critical_exit();
+}
+
+const ble_sim_adv_t *ble_sim_adv(void)
+{
+    return &adv;
+}
+
+void ble_sim_get_stats(ble_sim_stats_t *out)
+{
+    sim_critical_enter();
+    *out = stats;
+    out->msys_min_free = sim_msys_min_free();
+    sim_critical_exit();
+}
+
+int ble_sim_msys_free(void)
+{
+    return os_msys_num_free();
+}
@@ -0,0 +1,226 @@
+// test/host/sim/ble_sim.h
+// Simulador do host NimBLE para rodar ble_server*.c no Linux. Os fakes
+// (include/) implementam GAP, GATT server, mbufs, NPL e FreeRTOS; esta API
+// faz o papel do celular e do controlador: conecta, negocia MTU, inscreve,
+// escreve e lê, e entrega as notificações enviadas pelo servidor.
+//
+// A thread que chama ble_sim_* é a task do host: eventos NPL, callouts e
+// timers do esp_timer rodam dentro de ble_sim_run(). Tarefas FreeRTOS (ex.:
+// a de comandos) são threads de verdade. O relógio (esp_timer_get_time) é o
+// monotônico do host mais o tempo virtual avançado por ble_sim_run().
+#ifndef BLE_SIM_H
+#define BLE_SIM_H
+
+#include "host/ble_hs.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#define BLE_SIM_NO_CONN 0xFFFF
+#define BLE_SIM_NOTIFY_LOG 64 // Notificações guardadas para ble_sim_notify_pop()
+
+// Celular/central simulado
+typedef struct
+{
+    ble_addr_t id_addr; // Endereço de identidade
+    bool rpa;           // Anuncia com endereço privado resolvível (bond com IRK)
+} ble_sim_peer_t;
+
+// Notificação entregue pelo "controlador"
+typedef struct
+{
+    uint16_t conn_handle;
+    uint16_t attr_handle;
+    uint16_t len;
+    uint8_t data[BLE_ATT_ATTR_MAX_LEN];
+} ble_sim_notify_t;
+
+// Último advertising iniciado pelo servidor
+typedef struct
+{
+    bool active;
+    uint8_t own_addr_type;
+    bool directed;
+    ble_addr_t peer; // Alvo do direcionado
+    int32_t duration_ms;
+    struct ble_gap_adv_params params;
+    uint8_t adv_data[BLE_HS_ADV_MAX_SZ];
+    uint8_t adv_len;
+    uint8_t rsp_data[BLE_HS_ADV_MAX_SZ];
+    uint8_t rsp_len;
+    ble_addr_t accept_list[8];
+    uint8_t accept_count;
+} ble_sim_adv_t;
+
+// Contadores do simulador
+typedef struct
+{
+    uint32_t adv_starts;
+    uint32_t connects;
+    uint32_t connects_refused; // Advertising parado, direcionado a outro par ou filtrado
+    uint32_t conn_updates;     // ble_gap_update_params()
+    uint32_t phy_requests;
+    uint32_t data_len_requests;
+    uint16_t data_len_octets;  // Último pedido de ble_gap_set_data_len()
+    uint16_t data_len_time_us;
+    uint32_t adv_data_rejected; // Dados recusados pelo set estendido
+    uint32_t notifies;         // Entregues ao "rádio"
+    uint32_t notify_bytes;
+    uint32_t events;           // Eventos NPL executados
+    uint32_t msys_min_free;    // Menor número de blocos livres no msys
+} ble_sim_stats_t;
+
+/**
+ * @brief Zera o estado dos fakes (antes de ble_server_init)
+ */
+void ble_sim_init(void);
+
+/**
+ * @brief Host sincronizado com o controlador: chama ble_hs_cfg.sync_cb
+ */
+void ble_sim_sync(void);
+
+/**
+ * @brief Reset do host: derruba as conexões e chama ble_hs_cfg.reset_cb
+ */
+void ble_sim_host_reset(int reason);
+
+/**
+ * @brief Faz ble_hs_id_infer_auto() falhar nas próximas `count` chamadas
+ */
+void ble_sim_fail_infer_auto(int count);
+
+/**
+ * @brief Faz o controlador recusar os próximos `count` inícios de advertising
+ */
+void ble_sim_fail_adv_start(int count);
+
+/**
+ * @brief Executa eventos, callouts e timers avançando o relógio virtual
+ *
+ * @param ms Tempo virtual a avançar (0 = só o que já está pronto)
+ * @return Quantidade de eventos/timers executados
+ */
+int ble_sim_run(uint32_t ms);
+
+/**
+ * @brief Executa eventos em tempo real até cond() ou o timeout
+ *
+ * Para esperar threads (ex.: tarefa de comandos).
+ *
+ * @return true se cond() ficou verdadeira
+ */
+bool ble_sim_wait(bool (*cond)(void *arg), void *arg, uint32_t timeout_ms);
+
+/**
+ * @brief Central conecta ao advertising atual
+ *
+ * Respeita o alvo do direcionado e a accept list (sem resolução de RPA).
+ *
+ * @return Handle da conexão ou BLE_SIM_NO_CONN se recusada
+ */
+uint16_t ble_sim_connect(const ble_sim_peer_t *peer);
+
+void ble_sim_disconnect(uint16_t conn_handle, int reason);
+
+/**
+ * @brief Troca de MTU concluída (BLE_GAP_EVENT_MTU)
+ */
+void ble_sim_mtu(uint16_t conn_handle, uint16_t mtu);
+
+/**
+ * @brief Pareamento concluído (BLE_GAP_EVENT_ENC_CHANGE)
+ *
+ * @param bond Grava o bond (com IRK se o par usa RPA)
+ */
+void ble_sim_encrypt(uint16_t conn_handle, bool bond);
+
+/**
+ * @brief Escreve o CCCD da characteristic (BLE_GAP_EVENT_SUBSCRIBE)
+ *
+ * @return 0 ou código de erro ATT
+ */
+int ble_sim_subscribe(uint16_t conn_handle, uint16_t val_handle, bool notify);
+
+/**
+ * @brief Write Request no valor da characteristic
+ *
+ * O valor chega como cadeia de mbufs com segmentos de
+ * ble_sim_set_rx_chunk() bytes.
+ *
+ * @return 0 ou código de erro ATT retornado pelo servidor
+ */
+int ble_sim_write(uint16_t conn_handle, uint16_t val_handle, const void *data, uint16_t len);
+
+/**
+ * @brief Read Request (offset 0) ou Read Blob Request
+ *
+ * O valor é recortado pelo offset e por MTU - 1, como no NimBLE.
+ *
+ * @return Bytes lidos ou -(código de erro ATT)
+ */
+int ble_sim_read(uint16_t conn_handle, uint16_t val_handle, uint16_t offset, uint8_t *out, uint16_t cap);
+
+/**
+ * @brief Leitura longa: Read seguido de Read Blob enquanto a resposta vem cheia
+ *
+ * @param between Chamado entre as requisições (opcional)
+ * @return Bytes lidos ou -(código de erro ATT)
+ */
+int ble_sim_read_long(uint16_t conn_handle, uint16_t val_handle, uint8_t *out, uint16_t cap,
+                      void (*between)(void *arg), void *arg);
+
+/**
+ * @brief Handle do valor de uma characteristic registrada
+ *
+ * @return Handle ou 0 se não encontrada
+ */
+uint16_t ble_sim_find_chr(const ble_uuid_t *uuid);
+
+/**
+ * @brief Handle do valor da n-ésima characteristic registrada (0 = primeira)
+ *
+ * É o índice de characteristic dos registros do trace do servidor.
+ *
+ * @return Handle ou 0 se não existe
+ */
+uint16_t ble_sim_chr_by_index(int index);
+
+/**
+ * @brief Segura as notificações no "controlador" (mbufs continuam ocupados)
+ */
+void ble_sim_set_tx_paused(bool paused);
+
+/**
+ * @brief Tamanho dos segmentos da cadeia de mbufs dos writes recebidos
+ */
+void ble_sim_set_rx_chunk(uint16_t chunk);
+
+/**
+ * @brief Retira a notificação mais antiga do log
+ *
+ * @return false se o log está vazio
+ */
+bool ble_sim_notify_pop(ble_sim_notify_t *out);
+
+void ble_sim_notify_clear(void);
+
+const ble_sim_adv_t *ble_sim_adv(void);
+
+void ble_sim_get_stats(ble_sim_stats_t *out);
+
+/**
+ * @brief Blocos livres no pool msys
+ */
+int ble_sim_msys_free(void);
+
+/**
+ * @brief Último valor aplicado por time_sync_set()
+ */
+int64_t ble_sim_time_sync_last(void);
+
+/**
+ * @brief Resolução informada no último time_sync_set() (us)
+ */
+uint32_t ble_sim_time_sync_last_resolution(void);
+
+#endif
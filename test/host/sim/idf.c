@@ -0,0 +1,578 @@
+// test/host/sim/idf.c
+// ESP-IDF e FreeRTOS no Linux: seções críticas, filas, mutexes e tarefas
+// sobre pthreads; esp_timer com relógio virtual; log, NVS, aleatórios e o
+// time_sync usado pela characteristic Data/Hora.
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_random.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "nvs_flash.h"
+#include "sim_internal.h"
+#include "time_sync.h"
+#include <errno.h>
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// ===== Seções críticas =====
+
+static pthread_mutex_t critical_lock;
+static pthread_once_t critical_once = PTHREAD_ONCE_INIT;
+
+static void critical_init(void)
+{
+    pthread_mutexattr_t attr;
+
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(&critical_lock, &attr);
+    pthread_mutexattr_destroy(&attr);
+}
+
+void sim_critical_enter(void)
+{
+    pthread_once(&critical_once, critical_init);
+    pthread_mutex_lock(&critical_lock);
+}
+
+void sim_critical_exit(void)
+{
+    pthread_mutex_unlock(&critical_lock);
+}
+
+// Prazo absoluto de uma espera em ticks (1 tick = 1 ms)
+static struct timespec wait_deadline(TickType_t ticks)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_REALTIME, &ts);
+    ts.tv_sec += ticks / 1000;
+    ts.tv_nsec += (long)(ticks % 1000) * 1000000;
+    if (ts.tv_nsec >= 1000000000)
+    {
+        ts.tv_sec++;
+        ts.tv_nsec -= 1000000000;
+    }
+    return ts;
+}
+
+// ===== Filas =====
+
+struct sim_queue
+{
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+    UBaseType_t length;
+    UBaseType_t item_size;
+    UBaseType_t head;
+    UBaseType_t count;
+    uint8_t *items;
+};
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size)
+{
+    struct sim_queue *q = calloc(1, sizeof(*q));
+
+    if (q == NULL)
+    {
+        return NULL;
+    }
+    q->items = malloc((size_t)length * item_size);
+    if (q->items == NULL)
+    {
+        free(q);
+        return NULL;
+    }
+    q->length = length;
+    q->item_size = item_size;
+    pthread_mutex_init(&q->lock, NULL);
+    pthread_cond_init(&q->changed, NULL);
+    return q;
+}
+
+// Espera a condição com o mutex da fila; false no timeout
+static bool queue_wait(struct sim_queue *q, bool (*ready)(struct sim_queue *q), TickType_t wait)
+{
+    struct timespec deadline = wait_deadline(wait);
+
+    while (!ready(q))
+    {
+        if (wait == 0)
+        {
+            return false;
+        }
+        if (wait == portMAX_DELAY)
+        {
+            pthread_cond_wait(&q->changed, &q->lock);
+        }
+        else if (pthread_cond_timedwait(&q->changed, &q->lock, &deadline) == ETIMEDOUT)
+        {
+            return ready(q);
+        }
+    }
+    return true;
+}
+
+static bool queue_has_space(struct sim_queue *q)
+{
+    return q->count < q->length;
+}
+
+static bool queue_has_item(struct sim_queue *q)
+{
+    return q->count > 0;
+}
+
+BaseType_t xQueueSend(QueueHandle_t q, const void *item, TickType_t wait)
+{
+    pthread_mutex_lock(&q->lock);
+    if (!queue_wait(q, queue_has_space, wait))
+    {
+        pthread_mutex_unlock(&q->lock);
+        return pdFAIL;
+    }
+    memcpy(&q->items[((q->head + q->count) % q->length) * q->item_size], item, q->item_size);
+    q->count++;
+    pthread_cond_broadcast(&q->changed);
+    pthread_mutex_unlock(&q->lock);
+    return pdPASS;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t q, void *item, TickType_t wait)
+{
+    pthread_mutex_lock(&q->lock);
+    if (!queue_wait(q, queue_has_item, wait))
+    {
+        pthread_mutex_unlock(&q->lock);
+        return pdFAIL;
+    }
+    memcpy(item, &q->items[q->head * q->item_size], q->item_size);
+    q->head = (q->head + 1) % q->length;
+    q->count--;
+    pthread_cond_broadcast(&q->changed);
+    pthread_mutex_unlock(&q->lock);
+    return pdPASS;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t q)
+{
+    UBaseType_t count;
+
+    pthread_mutex_lock(&q->lock);
+    count = q->count;
+    pthread_mutex_unlock(&q->lock);
+    return count;
+}
+
+void vQueueDelete(QueueHandle_t q)
+{
+    pthread_mutex_destroy(&q->lock);
+    pthread_cond_destroy(&q->changed);
+    free(q->items);
+    free(q);
+}
+
+// ===== Mutexes =====
+
+struct sim_mutex
+{
+    pthread_mutex_t lock;
+};
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void)
+{
+    struct sim_mutex *m = calloc(1, sizeof(*m));
+
+    if (m)
+    {
+        pthread_mutex_init(&m->lock, NULL);
+    }
+    return m;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t m, TickType_t wait)
+{
+    if (wait == portMAX_DELAY)
+    {
+        return pthread_mutex_lock(&m->lock) == 0 ? pdTRUE : pdFALSE;
+    }
+    if (wait == 0)
+    {
+        return pthread_mutex_trylock(&m->lock) == 0 ? pdTRUE : pdFALSE;
+    }
+
+    struct timespec deadline = wait_deadline(wait);
+    return pthread_mutex_timedlock(&m->lock, &deadline) == 0 ? pdTRUE : pdFALSE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t m)
+{
+    return pthread_mutex_unlock(&m->lock) == 0 ? pdTRUE : pdFALSE;
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t m)
+{
+    pthread_mutex_destroy(&m->lock);
+    free(m);
+}
+
+// ===== Tarefas =====
+
+struct sim_task
+{
+    pthread_t thread;
+    TaskFunction_t fn;
+    void *param;
+};
+
+static void *task_main(void *arg)
+{
+    struct sim_task *task = arg;
+
+    task->fn(task->param);
+    return NULL;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, uint32_t stack_depth,
+                       void *param, UBaseType_t priority, TaskHandle_t *out)
+{
+    struct sim_task *task = calloc(1, sizeof(*task));
+
+    if (task == NULL)
+    {
+        return pdFAIL;
+    }
+    task->fn = fn;
+    task->param = param;
+    if (pthread_create(&task->thread, NULL, task_main, task) != 0)
+    {
+        free(task);
+        return pdFAIL;
+    }
+    pthread_detach(task->thread);
+    if (out)
+    {
+        *out = task;
+    }
+    return pdPASS;
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    struct timespec ts = {.tv_sec = ticks / 1000, .tv_nsec = (long)(ticks % 1000) * 1000000};
+    nanosleep(&ts, NULL);
+}
+
+// ===== Relógio e esp_timer =====
+
+#define SIM_MAX_TIMERS 8
+
+struct esp_timer
+{
+    bool in_use;
+    bool armed;
+    int64_t expires_us;
+    esp_timer_cb_t callback;
+    void *arg;
+};
+
+static struct esp_timer timers[SIM_MAX_TIMERS];
+static int64_t clock_offset_us; // Tempo virtual acumulado
+static int64_t clock_base_us;
+
+static int64_t host_monotonic_us(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+int64_t sim_clock_us(void)
+{
+    int64_t now = host_monotonic_us();
+
+    // Relógio começa perto de zero, como após o boot
+    if (clock_base_us == 0)
+    {
+        clock_base_us = now - 1;
+    }
+    return now - clock_base_us + __atomic_load_n(&clock_offset_us, __ATOMIC_RELAXED);
+}
+
+void sim_clock_advance(int64_t us)
+{
+    if (us > 0)
+    {
+        __atomic_add_fetch(&clock_offset_us, us, __ATOMIC_RELAXED);
+    }
+}
+
+int64_t esp_timer_get_time(void)
+{
+    return sim_clock_us();
+}
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t *args, esp_timer_handle_t *out_handle)
+{
+    if (args == NULL || args->callback == NULL || out_handle == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    sim_critical_enter();
+    for (int i = 0; i < SIM_MAX_TIMERS; i++)
+    {
+        if (!timers[i].in_use)
+        {
+            timers[i].in_use = true;
+            timers[i].armed = false;
+            timers[i].callback = args->callback;
+            timers[i].arg = args->arg;
+            *out_handle = &timers[i];
+            sim_critical_exit();
+            return ESP_OK;
+        }
+    }
+    sim_critical_exit();
+    return ESP_ERR_NO_MEM;
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us)
+{
+    esp_err_t err = ESP_OK;
+
+    sim_critical_enter();
+    if (timer->armed)
+    {
+        err = ESP_ERR_INVALID_STATE;
+    }
+    else
+    {
+        timer->armed = true;
+        timer->expires_us = sim_clock_us() + (int64_t)timeout_us;
+    }
+    sim_critical_exit();
+    return err;
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t timer)
+{
+    esp_err_t err;
+
+    sim_critical_enter();
+    err = timer->armed ? ESP_OK : ESP_ERR_INVALID_STATE;
+    timer->armed = false;
+    sim_critical_exit();
+    return err;
+}
+
+esp_err_t esp_timer_delete(esp_timer_handle_t timer)
+{
+    sim_critical_enter();
+    timer->in_use = false;
+    timer->armed = false;
+    sim_critical_exit();
+    return ESP_OK;
+}
+
+void sim_timers_reset(void)
+{
+    sim_critical_enter();
+    memset(timers, 0, sizeof(timers));
+    sim_critical_exit();
+}
+
+int64_t sim_timers_next(void)
+{
+    int64_t next = INT64_MAX;
+
+    sim_critical_enter();
+    for (int i = 0; i < SIM_MAX_TIMERS; i++)
+    {
+        if (timers[i].armed && timers[i].expires_us < next)
+            next = timers[i].expires_us;
+    }
+    sim_critical_exit();
+    return next;
+}
+
+// Dispara os timers vencidos (como a task do esp_timer, sem segurar locks)
+int sim_timers_fire(int64_t now)
+{
+    int fired = 0;
+
+    for (int i = 0; i < SIM_MAX_TIMERS; i++)
+    {
+        esp_timer_cb_t callback = NULL;
+        void *arg = NULL;
+
+        sim_critical_enter();
+        if (timers[i].armed && timers[i].expires_us <= now)
+        {
+            timers[i].armed = false;
+            callback = timers[i].callback;
+            arg = timers[i].arg;
+        }
+        sim_critical_exit();
+
+        if (callback)
+        {
+            callback(arg);
+            fired++;
+        }
+    }
+    return fired;
+}
+
+// ===== Log =====
+
+static esp_log_level_t log_level(void)
+{
+    static int level = -1;
+
+    if (level < 0)
+    {
+        const char *env = getenv("BLE_SIM_LOG");
+        switch (env ? env[0] : 'W')
+        {
+        case 'N':
+            level = ESP_LOG_NONE;
+            break;
+        case 'E':
+            level = ESP_LOG_ERROR;
+            break;
+        case 'I':
+            level = ESP_LOG_INFO;
+            break;
+        case 'D':
+            level = ESP_LOG_DEBUG;
+            break;
+        case 'V':
+            level = ESP_LOG_VERBOSE;
+            break;
+        default:
+            level = ESP_LOG_WARN;
+            break;
+        }
+    }
+    return (esp_log_level_t)level;
+}
+
+void esp_log_write(esp_log_level_t level, const char *tag, const char *format, ...)
+{
+    static const char letters[] = "NEWIDV";
+    va_list args;
+
+    if (level > log_level())
+    {
+        return;
+    }
+
+    fprintf(stderr, "%c (%lld) %s: ", letters[level], (long long)(sim_clock_us() / 1000), tag);
+    va_start(args, format);
+    vfprintf(stderr, format, args);
+    va_end(args);
+    fputc('\n', stderr);
+}
+
+const char *esp_err_to_name(esp_err_t code)
+{
+    switch (code)
+    {
+    case ESP_OK:
+        return "ESP_OK";
+    case ESP_FAIL:
+        return "ESP_FAIL";
+    case ESP_ERR_NO_MEM:
+        return "ESP_ERR_NO_MEM";
+    case ESP_ERR_INVALID_ARG:
+        return "ESP_ERR_INVALID_ARG";
+    case ESP_ERR_INVALID_STATE:
+        return "ESP_ERR_INVALID_STATE";
+    case ESP_ERR_INVALID_SIZE:
+        return "ESP_ERR_INVALID_SIZE";
+    case ESP_ERR_NOT_FOUND:
+        return "ESP_ERR_NOT_FOUND";
+    case ESP_ERR_NOT_SUPPORTED:
+        return "ESP_ERR_NOT_SUPPORTED";
+    case ESP_ERR_TIMEOUT:
+        return "ESP_ERR_TIMEOUT";
+    default:
+        return "UNKNOWN ERROR";
+    }
+}
+
+// ===== NVS, aleatórios, time_sync =====
+
+esp_err_t nvs_flash_init(void)
+{
+    return ESP_OK;
+}
+
+esp_err_t nvs_flash_erase(void)
+{
+    return ESP_OK;
+}
+
+static uint32_t random_state = 0x2545F491;
+
+uint32_t esp_random(void)
+{
+    uint32_t x;
+
+    sim_critical_enter();
+    x = random_state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    random_state = x;
+    sim_critical_exit();
+    return x;
+}
+
+void esp_fill_random(void *buf, size_t len)
+{
+    uint8_t *p = buf;
+
+    while (len > 0)
+    {
+        uint32_t r = esp_random();
+        size_t n = len < sizeof(r) ? len : sizeof(r);
+
+        memcpy(p, &r, n);
+        p += n;
+        len -= n;
+    }
+}
+
+static int64_t time_sync_last;
+static uint32_t time_sync_last_res;
+
+esp_err_t time_sync_set(int64_t wall_us, uint32_t resolution_us)
+{
+    if (wall_us < 0)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    time_sync_last = wall_us;
+    time_sync_last_res = resolution_us;
+    return ESP_OK;
+}
+
+int64_t ble_sim_time_sync_last(void)
+{
+    return time_sync_last;
+}
+
+uint32_t ble_sim_time_sync_last_resolution(void)
+{
+    return time_sync_last_res;
+}
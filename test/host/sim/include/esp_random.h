@@ -0,0 +1,12 @@
+// test/host/sim/include/esp_random.h
+// Gerador determinístico (semente fixa): execuções reproduzíveis
+#ifndef ESP_RANDOM_H
+#define ESP_RANDOM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+uint32_t esp_random(void);
+void esp_fill_random(void *buf, size_t len);
+
+#endif
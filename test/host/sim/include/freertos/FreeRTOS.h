@@ -0,0 +1,34 @@
+// test/host/sim/include/freertos/FreeRTOS.h
+// FreeRTOS sobre pthreads. As seções críticas (portMUX) viram um único mutex
+// recursivo global: serializam como o spinlock no ESP32-C3 de um núcleo.
+#ifndef FREERTOS_H
+#define FREERTOS_H
+
+#include <stdint.h>
+
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t TickType_t;
+
+#define pdFALSE 0
+#define pdTRUE 1
+#define pdPASS pdTRUE
+#define pdFAIL pdFALSE
+#define portMAX_DELAY ((TickType_t)0xFFFFFFFF)
+#define portTICK_PERIOD_MS 1
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
+
+typedef struct
+{
+    int unused;
+} portMUX_TYPE;
+
+#define portMUX_INITIALIZER_UNLOCKED {0}
+
+void sim_critical_enter(void);
+void sim_critical_exit(void);
+
+#define portENTER_CRITICAL(mux) ((void)(mux), sim_critical_enter())
+#define portEXIT_CRITICAL(mux) ((void)(mux), sim_critical_exit())
+
+#endif
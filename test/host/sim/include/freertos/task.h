@@ -0,0 +1,15 @@
+// test/host/sim/include/freertos/task.h
+// Cada tarefa é uma thread; prioridade e tamanho da pilha são ignorados
+#ifndef FREERTOS_TASK_H
+#define FREERTOS_TASK_H
+
+#include "freertos/FreeRTOS.h"
+
+typedef struct sim_task *TaskHandle_t;
+typedef void (*TaskFunction_t)(void *param);
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, uint32_t stack_depth,
+                       void *param, UBaseType_t priority, TaskHandle_t *out);
+void vTaskDelay(TickType_t ticks);
+
+#endif
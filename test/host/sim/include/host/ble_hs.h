@@ -0,0 +1,442 @@
+// test/host/sim/include/host/ble_hs.h
+// Subconjunto da API do host NimBLE usado pelo servidor: GAP, GATT server,
+// ATT, identidade e configuração. Constantes e layouts seguem o NimBLE do
+// ESP-IDF 5.x; o comportamento é o do simulador (ble_sim.c).
+#ifndef H_BLE_HS_
+#define H_BLE_HS_
+
+#include "host/ble_uuid.h"
+#include "nimble/nimble_npl.h"
+#include "os/os_mbuf.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// ===== Erros do host =====
+
+#define BLE_HS_EAGAIN 1
+#define BLE_HS_EALREADY 2
+#define BLE_HS_EINVAL 3
+#define BLE_HS_EMSGSIZE 4
+#define BLE_HS_ENOENT 5
+#define BLE_HS_ENOMEM 6
+#define BLE_HS_ENOTCONN 7
+#define BLE_HS_ENOTSUP 8
+#define BLE_HS_EAPP 9
+#define BLE_HS_EBADDATA 10
+#define BLE_HS_EOS 11
+#define BLE_HS_ECONTROLLER 12
+#define BLE_HS_ETIMEOUT 13
+#define BLE_HS_EDONE 14
+#define BLE_HS_EBUSY 15
+#define BLE_HS_EREJECT 16
+#define BLE_HS_EUNKNOWN 17
+#define BLE_HS_EROLE 18
+#define BLE_HS_ETIMEOUT_HCI 19
+#define BLE_HS_ENOMEM_EVT 20
+#define BLE_HS_ENOADDR 21
+#define BLE_HS_ENOTSYNCED 22
+#define BLE_HS_EAUTHEN 23
+#define BLE_HS_EAUTHOR 24
+#define BLE_HS_EENCRYPT 25
+#define BLE_HS_EENCRYPT_KEY_SZ 26
+#define BLE_HS_ESTORE_CAP 27
+#define BLE_HS_ESTORE_FAIL 28
+#define BLE_HS_EPREEMPTED 29
+#define BLE_HS_EDISABLED 30
+#define BLE_HS_ESTALLED 31
+
+#define BLE_HS_ERR_HCI_BASE 0x200
+#define BLE_HS_HCI_ERR(x) ((x) ? BLE_HS_ERR_HCI_BASE + (x) : 0)
+#define BLE_ERR_REM_USER_CONN_TERM 0x13
+#define BLE_ERR_CONN_SPVN_TMO 0x08
+
+#define BLE_HS_FOREVER INT32_MAX
+
+// ===== Endereços =====
+
+#define BLE_ADDR_PUBLIC 0x00
+#define BLE_ADDR_RANDOM 0x01
+#define BLE_ADDR_PUBLIC_ID 0x02
+#define BLE_ADDR_RANDOM_ID 0x03
+
+#define BLE_OWN_ADDR_PUBLIC 0x00
+#define BLE_OWN_ADDR_RANDOM 0x01
+#define BLE_OWN_ADDR_RPA_PUBLIC_DEFAULT 0x02
+#define BLE_OWN_ADDR_RPA_RANDOM_DEFAULT 0x03
+
+typedef struct
+{
+    uint8_t type;
+    uint8_t val[6];
+} ble_addr_t;
+
+int ble_hs_id_copy_addr(uint8_t id_addr_type, uint8_t *out_id_addr, int *out_is_nrpa);
+
+// ===== HCI =====
+
+#define BLE_HCI_ADV_FILT_NONE 0
+#define BLE_HCI_ADV_FILT_SCAN 1
+#define BLE_HCI_ADV_FILT_CONN 2
+#define BLE_HCI_ADV_FILT_BOTH 3
+
+#define BLE_HCI_LE_PHY_1M 1
+#define BLE_HCI_LE_PHY_2M 2
+#define BLE_HCI_LE_PHY_CODED 3
+
+// ===== ATT =====
+
+#define BLE_ATT_MTU_DFLT 23
+#define BLE_ATT_MTU_MAX 527
+#define BLE_ATT_ATTR_MAX_LEN 512
+
+#define BLE_ATT_ERR_INVALID_HANDLE 0x01
+#define BLE_ATT_ERR_READ_NOT_PERMITTED 0x02
+#define BLE_ATT_ERR_WRITE_NOT_PERMITTED 0x03
+#define BLE_ATT_ERR_INVALID_PDU 0x04
+#define BLE_ATT_ERR_INSUFFICIENT_AUTHEN 0x05
+#define BLE_ATT_ERR_REQ_NOT_SUPPORTED 0x06
+#define BLE_ATT_ERR_INVALID_OFFSET 0x07
+#define BLE_ATT_ERR_INSUFFICIENT_AUTHOR 0x08
+#define BLE_ATT_ERR_PREPARE_QUEUE_FULL 0x09
+#define BLE_ATT_ERR_ATTR_NOT_FOUND 0x0a
+#define BLE_ATT_ERR_ATTR_NOT_LONG 0x0b
+#define BLE_ATT_ERR_INSUFFICIENT_KEY_SZ 0x0c
+#define BLE_ATT_ERR_INVALID_ATTR_VALUE_LEN 0x0d
+#define BLE_ATT_ERR_UNLIKELY 0x0e
+#define BLE_ATT_ERR_INSUFFICIENT_ENC 0x0f
+#define BLE_ATT_ERR_UNSUPPORTED_GROUP 0x10
+#define BLE_ATT_ERR_INSUFFICIENT_RES 0x11
+#define BLE_ATT_ERR_VALUE_NOT_ALLOWED 0x13
+
+uint16_t ble_att_mtu(uint16_t conn_handle);
+
+// ===== GAP =====
+
+#define BLE_GAP_EVENT_CONNECT 0
+#define BLE_GAP_EVENT_DISCONNECT 1
+#define BLE_GAP_EVENT_CONN_UPDATE 3
+#define BLE_GAP_EVENT_CONN_UPDATE_REQ 4
+#define BLE_GAP_EVENT_L2CAP_UPDATE_REQ 5
+#define BLE_GAP_EVENT_TERM_FAILURE 6
+#define BLE_GAP_EVENT_DISC 7
+#define BLE_GAP_EVENT_DISC_COMPLETE 8
+#define BLE_GAP_EVENT_ADV_COMPLETE 9
+#define BLE_GAP_EVENT_ENC_CHANGE 10
+#define BLE_GAP_EVENT_PASSKEY_ACTION 11
+#define BLE_GAP_EVENT_NOTIFY_RX 12
+#define BLE_GAP_EVENT_NOTIFY_TX 13
+#define BLE_GAP_EVENT_SUBSCRIBE 14
+#define BLE_GAP_EVENT_MTU 15
+#define BLE_GAP_EVENT_IDENTITY_RESOLVED 16
+#define BLE_GAP_EVENT_REPEAT_PAIRING 17
+#define BLE_GAP_EVENT_PHY_UPDATE_COMPLETE 18
+
+#define BLE_GAP_REPEAT_PAIRING_RETRY 1
+#define BLE_GAP_REPEAT_PAIRING_IGNORE 2
+
+#define BLE_GAP_CONN_MODE_NON 0
+#define BLE_GAP_CONN_MODE_DIR 1
+#define BLE_GAP_CONN_MODE_UND 2
+
+#define BLE_GAP_DISC_MODE_NON 0
+#define BLE_GAP_DISC_MODE_LTD 1
+#define BLE_GAP_DISC_MODE_GEN 2
+
+#define BLE_GAP_LE_PHY_1M_MASK 0x01
+#define BLE_GAP_LE_PHY_2M_MASK 0x02
+#define BLE_GAP_LE_PHY_CODED_MASK 0x04
+#define BLE_GAP_LE_PHY_CODED_ANY 0
+
+#define BLE_GAP_SUBSCRIBE_REASON_WRITE 1
+#define BLE_GAP_SUBSCRIBE_REASON_TERM 2
+
+struct ble_gap_sec_state
+{
+    unsigned encrypted : 1;
+    unsigned authenticated : 1;
+    unsigned bonded : 1;
+    unsigned key_size : 5;
+};
+
+struct ble_gap_conn_desc
+{
+    struct ble_gap_sec_state sec_state;
+    ble_addr_t our_id_addr;
+    ble_addr_t peer_id_addr;
+    ble_addr_t our_ota_addr;
+    ble_addr_t peer_ota_addr;
+    uint16_t conn_handle;
+    uint16_t conn_itvl;
+    uint16_t conn_latency;
+    uint16_t supervision_timeout;
+    uint8_t role;
+    uint8_t master_clock_accuracy;
+};
+
+struct ble_gap_upd_params
+{
+    uint16_t itvl_min;
+    uint16_t itvl_max;
+    uint16_t latency;
+    uint16_t supervision_timeout;
+    uint16_t min_ce_len;
+    uint16_t max_ce_len;
+};
+
+struct ble_gap_adv_params
+{
+    uint8_t conn_mode;
+    uint8_t disc_mode;
+    uint16_t itvl_min;
+    uint16_t itvl_max;
+    uint8_t channel_map;
+    uint8_t filter_policy;
+    uint8_t high_duty_cycle;
+};
+
+struct ble_gap_event
+{
+    uint8_t type;
+
+    union
+    {
+        struct
+        {
+            int status;
+            uint16_t conn_handle;
+        } connect;
+
+        struct
+        {
+            int reason;
+            struct ble_gap_conn_desc conn;
+        } disconnect;
+
+        struct
+        {
+            int status;
+            uint16_t conn_handle;
+        } conn_update;
+
+        struct
+        {
+            int reason;
+            uint8_t instance;
+            uint16_t conn_handle;
+            uint8_t num_ext_adv_events;
+        } adv_complete;
+
+        struct
+        {
+            int status;
+            uint16_t conn_handle;
+        } enc_change;
+
+        struct
+        {
+            int status;
+            uint16_t conn_handle;
+            uint16_t attr_handle;
+            uint8_t indication : 1;
+        } notify_tx;
+
+        struct
+        {
+            uint16_t conn_handle;
+            uint16_t attr_handle;
+            uint8_t reason;
+            uint8_t prev_notify : 1;
+            uint8_t cur_notify : 1;
+            uint8_t prev_indicate : 1;
+            uint8_t cur_indicate : 1;
+        } subscribe;
+
+        struct
+        {
+            uint16_t conn_handle;
+            uint16_t channel_id;
+            uint16_t value;
+        } mtu;
+
+        struct
+        {
+            uint16_t conn_handle;
+            uint8_t cur_key_size;
+            uint8_t cur_authenticated : 1;
+            uint8_t cur_sc : 1;
+            uint8_t new_key_size;
+            uint8_t new_authenticated : 1;
+            uint8_t new_sc : 1;
+            uint8_t new_bonding : 1;
+        } repeat_pairing;
+
+        struct
+        {
+            int status;
+            uint16_t conn_handle;
+            uint8_t tx_phy;
+            uint8_t rx_phy;
+        } phy_updated;
+    };
+};
+
+typedef int ble_gap_event_fn(struct ble_gap_event *event, void *arg);
+
+int ble_gap_adv_start(uint8_t own_addr_type, const ble_addr_t *direct_addr, int32_t duration_ms,
+                      const struct ble_gap_adv_params *adv_params, ble_gap_event_fn *cb, void *cb_arg);
+int ble_gap_adv_stop(void);
+int ble_gap_adv_active(void);
+int ble_gap_adv_set_data(const uint8_t *data, int data_len);
+int ble_gap_adv_rsp_set_data(const uint8_t *data, int data_len);
+
+#if CONFIG_BT_NIMBLE_EXT_ADV
+struct ble_gap_ext_adv_params
+{
+    unsigned int connectable : 1;
+    unsigned int scannable : 1;
+    unsigned int directed : 1;
+    unsigned int high_duty_directed : 1;
+    unsigned int legacy_pdu : 1;
+    unsigned int anonymous : 1;
+    unsigned int include_tx_power : 1;
+    unsigned int scan_req_notif : 1;
+    uint32_t itvl_min;
+    uint32_t itvl_max;
+    uint8_t channel_map;
+    uint8_t own_addr_type;
+    ble_addr_t peer;
+    uint8_t filter_policy;
+    uint8_t primary_phy;
+    uint8_t secondary_phy;
+    int8_t tx_power;
+    uint8_t sid;
+};
+
+int ble_gap_ext_adv_configure(uint8_t instance, const struct ble_gap_ext_adv_params *params,
+                              int8_t *selected_tx_power, ble_gap_event_fn *cb, void *cb_arg);
+int ble_gap_ext_adv_set_data(uint8_t instance, struct os_mbuf *data);
+int ble_gap_ext_adv_rsp_set_data(uint8_t instance, struct os_mbuf *data);
+int ble_gap_ext_adv_start(uint8_t instance, int duration, int max_events);
+int ble_gap_ext_adv_stop(uint8_t instance);
+bool ble_gap_ext_adv_active(uint8_t instance);
+#endif
+
+int ble_gap_conn_find(uint16_t handle, struct ble_gap_conn_desc *out_desc);
+int ble_gap_update_params(uint16_t conn_handle, const struct ble_gap_upd_params *params);
+int ble_gap_set_prefered_le_phy(uint16_t conn_handle, uint8_t tx_phys_mask, uint8_t rx_phys_mask, uint16_t phy_opts);
+int ble_gap_set_data_len(uint16_t conn_handle, uint16_t tx_octets, uint16_t tx_time);
+int ble_gap_wl_set(const ble_addr_t *addrs, uint8_t white_list_count);
+
+// ===== GATT =====
+
+#define BLE_GATT_ACCESS_OP_READ_CHR 0
+#define BLE_GATT_ACCESS_OP_WRITE_CHR 1
+#define BLE_GATT_ACCESS_OP_READ_DSC 2
+#define BLE_GATT_ACCESS_OP_WRITE_DSC 3
+
+#define BLE_GATT_CHR_F_BROADCAST 0x0001
+#define BLE_GATT_CHR_F_READ 0x0002
+#define BLE_GATT_CHR_F_WRITE_NO_RSP 0x0004
+#define BLE_GATT_CHR_F_WRITE 0x0008
+#define BLE_GATT_CHR_F_NOTIFY 0x0010
+#define BLE_GATT_CHR_F_INDICATE 0x0020
+
+#define BLE_GATT_SVC_TYPE_END 0
+#define BLE_GATT_SVC_TYPE_PRIMARY 1
+#define BLE_GATT_SVC_TYPE_SECONDARY 2
+
+typedef uint16_t ble_gatt_chr_flags;
+
+struct ble_gatt_access_ctxt;
+typedef int ble_gatt_access_fn(uint16_t conn_handle, uint16_t attr_handle,
+                               struct ble_gatt_access_ctxt *ctxt, void *arg);
+
+struct ble_gatt_chr_def
+{
+    const ble_uuid_t *uuid;
+    ble_gatt_access_fn *access_cb;
+    void *arg;
+    struct ble_gatt_dsc_def *descriptors;
+    ble_gatt_chr_flags flags;
+    uint8_t min_key_size;
+    uint16_t *val_handle;
+};
+
+struct ble_gatt_svc_def
+{
+    uint8_t type;
+    const ble_uuid_t *uuid;
+    const struct ble_gatt_svc_def **includes;
+    const struct ble_gatt_chr_def *characteristics;
+};
+
+struct ble_gatt_access_ctxt
+{
+    uint8_t op;
+    struct os_mbuf *om;
+    union
+    {
+        const struct ble_gatt_chr_def *chr;
+        const struct ble_gatt_dsc_def *dsc;
+    };
+};
+
+int ble_gattc_notify_custom(uint16_t conn_handle, uint16_t att_handle, struct os_mbuf *om);
+int ble_gatts_count_cfg(const struct ble_gatt_svc_def *defs);
+int ble_gatts_add_svcs(const struct ble_gatt_svc_def *svcs);
+
+// ===== Advertising =====
+
+#define BLE_HS_ADV_MAX_SZ 31
+
+#define BLE_HS_ADV_TYPE_FLAGS 0x01
+#define BLE_HS_ADV_TYPE_INCOMP_UUIDS16 0x02
+#define BLE_HS_ADV_TYPE_COMP_UUIDS16 0x03
+#define BLE_HS_ADV_TYPE_INCOMP_UUIDS128 0x06
+#define BLE_HS_ADV_TYPE_COMP_UUIDS128 0x07
+#define BLE_HS_ADV_TYPE_INCOMP_NAME 0x08
+#define BLE_HS_ADV_TYPE_COMP_NAME 0x09
+#define BLE_HS_ADV_TYPE_MFG_DATA 0xff
+
+#define BLE_HS_ADV_F_DISC_LTD 0x01
+#define BLE_HS_ADV_F_DISC_GEN 0x02
+#define BLE_HS_ADV_F_BREDR_UNSUP 0x04
+
+// ===== Security manager =====
+
+#define BLE_SM_PAIR_KEY_DIST_ENC 0x01
+#define BLE_SM_PAIR_KEY_DIST_ID 0x02
+#define BLE_SM_PAIR_KEY_DIST_SIGN 0x04
+#define BLE_SM_PAIR_KEY_DIST_LINK 0x08
+
+// ===== Configuração e estado do host =====
+
+struct ble_store_status_event;
+typedef void ble_hs_reset_fn(int reason);
+typedef void ble_hs_sync_fn(void);
+typedef int ble_store_status_fn(struct ble_store_status_event *event, void *arg);
+
+struct ble_hs_cfg
+{
+    ble_hs_reset_fn *reset_cb;
+    ble_hs_sync_fn *sync_cb;
+    ble_store_status_fn *store_status_cb;
+    void *store_status_arg;
+    unsigned sm_io_cap : 3;
+    unsigned sm_oob_data_flag : 1;
+    unsigned sm_bonding : 1;
+    unsigned sm_mitm : 1;
+    unsigned sm_sc : 1;
+    unsigned sm_keypress : 1;
+    uint8_t sm_our_key_dist;
+    uint8_t sm_their_key_dist;
+};
+
+extern struct ble_hs_cfg ble_hs_cfg;
+
+int ble_hs_synced(void);
+struct os_mbuf *ble_hs_mbuf_from_flat(const void *buf, uint16_t len);
+
+#include "host/ble_store.h"
+
+#endif
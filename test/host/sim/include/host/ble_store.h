@@ -0,0 +1,42 @@
+// test/host/sim/include/host/ble_store.h
+#ifndef H_BLE_STORE_
+#define H_BLE_STORE_
+
+#include "host/ble_hs.h"
+
+struct ble_store_key_sec
+{
+    ble_addr_t peer_addr;
+    uint16_t ediv;
+    uint64_t rand_num;
+    unsigned ediv_rand_present : 1;
+    uint8_t idx;
+};
+
+struct ble_store_value_sec
+{
+    ble_addr_t peer_addr;
+    uint8_t key_size;
+    uint16_t ediv;
+    uint64_t rand_num;
+    uint8_t ltk[16];
+    uint8_t ltk_present : 1;
+    uint8_t irk[16];
+    uint8_t irk_present : 1;
+    uint8_t csrk[16];
+    uint8_t csrk_present : 1;
+    unsigned authenticated : 1;
+    uint8_t sc : 1;
+};
+
+struct ble_store_status_event
+{
+    int event_code;
+};
+
+int ble_store_read_peer_sec(const struct ble_store_key_sec *key_sec, struct ble_store_value_sec *value_sec);
+int ble_store_util_bonded_peers(ble_addr_t *out_peer_id_addrs, int *out_num_peers, int max_peers);
+int ble_store_util_delete_peer(const ble_addr_t *peer_id_addr);
+int ble_store_util_status_rr(struct ble_store_status_event *event, void *arg);
+
+#endif
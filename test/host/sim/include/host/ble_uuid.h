@@ -0,0 +1,42 @@
+// test/host/sim/include/host/ble_uuid.h
+#ifndef H_BLE_UUID_
+#define H_BLE_UUID_
+
+#include <stdint.h>
+
+#define BLE_UUID_TYPE_16 16
+#define BLE_UUID_TYPE_32 32
+#define BLE_UUID_TYPE_128 128
+
+typedef struct
+{
+    uint8_t type;
+} ble_uuid_t;
+
+typedef struct
+{
+    ble_uuid_t u;
+    uint16_t value;
+} ble_uuid16_t;
+
+typedef struct
+{
+    ble_uuid_t u;
+    uint8_t value[16];
+} ble_uuid128_t;
+
+#define BLE_UUID16_INIT(uuid16)                \
+    {                                          \
+        .u = {.type = BLE_UUID_TYPE_16},       \
+        .value = (uuid16),                     \
+    }
+
+#define BLE_UUID128_INIT(uuid128...)           \
+    {                                          \
+        .u = {.type = BLE_UUID_TYPE_128},      \
+        .value = {uuid128},                    \
+    }
+
+int ble_uuid_cmp(const ble_uuid_t *uuid1, const ble_uuid_t *uuid2);
+
+#endif
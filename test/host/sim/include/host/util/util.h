@@ -0,0 +1,9 @@
+// test/host/sim/include/host/util/util.h
+#ifndef H_BLE_HOST_UTIL_
+#define H_BLE_HOST_UTIL_
+
+#include <stdint.h>
+
+int ble_hs_id_infer_auto(int privacy, uint8_t *out_addr_type);
+
+#endif
@@ -0,0 +1,24 @@
+// test/host/sim/include/mbedtls/sha256.h
+// SHA-256 portável com a API do mbedtls 3 (o host não tem os headers)
+#ifndef MBEDTLS_SHA256_H
+#define MBEDTLS_SHA256_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct
+{
+    uint32_t state[8];
+    uint64_t total;
+    uint8_t buffer[64];
+    size_t used;
+} mbedtls_sha256_context;
+
+void mbedtls_sha256_init(mbedtls_sha256_context *ctx);
+void mbedtls_sha256_free(mbedtls_sha256_context *ctx);
+void mbedtls_sha256_clone(mbedtls_sha256_context *dst, const mbedtls_sha256_context *src);
+int mbedtls_sha256_starts(mbedtls_sha256_context *ctx, int is224);
+int mbedtls_sha256_update(mbedtls_sha256_context *ctx, const unsigned char *input, size_t len);
+int mbedtls_sha256_finish(mbedtls_sha256_context *ctx, unsigned char output[32]);
+
+#endif
@@ -0,0 +1,49 @@
+// test/host/sim/include/nimble/nimble_npl.h
+// Eventos e callouts do NPL. A fila padrão é drenada por ble_sim_run() na
+// thread que faz o papel da task do host; 1 tick = 1 ms.
+#ifndef H_NIMBLE_NPL_
+#define H_NIMBLE_NPL_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <sys/queue.h>
+
+struct ble_npl_event;
+typedef void ble_npl_event_fn(struct ble_npl_event *ev);
+typedef uint32_t ble_npl_time_t;
+
+struct ble_npl_event
+{
+    bool queued;
+    ble_npl_event_fn *fn;
+    void *arg;
+    TAILQ_ENTRY(ble_npl_event) next;
+};
+
+struct ble_npl_eventq
+{
+    TAILQ_HEAD(, ble_npl_event) head;
+};
+
+struct ble_npl_callout
+{
+    struct ble_npl_event ev;
+    struct ble_npl_eventq *evq;
+    bool active;
+    int64_t expires_us;
+    struct ble_npl_callout *next_callout; // Lista de todos os callouts iniciados
+};
+
+void ble_npl_event_init(struct ble_npl_event *ev, ble_npl_event_fn *fn, void *arg);
+void *ble_npl_event_get_arg(struct ble_npl_event *ev);
+void ble_npl_eventq_put(struct ble_npl_eventq *evq, struct ble_npl_event *ev);
+
+void ble_npl_callout_init(struct ble_npl_callout *co, struct ble_npl_eventq *evq,
+                          ble_npl_event_fn *fn, void *arg);
+int ble_npl_callout_reset(struct ble_npl_callout *co, ble_npl_time_t ticks);
+void ble_npl_callout_stop(struct ble_npl_callout *co);
+bool ble_npl_callout_is_active(struct ble_npl_callout *co);
+
+ble_npl_time_t ble_npl_time_ms_to_ticks32(uint32_t ms);
+
+#endif
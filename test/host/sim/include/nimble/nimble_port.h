@@ -0,0 +1,14 @@
+// test/host/sim/include/nimble/nimble_port.h
+#ifndef H_NIMBLE_PORT_
+#define H_NIMBLE_PORT_
+
+#include "esp_err.h"
+#include "nimble/nimble_npl.h"
+
+esp_err_t nimble_port_init(void);
+esp_err_t nimble_port_deinit(void);
+void nimble_port_run(void);
+int nimble_port_stop(void);
+struct ble_npl_eventq *nimble_port_get_dflt_eventq(void);
+
+#endif
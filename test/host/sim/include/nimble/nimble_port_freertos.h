@@ -0,0 +1,11 @@
+// test/host/sim/include/nimble/nimble_port_freertos.h
+// A task do host não é criada: o teste chama ble_sim_run() na própria thread
+#ifndef H_NIMBLE_PORT_FREERTOS_
+#define H_NIMBLE_PORT_FREERTOS_
+
+#include "freertos/task.h"
+
+void nimble_port_freertos_init(TaskFunction_t host_task_fn);
+void nimble_port_freertos_deinit(void);
+
+#endif
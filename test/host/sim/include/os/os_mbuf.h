@@ -0,0 +1,73 @@
+// test/host/sim/include/os/os_mbuf.h
+// Mbufs do NimBLE: mesmo layout de cadeia (om_data/om_len/om_next e o
+// cabeçalho de pacote logo após o os_mbuf), blocos de pools de tamanho fixo.
+#ifndef OS_MBUF_H
+#define OS_MBUF_H
+
+#include <stdint.h>
+#include <sys/queue.h>
+
+// Alinhamento de 8 bytes: os blocos guardam ponteiros no host de 64 bits
+typedef uint64_t os_membuf_t;
+#define OS_MEMPOOL_SIZE(n, blksize) ((((blksize) + 7) / 8) * (n))
+
+struct os_memblock
+{
+    SLIST_ENTRY(os_memblock) mb_next;
+};
+
+struct os_mempool
+{
+    uint32_t mp_block_size;
+    uint16_t mp_num_blocks;
+    uint16_t mp_num_free;
+    uint16_t mp_min_free;
+    const char *name;
+    SLIST_HEAD(, os_memblock) mp_head;
+};
+
+struct os_mbuf_pool
+{
+    uint16_t omp_databuf_len;
+    struct os_mempool *omp_pool;
+};
+
+struct os_mbuf_pkthdr
+{
+    uint16_t omp_len;
+    uint16_t omp_flags;
+};
+
+struct os_mbuf
+{
+    uint8_t *om_data;
+    uint8_t om_flags;
+    uint8_t om_pkthdr_len;
+    uint16_t om_len;
+    struct os_mbuf_pool *om_omp;
+    SLIST_ENTRY(os_mbuf) om_next;
+    uint8_t om_databuf[0];
+};
+
+#define OS_MBUF_PKTHDR(om) ((struct os_mbuf_pkthdr *)(void *)((om)->om_databuf))
+#define OS_MBUF_PKTLEN(om) (OS_MBUF_PKTHDR(om)->omp_len)
+#define OS_MBUF_IS_PKTHDR(om) ((om)->om_pkthdr_len >= sizeof(struct os_mbuf_pkthdr))
+
+int os_mempool_init(struct os_mempool *mp, uint16_t blocks, uint32_t block_size, void *membuf, const char *name);
+void *os_memblock_get(struct os_mempool *mp);
+int os_memblock_put(struct os_mempool *mp, void *block);
+
+int os_mbuf_pool_init(struct os_mbuf_pool *omp, struct os_mempool *mp, uint16_t buf_len, uint16_t nbufs);
+struct os_mbuf *os_mbuf_get(struct os_mbuf_pool *omp, uint16_t leadingspace);
+struct os_mbuf *os_mbuf_get_pkthdr(struct os_mbuf_pool *omp, uint8_t user_pkthdr_len);
+int os_mbuf_append(struct os_mbuf *om, const void *data, uint16_t len);
+void *os_mbuf_extend(struct os_mbuf *om, uint16_t len);
+void os_mbuf_adj(struct os_mbuf *om, int req_len);
+int os_mbuf_copydata(const struct os_mbuf *om, int off, int len, void *dst);
+int os_mbuf_free_chain(struct os_mbuf *om);
+
+// Pool do sistema (msys), usado pelo host para ATT e notificações
+struct os_mbuf *os_msys_get_pkthdr(uint16_t dsize, uint16_t user_hdr_len);
+int os_msys_num_free(void);
+
+#endif
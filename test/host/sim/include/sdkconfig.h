@@ -0,0 +1,61 @@
+// test/host/sim/include/sdkconfig.h
+// Configuração do build no Linux (incluída em todas as unidades com
+// -include). Valores padrão do Kconfig, exceto os recursos que o simulador
+// não cobre (L2CAP, broadcast de eventos); cada alvo pode sobrescrever com
+// -D.
+#ifndef SDKCONFIG_H
+#define SDKCONFIG_H
+
+// NimBLE
+#ifndef CONFIG_BT_NIMBLE_MAX_CONNECTIONS
+#define CONFIG_BT_NIMBLE_MAX_CONNECTIONS 3
+#endif
+#define CONFIG_BT_NIMBLE_MAX_BONDS 3
+#define CONFIG_BT_NIMBLE_ATT_PREFERRED_MTU 256
+#define CONFIG_BT_NIMBLE_NVS_PERSIST 1
+#define CONFIG_BT_NIMBLE_L2CAP_COC_MAX_NUM 0
+#define CONFIG_BT_NIMBLE_MSYS_1_BLOCK_COUNT 24
+#define CONFIG_BT_NIMBLE_MSYS_1_BLOCK_SIZE 128
+
+// Servidor BLE
+#ifndef CONFIG_BLE_SERVER_CMD_QUEUE_LEN
+#define CONFIG_BLE_SERVER_CMD_QUEUE_LEN 8
+#endif
+#define CONFIG_BLE_SERVER_CMD_MAX_LEN 128
+#define CONFIG_BLE_SERVER_CMD_TASK_STACK_SIZE 4096
+#define CONFIG_BLE_SERVER_CMD_TASK_PRIORITY 5
+#ifndef CONFIG_BLE_SERVER_TXQ_DEPTH
+#define CONFIG_BLE_SERVER_TXQ_DEPTH 6
+#endif
+#define CONFIG_BLE_SERVER_TXQ_SLOT_SIZE 256
+#define CONFIG_BLE_SERVER_TXQ_MSYS_RESERVE 4
+#define CONFIG_BLE_SERVER_TXQ_RETRY_MS 5
+#define CONFIG_BLE_SERVER_POLICY_FAST_ITVL_MIN 6
+#define CONFIG_BLE_SERVER_POLICY_FAST_ITVL_MAX 12
+#define CONFIG_BLE_SERVER_POLICY_IDLE_ITVL_MIN 80
+#define CONFIG_BLE_SERVER_POLICY_IDLE_ITVL_MAX 160
+#define CONFIG_BLE_SERVER_POLICY_IDLE_LATENCY 4
+#define CONFIG_BLE_SERVER_POLICY_SUPERVISION_TIMEOUT 400
+#define CONFIG_BLE_SERVER_POLICY_IDLE_TIMEOUT_MS 5000
+#define CONFIG_BLE_SERVER_ADV_FAST_ITVL 32
+#define CONFIG_BLE_SERVER_ADV_FAST_DURATION_MS 30000
+#define CONFIG_BLE_SERVER_ADV_MEDIUM_ITVL 244
+#define CONFIG_BLE_SERVER_ADV_MEDIUM_DURATION_MS 120000
+#define CONFIG_BLE_SERVER_ADV_SLOW_ITVL 1636
+#define CONFIG_BLE_SERVER_ADV_DIRECTED_RECONNECT 1
+#define CONFIG_BLE_SERVER_EVENT_BROADCAST_DEPTH 8
+#define CONFIG_BLE_SERVER_EVENT_BROADCAST_ITVL 800
+#define CONFIG_BLE_SERVER_L2CAP_PSM 0x80
+#define CONFIG_BLE_SERVER_L2CAP_MTU 512
+#define CONFIG_BLE_SERVER_L2CAP_SDU_BUF_COUNT 4
+#define CONFIG_BLE_SERVER_LONG_WRITE_MAX_LEN 2048
+#define CONFIG_BLE_SERVER_LONG_WRITE_POOL_SIZE 1
+#define CONFIG_BLE_SERVER_AUTH_KEY_SLOTS 4
+#ifndef CONFIG_BLE_SERVER_MAX_APP_CHRS
+#define CONFIG_BLE_SERVER_MAX_APP_CHRS 8
+#endif
+#define CONFIG_BLE_SERVER_DIAG 1
+#define CONFIG_BLE_SERVER_TRACE 1
+#define CONFIG_BLE_SERVER_TRACE_RECORDS 256
+
+#endif
@@ -0,0 +1,9 @@
+// test/host/sim/include/services/gap/ble_svc_gap.h
+#ifndef H_BLE_SVC_GAP_
+#define H_BLE_SVC_GAP_
+
+int ble_svc_gap_device_name_set(const char *name);
+const char *ble_svc_gap_device_name(void);
+void ble_svc_gap_init(void);
+
+#endif
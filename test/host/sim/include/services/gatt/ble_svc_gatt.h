@@ -0,0 +1,7 @@
+// test/host/sim/include/services/gatt/ble_svc_gatt.h
+#ifndef H_BLE_SVC_GATT_
+#define H_BLE_SVC_GATT_
+
+void ble_svc_gatt_init(void);
+
+#endif
@@ -0,0 +1,318 @@
+// test/host/sim/os_mbuf.c
+// Pools e cadeias de mbufs com a semântica do NimBLE (os_mbuf.c do mynewt):
+// append estende a cadeia com blocos do mesmo pool, adj positivo corta do
+// início e negativo do fim, extend garante espaço contíguo no último bloco.
+#include "freertos/FreeRTOS.h"
+#include "os/os_mbuf.h"
+#include "sim_internal.h"
+#include <string.h>
+
+#define MSYS_BLOCK_SIZE (CONFIG_BT_NIMBLE_MSYS_1_BLOCK_SIZE + sizeof(struct os_mbuf) + sizeof(struct os_mbuf_pkthdr))
+
+static os_membuf_t msys_mem[OS_MEMPOOL_SIZE(CONFIG_BT_NIMBLE_MSYS_1_BLOCK_COUNT, MSYS_BLOCK_SIZE)];
+static struct os_mempool msys_mempool;
+static struct os_mbuf_pool msys_pool;
+
+// ===== Pools =====
+
+int os_mempool_init(struct os_mempool *mp, uint16_t blocks, uint32_t block_size, void *membuf, const char *name)
+{
+    uint32_t size = (block_size + 7) & ~7u;
+    uint8_t *p = membuf;
+
+    if (mp == NULL || membuf == NULL || blocks == 0)
+    {
+        return -1;
+    }
+
+    mp->mp_block_size = size;
+    mp->mp_num_blocks = blocks;
+    mp->mp_num_free = blocks;
+    mp->mp_min_free = blocks;
+    mp->name = name;
+    SLIST_INIT(&mp->mp_head);
+    for (int i = blocks - 1; i >= 0; i--)
+    {
+        struct os_memblock *block = (struct os_memblock *)(void *)(p + (size_t)i * size);
+        SLIST_INSERT_HEAD(&mp->mp_head, block, mb_next);
+    }
+    return 0;
+}
+
+void *os_memblock_get(struct os_mempool *mp)
+{
+    struct os_memblock *block;
+
+    sim_critical_enter();
+    block = SLIST_FIRST(&mp->mp_head);
+    if (block)
+    {
+        SLIST_REMOVE_HEAD(&mp->mp_head, mb_next);
+        mp->mp_num_free--;
+        if (mp->mp_num_free < mp->mp_min_free)
+            mp->mp_min_free = mp->mp_num_free;
+    }
+    sim_critical_exit();
+    return block;
+}
+
+int os_memblock_put(struct os_mempool *mp, void *block)
+{
+    sim_critical_enter();
+    SLIST_INSERT_HEAD(&mp->mp_head, (struct os_memblock *)block, mb_next);
+    mp->mp_num_free++;
+    sim_critical_exit();
+    return 0;
+}
+
+// ===== Mbufs =====
+
+int os_mbuf_pool_init(struct os_mbuf_pool *omp, struct os_mempool *mp, uint16_t buf_len, uint16_t nbufs)
+{
+    omp->omp_databuf_len = buf_len - sizeof(struct os_mbuf);
+    omp->omp_pool = mp;
+    return 0;
+}
+
+struct os_mbuf *os_mbuf_get(struct os_mbuf_pool *omp, uint16_t leadingspace)
+{
+    if (leadingspace > omp->omp_databuf_len)
+    {
+        return NULL;
+    }
+
+    struct os_mbuf *om = os_memblock_get(omp->omp_pool);
+    if (om == NULL)
+    {
+        return NULL;
+    }
+
+    SLIST_NEXT(om, om_next) = NULL;
+    om->om_flags = 0;
+    om->om_pkthdr_len = 0;
+    om->om_len = 0;
+    om->om_data = om->om_databuf + leadingspace;
+    om->om_omp = omp;
+    return om;
+}
+
+struct os_mbuf *os_mbuf_get_pkthdr(struct os_mbuf_pool *omp, uint8_t user_pkthdr_len)
+{
+    uint16_t pkthdr_len = sizeof(struct os_mbuf_pkthdr) + user_pkthdr_len;
+    struct os_mbuf *om = os_mbuf_get(omp, 0);
+
+    if (om == NULL)
+    {
+        return NULL;
+    }
+
+    om->om_pkthdr_len = pkthdr_len;
+    om->om_data += pkthdr_len;
+    OS_MBUF_PKTHDR(om)->omp_len = 0;
+    OS_MBUF_PKTHDR(om)->omp_flags = 0;
+    return om;
+}
+
+static uint16_t mbuf_trailing(const struct os_mbuf *om)
+{
+    return (uint16_t)(om->om_databuf + om->om_omp->omp_databuf_len - (om->om_data + om->om_len));
+}
+
+static struct os_mbuf *mbuf_last(struct os_mbuf *om)
+{
+    while (SLIST_NEXT(om, om_next) != NULL)
+    {
+        om = SLIST_NEXT(om, om_next);
+    }
+    return om;
+}
+
+int os_mbuf_append(struct os_mbuf *om, const void *data, uint16_t len)
+{
+    const uint8_t *src = data;
+    struct os_mbuf *last;
+    int rc = 0;
+
+    if (om == NULL)
+    {
+        return -1;
+    }
+
+    last = mbuf_last(om);
+    while (len > 0)
+    {
+        uint16_t space = mbuf_trailing(last);
+
+        if (space == 0)
+        {
+            struct os_mbuf *next = os_mbuf_get(om->om_omp, 0);
+            if (next == NULL)
+            {
+                rc = -1;
+                break;
+            }
+            SLIST_NEXT(last, om_next) = next;
+            last = next;
+            continue;
+        }
+
+        uint16_t n = len < space ? len : space;
+        memcpy(last->om_data + last->om_len, src, n);
+        last->om_len += n;
+        src += n;
+        len -= n;
+        if (OS_MBUF_IS_PKTHDR(om))
+            OS_MBUF_PKTLEN(om) += n;
+    }
+    return rc;
+}
+
+void *os_mbuf_extend(struct os_mbuf *om, uint16_t len)
+{
+    struct os_mbuf *last = mbuf_last(om);
+    void *data;
+
+    if (len > om->om_omp->omp_databuf_len)
+    {
+        return NULL;
+    }
+    if (mbuf_trailing(last) < len)
+    {
+        struct os_mbuf *next = os_mbuf_get(om->om_omp, 0);
+        if (next == NULL)
+        {
+            return NULL;
+        }
+        SLIST_NEXT(last, om_next) = next;
+        last = next;
+    }
+
+    data = last->om_data + last->om_len;
+    last->om_len += len;
+    if (OS_MBUF_IS_PKTHDR(om))
+        OS_MBUF_PKTLEN(om) += len;
+    return data;
+}
+
+void os_mbuf_adj(struct os_mbuf *mp, int req_len)
+{
+    int len = req_len;
+    struct os_mbuf *m;
+
+    if ((m = mp) == NULL)
+    {
+        return;
+    }
+
+    if (len >= 0)
+    {
+        // Corta do início, esvaziando segmentos inteiros se preciso
+        while (m != NULL && len > 0)
+        {
+            if (m->om_len <= len)
+            {
+                len -= m->om_len;
+                m->om_len = 0;
+                m = SLIST_NEXT(m, om_next);
+            }
+            else
+            {
+                m->om_len -= len;
+                m->om_data += len;
+                len = 0;
+            }
+        }
+        if (OS_MBUF_IS_PKTHDR(mp))
+            OS_MBUF_PKTLEN(mp) -= (req_len - len);
+        return;
+    }
+
+    // Corta do fim: acha o segmento onde o novo fim cai e zera os seguintes
+    len = -len;
+    int count = 0;
+    for (m = mp; m != NULL; m = SLIST_NEXT(m, om_next))
+    {
+        count += m->om_len;
+    }
+    if (len > count)
+        len = count;
+    count -= len;
+    if (OS_MBUF_IS_PKTHDR(mp))
+        OS_MBUF_PKTLEN(mp) = count;
+    for (m = mp; m != NULL; m = SLIST_NEXT(m, om_next))
+    {
+        if (m->om_len >= count)
+        {
+            m->om_len = count;
+            break;
+        }
+        count -= m->om_len;
+    }
+    if (m != NULL)
+    {
+        while ((m = SLIST_NEXT(m, om_next)) != NULL)
+        {
+            m->om_len = 0;
+        }
+    }
+}
+
+int os_mbuf_copydata(const struct os_mbuf *m, int off, int len, void *dst)
+{
+    uint8_t *out = dst;
+
+    while (m != NULL && off >= m->om_len)
+    {
+        off -= m->om_len;
+        m = SLIST_NEXT(m, om_next);
+    }
+    while (len > 0 && m != NULL)
+    {
+        int n = m->om_len - off < len ? m->om_len - off : len;
+        memcpy(out, m->om_data + off, n);
+        out += n;
+        len -= n;
+        off = 0;
+        m = SLIST_NEXT(m, om_next);
+    }
+    return len > 0 ? -1 : 0;
+}
+
+int os_mbuf_free_chain(struct os_mbuf *om)
+{
+    while (om != NULL)
+    {
+        struct os_mbuf *next = SLIST_NEXT(om, om_next);
+        os_memblock_put(om->om_omp->omp_pool, om);
+        om = next;
+    }
+    return 0;
+}
+
+// ===== msys =====
+
+void sim_msys_init(void)
+{
+    os_mempool_init(&msys_mempool, CONFIG_BT_NIMBLE_MSYS_1_BLOCK_COUNT, MSYS_BLOCK_SIZE, msys_mem, "msys_1");
+    os_mbuf_pool_init(&msys_pool, &msys_mempool, msys_mempool.mp_block_size, CONFIG_BT_NIMBLE_MSYS_1_BLOCK_COUNT);
+}
+
+struct os_mbuf *os_msys_get_pkthdr(uint16_t dsize, uint16_t user_hdr_len)
+{
+    return os_mbuf_get_pkthdr(&msys_pool, user_hdr_len);
+}
+
+struct os_mbuf *sim_msys_get(void)
+{
+    return os_mbuf_get(&msys_pool, 0);
+}
+
+int os_msys_num_free(void)
+{
+    return msys_mempool.mp_num_free;
+}
+
+int sim_msys_min_free(void)
+{
+    return msys_mempool.mp_min_free;
+}
@@ -0,0 +1,142 @@
+// test/host/sim/sha256.c
+// SHA-256 (FIPS 180-4) com a API do mbedtls, para o HMAC de ble_auth.c no
+// Linux. Implementação direta, sem otimizações: só precisa bater com o
+// mbedtls do ESP-IDF.
+#include "mbedtls/sha256.h"
+#include <string.h>
+
+static const uint32_t K[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+static const uint32_t H0[8] = {
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
+};
+
+#define ROTR(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+
+static void sha256_block(mbedtls_sha256_context *ctx, const uint8_t *p)
+{
+    uint32_t w[64];
+    uint32_t v[8];
+
+    for (int i = 0; i < 16; i++)
+    {
+        w[i] = (uint32_t)p[4 * i] << 24 | (uint32_t)p[4 * i + 1] << 16 | (uint32_t)p[4 * i + 2] << 8 | p[4 * i + 3];
+    }
+    for (int i = 16; i < 64; i++)
+    {
+        uint32_t s0 = ROTR(w[i - 15], 7) ^ ROTR(w[i - 15], 18) ^ (w[i - 15] >> 3);
+        uint32_t s1 = ROTR(w[i - 2], 17) ^ ROTR(w[i - 2], 19) ^ (w[i - 2] >> 10);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+
+    memcpy(v, ctx->state, sizeof(v));
+    for (int i = 0; i < 64; i++)
+    {
+        uint32_t s1 = ROTR(v[4], 6) ^ ROTR(v[4], 11) ^ ROTR(v[4], 25);
+        uint32_t ch = (v[4] & v[5]) ^ (~v[4] & v[6]);
+        uint32_t t1 = v[7] + s1 + ch + K[i] + w[i];
+        uint32_t s0 = ROTR(v[0], 2) ^ ROTR(v[0], 13) ^ ROTR(v[0], 22);
+        uint32_t maj = (v[0] & v[1]) ^ (v[0] & v[2]) ^ (v[1] & v[2]);
+
+        v[7] = v[6];
+        v[6] = v[5];
+        v[5] = v[4];
+        v[4] = v[3] + t1;
+        v[3] = v[2];
+        v[2] = v[1];
+        v[1] = v[0];
+        v[0] = t1 + s0 + maj;
+    }
+    for (int i = 0; i < 8; i++)
+    {
+        ctx->state[i] += v[i];
+    }
+}
+
+void mbedtls_sha256_init(mbedtls_sha256_context *ctx)
+{
+    memset(ctx, 0, sizeof(*ctx));
+}
+
+void mbedtls_sha256_free(mbedtls_sha256_context *ctx)
+{
+    memset(ctx, 0, sizeof(*ctx));
+}
+
+void mbedtls_sha256_clone(mbedtls_sha256_context *dst, const mbedtls_sha256_context *src)
+{
+    *dst = *src;
+}
+
+int mbedtls_sha256_starts(mbedtls_sha256_context *ctx, int is224)
+{
+    // SHA-224 não é usado pelo projeto
+    memcpy(ctx->state, H0, sizeof(H0));
+    ctx->total = 0;
+    ctx->used = 0;
+    return 0;
+}
+
+int mbedtls_sha256_update(mbedtls_sha256_context *ctx, const unsigned char *input, size_t len)
+{
+    ctx->total += len;
+
+    if (ctx->used > 0)
+    {
+        size_t n = sizeof(ctx->buffer) - ctx->used;
+        if (n > len)
+            n = len;
+        memcpy(&ctx->buffer[ctx->used], input, n);
+        ctx->used += n;
+        input += n;
+        len -= n;
+        if (ctx->used < sizeof(ctx->buffer))
+        {
+            return 0;
+        }
+        sha256_block(ctx, ctx->buffer);
+        ctx->used = 0;
+    }
+
+    while (len >= sizeof(ctx->buffer))
+    {
+        sha256_block(ctx, input);
+        input += sizeof(ctx->buffer);
+        len -= sizeof(ctx->buffer);
+    }
+
+    memcpy(ctx->buffer, input, len);
+    ctx->used = len;
+    return 0;
+}
+
+int mbedtls_sha256_finish(mbedtls_sha256_context *ctx, unsigned char output[32])
+{
+    uint64_t bits = ctx->total * 8;
+    uint8_t pad[72] = {0x80};
+    size_t pad_len = (ctx->used < 56 ? 56 : 120) - ctx->used;
+
+    for (int i = 0; i < 8; i++)
+    {
+        pad[pad_len + i] = (uint8_t)(bits >> (56 - 8 * i));
+    }
+    mbedtls_sha256_update(ctx, pad, pad_len + 8);
+
+    for (int i = 0; i < 8; i++)
+    {
+        output[4 * i] = (uint8_t)(ctx->state[i] >> 24);
+        output[4 * i + 1] = (uint8_t)(ctx->state[i] >> 16);
+        output[4 * i + 2] = (uint8_t)(ctx->state[i] >> 8);
+        output[4 * i + 3] = (uint8_t)ctx->state[i];
+    }
+    return 0;
+}
@@ -0,0 +1,21 @@
+// test/host/sim/sim_internal.h
+// Ligações entre os fakes (não faz parte da API do simulador)
+#ifndef SIM_INTERNAL_H
+#define SIM_INTERNAL_H
+
+#include "os/os_mbuf.h"
+#include <stdint.h>
+
+// Pool msys (os_mbuf.c)
+void sim_msys_init(void);
+struct os_mbuf *sim_msys_get(void);
+int sim_msys_min_free(void);
+
+// Relógio e timers do esp_timer (idf.c)
+int64_t sim_clock_us(void);
+void sim_clock_advance(int64_t us);
+void sim_timers_reset(void);
+int64_t sim_timers_next(void); // INT64_MAX se nenhum armado
+int sim_timers_fire(int64_t now);
+
+#endif
@@ -0,0 +1,195 @@
+// test/host/test_sim_auth.c
+// Servidor com auth_commands: Command, Data/Hora e Long Write recusam writes
+// sem a tag HMAC da sessão (nonce lido da characteristic Auth) e aceitam os
+// autenticados, com os handlers vendo só o conteúdo original.
+#include "ble_auth.h"
+#include "ble_server.h"
+#include "ble_sim.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static int failures;
+
+#define CHECK(cond)                                                    \
+    do                                                                 \
+    {                                                                  \
+        if (!(cond))                                                   \
+        {                                                              \
+            printf("FALHA %s:%d: %s\n", __FILE__, __LINE__, #cond);    \
+            failures++;                                                \
+        }                                                              \
+    } while (0)
+
+static const ble_uuid128_t cmd_uuid = BLE_UUID128_INIT(
+    0x23, 0xd1, 0xbc, 0xea, 0x5f, 0x78, 0x23, 0x15, 0xde, 0xef, 0x12, 0x12, 0x25, 0x15, 0x00, 0x00);
+static const ble_uuid128_t datetime_uuid = BLE_UUID128_INIT(
+    0x23, 0xd1, 0xbc, 0xea, 0x5f, 0x78, 0x23, 0x15, 0xde, 0xef, 0x12, 0x12, 0x26, 0x15, 0x00, 0x00);
+static const ble_uuid128_t longwr_uuid = BLE_UUID128_INIT(
+    0x23, 0xd1, 0xbc, 0xea, 0x5f, 0x78, 0x23, 0x15, 0xde, 0xef, 0x12, 0x12, 0x27, 0x15, 0x00, 0x00);
+static const ble_uuid128_t auth_uuid = BLE_UUID128_INIT(
+    0x23, 0xd1, 0xbc, 0xea, 0x5f, 0x78, 0x23, 0x15, 0xde, 0xef, 0x12, 0x12, 0x28, 0x15, 0x00, 0x00);
+
+static const ble_sim_peer_t phone = {.id_addr = {BLE_ADDR_PUBLIC, {0x11, 0x22, 0x33, 0x44, 0x55, 0x66}}};
+static const uint8_t secret[] = "segredo-do-celular";
+
+static uint16_t cmd_handle;
+static uint16_t datetime_handle;
+static uint16_t longwr_handle;
+static uint16_t auth_handle;
+
+// Lado do celular: chave, sessão e contador
+static ble_auth_key_t key;
+static ble_auth_session_t session;
+static uint32_t counter;
+
+static int writes;
+static uint8_t last_write[64];
+static uint16_t last_write_len;
+static uint8_t long_object[64];
+static uint32_t long_object_len;
+
+static void app_on_write(uint8_t *data, uint16_t len)
+{
+    writes++;
+    last_write_len = len < sizeof(last_write) ? len : sizeof(last_write);
+    memcpy(last_write, data, last_write_len);
+}
+
+static void app_on_long_write(uint16_t conn_handle, const uint8_t *data, uint32_t len)
+{
+    long_object_len = len < sizeof(long_object) ? len : sizeof(long_object);
+    memcpy(long_object, data, long_object_len);
+}
+
+// Lê a Auth (sessão nova no servidor) e acompanha do lado do celular
+static void open_session(uint16_t conn)
+{
+    uint8_t nonce[BLE_AUTH_NONCE_LEN];
+
+    CHECK(ble_sim_read(conn, auth_handle, 0, nonce, sizeof(nonce)) == sizeof(nonce));
+    ble_auth_session_start(&session, nonce);
+    counter = 0;
+}
+
+static int write_signed(uint16_t conn, uint16_t handle, const uint8_t *data, uint16_t len)
+{
+    uint8_t msg[128];
+    size_t n = ble_auth_sign(&key, &session, 0, ++counter, data, len, msg, sizeof(msg));
+
+    CHECK(n == len + BLE_AUTH_OVERHEAD);
+    return ble_sim_write(conn, handle, msg, (uint16_t)n);
+}
+
+// Formato certo, tag adulterada
+static int write_forged(uint16_t conn, uint16_t handle, const uint8_t *data, uint16_t len)
+{
+    uint8_t msg[128];
+    size_t n = ble_auth_sign(&key, &session, 0, counter + 1, data, len, msg, sizeof(msg));
+
+    msg[n - 1] ^= 0x01;
+    return ble_sim_write(conn, handle, msg, (uint16_t)n);
+}
+
+static uint16_t test_boot(void)
+{
+    ble_server_config_t config = {
+        .device_name = "SimLock",
+        .on_write = app_on_write,
+        .on_long_write = app_on_long_write,
+        .auth_commands = true,
+    };
+
+    ble_sim_init();
+    CHECK(ble_server_init(&config) == ESP_OK);
+    CHECK(ble_server_auth_set_key(0, secret, sizeof(secret)) == ESP_OK);
+    CHECK(ble_auth_key_init(&key, secret, sizeof(secret)) == 0);
+    ble_sim_sync();
+    ble_sim_run(0);
+
+    cmd_handle = ble_sim_find_chr(&cmd_uuid.u);
+    datetime_handle = ble_sim_find_chr(&datetime_uuid.u);
+    longwr_handle = ble_sim_find_chr(&longwr_uuid.u);
+    auth_handle = ble_sim_find_chr(&auth_uuid.u);
+    CHECK(cmd_handle && datetime_handle && longwr_handle && auth_handle);
+
+    uint16_t conn = ble_sim_connect(&phone);
+    CHECK(conn != BLE_SIM_NO_CONN);
+    ble_sim_run(0);
+    ble_sim_mtu(conn, 247);
+    ble_sim_run(0);
+    return conn;
+}
+
+// Sem tag ou com tag errada: nada chega aos handlers
+static void test_unsigned_refused(uint16_t conn)
+{
+    static const uint8_t cmd[] = {0x01, 0x02};
+    static const uint8_t datetime[] = {24, 3, 15, 12, 34, 56, 5};
+    static const uint8_t segment[] = {BLE_SERVER_LONGWR_FIRST | BLE_SERVER_LONGWR_LAST, 0, 0, 0, 0, 'x'};
+    int64_t clock_before = ble_sim_time_sync_last();
+
+    CHECK(ble_sim_write(conn, cmd_handle, cmd, sizeof(cmd)) != 0);
+    CHECK(ble_sim_write(conn, datetime_handle, datetime, sizeof(datetime)) != 0);
+    CHECK(ble_sim_write(conn, longwr_handle, segment, sizeof(segment)) != 0);
+
+    open_session(conn);
+    CHECK(write_forged(conn, cmd_handle, cmd, sizeof(cmd)) == BLE_ATT_ERR_INSUFFICIENT_AUTHEN);
+    CHECK(write_forged(conn, datetime_handle, datetime, sizeof(datetime)) ==
+          BLE_ATT_ERR_INSUFFICIENT_AUTHEN);
+    CHECK(write_forged(conn, longwr_handle, segment, sizeof(segment)) ==
+          BLE_ATT_ERR_INSUFFICIENT_AUTHEN);
+    ble_sim_run(0);
+
+    CHECK(writes == 0);
+    CHECK(ble_sim_time_sync_last() == clock_before);
+    CHECK(long_object_len == 0);
+}
+
+static void test_signed_accepted(uint16_t conn)
+{
+    static const uint8_t cmd[] = {0x01, 0x02};
+    static const uint8_t datetime[] = {24, 3, 15, 12, 34, 56, 5};
+    static const uint8_t first[] = {BLE_SERVER_LONGWR_FIRST, 0, 0, 0, 0, 'a', 'b', 'c'};
+    static const uint8_t last[] = {BLE_SERVER_LONGWR_LAST, 3, 0, 0, 0, 'd', 'e'};
+
+    open_session(conn);
+    CHECK(write_signed(conn, cmd_handle, cmd, sizeof(cmd)) == 0);
+    ble_sim_run(0);
+    CHECK(writes == 1 && last_write_len == sizeof(cmd) && memcmp(last_write, cmd, sizeof(cmd)) == 0);
+
+    // 2024-03-15 12:34:56 UTC
+    CHECK(write_signed(conn, datetime_handle, datetime, sizeof(datetime)) == 0);
+    CHECK(ble_sim_time_sync_last() == 1710506096000000LL);
+
+    // Cada segmento do Long Write leva a própria tag
+    CHECK(write_signed(conn, longwr_handle, first, sizeof(first)) == 0);
+    CHECK(write_signed(conn, longwr_handle, last, sizeof(last)) == 0);
+    ble_sim_run(0);
+    CHECK(long_object_len == 5 && memcmp(long_object, "abcde", 5) == 0);
+
+    // Reenvio de um segmento já aceito: contador não cresceu
+    uint8_t msg[64];
+    size_t n = ble_auth_sign(&key, &session, 0, counter, last, sizeof(last), msg, sizeof(msg));
+    CHECK(ble_sim_write(conn, longwr_handle, msg, (uint16_t)n) == BLE_ATT_ERR_INSUFFICIENT_AUTHEN);
+}
+
+int main(void)
+{
+    // mktime() da characteristic Data/Hora em UTC, como no dispositivo
+    setenv("TZ", "UTC", 1);
+    tzset();
+
+    uint16_t conn = test_boot();
+    test_unsigned_refused(conn);
+    test_signed_accepted(conn);
+
+    if (failures)
+    {
+        printf("%d falha(s)\n", failures);
+        return EXIT_FAILURE;
+    }
+    printf("OK\n");
+    return EXIT_SUCCESS;
+}
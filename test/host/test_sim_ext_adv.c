@@ -0,0 +1,156 @@
+// test/host/test_sim_ext_adv.c
+// Advertising com CONFIG_BT_NIMBLE_EXT_ADV: o set conectável usa PDUs
+// legados, e ADV_DIRECT_IND não leva dados (o NimBLE recusa o envio com
+// EINVAL). O par com bond volta pelo direcionado; o estado alterado durante
+// ele sai no perfil seguinte; se o controlador recusa o direcionado, a
+// rajada rápida entra no lugar.
+#include "ble_server.h"
+#include "ble_sim.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static int failures;
+
+#define CHECK(cond)                                                    \
+    do                                                                 \
+    {                                                                  \
+        if (!(cond))                                                   \
+        {                                                              \
+            printf("FALHA %s:%d: %s\n", __FILE__, __LINE__, #cond);    \
+            failures++;                                                \
+        }                                                              \
+    } while (0)
+
+static const ble_sim_peer_t phone = {.id_addr = {BLE_ADDR_PUBLIC, {0x11, 0x22, 0x33, 0x44, 0x55, 0x66}}};
+
+static void app_on_write(uint8_t *data, uint16_t len)
+{
+}
+
+static uint32_t data_rejected(void)
+{
+    ble_sim_stats_t stats;
+
+    ble_sim_get_stats(&stats);
+    return stats.adv_data_rejected;
+}
+
+// Byte de estado do manufacturer data: [company id LE][estado][contador LE][bateria]
+static int adv_lock_state(void)
+{
+    const ble_sim_adv_t *adv = ble_sim_adv();
+
+    for (int i = 0; i + 1 < adv->adv_len; i += adv->adv_data[i] + 1)
+    {
+        if (adv->adv_data[i + 1] == BLE_HS_ADV_TYPE_MFG_DATA && adv->adv_data[i] >= 4)
+        {
+            return adv->adv_data[i + 4];
+        }
+    }
+    return -1;
+}
+
+// Conecta e cria o bond
+static uint16_t connect_bonded(void)
+{
+    uint16_t conn = ble_sim_connect(&phone);
+
+    CHECK(conn != BLE_SIM_NO_CONN);
+    ble_sim_run(0);
+    ble_sim_encrypt(conn, true);
+    ble_sim_run(0);
+    return conn;
+}
+
+static void test_boot(void)
+{
+    ble_server_config_t config = {
+        .device_name = "SimLock",
+        .on_write = app_on_write,
+    };
+
+    ble_sim_init();
+    CHECK(ble_server_init(&config) == ESP_OK);
+    ble_sim_sync();
+    ble_sim_run(0);
+
+    CHECK(ble_sim_adv()->active && !ble_sim_adv()->directed);
+    CHECK(ble_sim_adv()->adv_len > 0 && ble_sim_adv()->rsp_len > 0);
+    CHECK(adv_lock_state() == 0);
+    CHECK(data_rejected() == 0);
+}
+
+static void test_directed(void)
+{
+    ble_server_adv_stats_t adv_stats;
+    ble_server_status_t status = {.state = 1};
+
+    uint16_t conn = connect_bonded();
+    ble_sim_disconnect(conn, BLE_ERR_REM_USER_CONN_TERM);
+    ble_sim_run(0);
+
+    // Set reconfigurado como direcionado e iniciado sem enviar payload
+    CHECK(ble_sim_adv()->active && ble_sim_adv()->directed);
+    CHECK(memcmp(ble_sim_adv()->peer.val, phone.id_addr.val, 6) == 0);
+    CHECK(data_rejected() == 0);
+
+    // Estado muda durante o direcionado: nada vai para o set agora
+    CHECK(ble_server_set_status(&status) == ESP_OK);
+    ble_sim_run(0);
+    CHECK(ble_sim_adv()->directed);
+    CHECK(data_rejected() == 0);
+
+    // O par volta pelo direcionado e retoma a criptografia do bond
+    conn = ble_sim_connect(&phone);
+    CHECK(conn != BLE_SIM_NO_CONN);
+    ble_sim_run(0);
+    ble_sim_encrypt(conn, true);
+    ble_sim_run(0);
+    CHECK(ble_server_get_adv_stats(&adv_stats) == ESP_OK);
+    CHECK(adv_stats.directed_connects == 1);
+
+    // Sem retorno: o direcionado expira e o rápido leva o estado novo
+    ble_sim_disconnect(conn, BLE_ERR_REM_USER_CONN_TERM);
+    ble_sim_run(0);
+    CHECK(ble_sim_adv()->directed);
+    ble_sim_run(2000);
+    CHECK(ble_sim_adv()->active && !ble_sim_adv()->directed);
+    CHECK(adv_lock_state() == 1);
+    CHECK(data_rejected() == 0);
+}
+
+static void test_directed_refused(void)
+{
+    ble_server_adv_stats_t adv_stats;
+
+    uint16_t conn = connect_bonded();
+
+    // Controlador recusa o direcionado: o par ainda acha a rajada rápida
+    ble_sim_fail_adv_start(1);
+    ble_sim_disconnect(conn, BLE_ERR_REM_USER_CONN_TERM);
+    ble_sim_run(0);
+    CHECK(ble_sim_adv()->active && !ble_sim_adv()->directed);
+    CHECK(ble_server_get_adv_stats(&adv_stats) == ESP_OK);
+    CHECK(adv_stats.advertising && adv_stats.profile == BLE_SERVER_ADV_FAST);
+    CHECK(data_rejected() == 0);
+
+    conn = ble_sim_connect(&phone);
+    CHECK(conn != BLE_SIM_NO_CONN);
+    ble_sim_run(0);
+}
+
+int main(void)
+{
+    test_boot();
+    test_directed();
+    test_directed_refused();
+
+    if (failures)
+    {
+        printf("%d falha(s)\n", failures);
+        return EXIT_FAILURE;
+    }
+    printf("OK\n");
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,439 @@
+// test/host/test_sim_scenario.c
+// Servidor BLE completo no simulador do host NimBLE: um celular conecta,
+// negocia MTU, se inscreve, lê e escreve; a fila de notificações passa por
+// falta de mbufs; a leitura longa da Diag sai de uma cópia só; um par com
+// RPA não recebe advertising direcionado; o host reseta e volta a anunciar.
+#include "ble_server.h"
+#include "ble_sim.h"
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static int failures;
+
+#define CHECK(cond)                                                    \
+    do                                                                 \
+    {                                                                  \
+        if (!(cond))                                                   \
+        {                                                              \
+            printf("FALHA %s:%d: %s\n", __FILE__, __LINE__, #cond);    \
+            failures++;                                                \
+        }                                                              \
+    } while (0)
+
+static const ble_uuid128_t cmd_uuid = BLE_UUID128_INIT(
+    0x23, 0xd1, 0xbc, 0xea, 0x5f, 0x78, 0x23, 0x15, 0xde, 0xef, 0x12, 0x12, 0x25, 0x15, 0x00, 0x00);
+static const ble_uuid128_t status_uuid = BLE_UUID128_INIT(
+    0x23, 0xd1, 0xbc, 0xea, 0x5f, 0x78, 0x23, 0x15, 0xde, 0xef, 0x12, 0x12, 0x24, 0x15, 0x00, 0x00);
+static const ble_uuid128_t datetime_uuid = BLE_UUID128_INIT(
+    0x23, 0xd1, 0xbc, 0xea, 0x5f, 0x78, 0x23, 0x15, 0xde, 0xef, 0x12, 0x12, 0x26, 0x15, 0x00, 0x00);
+static const ble_uuid128_t diag_uuid = BLE_UUID128_INIT(
+    0x23, 0xd1, 0xbc, 0xea, 0x5f, 0x78, 0x23, 0x15, 0xde, 0xef, 0x12, 0x12, 0x29, 0x15, 0x00, 0x00);
+
+static uint16_t cmd_handle;
+static uint16_t status_handle;
+static uint16_t datetime_handle;
+static uint16_t diag_handle;
+
+static const ble_sim_peer_t phone = {.id_addr = {BLE_ADDR_PUBLIC, {0x11, 0x22, 0x33, 0x44, 0x55, 0x66}}};
+static const ble_sim_peer_t phone_rpa = {.id_addr = {BLE_ADDR_PUBLIC, {0xa1, 0xa2, 0xa3, 0xa4, 0xa5, 0xa6}}, .rpa = true};
+
+// ===== Callbacks da aplicação =====
+
+static atomic_int writes;
+static uint8_t last_write[64];
+static uint16_t last_write_len;
+static int connects;
+static int disconnects;
+static int sent_ok;
+static int sent_fail;
+static uint32_t sent_seq[64];
+
+// Tarefa de comandos (thread própria)
+static void app_on_write(uint8_t *data, uint16_t len)
+{
+    if (len > sizeof(last_write))
+        len = sizeof(last_write);
+    memcpy(last_write, data, len);
+    last_write_len = len;
+    atomic_fetch_add(&writes, 1);
+}
+
+static void app_on_connect(uint16_t conn_handle)
+{
+    connects++;
+}
+
+static void app_on_disconnect(uint16_t conn_handle)
+{
+    disconnects++;
+}
+
+static void app_sent(uint16_t conn_handle, esp_err_t status, void *arg)
+{
+    if (status == ESP_OK)
+    {
+        if (sent_ok < (int)(sizeof(sent_seq) / sizeof(sent_seq[0])))
+            sent_seq[sent_ok] = (uint32_t)(uintptr_t)arg;
+        sent_ok++;
+    }
+    else
+    {
+        sent_fail++;
+    }
+}
+
+static bool writes_reached(void *arg)
+{
+    return atomic_load(&writes) >= *(int *)arg;
+}
+
+static uint32_t get_u32(const uint8_t *p)
+{
+    return p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+// ===== Roteiro =====
+
+static void test_boot(void)
+{
+    ble_server_config_t config = {
+        .device_name = "SimLock",
+        .on_write = app_on_write,
+        .on_connect = app_on_connect,
+        .on_disconnect = app_on_disconnect,
+        .async_commands = true,
+        .conn_policy = BLE_SERVER_CONN_POLICY_FAST_THEN_IDLE,
+    };
+    ble_server_reset_stats_t reset_stats;
+
+    ble_sim_init();
+    CHECK(ble_server_init(&config) == ESP_OK);
+
+    cmd_handle = ble_sim_find_chr(&cmd_uuid.u);
+    status_handle = ble_sim_find_chr(&status_uuid.u);
+    datetime_handle = ble_sim_find_chr(&datetime_uuid.u);
+    diag_handle = ble_sim_find_chr(&diag_uuid.u);
+    CHECK(cmd_handle && status_handle && datetime_handle && diag_handle);
+
+    // Controlador sem endereço nas duas primeiras tentativas: o servidor
+    // tenta de novo em 50 e 100 ms em vez de ficar mudo
+    ble_sim_fail_infer_auto(2);
+    ble_sim_sync();
+    CHECK(!ble_sim_adv()->active);
+    ble_sim_run(200);
+    CHECK(ble_sim_adv()->active);
+    CHECK(!ble_sim_adv()->directed);
+    CHECK(ble_sim_adv()->adv_len > 0);
+
+    CHECK(ble_server_get_reset_stats(&reset_stats) == ESP_OK);
+    CHECK(reset_stats.syncs == 1);
+    CHECK(reset_stats.sync_retries == 2);
+}
+
+static uint16_t test_connect(void)
+{
+    ble_server_conn_info_t info;
+    ble_sim_stats_t stats;
+    uint8_t buf[64];
+
+    uint16_t conn = ble_sim_connect(&phone);
+    CHECK(conn != BLE_SIM_NO_CONN);
+    ble_sim_run(0);
+    CHECK(connects == 1);
+
+    // Data length máximo pedido já na conexão, antes da troca de MTU
+    ble_sim_get_stats(&stats);
+    CHECK(stats.data_len_requests == 1);
+    CHECK(stats.data_len_octets == 251 && stats.data_len_time_us == 2120);
+
+    ble_sim_mtu(conn, 247);
+    ble_sim_run(0);
+    CHECK(ble_server_get_conn_info(conn, &info) == ESP_OK);
+    CHECK(info.mtu == 247);
+    CHECK(!info.subscribed);
+
+    CHECK(ble_sim_subscribe(conn, status_handle, true) == 0);
+    CHECK(ble_server_get_conn_info(conn, &info) == ESP_OK && info.subscribed);
+
+    // Status: 20 bytes little-endian, state primeiro
+    ble_server_status_t status = {.state = 1, .op_count = 7};
+    CHECK(ble_server_set_status(&status) == ESP_OK);
+    int n = ble_sim_read(conn, status_handle, 0, buf, sizeof(buf));
+    CHECK(n == 20);
+    CHECK(get_u32(&buf[0]) == 1);
+    CHECK(get_u32(&buf[12]) == 7);
+
+    // Characteristics só de escrita recusam leitura
+    CHECK(ble_sim_read(conn, cmd_handle, 0, buf, sizeof(buf)) == -BLE_ATT_ERR_READ_NOT_PERMITTED);
+    return conn;
+}
+
+static void test_command(uint16_t conn)
+{
+    static const uint8_t cmd[] = {0x01, 0x02, 0x03, 0x04, 0x05};
+    int expected = atomic_load(&writes) + 1;
+
+    // Segmentos de 2 bytes: o servidor precisa percorrer a cadeia de mbufs
+    ble_sim_set_rx_chunk(2);
+    CHECK(ble_sim_write(conn, cmd_handle, cmd, sizeof(cmd)) == 0);
+    ble_sim_set_rx_chunk(0);
+
+    CHECK(ble_sim_wait(writes_reached, &expected, 2000));
+    CHECK(last_write_len == sizeof(cmd) && memcmp(last_write, cmd, sizeof(cmd)) == 0);
+
+    // 2024-03-15 12:34:56.789 UTC
+    static const uint8_t datetime[] = {24, 3, 15, 12, 34, 56, 5, 0x15, 0x03};
+    CHECK(ble_sim_write(conn, datetime_handle, datetime, sizeof(datetime)) == 0);
+    CHECK(ble_sim_time_sync_last() == 1710506096789000LL);
+    CHECK(ble_sim_time_sync_last_resolution() == 1000);
+    CHECK(ble_sim_write(conn, datetime_handle, datetime, 7) == 0);
+    CHECK(ble_sim_time_sync_last() == 1710506096000000LL);
+    CHECK(ble_sim_time_sync_last_resolution() == 1000000);
+    CHECK(ble_sim_write(conn, datetime_handle, datetime, 3) == BLE_ATT_ERR_INVALID_ATTR_VALUE_LEN);
+}
+
+static void test_notify_queue(uint16_t conn)
+{
+    ble_sim_notify_t note;
+    ble_server_txq_stats_t txq;
+    uint8_t payload[200];
+    uint32_t accepted = 0;
+
+    ble_sim_notify_clear();
+    CHECK(ble_server_notify_enqueue(conn, (const uint8_t *)"hello", 5, app_sent, NULL) == ESP_OK);
+    ble_sim_run(0);
+    CHECK(ble_sim_notify_pop(&note));
+    CHECK(note.conn_handle == conn && note.attr_handle == status_handle);
+    CHECK(note.len == 5 && memcmp(note.data, "hello", 5) == 0);
+    CHECK(sent_ok == 1);
+
+    // Controlador parado: os mbufs ficam presos, a fila para na reserva e
+    // segura o resto; ao liberar, tudo sai em ordem
+    sent_ok = 0;
+    ble_sim_set_tx_paused(true);
+    for (;;)
+    {
+        memset(payload, 0, sizeof(payload));
+        memcpy(payload, &accepted, sizeof(accepted));
+        if (ble_server_notify_enqueue(conn, payload, sizeof(payload), app_sent,
+                                      (void *)(uintptr_t)accepted) != ESP_OK)
+        {
+            break;
+        }
+        accepted++;
+        ble_sim_run(10);
+    }
+    CHECK(accepted > CONFIG_BLE_SERVER_TXQ_DEPTH);
+    CHECK(ble_sim_msys_free() <= CONFIG_BLE_SERVER_TXQ_MSYS_RESERVE + 2);
+    CHECK(ble_server_get_txq_stats(&txq) == ESP_OK && txq.retries > 0);
+
+    ble_sim_set_tx_paused(false);
+    ble_sim_run(50);
+    CHECK(sent_ok == (int)accepted);
+    CHECK(sent_fail == 0);
+    for (uint32_t i = 0; i < accepted && i < 64; i++)
+    {
+        CHECK(sent_seq[i] == i);
+    }
+
+    uint32_t received = 0;
+    while (ble_sim_notify_pop(&note))
+    {
+        uint32_t seq;
+        memcpy(&seq, note.data, sizeof(seq));
+        CHECK(seq == received);
+        CHECK(note.len == sizeof(payload));
+        received++;
+    }
+    CHECK(received == accepted);
+    CHECK(ble_sim_msys_free() == CONFIG_BT_NIMBLE_MSYS_1_BLOCK_COUNT);
+
+    // CCCD desabilitado: nada é enfileirado, e o que já estava na fila
+    // (também as respostas de comando) é descartado sem ir ao ar
+    sent_ok = 0;
+    CHECK(ble_server_notify_enqueue(conn, (const uint8_t *)"queued", 6, app_sent, NULL) == ESP_OK);
+    CHECK(ble_sim_subscribe(conn, status_handle, false) == 0);
+    CHECK(ble_server_notify_enqueue(conn, (const uint8_t *)"late", 4, app_sent, NULL) ==
+          ESP_ERR_INVALID_STATE);
+    ble_sim_run(0);
+    CHECK(!ble_sim_notify_pop(&note));
+    CHECK(sent_ok == 0 && sent_fail == 1);
+    sent_fail = 0;
+
+    CHECK(ble_sim_subscribe(conn, status_handle, true) == 0);
+    CHECK(ble_server_notify_enqueue(conn, (const uint8_t *)"again", 5, app_sent, NULL) == ESP_OK);
+    ble_sim_run(0);
+    CHECK(ble_sim_notify_pop(&note) && note.len == 5);
+    CHECK(sent_ok == 1);
+}
+
+// Entre os pedaços da leitura longa chegam comandos: sem a cópia por conexão
+// o cliente juntaria contadores de momentos diferentes
+static void diag_between(void *arg)
+{
+    uint16_t conn = *(uint16_t *)arg;
+    static const uint8_t cmd[] = {0xAA};
+
+    CHECK(ble_sim_write(conn, cmd_handle, cmd, sizeof(cmd)) == 0);
+}
+
+static void test_diag_long_read(uint16_t conn)
+{
+    uint8_t first[160];
+    uint8_t second[160];
+    uint8_t sel = 0; // Command é a primeira characteristic
+    uint16_t mtu_conn = ble_sim_connect(&(ble_sim_peer_t){.id_addr = {BLE_ADDR_PUBLIC, {9, 9, 9, 9, 9, 9}}});
+
+    // Conexão com MTU padrão: 120 bytes em 6 pedaços
+    CHECK(mtu_conn != BLE_SIM_NO_CONN);
+    ble_sim_run(0);
+    CHECK(ble_sim_write(mtu_conn, diag_handle, &sel, 1) == 0);
+
+    int writes_before = atomic_load(&writes);
+    int n1 = ble_sim_read_long(mtu_conn, diag_handle, first, sizeof(first), diag_between, &conn);
+    int n2 = ble_sim_read_long(mtu_conn, diag_handle, second, sizeof(second), NULL, NULL);
+    CHECK(n1 == n2 && n1 > BLE_ATT_MTU_DFLT);
+    CHECK(first[3] == 0);
+
+    // Bloco da characteristic selecionada no fim: reads, writes, ...
+    int buckets = first[2];
+    int chr_at = n1 - (5 * 4 + buckets * 2);
+    uint32_t writes_first = get_u32(&first[chr_at + 4]);
+    uint32_t writes_second = get_u32(&second[chr_at + 4]);
+    int blobs = n1 / (BLE_ATT_MTU_DFLT - 1);
+
+    CHECK(writes_first == (uint32_t)writes_before);
+    CHECK(writes_second == writes_first + blobs);
+
+    ble_sim_disconnect(mtu_conn, BLE_ERR_REM_USER_CONN_TERM);
+    ble_sim_run(0);
+
+    int expected = writes_second;
+    CHECK(ble_sim_wait(writes_reached, &expected, 2000));
+}
+
+static void test_disconnect_directed(uint16_t conn)
+{
+    ble_server_conn_info_t info;
+    ble_sim_stats_t stats;
+
+    // Par com endereço fixo e bond: direcionado para ele
+    ble_sim_encrypt(conn, true);
+    ble_sim_run(0);
+    CHECK(ble_server_get_conn_info(conn, &info) == ESP_OK && info.bonded && info.encrypted);
+
+    int before = disconnects;
+    ble_sim_disconnect(conn, BLE_ERR_REM_USER_CONN_TERM);
+    ble_sim_run(0);
+    CHECK(disconnects == before + 1);
+    CHECK(ble_server_get_conn_info(conn, &info) == ESP_ERR_NOT_FOUND);
+    CHECK(ble_sim_adv()->active && ble_sim_adv()->directed);
+    CHECK(memcmp(ble_sim_adv()->peer.val, phone.id_addr.val, 6) == 0);
+
+    // Outro celular não entra durante o direcionado
+    ble_sim_get_stats(&stats);
+    uint32_t refused = stats.connects_refused;
+    CHECK(ble_sim_connect(&phone_rpa) == BLE_SIM_NO_CONN);
+    ble_sim_get_stats(&stats);
+    CHECK(stats.connects_refused == refused + 1);
+
+    // Direcionado expira e volta a rajada rápida
+    ble_sim_run(2000);
+    CHECK(ble_sim_adv()->active && !ble_sim_adv()->directed);
+
+    // Par com RPA (bond com IRK): não responderia ao direcionado para a
+    // identidade, então o servidor vai direto para o não direcionado
+    uint16_t rpa_conn = ble_sim_connect(&phone_rpa);
+    CHECK(rpa_conn != BLE_SIM_NO_CONN);
+    ble_sim_run(0);
+    ble_sim_encrypt(rpa_conn, true);
+    ble_sim_run(0);
+    ble_sim_disconnect(rpa_conn, BLE_ERR_CONN_SPVN_TMO);
+    ble_sim_run(0);
+    CHECK(ble_sim_adv()->active && !ble_sim_adv()->directed);
+
+    uint16_t again = ble_sim_connect(&phone_rpa);
+    CHECK(again != BLE_SIM_NO_CONN);
+    ble_sim_run(0);
+    ble_sim_disconnect(again, BLE_ERR_REM_USER_CONN_TERM);
+    ble_sim_run(0);
+}
+
+static void test_host_reset(void)
+{
+    ble_server_reset_stats_t reset_stats;
+
+    uint16_t conn = ble_sim_connect(&phone_rpa);
+    CHECK(conn != BLE_SIM_NO_CONN);
+    ble_sim_run(0);
+
+    int before = disconnects;
+    ble_sim_host_reset(BLE_HS_ETIMEOUT_HCI);
+    ble_sim_run(0);
+    CHECK(disconnects == before + 1);
+    CHECK(!ble_sim_adv()->active);
+
+    ble_sim_run(100);
+    ble_sim_sync();
+    ble_sim_run(0);
+    CHECK(ble_sim_adv()->active);
+
+    CHECK(ble_server_get_reset_stats(&reset_stats) == ESP_OK);
+    CHECK(reset_stats.resets == 1);
+    CHECK(reset_stats.last_reason == BLE_HS_ETIMEOUT_HCI);
+    CHECK(reset_stats.syncs == 2);
+    CHECK(reset_stats.recover_ms_last >= 100);
+}
+
+// Conexão no meio da rajada rápida: o advertising volta com o que faltava
+// dela, e não com a duração inteira (reconexões em série a prolongariam)
+static void test_connect_keeps_deadline(void)
+{
+    ble_server_adv_stats_t adv_stats;
+
+    CHECK(ble_server_get_adv_stats(&adv_stats) == ESP_OK);
+    CHECK(adv_stats.advertising && adv_stats.profile == BLE_SERVER_ADV_FAST);
+
+    ble_sim_run(CONFIG_BLE_SERVER_ADV_FAST_DURATION_MS - 10000);
+    uint16_t conn = ble_sim_connect(&phone_rpa);
+    CHECK(conn != BLE_SIM_NO_CONN);
+    ble_sim_run(0);
+    CHECK(ble_server_get_adv_stats(&adv_stats) == ESP_OK);
+    CHECK(adv_stats.advertising && adv_stats.profile == BLE_SERVER_ADV_FAST);
+    CHECK(ble_sim_adv()->duration_ms > 9000 && ble_sim_adv()->duration_ms <= 10000);
+
+    ble_sim_run(10100);
+    CHECK(ble_server_get_adv_stats(&adv_stats) == ESP_OK);
+    CHECK(adv_stats.advertising && adv_stats.profile == BLE_SERVER_ADV_MEDIUM);
+    CHECK(ble_sim_adv()->duration_ms == CONFIG_BLE_SERVER_ADV_MEDIUM_DURATION_MS);
+
+    ble_sim_disconnect(conn, BLE_ERR_REM_USER_CONN_TERM);
+    ble_sim_run(0);
+}
+
+int main(void)
+{
+    // mktime() da characteristic Data/Hora em UTC, como no dispositivo
+    setenv("TZ", "UTC", 1);
+    tzset();
+
+    test_boot();
+    uint16_t conn = test_connect();
+    test_command(conn);
+    test_notify_queue(conn);
+    test_diag_long_read(conn);
+    test_disconnect_directed(conn);
+    test_host_reset();
+    test_connect_keeps_deadline();
+
+    if (failures)
+    {
+        printf("%d falha(s)\n", failures);
+        return EXIT_FAILURE;
+    }
+    printf("OK\n");
+    return EXIT_SUCCESS;
+}
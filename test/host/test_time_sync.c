@@ -0,0 +1,166 @@
+// test/host/test_time_sync.c
+// Estimativa de drift de time_sync.c com um oscilador 30 ppm adiantado e o
+// esp_timer sob controle do teste. Referências em segundos inteiros (Data/
+// Hora de 7 bytes) não estimam nada em intervalos curtos; referências em ms
+// estimam a partir de 600 s; uma referência ruim é descartada, sem virar o
+// limite de CONFIG_TIME_SYNC_DRIFT_MAX_PPM.
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "time_sync.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+
+static int failures;
+
+#define CHECK(cond)                                                    \
+    do                                                                 \
+    {                                                                  \
+        if (!(cond))                                                   \
+        {                                                              \
+            printf("FALHA %s:%d: %s\n", __FILE__, __LINE__, #cond);    \
+            failures++;                                                \
+        }                                                              \
+    } while (0)
+
+#define DRIFT_PPB 30000
+#define WALL0_US 1710506096000000LL // 2024-03-15 12:34:56 UTC
+#define RES_S 1000000
+#define RES_MS 1000
+
+// ===== Fakes (esp_timer, log, seções críticas e relógio do sistema) =====
+
+static int64_t mono_us = 1000000;
+
+int64_t esp_timer_get_time(void)
+{
+    return mono_us;
+}
+
+void esp_log_write(esp_log_level_t level, const char *tag, const char *format, ...)
+{
+}
+
+void sim_critical_enter(void)
+{
+}
+
+void sim_critical_exit(void)
+{
+}
+
+int test_settimeofday(const struct timeval *tv, const struct timezone *tz)
+{
+    return 0;
+}
+
+int test_adjtime(const struct timeval *delta, struct timeval *olddelta)
+{
+    return 0;
+}
+
+// ===== Relógio simulado =====
+
+// Tempo real: o oscilador do esp_timer atrasa DRIFT_PPB em relação a ele
+static int64_t true_wall(void)
+{
+    int64_t dt = mono_us - 1000000;
+
+    return WALL0_US + dt + dt / 1000000 * DRIFT_PPB / 1000;
+}
+
+static void advance_s(int64_t s)
+{
+    mono_us += s * 1000000;
+}
+
+// Referência como o celular envia: truncada na resolução
+static void sync_ref(uint32_t res_us, int64_t offset_us)
+{
+    int64_t wall = true_wall() + offset_us;
+
+    CHECK(time_sync_set(wall - wall % res_us, res_us) == ESP_OK);
+}
+
+static int32_t drift_ppb(void)
+{
+    time_sync_stats_t stats;
+
+    CHECK(time_sync_get_stats(&stats) == ESP_OK);
+    return stats.drift_ppb;
+}
+
+static uint32_t drift_rejected(void)
+{
+    time_sync_stats_t stats;
+
+    CHECK(time_sync_get_stats(&stats) == ESP_OK);
+    return stats.drift_rejected;
+}
+
+static int drift_near(int32_t expected, int32_t tolerance)
+{
+    int32_t d = drift_ppb();
+
+    return d >= expected - tolerance && d <= expected + tolerance;
+}
+
+int main(void)
+{
+    // Segundos inteiros a cada 600 s: ±1 s em 600 s seria ±1667 ppm
+    sync_ref(RES_S, 0);
+    for (int i = 0; i < 5; i++)
+    {
+        advance_s(600);
+        sync_ref(RES_S, 0);
+        CHECK(drift_ppb() == 0);
+    }
+    CHECK(drift_rejected() == 0);
+
+    // Referência em ms: vira a base e estima 600 s depois (erro ≤ 3,4 ppm)
+    advance_s(600);
+    sync_ref(RES_MS, 0);
+    CHECK(drift_ppb() == 0);
+    advance_s(600);
+    sync_ref(RES_MS, 0);
+    CHECK(drift_near(DRIFT_PPB, 3400));
+
+    // Celular com o relógio 1,5 s errado: abaixo do ajuste direto, mas
+    // 2500 ppm em 600 s. Descartada, e a estimativa seguinte (contra ela)
+    // também; o drift não muda até a base voltar a ser boa
+    int32_t before = drift_ppb();
+    advance_s(600);
+    sync_ref(RES_MS, 1500000);
+    CHECK(drift_ppb() == before);
+    CHECK(drift_rejected() == 1);
+    advance_s(600);
+    sync_ref(RES_MS, 0);
+    CHECK(drift_ppb() == before);
+    CHECK(drift_rejected() == 2);
+    advance_s(600);
+    sync_ref(RES_MS, 0);
+    CHECK(drift_near(DRIFT_PPB, 3400));
+
+    // De volta aos segundos inteiros: contra a base em ms (1 ms + 1 s a
+    // 5 ppm), só depois de ~200200 s
+    before = drift_ppb();
+    for (int i = 0; i < 55; i++)
+    {
+        advance_s(3600);
+        sync_ref(RES_S, 0);
+        CHECK(drift_ppb() == before);
+    }
+    advance_s(3600);
+    sync_ref(RES_S, 0);
+    CHECK(drift_ppb() != before);
+    CHECK(drift_near(DRIFT_PPB, 5000));
+    CHECK(drift_rejected() == 2);
+
+    if (failures)
+    {
+        printf("%d falha(s)\n", failures);
+        return EXIT_FAILURE;
+    }
+    printf("OK\n");
+    return EXIT_SUCCESS;
+}